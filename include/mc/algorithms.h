@@ -64,7 +64,8 @@
  * For the flags that do not mention any specific algorithms, such as those
  * that select an algorithm based on performance or quality characteristics,
  * the exact algorithm selected is subject to change. Newer versions of libmc
- * may select a different algorithm.
+ * may select a different algorithm. The CPU flags are resolved by timing the
+ * candidate algorithms on the current machine, as described in mc/policy.h.
  */
 typedef enum mcAlgorithmFlag {
   /**
@@ -72,11 +73,13 @@ typedef enum mcAlgorithmFlag {
    */
   MC_UNKNOWN_ALGORITHM = -1,
   /** The default algorihm used by libmc, which is currently the same algorithm
-   * as chosen for MC_CPU_BALANCE_ALGORITHM. */
+   * as chosen for MC_CPU_BALANCE_ALGORITHM, but always run on a single
+   * thread. */
   MC_DEFAULT_ALGORITHM = 1,
   /** Selects a performant isosurface extraction algorithm and its
    * corresponding parameters (possibly sacrificing some quality) for execution
-   * on a CPU. */
+   * on a CPU. Like the other MC_CPU_* flags, this may split the lattice into
+   * blocks and evaluate the scalar field from several threads at once. */
   MC_CPU_PERFORMANCE_ALGORITHM,
   /** Selects an algorithm and its parameters with a balance between
    * performance and mesh quality for execution on a CPU. */
@@ -116,6 +119,16 @@ typedef enum mcAlgorithmFlag {
   MC_TRANSVOXEL,
   MC_MARCHING_SQUARES,
   MC_COLORED_MARCHING_SQUARES,
+  /** Dual contouring on an octree that is collapsed wherever the surface can
+   * be represented by fewer cells. \cite Ju:2002:DCH:566654.566586 */
+  MC_ADAPTIVE_DUAL_CONTOURING,
+  /** Marching squares over a quadtree that is only refined where the contour
+   * passes. */
+  MC_ADAPTIVE_MARCHING_SQUARES,
+  /** Marching cubes with the ambiguous faces and cube interiors resolved to
+   * match the topology of the trilinear interpolant.
+   * \cite Chernyaev95marchingcubes */
+  MC_MARCHING_CUBES_33,
 } mcAlgorithmFlag;
 
 /**
@@ -152,6 +165,10 @@ typedef void * mcAlgorithmParams;
 typedef enum mcAlgorithmParamsType {
   MC_CUBERILLE_PARAMS,
   MC_TRANSVOXEL_PARAMS,
+  MC_ELASTIC_SURFACE_NET_PARAMS,
+  MC_ADAPTIVE_DUAL_CONTOURING_PARAMS,
+  MC_ADAPTIVE_MARCHING_SQUARES_PARAMS,
+  MC_SNAP_MC_PARAMS,
 } mcAlgorithmParamsType;
 
 /** @} */
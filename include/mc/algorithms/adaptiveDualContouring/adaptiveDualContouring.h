@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_ALGORITHMS_ADAPTIVE_DUAL_CONTOURING_ADAPTIVE_DUAL_CONTOURING_H_
+#define MC_ALGORITHMS_ADAPTIVE_DUAL_CONTOURING_ADAPTIVE_DUAL_CONTOURING_H_
+
+#include <mc/isosurfaceBuilder.h>
+
+/**
+ * A parameter structure that can optionally be passed into the adaptive dual
+ * contouring isosurface extraction algorithm.
+ */
+typedef struct mcAdaptiveDualContouringParams {
+  /** This field \em must be set to the value
+   * MC_ADAPTIVE_DUAL_CONTOURING_PARAMS or a runtime error will occur. */
+  mcAlgorithmParamsType type;
+  /** The largest quadratic error allowed when collapsing the octree cells
+   * beneath an octree node into a single cell. The error is the sum of the
+   * squared distances from the cell's vertex to the tangent planes at each of
+   * its edge intersections, measured in units of the lattice spacing. Larger
+   * values give coarser meshes; a tolerance of zero only collapses cells where
+   * the surface is exactly planar. */
+  float tolerance;
+  /** If nonzero, each quad of the dual surface is split into two triangles.
+   * Otherwise, the faces are given as quads, except where collapsed cells make
+   * two corners of a quad coincide. */
+  int triangulate;
+} mcAdaptiveDualContouringParams;
+
+/**
+ * Initializes the given \p params structure with the default parameters for
+ * the adaptive dual contouring isosurface extraction algorithm.
+ *
+ * The specific values of these default parameters depends on the version of
+ * the libmc library used.
+ */
+void mcAdaptiveDualContouringParams_default(
+    mcAdaptiveDualContouringParams *params);
+
+/**
+ * This routine implements the adaptive dual contouring isosurface extraction
+ * algorithm described by Ju et al. \cite Ju:2002:DCH:566654.566586
+ *
+ * Hermite data (edge intersections and their surface normals) is sampled for
+ * every voxel cube that intersects the isosurface, and each cube is given a
+ * single vertex that minimizes a quadratic error function of the tangent
+ * planes at its edge intersections. This places vertices on sharp features of
+ * the surface.
+ *
+ * The voxel cubes are stored in an octree. Wherever the quadratic error of the
+ * combined cells beneath an octree node is within the tolerance given in \p
+ * params, and collapsing the node would not change the topology of the
+ * surface, the node is collapsed into a single cell with a single vertex.
+ * Faces are generated for every lattice edge crossing the isosurface, so that
+ * faces between cells of different sizes share vertices and the resulting
+ * mesh has no cracks. If \p params is NULL, the default parameters are used.
+ */
+void mcAdaptiveDualContouring_isosurfaceFromField(
+    mcScalarFieldWithArgs sf, const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max,
+    const mcAdaptiveDualContouringParams *params,
+    mcMesh *mesh);
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_ALGORITHMS_ADAPTIVE_MARCHING_SQUARES_ADAPTIVE_MARCHING_SQUARES_H_
+#define MC_ALGORITHMS_ADAPTIVE_MARCHING_SQUARES_ADAPTIVE_MARCHING_SQUARES_H_
+
+#include <mc/algorithms.h>
+#include <mc/common/quadNode.h>
+#include <mc/contour.h>
+#include <mc/scalarField.h>
+#include <mc/vector.h>
+
+/**
+ * A parameter structure that can optionally be passed into the adaptive
+ * marching squares contouring algorithm.
+ */
+typedef struct mcAdaptiveMarchingSquaresParams {
+  /** This field \em must be set to the value
+   * MC_ADAPTIVE_MARCHING_SQUARES_PARAMS or a runtime error will occur. */
+  mcAlgorithmParamsType type;
+  /** The level of the largest quadtree cells that are not refined, so that
+   * leaf cells span at most 2^coarsestLevel lattice squares along each axis.
+   * Cells are only refined below this level where their samples indicate that
+   * the contour passes through them. Features of the contour smaller than
+   * half of such a cell can be missed, so smaller values find smaller
+   * features at the cost of sampling more of the field. */
+  unsigned int coarsestLevel;
+} mcAdaptiveMarchingSquaresParams;
+
+/**
+ * Initializes the given \p params structure with the default parameters for
+ * the adaptive marching squares contouring algorithm.
+ *
+ * The specific values of these default parameters depends on the version of
+ * the libmc library used.
+ */
+void mcAdaptiveMarchingSquaresParams_default(
+    mcAdaptiveMarchingSquaresParams *params);
+
+/**
+ * This routine contours a scalar field with marching squares over a quadtree
+ * instead of a regular lattice. Quadtree cells are refined down to individual
+ * lattice squares only where the contour passes, so the number of samples
+ * taken is roughly proportional to the length of the contour rather than to
+ * the number of lattice points.
+ *
+ * A cell is refined if any of its four corners, the midpoints of its edges or
+ * its center differ in sign. Where a leaf cell borders smaller leaf cells, the
+ * corners of the smaller cells on the shared edge are included in the boundary
+ * of the larger cell. Both cells then compute the same edge intersections
+ * from the same samples, so the contour has no cracks between levels. If \p
+ * params is NULL, the default parameters are used.
+ */
+void mcAdaptiveMarchingSquares_contourFromField(
+    mcScalarFieldWithArgs sf, const void *args,
+    unsigned int x_res, unsigned int y_res,
+    const mcVec2 *min, const mcVec2 *max,
+    const mcAdaptiveMarchingSquaresParams *params,
+    mcContour *contour);
+
+#endif
@@ -254,6 +254,30 @@ unsigned int mcCube_rotateEdgeReverseZ(unsigned int edge);
  * pseudo index -1. */
 unsigned int mcCube_translateEdge(unsigned int edge, unsigned int face);
 
+/**
+ * This routine takes the index of a cube face and returns the four sample
+ * indices on that face in sampleIndices. The samples are given in cyclic order
+ * around the face, so samples 0 and 2 (and likewise 1 and 3) are diagonal from
+ * each other. This is the same order in which mcCube_getCubeFace() packs the
+ * face samples into bits.
+ */
+void mcCube_faceSampleIndices(unsigned int face, unsigned int *sampleIndices);
+
+/**
+ * Extracts the four sample values on the given face of the given cube
+ * configuration and returns them as a 4-bit square configuration, with the
+ * samples in the order given by mcCube_faceSampleIndices().
+ */
+int mcCube_getCubeFace(int cube, int faceIndex);
+
+/**
+ * This routine returns true if the given 4-bit face configuration, as returned
+ * by mcCube_getCubeFace(), is ambiguous. Ambiguous faces have two samples on
+ * opposite corners above the isosurface, and the other two corners below the
+ * isosurface.
+ */
+int mcCube_isAmbiguousFace(int face);
+
 /**
  * This routine returns true if the given cube has at least one ambiguous face.
  * Ambiguous faces have two samples on opposite corners above the isosurface,
@@ -26,9 +26,15 @@
 
 #include <mc/mesh.h>
 
+/**
+ * Constructs the dual of the given mesh and adds it to \p dual. Each face of
+ * the mesh becomes a vertex at the face midpoint, and each vertex with at
+ * least three adjacent faces becomes a face. Dual faces are wound
+ * counter-clockwise about the vertex normal; for vertices without a normal,
+ * the normal is estimated from the adjacent faces.
+ */
 void mcDual_makeDual(
     const mcMesh *mesh,
-    int maxFacesPerVertex,
     mcMesh *dual);
 
 #endif
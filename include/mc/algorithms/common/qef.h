@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_ALGORITHMS_COMMON_QEF_H_
+#define MC_ALGORITHMS_COMMON_QEF_H_
+
+/**
+ * \addtogroup libmc
+ * @{
+ */
+
+/**
+ * \addtogroup algorithms
+ * @{
+ */
+
+/**
+ * \addtogroup common
+ * @{
+ */
+
+/**
+ * \defgroup mcQef mcQef
+ */
+
+/**
+ * \addtogroup mcQef
+ * @{
+ */
+
+#include <mc/vector.h>
+
+/**
+ * A quadratic error function measuring the sum of squared distances from a
+ * point to a set of planes. Each plane is given by a point on the plane and
+ * the plane's normal, as with the Hermite data (edge intersections and their
+ * surface normals) used by dual contouring.
+ *
+ * Only the normal equations are stored, so the error functions of
+ * neighboring cells can be combined by simply adding them together.
+ */
+typedef struct mcQef {
+  /* The sums are kept in double precision. In lattice coordinates the terms
+   * of b^T b grow with the square of the lattice resolution, and in single
+   * precision their rounding alone would exceed any useful error tolerance. */
+  /** The upper triangle of the symmetric matrix A^T A, stored as xx, xy, xz,
+   * yy, yz, zz. */
+  double ata[6];
+  /** The vector A^T b. */
+  double atb[3];
+  /** The scalar b^T b. */
+  double btb;
+  /** The sum of the points on each plane. */
+  double pointSum[3];
+  /** The number of planes added to this error function. */
+  unsigned int numPoints;
+} mcQef;
+
+/**
+ * Initializes the given quadratic error function with no planes.
+ */
+void mcQef_init(mcQef *self);
+
+/**
+ * Adds the plane through the given point with the given unit normal to the
+ * quadratic error function.
+ */
+void mcQef_addPlane(mcQef *self, const mcVec3 *point, const mcVec3 *normal);
+
+/**
+ * Adds all of the planes in the quadratic error function \p other to this
+ * quadratic error function.
+ */
+void mcQef_add(mcQef *self, const mcQef *other);
+
+/**
+ * Finds the mass point of the quadratic error function, which is the average
+ * of the points on each of its planes.
+ */
+void mcQef_massPoint(const mcQef *self, mcVec3 *point);
+
+/**
+ * Evaluates the quadratic error function at the given point.
+ */
+float mcQef_error(const mcQef *self, const mcVec3 *point);
+
+/**
+ * Finds the point minimizing the quadratic error function.
+ *
+ * Directions in which the planes do not constrain the minimizer (such as along
+ * the ridge of two planes) are resolved toward the mass point of the planes,
+ * by truncating small eigenvalues of A^T A as described by Lindstrom in
+ * "Out-of-Core Simplification of Large Polygonal Models."
+ *
+ * \param self The quadratic error function to minimize.
+ * \param point Location in which to store the minimizing point.
+ * \return The value of the quadratic error function at the minimizer.
+ */
+float mcQef_solve(const mcQef *self, mcVec3 *point);
+
+/** @} */
+
+/** @} */
+
+/** @} */
+
+/** @} */
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_ALGORITHMS_COMMON_SAMPLE_SLICES_H_
+#define MC_ALGORITHMS_COMMON_SAMPLE_SLICES_H_
+
+/**
+ * \addtogroup libmc
+ * @{
+ */
+
+/**
+ * \addtogroup algorithms
+ * @{
+ */
+
+/**
+ * \addtogroup common
+ * @{
+ */
+
+/**
+ * \defgroup mcSampleSlices mcSampleSlices
+ */
+
+/**
+ * \addtogroup mcSampleSlices
+ * @{
+ */
+
+#include <mc/scalarField.h>
+#include <mc/vector.h>
+
+/** The number of lattice slices kept in the mcSampleSlices ring buffer. */
+#define MC_SAMPLE_SLICES_NUM_SLICES 4
+
+/**
+ * Algorithms that march through the sample lattice one slice at a time only
+ * ever need the samples from a few neighboring slices. The mcSampleSlices
+ * structure keeps a circular buffer of four lattice slices parallel to the
+ * xy-plane: the current slice z, the slice z + 1 that completes the current
+ * layer of voxel cubes, and the slices z - 1 and z + 2 that are needed to
+ * estimate gradients at the samples of the current layer.
+ *
+ * Each lattice point is evaluated exactly once as the buffer advances along
+ * the z-axis. Each slice is sampled with the lattice sampler of the scalar
+ * field descriptor, if it has one, as a block of the whole lattice.
+ */
+typedef struct mcSampleSlices {
+  /** The sample values for all four slices. */
+  float *samples;
+  /** The scalar field being sampled. */
+  mcScalarFieldDescriptor field;
+  /** The number of samples along each axis of the lattice. */
+  unsigned int x_res, y_res, z_res;
+  /** The absolute position of the first lattice sample. */
+  mcVec3 min;
+  /** The distance between adjacent lattice samples along each axis. */
+  float delta_x, delta_y, delta_z;
+  /** The z coordinate of the current lattice slice. */
+  int z;
+  /** The index within the ring buffer of the current lattice slice. */
+  int slice;
+  /** Scratch memory kept by the lattice sampler between slices, or NULL. */
+  void *scratch;
+} mcSampleSlices;
+
+/**
+ * Initializes the sample slice buffer and samples the first two lattice
+ * slices. The buffer starts positioned at z = -1, so the first call to
+ * mcSampleSlices_advance() makes lattice slice 0 the current slice.
+ *
+ * \param self The sample slice buffer to initialize.
+ * \param sf The scalar field to sample, which may be
+ * mcScalarFieldDescriptor_scalarField() with a descriptor as \p args.
+ * \param args Auxiliary arguments for the scalar field function.
+ * \param x_res The number of samples in the lattice parallel to the x-axis.
+ * \param y_res The number of samples in the lattice parallel to the y-axis.
+ * \param z_res The number of samples in the lattice parallel to the z-axis.
+ * \param min The absolute position of the first lattice sample.
+ * \param max The absolute position of the last lattice sample.
+ */
+void mcSampleSlices_init(mcSampleSlices *self,
+    mcScalarFieldWithArgs sf, const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max);
+
+/**
+ * Frees the memory held by the sample slice buffer.
+ */
+void mcSampleSlices_destroy(mcSampleSlices *self);
+
+/**
+ * Moves the current slice one step along the z-axis and samples the lattice
+ * slice two steps ahead of the new current slice, if it exists.
+ */
+void mcSampleSlices_advance(mcSampleSlices *self);
+
+/**
+ * Returns the sample at the given lattice coordinates.
+ *
+ * \param self The sample slice buffer.
+ * \param x The x coordinate of the sample in the lattice.
+ * \param y The y coordinate of the sample in the lattice.
+ * \param dz The z coordinate of the sample relative to the current slice,
+ * from -1 to 2 inclusive.
+ */
+static inline float mcSampleSlices_value(const mcSampleSlices *self,
+    unsigned int x, unsigned int y, int dz)
+{
+  int slice = (self->slice + dz + MC_SAMPLE_SLICES_NUM_SLICES)
+    % MC_SAMPLE_SLICES_NUM_SLICES;
+  return self->samples[x + y * self->x_res
+    + slice * self->x_res * self->y_res];
+}
+
+/**
+ * Estimates the gradient of the scalar field at the given lattice sample by
+ * central differences of the buffered samples. One-sided differences are used
+ * at the boundaries of the lattice. No additional scalar field evaluations are
+ * made.
+ *
+ * \param self The sample slice buffer.
+ * \param x The x coordinate of the sample in the lattice.
+ * \param y The y coordinate of the sample in the lattice.
+ * \param dz The z coordinate of the sample relative to the current slice,
+ * from 0 to 1 inclusive.
+ * \param gradient Location in which to store the estimated gradient.
+ */
+void mcSampleSlices_gradient(const mcSampleSlices *self,
+    unsigned int x, unsigned int y, int dz,
+    mcVec3 *gradient);
+
+/** @} */
+
+/** @} */
+
+/** @} */
+
+/** @} */
+
+#endif
@@ -48,6 +48,8 @@
  * @{
  */
 
+#include <stdint.h>
+
 #include <mc/vector.h>
 #include <mc/isosurfaceBuilder.h>  /* FIXME: This should be mc/scalarField.h */
 
@@ -80,79 +82,39 @@ typedef enum mcSurfaceNodePos {
  */
 mcSurfaceNodePos mcSurfaceNodePos_opposite(mcSurfaceNodePos pos);
 
-typedef struct mcSurfaceNode mcSurfaceNode;
-/**
- * Struct representing a single node in a surface net. This struct stores all
- * of the information needed to associate a surface node with its neighbors and
- * adjust its position accordingly.
- */
-struct mcSurfaceNode {
-  mcSurfaceNode *neighbors[6];
-  mcVec3 pos, oldPos;
-  unsigned int latticePos[3];
-  unsigned int vertexIndex;
-};
-
-/**
- * Initilaizes the given surface node. Surface nodes do not use any dynamically
- * allocated memory, so this routine simply initializes the node neighbor
- * pointers to NULL.
- *
- * \param self The surface node structure to initialize.
- */
-void mcSurfaceNode_init(mcSurfaceNode *self);
+/** Neighbor index value indicating that a surface node has no neighbor in a
+ * given direction. */
+#define MC_SURFACE_NET_NO_NEIGHBOR -1
 
-/**
- * Destroys the given surface node.
- *
- * \param self The surface node structure to destroy.
- *
- * \todo It might be nice if the surface node destructor cleared up any
- * pointers that neighbors have to this node. This behavior is not yet needed
- * at this time, and might harm performance when the surface net itself is
- * destroyed.
- */
-void mcSurfaceNode_destroy(mcSurfaceNode *self);
+/** The initial number of surface nodes allocated in the mcSurfaceNet
+ * structure. */
+extern const int MC_SURFACE_NET_INIT_SIZE_NODES;
 
 /**
- * Adds a neighbor in the given direction to the given surface node.
- */
-void mcSurfaceNode_addNeighbor(
-    mcSurfaceNode *self, mcSurfaceNode *neighbor, mcSurfaceNodePos pos);
-
-/**
- * Sets the vertex position of the given surface node.
- */
-void mcSurfaceNode_setPosition(mcSurfaceNode *self, mcVec3 *pos);
-
-/** The number of surface nodes that are allocated per node block in the
- * mcSurfaceNet structure. */
-extern const int MC_SURFACE_NET_NODES_PER_BLOCK;
-/** The initial size of the node pool in the mcSurfaceNet structure. */
-extern const int MC_SURFACE_NET_INIT_POOL_SIZE;
-
-/**
- * The surface net is structured as a pool of surface nodes which are allocated
- * as needed.
- *
- * The surface nodes themselves use pointers to represent the graph, making it
- * prohibitively expensive to move surface nodes around in memory.
- * mcSurfaceNet is structured to avoid moving surface nodes as the number of
- * nodes increases.
+ * The surface net is structured as a set of parallel arrays, with one entry
+ * per surface node. Surface nodes refer to their neighbors by index rather
+ * than by pointer, so the arrays are free to move in memory as they grow.
+ * Storing each attribute contiguously keeps the iterative relaxation loops of
+ * the various surface net algorithms simple enough to be vectorized.
  */
 typedef struct mcSurfaceNet {
-  /** Pool of pointers to node blocks in the surface net. This pool is expected
-   * to grow as the surface net is built. The memory pointed to by these
-   * pointers is never re-allocated, since the structure of the surface net
-   * depends on these memory addresses remaining valid. */
-  mcSurfaceNode **nodePool;
-  /** The number of pointers that the node pool currently has allocated. */
-  unsigned int poolSize;
-  /** The number of blocks that are currently allocated and for which we have
-   * pointers to in the node pool. */
-  unsigned int numBlocks;
+  /** The current position of each surface node. */
+  mcVec3 *pos;
+  /** The previous position of each surface node, for iterative algorithms.
+   * See mcSurfaceNet_updateOldPos(). */
+  mcVec3 *oldPos;
+  /** Six neighbor indices per surface node, indexed by mcSurfaceNodePos.
+   * Missing neighbors are given as MC_SURFACE_NET_NO_NEIGHBOR. */
+  int32_t *neighbors;
+  /** Three lattice coordinates per surface node, giving the position of the
+   * voxel cube containing the node. */
+  unsigned int *latticePos;
+  /** The mesh vertex index generated for each surface node. */
+  unsigned int *vertexIndices;
   /** The actual number of nodes that have been added to the surface net. */
   unsigned int numNodes;
+  /** The number of nodes for which memory is currently allocated. */
+  unsigned int sizeNodes;
 } mcSurfaceNet;
 
 /**
@@ -214,40 +176,48 @@ void mcSurfaceNet_build(mcSurfaceNet *self,
 void mcSurfaceNet_updateOldPos(mcSurfaceNet *self);
 
 /**
- * Doubles the number of node block pointers that can be referred to by this
+ * Doubles the number of surface nodes for which memory is allocated in this
  * surface net.
  *
- * \param self The surface net structure whose node block pool data structure
- * is to be doubled.
+ * \param self The surface net structure whose node arrays are to be doubled.
  */
-void mcSurfaceNet_growBlockPool(mcSurfaceNet *self);
+void mcSurfaceNet_growNodes(mcSurfaceNet *self);
 
 /**
- * Allocates a block of memory for storing more surface net nodes in this
- * surface net.
+ * Adds a surface node to the surface net. The new node has no neighbors.
  *
- * \param self The surface net structure to which we are adding a node block.
+ * \param self The surface net structure to which we are adding a new surface
+ * node.
+ * \param pos The initial position of the new surface node.
+ * \param x The x coordinate of the voxel cube containing the node.
+ * \param y The y coordinate of the voxel cube containing the node.
+ * \param z The z coordinate of the voxel cube containing the node.
+ * \return The index of the newly added surface node.
  */
-void mcSurfaceNet_addNodeBlock(mcSurfaceNet *self);
+unsigned int mcSurfaceNet_addNode(mcSurfaceNet *self, const mcVec3 *pos,
+    unsigned int x, unsigned int y, unsigned int z);
 
 /**
- * Returns a pointer to the surface node at the given surface node index.
+ * Connects two surface nodes in the surface net. The neighbor relationship is
+ * recorded in both directions.
  *
- * \param self The surface node structure whose surface node we are retrieving.
- * \param i The index of the surface node we are accessing.
- * \return A pointer to the surface node at index \p i.
+ * \param self The surface net structure containing the surface nodes.
+ * \param node The index of the surface node gaining a neighbor.
+ * \param neighbor The index of the neighboring surface node.
+ * \param pos The direction of the neighbor relative to \p node.
  */
-mcSurfaceNode *mcSurfaceNet_getNode(mcSurfaceNet *self, unsigned int i);
+void mcSurfaceNet_addNeighbor(mcSurfaceNet *self,
+    unsigned int node, unsigned int neighbor, mcSurfaceNodePos pos);
 
 /**
- * Adds a surface node to the surface net and returns a pointer to the memory
- * for that new surface node.
- *
- * \param self The surface node structure to which we are adding a new surface
- * node.
- * \return A pointer to the newly added surface node.
+ * Returns the index of the neighbor of the given surface node in the given
+ * direction, or MC_SURFACE_NET_NO_NEIGHBOR if there is no such neighbor.
  */
-mcSurfaceNode *mcSurfaceNet_getNextNode(mcSurfaceNet *self);
+static inline int mcSurfaceNet_neighbor(const mcSurfaceNet *self,
+    unsigned int node, mcSurfaceNodePos pos)
+{
+  return self->neighbors[node * 6 + pos];
+}
 
 /** @} */
 
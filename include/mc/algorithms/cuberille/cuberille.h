@@ -34,6 +34,9 @@ typedef struct mcCuberilleParams {
   /** This field \em must be set to the value MC_CUBERILLE_PARAMS or a runtime
    * error will occur. */
   mcAlgorithmParamsType type;
+  /** If nonzero, each square face of the cuberille surface is split into two
+   * triangles. Otherwise, the faces are given as quads. */
+  int triangulate;
 } mcCuberilleParams;
 
 /**
@@ -48,7 +51,8 @@ void mcCuberilleParams_default(mcCuberilleParams *params);
 /**
  * This routine implements the "cuberille" isosurface extraction algorithm as
  * described in FIXME.  This algorithm is the precursor to elastic surface nets
- * and other "dual" methods.
+ * and other "dual" methods. If \p params is NULL, the default parameters are
+ * used.
  *
  * \todo Find a good reference for the cuberille isosurface extraction
  * algorithm.
@@ -57,7 +61,7 @@ void mcCuberille_isosurfaceFromField(
     mcScalarFieldWithArgs sf, const void *args,
     unsigned int res_x, unsigned int res_y, unsigned int res_z,
     const mcVec3 *min, const mcVec3 *max,
-    mcCuberilleParams *params,
+    const mcCuberilleParams *params,
     mcMesh *mesh);
 
 #endif
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_ALGORITHMS_CUBES33_COMMON_H_
+#define MC_ALGORITHMS_CUBES33_COMMON_H_
+
+/**
+ * The number of face tests in Marching Cubes 33, one for each cube face.
+ * Face test i corresponds to bit i of the entries in mcCubes33_testTable.
+ */
+#define MC_CUBES33_NUM_FACE_TESTS 6
+
+/**
+ * The number of interior tests in Marching Cubes 33. Interior tests slice the
+ * cube perpendicular to the z-axis and look for a slice in which two diagonal
+ * z-axis cube edges are connected through the cube interior. Interior test i
+ * corresponds to bit (MC_CUBES33_NUM_FACE_TESTS + i) of the entries in
+ * mcCubes33_testTable.
+ *
+ * Bit 1 of the interior test index selects the diagonal: samples 0 and 3 at
+ * the bottom of the z-axis edges for 0, samples 1 and 2 for 1. Bit 0 selects
+ * the side of the isosurface being connected: inside for 0, outside for 1.
+ */
+#define MC_CUBES33_NUM_INTERIOR_TESTS 4
+
+/**
+ * The total number of tests that can apply to a cube configuration.
+ */
+#define MC_CUBES33_NUM_TESTS \
+  (MC_CUBES33_NUM_FACE_TESTS + MC_CUBES33_NUM_INTERIOR_TESTS)
+
+/**
+ * The edge intersection index used in the triangle tables for a vertex at the
+ * center of the isosurface within the cube. Disks and tubes that cannot be
+ * triangulated without a triangle edge lying in a cube face are fanned around
+ * such a vertex, placed at the average of the edge intersections given by
+ * mcCubes33_centerTable.
+ */
+#define MC_CUBES33_CENTER_VERTEX 12
+
+#endif
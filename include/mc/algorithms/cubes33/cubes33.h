@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_ALGORITHMS_CUBES33_CUBES33_H_
+#define MC_ALGORITHMS_CUBES33_CUBES33_H_
+
+#include <mc/isosurfaceBuilder.h>
+
+/**
+ * Decides the tests for the given cube configuration and returns the index of
+ * the resulting subcase relative to the first subcase of that configuration.
+ *
+ * \param tests The tests that apply to the cube configuration, as given by
+ * mcCubes33_testTable.
+ * \param values The eight sample values of the cube, in cube sample order.
+ * \return The results of the tests that apply, packed into consecutive bits
+ * in order of increasing test number.
+ */
+unsigned int mcCubes33_subcase(unsigned int tests, const float *values);
+
+/**
+ * This routine implements Marching Cubes 33, which resolves the ambiguous
+ * faces and the ambiguous cube interiors of marching cubes according to the
+ * trilinear interpolant of the samples. The resulting mesh is free of holes
+ * and matches the topology of the trilinear interpolant.
+ *
+ * Cube configurations without any ambiguity use a single subcase and take the
+ * same path as simple marching cubes.
+ */
+void mcCubes33_isosurfaceFromField(
+    mcScalarFieldWithArgs sf, const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max,
+    mcMesh *mesh);
+
+#endif
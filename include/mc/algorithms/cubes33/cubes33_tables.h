@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_ALGORITHMS_CUBES33_CUBES33_TABLES_H_
+#define MC_ALGORITHMS_CUBES33_CUBES33_TABLES_H_
+
+#include <mc/algorithms/cubes33/common.h>
+
+/**
+ * The tests that apply to each cube configuration. Bit i is set if face test i
+ * applies, and bit (MC_CUBES33_NUM_FACE_TESTS + i) is set if interior test i
+ * applies. This table is generated by
+ * src/mc/algorithms/cubes33/generate_tables.c.
+ */
+extern const unsigned short mcCubes33_testTable[];
+
+/**
+ * The index of the first subcase of each cube configuration. A configuration
+ * with n tests that apply has 2^n subcases, one for each combination of test
+ * results.
+ */
+extern const unsigned short mcCubes33_subcaseTable[];
+
+/**
+ * The offset of the first triangle of each subcase in
+ * mcCubes33_triangleTable. The triangles of subcase i end where those of
+ * subcase i + 1 begin.
+ */
+extern const unsigned int mcCubes33_triangleOffsetTable[];
+
+/**
+ * The edge intersections averaged to place the center vertex
+ * MC_CUBES33_CENTER_VERTEX of each subcase, with edge i in bit i. This is zero
+ * for subcases without a center vertex.
+ */
+extern const unsigned short mcCubes33_centerTable[];
+
+/**
+ * The triangles of all subcases packed into a single byte array, with three
+ * edge intersections per triangle.
+ */
+extern const unsigned char mcCubes33_triangleTable[];
+
+#endif
@@ -24,13 +24,16 @@
 #ifndef MC_ALGORITHMS_DUAL_MARCHING_CUBES_DUAL_MARCHING_CUBES_H_
 #define MC_ALGORITHMS_DUAL_MARCHING_CUBES_DUAL_MARCHING_CUBES_H_
 
+#include <mc/isosurfaceBuilder.h>
+
 /**
  * This routine implements the Dual Marching Cubes algorithm as descirbed by
  * Nielson.
  *
- * This implementation utilizes the MC-Patch algorithm. Future optimization can
- * eliminate the use of the MC-Patch algorithm and directly compute the MC-Dual
- * surface as described by Nielson.
+ * The MC-Dual surface is computed directly, without building the MC-Patch
+ * mesh: each marching cubes patch becomes a dual vertex as soon as its voxel
+ * cube is visited, and the dual face about an edge intersection is emitted as
+ * soon as the last voxel cube sharing that edge has been visited.
  */
 void mcDualMarchingCubes_isosurfaceFromField(
     mcScalarFieldWithArgs sf, const void *args,
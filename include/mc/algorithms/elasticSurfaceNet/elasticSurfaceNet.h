@@ -24,10 +24,45 @@
 #ifndef MC_ALGORITHMS_ELASTIC_SURFACE_NET_ELASTIC_SURFACE_NET_H_
 #define MC_ALGORITHMS_ELASTIC_SURFACE_NET_ELASTIC_SURFACE_NET_H_
 
+#include <mc/isosurfaceBuilder.h>
+
+/**
+ * A parameter structure that can optionally be passed into the elastic
+ * surface net isosurface extraction algorithm.
+ */
+typedef struct mcElasticSurfaceNetParams {
+  /** This field \em must be set to the value MC_ELASTIC_SURFACE_NET_PARAMS or
+   * a runtime error will occur. */
+  mcAlgorithmParamsType type;
+  /** The maximum number of relaxation iterations to perform. */
+  unsigned int maxIterations;
+  /** How far each surface node moves towards the midpoint of its neighbors in
+   * each iteration, between 0.0 and 1.0. */
+  float weight;
+  /** Relaxation stops early once an iteration reduces the total energy of
+   * the surface net by less than this fraction. */
+  float energyTolerance;
+} mcElasticSurfaceNetParams;
+
+/**
+ * Initializes the given \p params structure with the default parameters for
+ * the elastic surface net isosurface extraction algorithm.
+ *
+ * The specific values of these default parameters depends on the version of
+ * the libmc library used.
+ */
+void mcElasticSurfaceNetParams_default(mcElasticSurfaceNetParams *params);
+
+/**
+ * This routine implements the Elastic Surface Net algorithm for extracting
+ * isosurfaces as described by Gibson. If \p params is NULL, the default
+ * parameters are used.
+ */
 void mcElasticSurfaceNet_isosurfaceFromField(
     mcScalarFieldWithArgs sf, const void *args,
     unsigned int res_x, unsigned int res_y, unsigned int res_z,
     const mcVec3 *min, const mcVec3 *max,
+    const mcElasticSurfaceNetParams *params,
     mcMesh *mesh);
 
 #endif
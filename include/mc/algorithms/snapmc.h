@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_ALGORITHMS_SNAPMC_H_
+#define MC_ALGORITHMS_SNAPMC_H_
+
+/**
+ * \addtogroup libmc
+ * @{
+ */
+
+/**
+ * \addtogroup algorithms
+ * @{
+ */
+
+/**
+ * \defgroup snapmc SnapMC
+ *
+ * This is the SnapMC isosurface extraction algorithm, as described by Raman
+ * and Wenger \cite journals/cgf/RamanW08
+ */
+
+/**
+ * \addtogroup snapmc
+ * @{
+ */
+
+/** \file mc/algorithms/snapmc.h
+ *
+ * This is a convenience header which includes all of the headers needed to use
+ * the SnapMC isosurface extraction algorithm. See the documentation for each
+ * of these included files for more information.
+ */
+
+#include <mc/algorithms/snapmc/snapmc.h>
+
+/** @} */
+
+/** @} */
+
+/** @} */
+
+#endif
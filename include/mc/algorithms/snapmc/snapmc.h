@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_ALGORITHMS_SNAPMC_SNAPMC_H_
+#define MC_ALGORITHMS_SNAPMC_SNAPMC_H_
+
+#include <mc/isosurfaceBuilder.h>
+
+/**
+ * A parameter structure that can optionally be passed into the SnapMC
+ * isosurface extraction algorithm.
+ */
+typedef struct mcSnapMCParams {
+  /** This field \em must be set to the value MC_SNAP_MC_PARAMS or a runtime
+   * error will occur. */
+  mcAlgorithmParamsType type;
+  /** How close an edge intersection must be to a lattice point, as a fraction
+   * of the edge length, for the sample at that lattice point to be snapped to
+   * the isovalue. Values from zero (plain marching cubes) up to one half are
+   * sensible; larger values remove more small triangles but move the surface
+   * further from the interpolated edge intersections. */
+  float snapThreshold;
+} mcSnapMCParams;
+
+/**
+ * Initializes the given \p params structure with the default parameters for
+ * the SnapMC isosurface extraction algorithm.
+ *
+ * The specific values of these default parameters depends on the version of
+ * the libmc library used.
+ */
+void mcSnapMCParams_default(mcSnapMCParams *params);
+
+/**
+ * This routine implements the SnapMC isosurface extraction algorithm
+ * described by Raman and Wenger. \cite journals/cgf/RamanW08
+ *
+ * Any lattice point with an edge intersection closer than the snap threshold
+ * to it is snapped to the isovalue, so the isosurface passes through that
+ * lattice point. The edge intersections on the edges incident to a snapped
+ * point all coincide with the lattice point and are merged into a single mesh
+ * vertex. Triangles that collapse as a result are discarded. Marching cubes
+ * produces many thin slivers wherever the isosurface passes close to a lattice
+ * point; SnapMC replaces them with fewer, better shaped triangles. If
+ * \p params is NULL, the default parameters are used.
+ *
+ * Rather than the extended lookup tables of Raman and Wenger, this
+ * implementation snaps the vertices of the marching cubes mesh, and skips any
+ * snap that would make the mesh non-manifold around the snapped vertex. The
+ * resulting mesh is therefore manifold wherever the marching cubes mesh is.
+ * The whole marching cubes mesh is kept in memory until snapping is done.
+ */
+void mcSnapMC_isosurfaceFromField(
+    mcScalarFieldWithArgs sf, const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max,
+    const mcSnapMCParams *params,
+    mcMesh *mesh);
+
+#endif
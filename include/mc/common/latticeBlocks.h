@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_COMMON_LATTICE_BLOCKS_H_
+#define MC_COMMON_LATTICE_BLOCKS_H_
+
+/*
+ * A recursive splitter shared by the lattice samplers that can prove parts of
+ * the lattice empty. The lattice is split in half along its longest axis
+ * until the blocks are small, and a bound callback is asked about each block
+ * on the way down. Blocks that the callback proves cannot contain the
+ * isosurface are filled with a single value of the right sign instead of
+ * being sampled. The callback may also narrow its arguments to a block, for
+ * instance by pruning a program to the parts that matter inside it, and the
+ * narrowed arguments are used for everything within that block.
+ */
+
+#include <mc/vector.h>
+
+struct mcLatticeBlocks;
+
+/**
+ * Bounds the field over the block of the lattice from start up to but not
+ * including end. Returns nonzero and stores a value on the same side of the
+ * isosurface as the whole block in \p value if the isosurface cannot pass
+ * near the block. Otherwise, it may store arguments narrowed to the block in
+ * \p narrowed, which are used for the samples and smaller blocks within it
+ * and then passed to the release callback.
+ */
+typedef int (*mcLatticeBlockBound)(
+    const void *args,
+    const struct mcLatticeBlocks *lattice,
+    const unsigned int *start, const unsigned int *end,
+    float *value,
+    void **narrowed);
+
+/**
+ * Evaluates every sample of the block of the lattice from start up to but not
+ * including end.
+ */
+typedef void (*mcLatticeBlockSample)(
+    const void *args,
+    const struct mcLatticeBlocks *lattice,
+    const unsigned int *start, const unsigned int *end);
+
+/**
+ * Frees arguments narrowed to a block by the bound callback.
+ */
+typedef void (*mcLatticeBlockRelease)(void *narrowed);
+
+/**
+ * A lattice being sampled block by block. The callbacks receive blocks in the
+ * lattice coordinates of the whole lattice, whose first sample lies at min.
+ */
+typedef struct mcLatticeBlocks {
+  /** The position of the first sample of the whole lattice. */
+  mcVec3 min;
+  /** The distance between samples along each axis. */
+  mcVec3 delta;
+  /** The lattice coordinates of the first sample to evaluate. */
+  unsigned int start[3];
+  /** The number of samples to evaluate along each axis. */
+  unsigned int res[3];
+  /** Receives the samples from start up to but not including start + res,
+   * with x varying fastest. */
+  float *samples;
+  /** Blocks with at most this many samples are sampled without splitting
+   * them further. */
+  unsigned int leafSize;
+  mcLatticeBlockBound bound;
+  mcLatticeBlockSample sample;
+  /** Frees narrowed arguments, or NULL if the bound never narrows them. */
+  mcLatticeBlockRelease release;
+} mcLatticeBlocks;
+
+/**
+ * Returns the sample at the given lattice coordinates. The samples of a row
+ * follow each other along the x-axis.
+ */
+static inline float *mcLatticeBlocks_sample(
+    const mcLatticeBlocks *self,
+    unsigned int x, unsigned int y, unsigned int z)
+{
+  return &self->samples[
+    ((size_t)(z - self->start[2]) * self->res[1] + (y - self->start[1]))
+    * self->res[0] + (x - self->start[0])];
+}
+
+/**
+ * Samples the lattice from start up to but not including start + res,
+ * skipping the blocks that the bound callback proves empty.
+ */
+void mcLatticeBlocks_evaluate(
+    const mcLatticeBlocks *self,
+    const void *args);
+
+#endif
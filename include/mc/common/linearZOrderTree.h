@@ -0,0 +1,442 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_COMMON_LINEAR_Z_ORDER_TREE_H_
+#define MC_COMMON_LINEAR_Z_ORDER_TREE_H_
+
+/*
+ * Linear quadtrees and octrees. Unlike the trees of mc/common/zOrderNode.h,
+ * whose nodes are allocated one at a time and linked by pointers, these trees
+ * keep every node in a single growing pool, link nodes by their indices in
+ * that pool, and address nodes by 64-bit Morton keys. The key of the root
+ * node is 1, and the key of each child is the key of its parent followed by
+ * the DIMENSION bits of its child index. Point location and neighbor finding
+ * compute the key they are looking for and follow its bits down the tree,
+ * without recursion. Building a tree costs no allocation per node, and
+ * destroying it frees a single array.
+ *
+ * A tree of level L covers the node coordinates from 0 up to but not
+ * including 2^L along each axis, and node levels and positions follow the
+ * same conventions as mcOctNode and mcQuadNode. The iterators visit nodes in
+ * the same order as the mcOctNode and mcQuadNode iterators: each node before
+ * its children, and children in order of their index.
+ *
+ * Node pointers returned by these routines remain valid until the next node
+ * is added to the tree.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mc/common/morton.h>
+#include <mc/common/zOrderNode.h>
+
+#define MC_DECLARE_LINEAR_Z_ORDER_TREE(PREFIX, DIMENSION) \
+typedef uint64_t mc ## PREFIX ## Key; \
+typedef struct { \
+  /* The Morton key of this node, which is also its location in the tree */ \
+  mc ## PREFIX ## Key key; \
+  /* The indices of the children and parent of this node in the node pool. \
+   * The root node is never a child, so index zero marks a missing child. */ \
+  unsigned int children[1 << DIMENSION]; \
+  unsigned int parent; \
+  mc ## PREFIX ## NodeCoordinates pos; \
+  int level; \
+  float value; \
+  /* Auxiliary data owned by the algorithm using the tree */ \
+  void *data; \
+} mc ## PREFIX ## TreeNode; \
+\
+typedef struct { \
+  /* The node pool, with the root first */ \
+  mc ## PREFIX ## TreeNode *nodes; \
+  unsigned int numNodes, sizeNodes; \
+  int level; \
+} mc ## PREFIX ## Tree; \
+\
+typedef struct { \
+  const mc ## PREFIX ## Tree *tree; \
+  const mc ## PREFIX ## TreeNode *current; \
+} mc ## PREFIX ## TreeIterator; \
+\
+void mc ## PREFIX ## Tree_init(mc ## PREFIX ## Tree *self, int level); \
+void mc ## PREFIX ## Tree_destroy(mc ## PREFIX ## Tree *self); \
+mc ## PREFIX ## Key mc ## PREFIX ## Tree_encode( \
+    const mc ## PREFIX ## Tree *self, \
+    const mc ## PREFIX ## NodeCoordinates *pos, \
+    int level); \
+void mc ## PREFIX ## Tree_decode( \
+    const mc ## PREFIX ## Tree *self, \
+    mc ## PREFIX ## Key key, \
+    mc ## PREFIX ## NodeCoordinates *pos, \
+    int *level); \
+mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_getRoot( \
+    mc ## PREFIX ## Tree *self); \
+mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_find( \
+    const mc ## PREFIX ## Tree *self, \
+    mc ## PREFIX ## Key key); \
+mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_getChild( \
+    const mc ## PREFIX ## Tree *self, \
+    const mc ## PREFIX ## TreeNode *node, \
+    int index); \
+mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_getParent( \
+    const mc ## PREFIX ## Tree *self, \
+    const mc ## PREFIX ## TreeNode *node); \
+mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_createChild( \
+    mc ## PREFIX ## Tree *self, \
+    const mc ## PREFIX ## TreeNode *node, \
+    int index); \
+mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_getNode( \
+    mc ## PREFIX ## Tree *self, \
+    const mc ## PREFIX ## NodeCoordinates *pos, \
+    int level); \
+mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_getNodeContainingPos( \
+    const mc ## PREFIX ## Tree *self, \
+    const mc ## PREFIX ## NodeCoordinates *pos); \
+mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_getNeighbor( \
+    const mc ## PREFIX ## Tree *self, \
+    const mc ## PREFIX ## TreeNode *node, \
+    int axis, int direction); \
+mc ## PREFIX ## TreeIterator mc ## PREFIX ## Tree_begin( \
+    const mc ## PREFIX ## Tree *self); \
+mc ## PREFIX ## TreeIterator mc ## PREFIX ## Tree_end( \
+    const mc ## PREFIX ## Tree *self); \
+\
+void mc ## PREFIX ## TreeIterator_next(mc ## PREFIX ## TreeIterator *self); \
+int mc ## PREFIX ## TreeIterator_equals( \
+    const mc ## PREFIX ## TreeIterator *self, \
+    mc ## PREFIX ## TreeIterator other);
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_insert(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_init(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_destroy(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_encode(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_decode(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_getRoot(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_find(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_getChild(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_getParent(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_createChild(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_getNode(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_getNodeContainingPos(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_getNeighbor(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_begin(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_end(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_ITERATOR_next(PREFIX, DIMENSION) \
+  MC_DEFINE_LINEAR_Z_ORDER_TREE_ITERATOR_equals(PREFIX, DIMENSION)
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_insert(PREFIX, DIMENSION) \
+  mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_insert( \
+      mc ## PREFIX ## Tree *self, \
+      mc ## PREFIX ## Key key, \
+      unsigned int parent, \
+      const mc ## PREFIX ## NodeCoordinates *pos, \
+      int level) \
+  { \
+    if (self->numNodes >= self->sizeNodes) { \
+      /* Double the size of the node pool */ \
+      mc ## PREFIX ## TreeNode *newNodes = (mc ## PREFIX ## TreeNode *)malloc( \
+          sizeof(mc ## PREFIX ## TreeNode) * self->sizeNodes * 2); \
+      memcpy(newNodes, self->nodes, \
+          sizeof(mc ## PREFIX ## TreeNode) * self->sizeNodes); \
+      free(self->nodes); \
+      self->nodes = newNodes; \
+      self->sizeNodes *= 2; \
+    } \
+    mc ## PREFIX ## TreeNode *node = &self->nodes[self->numNodes++]; \
+    node->key = key; \
+    for (int i = 0; i < (1 << DIMENSION); ++i) \
+      node->children[i] = 0; \
+    node->parent = parent; \
+    node->pos = *pos; \
+    node->level = level; \
+    node->value = 0.0f; \
+    node->data = NULL; \
+    return node; \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_init(PREFIX, DIMENSION) \
+  void mc ## PREFIX ## Tree_init(mc ## PREFIX ## Tree *self, int level) { \
+    static const unsigned int INIT_NUM_NODES = 64; \
+    /* Keys hold DIMENSION bits per level below the root, after a leading \
+     * one bit that marks where the key begins */ \
+    assert(level >= 0 && level < 31 && level * DIMENSION < 64); \
+    self->level = level; \
+    self->nodes = (mc ## PREFIX ## TreeNode *)malloc( \
+        sizeof(mc ## PREFIX ## TreeNode) * INIT_NUM_NODES); \
+    self->numNodes = 0; \
+    self->sizeNodes = INIT_NUM_NODES; \
+    /* The root node has the key 1 */ \
+    mc ## PREFIX ## NodeCoordinates origin; \
+    for (int i = 0; i < DIMENSION; ++i) \
+      origin.coord[i] = 0; \
+    mc ## PREFIX ## Tree_insert(self, 1, 0, &origin, level); \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_destroy(PREFIX, DIMENSION) \
+  void mc ## PREFIX ## Tree_destroy(mc ## PREFIX ## Tree *self) { \
+    /* The auxiliary data pointers are left for the caller to free */ \
+    free(self->nodes); \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_encode(PREFIX, DIMENSION) \
+  mc ## PREFIX ## Key mc ## PREFIX ## Tree_encode( \
+      const mc ## PREFIX ## Tree *self, \
+      const mc ## PREFIX ## NodeCoordinates *pos, \
+      int level) \
+  { \
+    assert(level >= 0 && level <= self->level); \
+    for (int i = 0; i < DIMENSION; ++i) \
+      assert(pos->coord[i] >= 0 && pos->coord[i] < (1 << self->level)); \
+    /* Drop the bits below the level of the node and mark the start of the \
+     * key with a leading one bit */ \
+    int depth = self->level - level; \
+    return ((mc ## PREFIX ## Key)1 << (DIMENSION * depth)) \
+      | (mcMorton_encode(pos->coord, DIMENSION) >> (DIMENSION * level)); \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_decode(PREFIX, DIMENSION) \
+  void mc ## PREFIX ## Tree_decode( \
+      const mc ## PREFIX ## Tree *self, \
+      mc ## PREFIX ## Key key, \
+      mc ## PREFIX ## NodeCoordinates *pos, \
+      int *level) \
+  { \
+    assert(key != 0); \
+    /* Each level below the root adds DIMENSION bits after the leading one */ \
+    int depth = mcMorton_highestBit(key) / DIMENSION; \
+    *level = self->level - depth; \
+    mcMorton_decode(key ^ ((mc ## PREFIX ## Key)1 << (DIMENSION * depth)), \
+        pos->coord, DIMENSION); \
+    for (int i = 0; i < DIMENSION; ++i) \
+      pos->coord[i] <<= *level; \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_getRoot(PREFIX, DIMENSION) \
+  mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_getRoot( \
+      mc ## PREFIX ## Tree *self) \
+  { \
+    return &self->nodes[0]; \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_find(PREFIX, DIMENSION) \
+  mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_find( \
+      const mc ## PREFIX ## Tree *self, \
+      mc ## PREFIX ## Key key) \
+  { \
+    assert(key != 0); \
+    /* Follow the child indices held in the key down from the root */ \
+    int depth = mcMorton_highestBit(key) / DIMENSION; \
+    mc ## PREFIX ## TreeNode *node = &self->nodes[0]; \
+    for (int shift = DIMENSION * (depth - 1); shift >= 0; \
+        shift -= DIMENSION) \
+    { \
+      int index = (int)((key >> shift) & ((1u << DIMENSION) - 1)); \
+      if (node->children[index] == 0) \
+        return NULL; \
+      node = &self->nodes[node->children[index]]; \
+    } \
+    return node; \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_getChild(PREFIX, DIMENSION) \
+  mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_getChild( \
+      const mc ## PREFIX ## Tree *self, \
+      const mc ## PREFIX ## TreeNode *node, \
+      int index) \
+  { \
+    if (node->children[index] == 0) \
+      return NULL; \
+    return &self->nodes[node->children[index]]; \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_getParent(PREFIX, DIMENSION) \
+  mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_getParent( \
+      const mc ## PREFIX ## Tree *self, \
+      const mc ## PREFIX ## TreeNode *node) \
+  { \
+    if (node->key == 1) \
+      return NULL;  /* The root node has no parent */ \
+    return &self->nodes[node->parent]; \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_createChild(PREFIX, DIMENSION) \
+  mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_createChild( \
+      mc ## PREFIX ## Tree *self, \
+      const mc ## PREFIX ## TreeNode *node, \
+      int index) \
+  { \
+    /* Don't overwrite any children */ \
+    assert(node->children[index] == 0); \
+    assert(node->level > 0);  /* Level 0 cannot have children */ \
+    /* Inserting may move the node pool, so note the parent by index */ \
+    unsigned int parent = (unsigned int)(node - self->nodes); \
+    mc ## PREFIX ## NodeCoordinates pos = node->pos; \
+    for (int i = 0; i < DIMENSION; ++i) \
+      pos.coord[i] += ((index >> i) & 1) << (node->level - 1); \
+    mc ## PREFIX ## TreeNode *child = mc ## PREFIX ## Tree_insert(self, \
+        (node->key << DIMENSION) | (mc ## PREFIX ## Key)index, parent, \
+        &pos, node->level - 1); \
+    self->nodes[parent].children[index] = self->numNodes - 1; \
+    return child; \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_getNode(PREFIX, DIMENSION) \
+  mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_getNode( \
+      mc ## PREFIX ## Tree *self, \
+      const mc ## PREFIX ## NodeCoordinates *pos, \
+      int level) \
+  { \
+    mc ## PREFIX ## Key key = mc ## PREFIX ## Tree_encode(self, pos, level); \
+    /* Follow the key down from the root, creating any missing nodes */ \
+    mc ## PREFIX ## TreeNode *node = &self->nodes[0]; \
+    for (int shift = DIMENSION * (self->level - level - 1); shift >= 0; \
+        shift -= DIMENSION) \
+    { \
+      int index = (int)((key >> shift) & ((1u << DIMENSION) - 1)); \
+      if (node->children[index] == 0) \
+        node = mc ## PREFIX ## Tree_createChild(self, node, index); \
+      else \
+        node = &self->nodes[node->children[index]]; \
+    } \
+    return node; \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_getNodeContainingPos(PREFIX, DIMENSION) \
+  mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_getNodeContainingPos( \
+      const mc ## PREFIX ## Tree *self, \
+      const mc ## PREFIX ## NodeCoordinates *pos) \
+  { \
+    for (int i = 0; i < DIMENSION; ++i) { \
+      if (pos->coord[i] < 0 || pos->coord[i] >= (1 << self->level)) \
+        return NULL; \
+    } \
+    /* Follow the key of the level zero node at this position down from the \
+     * root for as long as the nodes exist */ \
+    mc ## PREFIX ## Key key = mc ## PREFIX ## Tree_encode(self, pos, 0); \
+    mc ## PREFIX ## TreeNode *node = &self->nodes[0]; \
+    for (int shift = DIMENSION * (self->level - 1); shift >= 0; \
+        shift -= DIMENSION) \
+    { \
+      int index = (int)((key >> shift) & ((1u << DIMENSION) - 1)); \
+      if (node->children[index] == 0) \
+        break; \
+      node = &self->nodes[node->children[index]]; \
+    } \
+    return node; \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_getNeighbor(PREFIX, DIMENSION) \
+  mc ## PREFIX ## TreeNode *mc ## PREFIX ## Tree_getNeighbor( \
+      const mc ## PREFIX ## Tree *self, \
+      const mc ## PREFIX ## TreeNode *node, \
+      int axis, int direction) \
+  { \
+    assert(axis >= 0 && axis < DIMENSION); \
+    assert(direction == 1 || direction == -1); \
+    /* Step to the node of the same size next to this one */ \
+    mc ## PREFIX ## NodeCoordinates pos = node->pos; \
+    pos.coord[axis] += direction * (1 << node->level); \
+    if (pos.coord[axis] < 0 || pos.coord[axis] >= (1 << self->level)) \
+      return NULL; \
+    mc ## PREFIX ## Key key = \
+      mc ## PREFIX ## Tree_encode(self, &pos, node->level); \
+    /* Climb to the nearest common ancestor, whose key is the longest common \
+     * prefix of both keys */ \
+    mc ## PREFIX ## TreeNode *ancestor = &self->nodes[node - self->nodes]; \
+    int shift = 0; \
+    while (ancestor->key != key >> shift) { \
+      ancestor = &self->nodes[ancestor->parent]; \
+      shift += DIMENSION; \
+    } \
+    /* Return the smallest existing node containing the neighbor on the way \
+     * back down */ \
+    for (shift -= DIMENSION; shift >= 0; shift -= DIMENSION) { \
+      int index = (int)((key >> shift) & ((1u << DIMENSION) - 1)); \
+      if (ancestor->children[index] == 0) \
+        break; \
+      ancestor = &self->nodes[ancestor->children[index]]; \
+    } \
+    return ancestor; \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_begin(PREFIX, DIMENSION) \
+  mc ## PREFIX ## TreeIterator mc ## PREFIX ## Tree_begin( \
+      const mc ## PREFIX ## Tree *self) \
+  { \
+    mc ## PREFIX ## TreeIterator i; \
+    i.tree = self; \
+    i.current = &self->nodes[0]; \
+    return i; \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_end(PREFIX, DIMENSION) \
+  mc ## PREFIX ## TreeIterator mc ## PREFIX ## Tree_end( \
+      const mc ## PREFIX ## Tree *self) \
+  { \
+    mc ## PREFIX ## TreeIterator i; \
+    i.tree = self; \
+    i.current = NULL; \
+    return i; \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_ITERATOR_next(PREFIX, DIMENSION) \
+  void mc ## PREFIX ## TreeIterator_next(mc ## PREFIX ## TreeIterator *self) { \
+    const mc ## PREFIX ## TreeNode *node = self->current; \
+    /* Visit our first child */ \
+    for (int i = 0; i < (1 << DIMENSION); ++i) { \
+      if (node->children[i]) { \
+        self->current = &self->tree->nodes[node->children[i]]; \
+        return; \
+      } \
+    } \
+    /* Otherwise visit the next sibling of the nearest node up the tree that \
+     * has one */ \
+    while (node->key != 1) { \
+      const mc ## PREFIX ## TreeNode *parent = \
+        &self->tree->nodes[node->parent]; \
+      int index = (int)(node->key & ((1u << DIMENSION) - 1)); \
+      for (int i = index + 1; i < (1 << DIMENSION); ++i) { \
+        if (parent->children[i]) { \
+          self->current = &self->tree->nodes[parent->children[i]]; \
+          return; \
+        } \
+      } \
+      node = parent; \
+    } \
+    /* We climbed past the root node, so we're done */ \
+    self->current = NULL; \
+  }
+
+#define MC_DEFINE_LINEAR_Z_ORDER_TREE_ITERATOR_equals(PREFIX, DIMENSION) \
+  int mc ## PREFIX ## TreeIterator_equals( \
+      const mc ## PREFIX ## TreeIterator *self, \
+      mc ## PREFIX ## TreeIterator other) \
+  { \
+    return self->current == other.current; \
+  }
+
+#endif
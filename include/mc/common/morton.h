@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_COMMON_MORTON_H_
+#define MC_COMMON_MORTON_H_
+
+/*
+ * Morton codes, which interleave the bits of two or three integer
+ * coordinates so that sorting by code visits points in Z-order. With BMI2
+ * (for instance with -mbmi2 or -march=native), encoding and decoding are a
+ * single PDEP or PEXT instruction per coordinate. Otherwise they spread and
+ * compact the bits with shifts and masks, in a fixed number of steps rather
+ * than one bit at a time.
+ *
+ * Two dimensional codes hold 32 bits per coordinate, and three dimensional
+ * codes hold 21 bits per coordinate. Bit i of the x coordinate becomes bit
+ * DIMENSION * i of the code, followed by the same bit of y and then z,
+ * matching the child indices of mcQuadNode and mcOctNode.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+#define MC_MORTON_MASK_2D 0x5555555555555555ull
+#define MC_MORTON_MASK_3D 0x1249249249249249ull
+
+/**
+ * Spreads the bits of \p x apart so that each is followed by one zero bit.
+ */
+static inline uint64_t mcMorton_spread2(uint32_t x) {
+#ifdef __BMI2__
+  return _pdep_u64(x, MC_MORTON_MASK_2D);
+#else
+  uint64_t v = x;
+  v = (v | (v << 16)) & 0x0000ffff0000ffffull;
+  v = (v | (v << 8)) & 0x00ff00ff00ff00ffull;
+  v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0full;
+  v = (v | (v << 2)) & 0x3333333333333333ull;
+  v = (v | (v << 1)) & MC_MORTON_MASK_2D;
+  return v;
+#endif
+}
+
+/**
+ * Gathers every other bit of \p v, starting with the lowest. This is the
+ * inverse of mcMorton_spread2().
+ */
+static inline uint32_t mcMorton_compact2(uint64_t v) {
+#ifdef __BMI2__
+  return (uint32_t)_pext_u64(v, MC_MORTON_MASK_2D);
+#else
+  v &= MC_MORTON_MASK_2D;
+  v = (v | (v >> 1)) & 0x3333333333333333ull;
+  v = (v | (v >> 2)) & 0x0f0f0f0f0f0f0f0full;
+  v = (v | (v >> 4)) & 0x00ff00ff00ff00ffull;
+  v = (v | (v >> 8)) & 0x0000ffff0000ffffull;
+  v = (v | (v >> 16)) & 0x00000000ffffffffull;
+  return (uint32_t)v;
+#endif
+}
+
+/**
+ * Spreads the lowest 21 bits of \p x apart so that each is followed by two
+ * zero bits.
+ */
+static inline uint64_t mcMorton_spread3(uint32_t x) {
+#ifdef __BMI2__
+  return _pdep_u64(x, MC_MORTON_MASK_3D);
+#else
+  uint64_t v = x & 0x1fffff;
+  v = (v | (v << 32)) & 0x001f00000000ffffull;
+  v = (v | (v << 16)) & 0x001f0000ff0000ffull;
+  v = (v | (v << 8)) & 0x100f00f00f00f00full;
+  v = (v | (v << 4)) & 0x10c30c30c30c30c3ull;
+  v = (v | (v << 2)) & MC_MORTON_MASK_3D;
+  return v;
+#endif
+}
+
+/**
+ * Gathers every third bit of \p v, starting with the lowest. This is the
+ * inverse of mcMorton_spread3().
+ */
+static inline uint32_t mcMorton_compact3(uint64_t v) {
+#ifdef __BMI2__
+  return (uint32_t)_pext_u64(v, MC_MORTON_MASK_3D);
+#else
+  v &= MC_MORTON_MASK_3D;
+  v = (v | (v >> 2)) & 0x10c30c30c30c30c3ull;
+  v = (v | (v >> 4)) & 0x100f00f00f00f00full;
+  v = (v | (v >> 8)) & 0x001f0000ff0000ffull;
+  v = (v | (v >> 16)) & 0x001f00000000ffffull;
+  v = (v | (v >> 32)) & 0x00000000001fffffull;
+  return (uint32_t)v;
+#endif
+}
+
+static inline uint64_t mcMorton_encode2(uint32_t x, uint32_t y) {
+  return mcMorton_spread2(x) | (mcMorton_spread2(y) << 1);
+}
+
+static inline void mcMorton_decode2(uint64_t code, uint32_t *x, uint32_t *y)
+{
+  *x = mcMorton_compact2(code);
+  *y = mcMorton_compact2(code >> 1);
+}
+
+static inline uint64_t mcMorton_encode3(uint32_t x, uint32_t y, uint32_t z) {
+  return mcMorton_spread3(x)
+    | (mcMorton_spread3(y) << 1)
+    | (mcMorton_spread3(z) << 2);
+}
+
+static inline void mcMorton_decode3(uint64_t code,
+    uint32_t *x, uint32_t *y, uint32_t *z)
+{
+  *x = mcMorton_compact3(code);
+  *y = mcMorton_compact3(code >> 1);
+  *z = mcMorton_compact3(code >> 2);
+}
+
+/**
+ * Encodes the given non-negative coordinates in two or three dimensions. The
+ * z-order node templates call this with a constant dimension, so the
+ * dispatch is folded away.
+ */
+static inline uint64_t mcMorton_encode(const int *coord, int dimension) {
+  switch (dimension) {
+    case 2:
+      return mcMorton_encode2((uint32_t)coord[0], (uint32_t)coord[1]);
+    case 3:
+      return mcMorton_encode3(
+          (uint32_t)coord[0], (uint32_t)coord[1], (uint32_t)coord[2]);
+  }
+  assert(0);
+  return 0;
+}
+
+/**
+ * Decodes coordinates in two or three dimensions from the given code.
+ */
+static inline void mcMorton_decode(uint64_t code, int *coord, int dimension)
+{
+  switch (dimension) {
+    case 2:
+      coord[0] = (int)mcMorton_compact2(code);
+      coord[1] = (int)mcMorton_compact2(code >> 1);
+      return;
+    case 3:
+      coord[0] = (int)mcMorton_compact3(code);
+      coord[1] = (int)mcMorton_compact3(code >> 1);
+      coord[2] = (int)mcMorton_compact3(code >> 2);
+      return;
+  }
+  assert(0);
+}
+
+/**
+ * Returns the index of the highest set bit of \p v, which must not be zero.
+ */
+static inline int mcMorton_highestBit(uint64_t v) {
+  assert(v != 0);
+#ifdef __GNUC__
+  return 63 - __builtin_clzll(v);
+#else
+  int bit = 0;
+  while (v >>= 1)
+    ++bit;
+  return bit;
+#endif
+}
+
+#endif
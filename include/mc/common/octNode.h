@@ -24,8 +24,10 @@
 #ifndef MC_COMMON_OCT_NODE_H_
 #define MC_COMMON_OCT_NODE_H_
 
+#include <mc/common/linearZOrderTree.h>
 #include <mc/common/zOrderNode.h>
 
 MC_DECLARE_Z_ORDER_NODE(Oct, 3)
+MC_DECLARE_LINEAR_Z_ORDER_TREE(Oct, 3)
 
 #endif
@@ -24,8 +24,10 @@
 #ifndef MC_COMMON_QUAD_NODE_H_
 #define MC_COMMON_QUAD_NODE_H_
 
+#include <mc/common/linearZOrderTree.h>
 #include <mc/common/zOrderNode.h>
 
 MC_DECLARE_Z_ORDER_NODE(Quad, 2)
+MC_DECLARE_LINEAR_Z_ORDER_TREE(Quad, 2)
 
 #endif
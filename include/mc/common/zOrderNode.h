@@ -25,10 +25,12 @@
 #define MC_COMMON_Z_ORDER_NODE_H_
 
 #include <assert.h>
-#include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <mc/common/morton.h>
+
 #define MC_DECLARE_Z_ORDER_NODE(PREFIX, DIMENSION) \
 typedef struct { \
   int coord[DIMENSION]; \
@@ -46,16 +48,21 @@ struct mc ## PREFIX ## Node { \
   mc ## PREFIX ## NodeCoordinates pos; \
   int level; \
   float value; \
+  /* Auxiliary data owned by the algorithm using the tree */ \
+  void *data; \
 }; \
 \
 typedef struct { \
   mc ## PREFIX ## Node *current; \
 } mc ## PREFIX ## NodeIterator; \
 \
+/* Iterates over the level zero positions covered by a node in Z-order, as if
+ * the node were the root of a full tree */ \
 typedef struct { \
   mc ## PREFIX ## Node *node; \
-  int maskStack[sizeof(int) * 8]; \
-  int latticeIndex; \
+  /* The current position, and its Morton code relative to the node */ \
+  mc ## PREFIX ## NodeCoordinates pos; \
+  uint64_t latticeIndex; \
 } mc ## PREFIX ## LatticeIterator; \
 \
 void mc ## PREFIX ## Node_init(mc ## PREFIX ## Node *self); \
@@ -76,7 +83,7 @@ mc ## PREFIX ## Node *mc ## PREFIX ## Node_getNode( \
 int mc ## PREFIX ## Node_containsPoint( \
     const mc ## PREFIX ## Node *self, \
     const mc ## PREFIX ## SpaceCoordinates *point); \
-mc ## PREFIX ## Node *mc ## PREFIX ## Node_getNodeContainingPoint( \
+const mc ## PREFIX ## Node *mc ## PREFIX ## Node_getNodeContainingPoint( \
     const mc ## PREFIX ## Node *self, \
     const mc ## PREFIX ## SpaceCoordinates *point); \
 mc ## PREFIX ## Node *mc ## PREFIX ## Node_makeNodeContainingPoint( \
@@ -117,7 +124,10 @@ int mc ## PREFIX ## NodeIterator_equals( \
     mc ## PREFIX ## NodeIterator other); \
 \
 void mc ## PREFIX ## LatticeIterator_next( \
-    mc ## PREFIX ## LatticeIterator *self);
+    mc ## PREFIX ## LatticeIterator *self); \
+int mc ## PREFIX ## LatticeIterator_equals( \
+    const mc ## PREFIX ## LatticeIterator *self, \
+    mc ## PREFIX ## LatticeIterator other);
 
 #define MC_DEFINE_Z_ORDER_NODE(PREFIX, DIMENSION) \
   MC_DEFINE_Z_ORDER_alignPosToLevel(PREFIX, DIMENSION) \
@@ -143,7 +153,8 @@ void mc ## PREFIX ## LatticeIterator_next( \
   MC_DEFINE_Z_ORDER_NODE_createChild(PREFIX, DIMENSION) \
   MC_DEFINE_Z_ORDER_NODE_ITERATOR_next(PREFIX, DIMENSION) \
   MC_DEFINE_Z_ORDER_NODE_ITERATOR_equals(PREFIX, DIMENSION) \
-  MC_DEFINE_Z_ORDER_LATTICE_ITERATOR_next(PREFIX, DIMENSION)
+  MC_DEFINE_Z_ORDER_LATTICE_ITERATOR_next(PREFIX, DIMENSION) \
+  MC_DEFINE_Z_ORDER_LATTICE_ITERATOR_equals(PREFIX, DIMENSION)
 
 #define MC_DEFINE_Z_ORDER_alignPosToLevel(PREFIX, DIMENSION) \
   void mc ## PREFIX ## _alignPosToLevel( \
@@ -162,6 +173,7 @@ void mc ## PREFIX ## LatticeIterator_next( \
   void mc ## PREFIX ## Node_init(mc ## PREFIX ## Node *self) { \
     self->level = -1; \
     self->parent = NULL; \
+    self->data = NULL; \
     for (int i = 0; i < DIMENSION; ++i) { \
       self->pos.coord[i] = 0; \
     } \
@@ -175,6 +187,7 @@ void mc ## PREFIX ## LatticeIterator_next( \
     /* The root node starts at level 1 and straddles the origin */ \
     root->level = 1; \
     root->parent = NULL; \
+    root->data = NULL; \
     for (int i = 0; i < DIMENSION; ++i) { \
       root->pos.coord[i] = -1; \
     } \
@@ -185,10 +198,13 @@ void mc ## PREFIX ## LatticeIterator_next( \
 
 #define MC_DEFINE_Z_ORDER_NODE_destroy(PREFIX, DIMENSION) \
   void mc ## PREFIX ## Node_destroy(mc ## PREFIX ## Node *self) { \
-    /* Recursively destroy all children nodes */ \
+    /* Recursively destroy and free all children nodes. The auxiliary data
+     * pointers are left for the caller to free. */ \
     for (int i = 0; i < (1 << DIMENSION); ++i) { \
       if (self->children[i]) { \
         mc ## PREFIX ## Node_destroy(self->children[i]); \
+        free(self->children[i]); \
+        self->children[i] = NULL; \
       } \
     } \
   }
@@ -215,22 +231,27 @@ void mc ## PREFIX ## LatticeIterator_next( \
   mc ## PREFIX ## LatticeIterator mc ## PREFIX ## Node_beginLattice( \
       mc ## PREFIX ## Node *self) \
   { \
+    /* Lattice indices hold DIMENSION bits per level */ \
+    assert(self->level * DIMENSION < 64); \
     mc ## PREFIX ## LatticeIterator i; \
     i.node = self; \
-    memset(i.maskStack, 0, sizeof(i.maskStack)); \
+    i.pos = self->pos; \
     i.latticeIndex = 0;  /* Start iterating over the lattice at the
                             bottom-left corner of the node */ \
+    return i; \
   }
 
 #define MC_DEFINE_Z_ORDER_NODE_endLattice(PREFIX, DIMENSION) \
   mc ## PREFIX ## LatticeIterator mc ## PREFIX ## Node_endLattice( \
       mc ## PREFIX ## Node *self) \
 { \
+  assert(self->level * DIMENSION < 64); \
   mc ## PREFIX ## LatticeIterator i; \
   i.node = self; \
-  memset(i.maskStack, 0, sizeof(i.maskStack)); \
-  i.latticeIndex = 3;  /* Finish iterating over the lattice at the top-right
-                          corner of the node */ \
+  i.pos = self->pos; \
+  /* Finish one past the top-right corner of the node */ \
+  i.latticeIndex = (uint64_t)1 << (self->level * DIMENSION); \
+  return i; \
 }
 
 #define MC_DEFINE_Z_ORDER_NODE_nextSibling(PREFIX, DIMENSION) \
@@ -270,15 +291,6 @@ void mc ## PREFIX ## LatticeIterator_next( \
      * given level */ \
     mc ## PREFIX ## NodeCoordinates alignedPos; \
     mc ## PREFIX ## _alignPosToLevel(pos, level, &alignedPos); \
-    fprintf(stderr, /* XXX */ \
-        "level: %d\n" \
-        "pos: (0x%08x, 0x%08x)\n" \
-        "alignedPos: (0x%08x, 0x%08x)\n", \
-        level, \
-        pos->coord[0], \
-        pos->coord[1], \
-        alignedPos.coord[0], \
-        alignedPos.coord[1]); \
     /* Make sure the root node contains the node */ \
     if (!mc ## PREFIX ## Node_contains(root, &alignedPos, level)) { \
       /* We grow the root to contain the node */ \
@@ -298,7 +310,7 @@ void mc ## PREFIX ## LatticeIterator_next( \
   }
 
 #define MC_DEFINE_Z_ORDER_NODE_containsPoint(PREFIX, DIMENSION) \
-  int mc ## PREFIX ## Node_containspoint( \
+  int mc ## PREFIX ## Node_containsPoint( \
       const mc ## PREFIX ## Node *self, \
       const mc ## PREFIX ## SpaceCoordinates *point) \
 { \
@@ -320,7 +332,7 @@ void mc ## PREFIX ## LatticeIterator_next( \
 }
 
 #define MC_DEFINE_Z_ORDER_NODE_getNodeContainingPoint(PREFIX, DIMENSION) \
-  mc ## PREFIX ## Node *mc ## PREFIX ## Node_getNodeContainingPoint( \
+  const mc ## PREFIX ## Node *mc ## PREFIX ## Node_getNodeContainingPoint( \
       const mc ## PREFIX ## Node *self, \
       const mc ## PREFIX ## SpaceCoordinates *point) \
 { \
@@ -329,8 +341,8 @@ void mc ## PREFIX ## LatticeIterator_next( \
     return NULL; \
   } \
   /* Iterate over children looking for child that contains this point */ \
-  for (int i = 0; (1 << DIMENSION); ++i) { \
-    mc ## PREFIX ## Node *containingNode; \
+  for (int i = 0; i < (1 << DIMENSION); ++i) { \
+    const mc ## PREFIX ## Node *containingNode; \
     if (!self->children[i]) \
       continue; \
     containingNode = \
@@ -382,18 +394,15 @@ void mc ## PREFIX ## LatticeIterator_next( \
     } \
     if (level > self->level) { \
       /* The target is larger than this node */ \
-      fprintf(stderr, "the target is larger than this node\n"); \
       return 0; \
     } else if (level == self->level) { \
       /* The target is the same size as this node */ \
-      fprintf(stderr, "the target is the same size as this node\n"); \
       if (memcmp(&self->pos, pos, sizeof(*pos)) != 0) { \
         return 0; \
       } \
     } else { \
       /* The target is smaller than this node and might be contained within
        * this node */ \
-      fprintf(stderr, "the target is smaller than this node\n"); \
       for (int i = 0; i < DIMENSION; ++i) { \
         if (pos->coord[i] < self->pos.coord[i]) \
           return 0; \
@@ -403,7 +412,6 @@ void mc ## PREFIX ## LatticeIterator_next( \
           return 0; \
       } \
     } \
-    fprintf(stderr, "the target is contained in this node\n"); \
     return 1; \
   }
 
@@ -442,7 +450,6 @@ void mc ## PREFIX ## LatticeIterator_next( \
         int oldChildNewIndex = mc ## PREFIX ## Node_childIndexContainingPos( \
             newChild, \
             &oldChild->pos); \
-        fprintf(stderr, "oldChildNewindex: %d\n", oldChildNewIndex); \
         newChild->children[oldChildNewIndex] = oldChild; \
         oldChild->parent = newChild; \
       } \
@@ -491,19 +498,23 @@ void mc ## PREFIX ## Node_childIndexToPos( \
   { \
     assert(mc ## PREFIX ## Node_contains(self, pos, level)); \
     assert(level < self->level); \
-    /* Determine which of our children this descendant must belong to */ \
-    int index = mc ## PREFIX ## Node_childIndexContainingPos(self, pos); \
-    fprintf(stderr, "descendant index: %d\n", index); \
-    mc ## PREFIX ## Node *child = \
-        mc ## PREFIX ## Node_getChild(self, index); \
-    if (child->level == level) { \
-      assert(memcmp(&child->pos, pos, sizeof(*pos)) == 0); \
-      /* The base case, where our child is the node we are looking for */ \
-      fprintf(stderr, "We found the child: 0x%016x\n", child); \
-      return child; \
+    /* The Morton code of the descendant's offset within this node holds
+     * the child index to take at each level */ \
+    assert(self->level * DIMENSION < 64); \
+    int offset[DIMENSION]; \
+    for (int i = 0; i < DIMENSION; ++i) \
+      offset[i] = pos->coord[i] - self->pos.coord[i]; \
+    uint64_t code = mcMorton_encode(offset, DIMENSION); \
+    /* Walk down through the children containing the descendant, creating
+     * them as necessary */ \
+    mc ## PREFIX ## Node *node = self; \
+    while (node->level > level) { \
+      int index = (int)((code >> ((node->level - 1) * DIMENSION)) \
+          & ((1u << DIMENSION) - 1)); \
+      node = mc ## PREFIX ## Node_getChild(node, index); \
     } \
-    /* Recursive call to find the node */ \
-    return mc ## PREFIX ## Node_getDescendant(child, pos, level); \
+    assert(memcmp(&node->pos, pos, sizeof(*pos)) == 0); \
+    return node; \
   }
 
 #define MC_DEFINE_Z_ORDER_NODE_getChild(PREFIX, DIMENSION) \
@@ -592,15 +603,22 @@ void mc ## PREFIX ## Node_childIndexToPos( \
   void mc ## PREFIX ## LatticeIterator_next( \
       mc ## PREFIX ## LatticeIterator *self) \
   { \
-    /* Each node has four potential lattice points associated with it. Up to
-     * three of these lattice points might also be associated with a parent
-     * node.
-     */ \
-    /* TODO: We need to traverse down the tree */ \
-    /* TODO: We need to make sure the very last lattice point we iterate over
-     * is index 3 on this node */ \
-    /* TODO: Assert that the lattice point that we are currently at is not
-     * divisible by the lattice level of our parent nodes */ \
+    /* Incrementing the Morton code steps to the next position in Z-order,
+     * and decoding it takes a constant number of operations */ \
+    int offset[DIMENSION]; \
+    self->latticeIndex += 1; \
+    mcMorton_decode(self->latticeIndex, offset, DIMENSION); \
+    for (int i = 0; i < DIMENSION; ++i) \
+      self->pos.coord[i] = self->node->pos.coord[i] + offset[i]; \
+  }
+
+#define MC_DEFINE_Z_ORDER_LATTICE_ITERATOR_equals(PREFIX, DIMENSION) \
+  int mc ## PREFIX ## LatticeIterator_equals( \
+      const mc ## PREFIX ## LatticeIterator *self, \
+      mc ## PREFIX ## LatticeIterator other) \
+  { \
+    return self->node == other.node \
+      && self->latticeIndex == other.latticeIndex; \
   }
 
 #endif
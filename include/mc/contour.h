@@ -30,19 +30,53 @@ typedef struct {
   int a, b;
 } mcLine;
 
+/**
+ * Output formats for contours. With MC_CONTOUR_LINES, each segment is stored
+ * as an independent mcLine. With MC_CONTOUR_POLYLINES, segments are chained
+ * together as they are added and the contour is stored as a list of ordered
+ * polylines, suitable for line strip rendering. Closed loops repeat their
+ * first vertex index at the end of the polyline.
+ */
+typedef enum {
+  MC_CONTOUR_LINES = 1,
+  MC_CONTOUR_POLYLINES,
+} mcContourFormat;
+
 typedef struct {
   mcVertex *vertices;
   mcLine *lines;
   int numVertices, numLines;
   int sizeVertices, sizeLines;
+  /* Polyline i consists of the vertex indices in polylineIndices from
+   * polylineOffsets[i] up to (but not including) polylineOffsets[i + 1] */
+  int *polylineOffsets, *polylineIndices;
+  int numPolylines, numPolylineIndices;
+  int sizePolylineOffsets, sizePolylineIndices;
+  /* Two neighboring vertex indices for each vertex, used for chaining
+   * segments into polylines; -1 indicates no neighbor. These are freed (and
+   * set to NULL) by mcContour_assemblePolylines. */
+  int *links;
+  int sizeLinks;
+  mcContourFormat format;
 } mcContour;
 
 void mcContour_init(mcContour *self);
 
+void mcContour_initWithFormat(mcContour *self, mcContourFormat format);
+
 void mcContour_destroy(mcContour *self);
 
 int mcContour_addVertex(mcContour *self, const mcVertex *vertex);
 
 void mcContour_addLine(mcContour *self, const mcLine *line);
 
+/**
+ * Orders the segments added to a contour with the MC_CONTOUR_POLYLINES format
+ * into polylines. Open polylines are emitted first, followed by closed loops.
+ * This is called by the contour builder after the contour has been extracted.
+ * The per-vertex links are freed afterwards, so no further vertices or lines
+ * can be added to the contour.
+ */
+void mcContour_assemblePolylines(mcContour *self);
+
 #endif
@@ -39,6 +39,14 @@ void mcContourBuilder_init(mcContourBuilder *self);
 
 void mcContourBuilder_destroy(mcContourBuilder *self);
 
+/**
+ * Sets the output format used for all subsequently built contours. The
+ * default format is MC_CONTOUR_LINES.
+ */
+void mcContourBuilder_setFormat(
+    mcContourBuilder *self,
+    mcContourFormat format);
+
 const mcContour *mcContourBuilder_contourFromFieldWithArgs(
     mcContourBuilder *self,
     mcScalarFieldWithArgs sf,
@@ -47,6 +55,30 @@ const mcContour *mcContourBuilder_contourFromFieldWithArgs(
     unsigned int x_res, unsigned int y_res,
     const mcVec2 *min, const mcVec2 *max);
 
+/**
+ * Builds a contour in the same way as
+ * mcContourBuilder_contourFromFieldWithArgs(), but additionally passes the
+ * given algorithm parameters to the contouring algorithm.
+ *
+ * \param params A pointer to the parameter structure for the given algorithm,
+ * such as mcAdaptiveMarchingSquaresParams for MC_ADAPTIVE_MARCHING_SQUARES, or
+ * NULL to use the default parameters.
+ */
+const mcContour *mcContourBuilder_contourFromFieldWithParams(
+    mcContourBuilder *self,
+    mcScalarFieldWithArgs sf,
+    const void *args,
+    mcAlgorithmFlag algorithm,
+    mcAlgorithmParams params,
+    unsigned int x_res, unsigned int y_res,
+    const mcVec2 *min, const mcVec2 *max);
+
+/**
+ * Builds a contour between the regions of a colored field. Colored marching
+ * squares does not share vertices between neighboring squares yet, so its
+ * segments cannot be chained. The returned contour always has the
+ * MC_CONTOUR_LINES format, regardless of the format set on the builder.
+ */
 const mcContour *mcContourBuilder_contourFromColoredFieldWithArgs(
     mcContourBuilder *self,
     mcColoredFieldWithArgs cf,
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_DECIMATION_H_
+#define MC_DECIMATION_H_
+
+/**
+ * \addtogroup libmc
+ * @{
+ */
+
+/**
+ * \defgroup mcDecimation mcDecimation
+ */
+
+/**
+ * \addtogroup mcDecimation
+ * @{
+ */
+
+/** \file mc/decimation.h
+ *
+ * This file contains routines for reducing the number of triangles in meshes
+ * generated by libmc.
+ */
+
+#include <mc/mesh.h>
+
+/**
+ * Parameters controlling the mesh decimation performed by
+ * mcDecimation_decimateMesh(). Decimation stops as soon as either limit is
+ * reached.
+ */
+typedef struct mcDecimationParams {
+  /** The number of triangles at or below which decimation stops. A value of
+   * zero places no limit on the number of triangles removed. */
+  unsigned int targetNumFaces;
+  /** The largest quadric error allowed for any single edge collapse. The
+   * quadric error is the sum of the squared distances from the collapsed
+   * vertex to the planes of the original triangles around it, in mesh space
+   * units. */
+  float maxError;
+  /** If nonzero, vertices on the open boundary of the mesh are never moved or
+   * removed. Meshes built for neighboring chunks of the same scalar field have
+   * matching boundaries, and locking those boundaries keeps the decimated
+   * chunks free of cracks. */
+  int lockBoundary;
+} mcDecimationParams;
+
+/**
+ * Initializes the given \p params structure with the default decimation
+ * parameters, which remove only the triangles that lie (nearly) flat on the
+ * surface and lock the mesh boundary.
+ */
+void mcDecimationParams_default(mcDecimationParams *params);
+
+/**
+ * Reduces the number of triangles in a mesh with quadric error metric edge
+ * collapses, as described by Garland and Heckbert
+ * \cite Garland:1997:SSU:258734.258849. Edges are collapsed in order of
+ * increasing quadric error until one of the limits in \p params is reached.
+ * Collapses that would flip a triangle or make the mesh non-manifold are
+ * skipped.
+ *
+ * Vertices with identical positions are merged before decimating, since
+ * several isosurface extraction algorithms give each voxel cube its own copy
+ * of the vertices it shares with its neighbors. Faces with more than three
+ * vertices are split into triangle fans.
+ *
+ * \param mesh The mesh to decimate.
+ * \param params The decimation parameters, or NULL for the default
+ * parameters.
+ * \param output An initialized mesh to which the decimated vertices and
+ * triangles are added.
+ */
+void mcDecimation_decimateMesh(
+    const mcMesh *mesh,
+    const mcDecimationParams *params,
+    mcMesh *output);
+
+/** @} */
+
+/** @} */
+
+#endif
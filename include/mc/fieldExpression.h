@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_FIELD_EXPRESSION_H_
+#define MC_FIELD_EXPRESSION_H_
+
+/**
+ * \addtogroup libmc
+ * @{
+ */
+
+/**
+ * \defgroup mcFieldExpression mcFieldExpression
+ */
+
+/**
+ * \addtogroup mcFieldExpression
+ * @{
+ */
+
+/** \file mc/fieldExpression.h
+ *
+ * This file contains scalar fields that are described to libmc rather than
+ * passed as opaque callbacks. An mcFieldExpression is a DAG of signed distance
+ * primitives, CSG operators, transforms and arithmetic. It compiles into an
+ * mcFieldProgram, a flat bytecode that evaluates each instruction over a whole
+ * batch of points at once in tight loops that the compiler can vectorize.
+ *
+ * A compiled program can be passed to any isosurface or contour builder entry
+ * point through the descriptor made by mcFieldProgram_descriptor(). The
+ * samplers of the extraction algorithms then sample the program with
+ * mcFieldProgram_evaluateLattice(), which evaluates entire rows of samples at
+ * once and skips the empty parts of the lattice, instead of calling it once
+ * per sample.
+ */
+
+#include <mc/scalarField.h>
+#include <mc/vector.h>
+
+/** The number of points that mcFieldProgram evaluates each instruction over
+ * at a time. */
+#define MC_FIELD_PROGRAM_BATCH_SIZE 64
+
+/**
+ * The operations of field expression nodes and of the instructions they
+ * compile to.
+ */
+typedef enum mcFieldOp {
+  /** The x, y or z coordinate of the point being evaluated. */
+  MC_FIELD_X,
+  MC_FIELD_Y,
+  MC_FIELD_Z,
+  /** A constant value. */
+  MC_FIELD_CONSTANT,
+  /** Arithmetic on the values of child nodes. */
+  MC_FIELD_ADD,
+  MC_FIELD_SUBTRACT,
+  MC_FIELD_MULTIPLY,
+  MC_FIELD_MIN,
+  MC_FIELD_MAX,
+  MC_FIELD_NEGATE,
+  MC_FIELD_ABS,
+  /** The polynomial smooth minimum of two child nodes. */
+  MC_FIELD_SMOOTH_MIN,
+  /** Signed distance primitives. */
+  MC_FIELD_SPHERE,
+  MC_FIELD_BOX,
+  MC_FIELD_TORUS,
+  MC_FIELD_PLANE,
+  /** Smoothly interpolated value noise. */
+  MC_FIELD_NOISE,
+  /** Evaluates a child node at affinely transformed coordinates. In programs,
+   * each of these instructions computes one transformed coordinate. */
+  MC_FIELD_AFFINE,
+} mcFieldOp;
+
+/**
+ * A node of a field expression. Nodes refer to their children and parameters
+ * by index.
+ */
+typedef struct mcFieldNode {
+  mcFieldOp op;
+  /** The indices of the child nodes, or -1. */
+  int children[2];
+  /** The index of the first parameter of this node in the expression's
+   * parameter array. */
+  unsigned int params;
+} mcFieldNode;
+
+/**
+ * A DAG of field expression nodes. Nodes are only ever added, and each node
+ * may only refer to nodes added before it, so node indices double as handles
+ * for building larger expressions. A node may be shared by any number of
+ * parents.
+ */
+typedef struct mcFieldExpression {
+  mcFieldNode *nodes;
+  unsigned int numNodes, sizeNodes;
+  float *params;
+  unsigned int numParams, sizeParams;
+} mcFieldExpression;
+
+/**
+ * A single bytecode instruction. Registers hold one value per point of the
+ * batch being evaluated, and registers 0, 1 and 2 hold the x, y and z
+ * coordinates of the points.
+ */
+typedef struct mcFieldInstruction {
+  mcFieldOp op;
+  /** The register receiving the result. */
+  unsigned int dest;
+  /** The source registers. Arithmetic reads the first one or two, while
+   * primitives and affine transforms read coordinates from all three. */
+  unsigned int src[3];
+  /** The index of the first immediate parameter of this instruction. */
+  unsigned int params;
+} mcFieldInstruction;
+
+/**
+ * A field expression compiled into a flat list of instructions. The program
+ * does not refer back to its expression, and evaluating it does not modify
+ * it, so one program can be evaluated from several threads at once.
+ */
+typedef struct mcFieldProgram {
+  mcFieldInstruction *instructions;
+  unsigned int numInstructions;
+  float *params;
+  unsigned int numParams;
+  /** The number of registers used, including the three coordinates. */
+  unsigned int numRegisters;
+  /** The register holding the value of the field. */
+  unsigned int result;
+} mcFieldProgram;
+
+/**
+ * Initializes an empty field expression.
+ */
+void mcFieldExpression_init(
+    mcFieldExpression *self);
+
+/**
+ * Frees the nodes of the given field expression.
+ */
+void mcFieldExpression_destroy(
+    mcFieldExpression *self);
+
+/** \name Coordinates and arithmetic
+ * Each of these adds a node and returns its index.
+ * @{
+ */
+int mcFieldExpression_x(mcFieldExpression *self);
+int mcFieldExpression_y(mcFieldExpression *self);
+int mcFieldExpression_z(mcFieldExpression *self);
+int mcFieldExpression_constant(mcFieldExpression *self, float value);
+int mcFieldExpression_add(mcFieldExpression *self, int a, int b);
+int mcFieldExpression_subtract(mcFieldExpression *self, int a, int b);
+int mcFieldExpression_multiply(mcFieldExpression *self, int a, int b);
+int mcFieldExpression_min(mcFieldExpression *self, int a, int b);
+int mcFieldExpression_max(mcFieldExpression *self, int a, int b);
+int mcFieldExpression_negate(mcFieldExpression *self, int a);
+int mcFieldExpression_abs(mcFieldExpression *self, int a);
+/** @} */
+
+/** \name Primitives
+ * Signed distance functions, negative inside the primitive. Each of these adds
+ * a node and returns its index.
+ * @{
+ */
+int mcFieldExpression_sphere(mcFieldExpression *self,
+    const mcVec3 *center, float radius);
+int mcFieldExpression_box(mcFieldExpression *self,
+    const mcVec3 *center, const mcVec3 *halfExtents);
+/** A torus around the z-axis through the given center. */
+int mcFieldExpression_torus(mcFieldExpression *self,
+    const mcVec3 *center, float majorRadius, float minorRadius);
+/** The half space behind the plane with the given normal and distance from
+ * the origin along it. The normal need not be normalized. */
+int mcFieldExpression_plane(mcFieldExpression *self,
+    const mcVec3 *normal, float distance);
+/** Value noise between -amplitude and amplitude, with lattice features
+ * spaced 1 / frequency apart. Different seeds give different noise. */
+int mcFieldExpression_noise(mcFieldExpression *self,
+    float frequency, float amplitude, unsigned int seed);
+/** @} */
+
+/** \name CSG operators
+ * Each of these adds a node and returns its index.
+ * @{
+ */
+int mcFieldExpression_union(mcFieldExpression *self, int a, int b);
+int mcFieldExpression_intersection(mcFieldExpression *self, int a, int b);
+/** The parts of \p a outside of \p b. */
+int mcFieldExpression_difference(mcFieldExpression *self, int a, int b);
+/** A union that blends the surfaces together where they come within
+ * \p radius of each other. */
+int mcFieldExpression_smoothUnion(mcFieldExpression *self,
+    int a, int b, float radius);
+/** @} */
+
+/** \name Transforms
+ * Each of these adds a node that moves the given node, and returns its index.
+ * Translations, rotations and uniform scales keep signed distances exact.
+ * @{
+ */
+int mcFieldExpression_translate(mcFieldExpression *self,
+    int a, const mcVec3 *offset);
+/** Rotates by the given angle in radians around the given axis through the
+ * origin. */
+int mcFieldExpression_rotate(mcFieldExpression *self,
+    int a, const mcVec3 *axis, float angle);
+int mcFieldExpression_scale(mcFieldExpression *self, int a, float factor);
+/** Evaluates \p a at the coordinates given by the 3x4 row-major affine
+ * matrix \p matrix applied to each point. This is the inverse of the
+ * transform applied to the shape. */
+int mcFieldExpression_affine(mcFieldExpression *self,
+    int a, const float *matrix);
+/** @} */
+
+/**
+ * Compiles the field expression rooted at the given node into a program.
+ * Nodes that are shared within the same coordinate frame are only evaluated
+ * once, and constant arithmetic is folded.
+ *
+ * \param self The program to initialize.
+ * \param expression The field expression.
+ * \param root The index of the node giving the value of the field.
+ */
+void mcFieldProgram_init(
+    mcFieldProgram *self,
+    const mcFieldExpression *expression,
+    int root);
+
+/**
+ * Frees the instructions of the given program.
+ */
+void mcFieldProgram_destroy(
+    mcFieldProgram *self);
+
+/**
+ * Evaluates the program at the given points.
+ *
+ * \param self The program.
+ * \param x The x coordinates of the points.
+ * \param y The y coordinates of the points.
+ * \param z The z coordinates of the points.
+ * \param count The number of points.
+ * \param values Receives the value of the field at each point.
+ */
+void mcFieldProgram_evaluate(
+    const mcFieldProgram *self,
+    const float *x, const float *y, const float *z,
+    unsigned int count,
+    float *values);
+
+/**
+ * Evaluates the program along a row of evenly spaced points parallel to the
+ * x-axis, at x = x0 + i * dx for i from 0 to count - 1. This computes each x
+ * coordinate exactly as the lattice samplers do.
+ */
+void mcFieldProgram_evaluateRow(
+    const mcFieldProgram *self,
+    float x0, float dx, float y, float z,
+    unsigned int count,
+    float *values);
+
+/**
+ * Computes an interval containing every value of the program within the box
+ * between two corners, using interval arithmetic. The bounds are conservative,
+ * and are looser after rotations and over boxes that are large compared to
+ * the features of the field.
+ *
+ * \param self The program.
+ * \param min One corner of the box.
+ * \param max The opposite corner of the box.
+ * \param lower Receives the lower bound of the field within the box.
+ * \param upper Receives the upper bound of the field within the box.
+ */
+void mcFieldProgram_evaluateInterval(
+    const mcFieldProgram *self,
+    const mcVec3 *min, const mcVec3 *max,
+    float *lower, float *upper);
+
+/**
+ * Samples the program over a regular lattice for isosurface extraction. The
+ * lattice is recursively split into blocks, and blocks whose interval of
+ * values excludes the isovalue, even a couple of samples beyond the block, are
+ * filled with a value of the right sign without evaluating a single sample.
+ * Within the remaining blocks, CSG branches that cannot win their minimum or
+ * maximum are pruned before sampling.
+ *
+ * Every sample near the isosurface holds exactly the value that
+ * mcFieldProgram_evaluateRow() would give, so the cubes containing the surface
+ * and the normals estimated from their neighbors are unchanged. Samples far
+ * from the isosurface only keep their sign.
+ *
+ * \param self The program.
+ * \param min The position of the first sample.
+ * \param delta The distance between samples along each axis.
+ * \param x_res The number of samples along the x-axis.
+ * \param y_res The number of samples along the y-axis.
+ * \param z_res The number of samples along the z-axis.
+ * \param samples Receives the samples, with x varying fastest.
+ */
+void mcFieldProgram_evaluateLattice(
+    const mcFieldProgram *self,
+    const mcVec3 *min, const mcVec3 *delta,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    float *samples);
+
+/**
+ * A scalar field that evaluates the mcFieldProgram passed as its arguments at
+ * a single point. Pass a descriptor from mcFieldProgram_descriptor() to the
+ * builders instead, so that whole lattices are sampled at once.
+ */
+float mcFieldProgram_scalarField(
+    float x, float y, float z,
+    const void *args);
+
+/**
+ * Initializes a scalar field descriptor whose lattice sampler samples the
+ * program as mcFieldProgram_evaluateLattice() does. The descriptor refers to
+ * \p self, which must outlive it.
+ */
+void mcFieldProgram_descriptor(
+    const mcFieldProgram *self,
+    mcScalarFieldDescriptor *descriptor);
+
+/** @} */
+
+/** @} */
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_HEIGHT_FIELD_H_
+#define MC_HEIGHT_FIELD_H_
+
+/**
+ * \addtogroup libmc
+ * @{
+ */
+
+/**
+ * \defgroup mcHeightField mcHeightField
+ */
+
+/**
+ * \addtogroup mcHeightField
+ * @{
+ */
+
+/** \file mc/heightField.h
+ *
+ * This file contains a scalar field descriptor for terrain and other 2.5D
+ * surfaces, given by a height function over two axes. The field is the
+ * coordinate along the vertical axis minus the height, so it is negative
+ * below the surface. Since the height only depends on the horizontal
+ * coordinates, the samplers evaluate it once per column of the lattice and
+ * derive every sample of the column from it. The field is linear along each
+ * column, so the isosurface crossings found by interpolating the samples lie
+ * exactly at the height. Lattices that lie entirely above or below the
+ * declared range of heights are filled without evaluating the height at all.
+ *
+ * To use it, initialize an mcHeightField around the height function, make a
+ * descriptor for it with mcHeightField_descriptor() and pass
+ * mcScalarFieldDescriptor_scalarField() to any builder entry point, with the
+ * descriptor as the scalar field arguments.
+ */
+
+#include <mc/scalarField.h>
+#include <mc/vector.h>
+
+/**
+ * The function signature for the height function of a height field, which
+ * takes the two horizontal coordinates in increasing axis order.
+ */
+typedef float (*mcHeightFunction)(float u, float v, const void *args);
+
+/**
+ * A scalar field given by a height function along one axis.
+ */
+typedef struct mcHeightField {
+  /** The height function. */
+  mcHeightFunction height;
+  /** Arguments passed to the height function. */
+  const void *args;
+  /** The vertical axis, with 0, 1 and 2 for the x, y and z-axes. */
+  int axis;
+  /** Lower and upper bounds on the values of the height function. */
+  float minHeight, maxHeight;
+} mcHeightField;
+
+/**
+ * Initializes a descriptor for the given height function. If the bounds are
+ * too tight, lattices that contain the surface may be skipped, so err on the
+ * side of wider bounds. Pass -INFINITY and INFINITY if they are not known.
+ *
+ * \param self The height field to initialize.
+ * \param height The height function.
+ * \param args Arguments passed to the height function.
+ * \param axis The vertical axis, with 0, 1 and 2 for the x, y and z-axes.
+ * \param minHeight A lower bound on the values of the height function.
+ * \param maxHeight An upper bound on the values of the height function.
+ */
+void mcHeightField_init(
+    mcHeightField *self,
+    mcHeightFunction height,
+    const void *args,
+    int axis,
+    float minHeight, float maxHeight);
+
+/**
+ * A scalar field that evaluates the height field passed as its arguments at a
+ * single point. Pass a descriptor from mcHeightField_descriptor() to the
+ * builders instead, so that the height is evaluated once per column.
+ */
+float mcHeightField_scalarField(
+    float x, float y, float z,
+    const void *args);
+
+/**
+ * Samples the field over a regular lattice for isosurface extraction,
+ * evaluating the height function at most once per column. Lattices that lie
+ * entirely above or below the range of heights, even a couple of samples
+ * beyond them, are filled without evaluating it at all, and their samples
+ * only keep their sign.
+ *
+ * \param self The height field.
+ * \param min The position of the first sample.
+ * \param delta The distance between samples along each axis.
+ * \param x_res The number of samples along the x-axis.
+ * \param y_res The number of samples along the y-axis.
+ * \param z_res The number of samples along the z-axis.
+ * \param samples Receives the samples, with x varying fastest.
+ */
+void mcHeightField_evaluateLattice(
+    const mcHeightField *self,
+    const mcVec3 *min, const mcVec3 *delta,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    float *samples);
+
+/**
+ * Initializes a scalar field descriptor whose lattice sampler samples the
+ * height field as mcHeightField_evaluateLattice() does. The descriptor refers
+ * to \p self, which must outlive it.
+ */
+void mcHeightField_descriptor(
+    const mcHeightField *self,
+    mcScalarFieldDescriptor *descriptor);
+
+/** @} */
+
+/** @} */
+
+#endif
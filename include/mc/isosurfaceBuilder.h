@@ -37,8 +37,12 @@
 #include <stdint.h>
 
 #include <mc/algorithms.h>
+#include <mc/decimation.h>
 #include <mc/mesh.h>
+#include <mc/meshCache.h>
+#include <mc/sampleGrid.h>
 #include <mc/scalarField.h>
+#include <mc/vertexCache.h>
 
 /**
  * Stores a lattice of pre-gathered sample points in a regular lattice. This is
@@ -137,6 +141,13 @@ void mcIsosurfaceBuilder_destroy(
  * The memory of the returned mesh structure is owned by the isosurface builder
  * structure itself.
  *
+ * The MC_CPU_PERFORMANCE_ALGORITHM, MC_CPU_BALANCE_ALGORITHM and
+ * MC_CPU_QUALITY_ALGORITHM flags may extract blocks of the lattice in
+ * parallel, which calls \p sf from several threads at once. Use these flags
+ * only with scalar fields that are safe to call concurrently. All other flags,
+ * including MC_DEFAULT_ALGORITHM and MC_LOW_MEMORY_ALGORITHM, call \p sf from
+ * the calling thread only.
+ *
  * This is actually a convenience wrapper for
  * mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs() that simply passes a
  * scalar field without args to the other method.
@@ -179,6 +190,13 @@ const mcMesh *mcIsosurfaceBuilder_isosurfaceFromField(
  * The memory of the returned mesh structure is owned by the isosurface builder
  * structure itself.
  *
+ * The MC_CPU_PERFORMANCE_ALGORITHM, MC_CPU_BALANCE_ALGORITHM and
+ * MC_CPU_QUALITY_ALGORITHM flags may extract blocks of the lattice in
+ * parallel, which calls \p sf from several threads at once with the same
+ * \p args. Use these flags only with scalar fields that are safe to call
+ * concurrently. All other flags, including MC_DEFAULT_ALGORITHM and
+ * MC_LOW_MEMORY_ALGORITHM, call \p sf from the calling thread only.
+ *
  * \sa mcIsosurfaceBuilder_isosurfaceFromField()
  */
 const mcMesh *mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
@@ -189,6 +207,118 @@ const mcMesh *mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
     unsigned int x_res, unsigned int y_res, unsigned int z_res,
     const mcVec3 *min, const mcVec3 *max);
 
+/**
+ * Builds an isosurface in the same way as
+ * mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(), but additionally passes
+ * the given algorithm parameters to the isosurface extraction algorithm.
+ *
+ * \param params A pointer to the parameter structure for the given algorithm,
+ * such as mcCuberilleParams for MC_CUBERILLE, or NULL to use the default
+ * parameters. The type field of the parameter structure must correspond to
+ * \p algorithm.
+ *
+ * As with mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(), the MC_CPU_*
+ * flags may call \p sf from several threads at once.
+ *
+ * \sa mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs()
+ */
+const mcMesh *mcIsosurfaceBuilder_isosurfaceFromFieldWithParams(
+    mcIsosurfaceBuilder *self,
+    mcScalarFieldWithArgs sf,
+    const void *args,
+    mcAlgorithmFlag algorithm,
+    mcAlgorithmParams params,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max);
+
+/**
+ * Builds an isosurface from the samples of a sample grid, using the
+ * resolution and bounds of the grid. Building isosurfaces from the same sample
+ * grid with several algorithms evaluates the underlying scalar field only
+ * once.
+ *
+ * \param self The isosurface builder object to do the building.
+ * \param grid The sample grid, or a view of a sample grid, to build from.
+ * \param algorithm Flag representing the isosurface extraction algorithm to
+ * use.
+ * \param params A pointer to the parameter structure for the given algorithm,
+ * or NULL to use the default parameters.
+ * \return A mesh structure representing the isosurface that was extracted.
+ *
+ * \sa mcSampleGrid_scalarField()
+ */
+const mcMesh *mcIsosurfaceBuilder_isosurfaceFromSampleGrid(
+    mcIsosurfaceBuilder *self,
+    const mcSampleGrid *grid,
+    mcAlgorithmFlag algorithm,
+    mcAlgorithmParams params);
+
+/**
+ * Sets the mesh cache used by mcIsosurfaceBuilder_isosurfaceFromFieldCached().
+ * The cache is not owned by the isosurface builder and may be shared between
+ * isosurface builders on different threads.
+ *
+ * \param self The isosurface builder to use the cache.
+ * \param cache The mesh cache to use, or NULL to stop caching meshes.
+ */
+void mcIsosurfaceBuilder_setMeshCache(
+    mcIsosurfaceBuilder *self,
+    mcMeshCache *cache);
+
+/**
+ * Builds an isosurface in the same way as
+ * mcIsosurfaceBuilder_isosurfaceFromFieldWithParams(), but first looks for a
+ * mesh built from the same request in the mesh cache set with
+ * mcIsosurfaceBuilder_setMeshCache(). On a cache hit, the cached mesh is
+ * copied and the scalar field is never sampled. On a miss, the extracted mesh
+ * is added to the cache.
+ *
+ * \param fieldVersion A version or hash of the scalar field, which must change
+ * whenever the values of the scalar field change for the same \p sf and
+ * \p args.
+ *
+ * Without a mesh cache, this simply extracts the isosurface.
+ *
+ * \sa mcIsosurfaceBuilder_isosurfaceFromFieldWithParams()
+ */
+const mcMesh *mcIsosurfaceBuilder_isosurfaceFromFieldCached(
+    mcIsosurfaceBuilder *self,
+    mcScalarFieldWithArgs sf,
+    const void *args,
+    uint64_t fieldVersion,
+    mcAlgorithmFlag algorithm,
+    mcAlgorithmParams params,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max);
+
+/**
+ * Builds a decimated copy of the given mesh with mcDecimation_decimateMesh().
+ * The decimated mesh is stored by the isosurface builder along with the meshes
+ * it extracts, and the original mesh is left untouched.
+ *
+ * \param self The isosurface builder to store the decimated mesh.
+ * \param mesh The mesh to decimate, typically one built by \p self.
+ * \param params The decimation parameters, or NULL for the default
+ * parameters.
+ * \return The decimated mesh.
+ */
+const mcMesh *mcIsosurfaceBuilder_decimateMesh(
+    mcIsosurfaceBuilder *self,
+    const mcMesh *mesh,
+    const mcDecimationParams *params);
+
+/**
+ * Reorders the faces and vertices of a mesh held by this isosurface builder
+ * for efficient rendering with mcVertexCache_optimizeMesh(), using a cache
+ * size of MC_VERTEX_CACHE_DEFAULT_SIZE.
+ *
+ * \param self The isosurface builder holding the mesh.
+ * \param mesh A mesh that was returned by \p self.
+ */
+void mcIsosurfaceBuilder_optimizeVertexCache(
+    mcIsosurfaceBuilder *self,
+    const mcMesh *mesh);
+
 /**
  * Builds an isosurface mesh from a pre-sampled lattice. This method of
  * building isosurface meshes requires a pre-sampled lattice, which has the
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_LIPSCHITZ_FIELD_H_
+#define MC_LIPSCHITZ_FIELD_H_
+
+/**
+ * \addtogroup libmc
+ * @{
+ */
+
+/**
+ * \defgroup mcLipschitzField mcLipschitzField
+ */
+
+/**
+ * \addtogroup mcLipschitzField
+ * @{
+ */
+
+/** \file mc/lipschitzField.h
+ *
+ * This file contains a scalar field descriptor that declares how fast the
+ * field can change. Many fields are signed distance functions, which change
+ * by at most the distance moved, and many others have a known bound on their
+ * gradient. A single sample of such a field far from the isosurface proves
+ * that a whole block of the lattice around it is empty, so the samplers can
+ * skip the block without evaluating the field anywhere else in it.
+ *
+ * To use it, initialize an mcLipschitzField around the scalar field, make a
+ * descriptor for it with mcLipschitzField_descriptor() and pass
+ * mcScalarFieldDescriptor_scalarField() to any builder entry point, with the
+ * descriptor as the scalar field arguments.
+ */
+
+#include <mc/scalarField.h>
+#include <mc/vector.h>
+
+/**
+ * A scalar field with a Lipschitz constant.
+ */
+typedef struct mcLipschitzField {
+  /** The scalar field being described. */
+  mcScalarFieldWithArgs sf;
+  /** Arguments passed to the scalar field. */
+  const void *args;
+  /** An upper bound on |f(p) - f(q)| / |p - q| for any two points p and q.
+   * This is 1 for signed distance functions. */
+  float lipschitz;
+} mcLipschitzField;
+
+/**
+ * Initializes a descriptor for the given scalar field with the given
+ * Lipschitz constant. If the constant is too small, blocks that contain the
+ * isosurface may be skipped, so err on the side of a larger one.
+ */
+void mcLipschitzField_init(
+    mcLipschitzField *self,
+    mcScalarFieldWithArgs sf,
+    const void *args,
+    float lipschitz);
+
+/**
+ * A scalar field that evaluates the field described by the mcLipschitzField
+ * passed as its arguments. This evaluates a single point at a time, so pass a
+ * descriptor from mcLipschitzField_descriptor() to the builders instead.
+ */
+float mcLipschitzField_scalarField(
+    float x, float y, float z,
+    const void *args);
+
+/**
+ * Samples the field over a regular lattice for isosurface extraction. The
+ * lattice is recursively split into blocks, and the field is evaluated at the
+ * center of each block. Blocks whose center value exceeds the Lipschitz
+ * constant times the half diagonal of the block, grown by a couple of samples
+ * on each side, cannot contain the isosurface and are filled with the center
+ * value, which has the right sign.
+ *
+ * Every sample near the isosurface holds exactly the value of the field, so
+ * the cubes containing the surface and the normals estimated from their
+ * neighbors are unchanged. Samples far from the isosurface only keep their
+ * sign.
+ *
+ * \param self The field descriptor.
+ * \param min The position of the first sample.
+ * \param delta The distance between samples along each axis.
+ * \param x_res The number of samples along the x-axis.
+ * \param y_res The number of samples along the y-axis.
+ * \param z_res The number of samples along the z-axis.
+ * \param samples Receives the samples, with x varying fastest.
+ */
+void mcLipschitzField_evaluateLattice(
+    const mcLipschitzField *self,
+    const mcVec3 *min, const mcVec3 *delta,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    float *samples);
+
+/**
+ * Initializes a scalar field descriptor whose lattice sampler samples the
+ * field as mcLipschitzField_evaluateLattice() does. The descriptor refers to
+ * \p self, which must outlive it.
+ */
+void mcLipschitzField_descriptor(
+    const mcLipschitzField *self,
+    mcScalarFieldDescriptor *descriptor);
+
+/** @} */
+
+/** @} */
+
+#endif
@@ -161,6 +161,17 @@ void mcMesh_init(
 void mcMesh_destroy(
     mcMesh *self);
 
+/**
+ * Initializes the mcMesh structure as a copy of another mesh, including all of
+ * its vertices and faces.
+ *
+ * \param self The mcMesh structure to initialize with the copied data.
+ * \param other The mesh to be copied.
+ */
+void mcMesh_copy(
+    mcMesh *self,
+    const mcMesh *other);
+
 /**
  * \internal
  * Doubles the number of vertices that can be stored by this mesh.
@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_MESH_CACHE_H_
+#define MC_MESH_CACHE_H_
+
+/**
+ * \addtogroup libmc
+ * @{
+ */
+
+/**
+ * \defgroup mcMeshCache mcMeshCache
+ */
+
+/**
+ * \addtogroup mcMeshCache
+ * @{
+ */
+
+/** \file mc/meshCache.h
+ *
+ * This file contains a cache of extracted meshes keyed on the request that
+ * produced them. Interactive programs often request the same isosurface again,
+ * for example when switching back to a previous algorithm or when a level of
+ * detail node comes back into view, and a cache hit avoids sampling the scalar
+ * field and extracting the isosurface altogether.
+ *
+ * The cache holds its own copies of meshes and evicts the least recently used
+ * meshes once the memory they use exceeds a given budget. All operations are
+ * serialized with a mutex, so a single cache may be shared between isosurface
+ * builders on different threads.
+ */
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mc/algorithms.h>
+#include <mc/mesh.h>
+#include <mc/scalarField.h>
+#include <mc/vector.h>
+
+/**
+ * Identifies an isosurface extraction request.
+ *
+ * Since libmc cannot know when the data behind a scalar field function changes,
+ * the user supplies a field version that must change whenever the scalar field
+ * (or the data that \p args points to) changes.
+ */
+typedef struct mcMeshCacheKey {
+  mcScalarFieldWithArgs sf;
+  const void *args;
+  /** A user-supplied version or hash of the scalar field. */
+  uint64_t fieldVersion;
+  mcAlgorithmFlag algorithm;
+  /** A hash of the algorithm parameters, or zero for the defaults. */
+  uint64_t paramsHash;
+  unsigned int res[3];
+  mcVec3 min, max;
+} mcMeshCacheKey;
+
+/**
+ * \internal
+ * A cached mesh, which is both an element of a hash table bucket and of the
+ * least recently used list.
+ * \endinternal
+ */
+typedef struct mcMeshCacheEntry mcMeshCacheEntry;
+
+/**
+ * A thread-safe cache of extracted meshes with a memory budget.
+ */
+typedef struct mcMeshCache {
+  pthread_mutex_t mutex;
+  mcMeshCacheEntry **buckets;
+  unsigned int numBuckets, numEntries;
+  /** The most and least recently used entries. */
+  mcMeshCacheEntry *head, *tail;
+  /** The maximum and current number of bytes used by cached meshes. */
+  size_t budget, size;
+  /** Counters of lookups that were and were not found in the cache. */
+  unsigned long hits, misses;
+} mcMeshCache;
+
+/**
+ * Initializes an empty mesh cache.
+ *
+ * \param self The mesh cache to initialize.
+ * \param budget The maximum number of bytes of mesh data to keep, as measured
+ * by mcMeshCache_meshSize().
+ */
+void mcMeshCache_init(
+    mcMeshCache *self,
+    size_t budget);
+
+/**
+ * Frees all meshes held by the given mesh cache.
+ *
+ * \param self The mesh cache to destroy.
+ */
+void mcMeshCache_destroy(
+    mcMeshCache *self);
+
+/**
+ * Removes all meshes from the given mesh cache, for example after every
+ * scalar field has changed.
+ *
+ * \param self The mesh cache to clear.
+ */
+void mcMeshCache_clear(
+    mcMeshCache *self);
+
+/**
+ * Looks up the mesh for the given request and, if found, initializes \p mesh
+ * as a copy of it and marks it as the most recently used mesh.
+ *
+ * \param self The mesh cache to search.
+ * \param key The request to look for.
+ * \param mesh An uninitialized mesh structure to receive the cached mesh.
+ * \return Nonzero if the mesh was found and copied into \p mesh.
+ */
+int mcMeshCache_lookup(
+    mcMeshCache *self,
+    const mcMeshCacheKey *key,
+    mcMesh *mesh);
+
+/**
+ * Stores a copy of the mesh extracted for the given request, evicting the
+ * least recently used meshes as needed to stay within the budget. Meshes
+ * larger than the entire budget are not stored. If the cache already holds a
+ * mesh for the request, it is kept and \p mesh is ignored.
+ *
+ * \param self The mesh cache to store the mesh.
+ * \param key The request that produced the mesh.
+ * \param mesh The mesh to store.
+ */
+void mcMeshCache_insert(
+    mcMeshCache *self,
+    const mcMeshCacheKey *key,
+    const mcMesh *mesh);
+
+/**
+ * Returns the number of bytes of memory used by the vertices and faces of the
+ * given mesh, which is what a mesh cache counts against its budget.
+ */
+size_t mcMeshCache_meshSize(
+    const mcMesh *mesh);
+
+/**
+ * Computes the 64-bit FNV-1a hash of the given bytes, continuing from the
+ * given hash. This is suitable for hashing algorithm parameter structures and
+ * field data for use in an mcMeshCacheKey.
+ *
+ * \param bytes The bytes to hash.
+ * \param size The number of bytes to hash.
+ * \param hash The hash to continue from, or MC_MESH_CACHE_HASH_INIT.
+ * \return The updated hash.
+ */
+uint64_t mcMeshCache_hashBytes(
+    const void *bytes,
+    size_t size,
+    uint64_t hash);
+
+/** The initial value for mcMeshCache_hashBytes(). */
+#define MC_MESH_CACHE_HASH_INIT 0xcbf29ce484222325ull
+
+/** @} */
+
+/** @} */
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_MESH_ENCODING_H_
+#define MC_MESH_ENCODING_H_
+
+/**
+ * \addtogroup libmc
+ * @{
+ */
+
+/**
+ * \defgroup mcMeshEncoding mcMeshEncoding
+ */
+
+/**
+ * \addtogroup mcMeshEncoding
+ * @{
+ */
+
+/** \file mc/meshEncoding.h
+ *
+ * This file contains routines for storing meshes in a compact binary format,
+ * suitable for caching extracted meshes on disk.
+ *
+ * An encoded mesh consists of an mcEncodedMeshHeader followed by three
+ * sections, each starting at a four byte aligned offset given in the header:
+ *
+ * - Vertex positions, as three unsigned 16-bit integers per vertex quantized
+ *   within the bounding box of the mesh.
+ * - Vertex normals, as two signed 16-bit integers per vertex giving the
+ *   octahedral projection of the unit normal.
+ * - Faces. For meshes that are not triangle meshes, the number of indices of
+ *   each face is stored first as one byte per face. Vertex indices follow as
+ *   the zig-zag encoded difference from the previous index, written as
+ *   little-endian base 128 variable length integers.
+ *
+ * All values are little-endian. Since the fixed size sections are aligned,
+ * encoded meshes can be memory mapped and their positions and normals decoded
+ * in place.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mc/mesh.h>
+
+/** The magic number at the start of every encoded mesh, "MCM1". */
+#define MC_ENCODED_MESH_MAGIC 0x314d434du
+
+/**
+ * The header at the start of an encoded mesh.
+ */
+typedef struct mcEncodedMeshHeader {
+  /** Always MC_ENCODED_MESH_MAGIC. */
+  uint32_t magic;
+  /** The total size of the encoded mesh in bytes, including this header. */
+  uint32_t size;
+  uint32_t numVertices, numFaces, numIndices;
+  /** Nonzero if every face of the mesh is a triangle. */
+  uint32_t isTriangleMesh;
+  /** A quantized position q decodes to min + q * scale along each axis. */
+  float min[3], scale[3];
+  /** The byte offsets of each section from the start of the header. */
+  uint32_t positionsOffset, normalsOffset, facesOffset;
+} mcEncodedMeshHeader;
+
+/**
+ * Returns an upper bound on the size in bytes of the encoding of the given
+ * mesh, suitable for allocating a buffer for mcMeshEncoding_encode().
+ */
+size_t mcMeshEncoding_encodedSizeBound(
+    const mcMesh *mesh);
+
+/**
+ * Encodes the given mesh into the given buffer. Faces may have at most 255
+ * vertex indices.
+ *
+ * \param mesh The mesh to encode.
+ * \param buffer The buffer in which to store the encoded mesh, which should
+ * be at least mcMeshEncoding_encodedSizeBound() bytes long.
+ * \param bufferSize The size of \p buffer in bytes.
+ * \return The size of the encoded mesh in bytes.
+ */
+size_t mcMeshEncoding_encode(
+    const mcMesh *mesh,
+    void *buffer,
+    size_t bufferSize);
+
+/**
+ * Returns the header of the given encoded mesh, or NULL if \p size bytes do
+ * not hold a complete encoded mesh.
+ */
+const mcEncodedMeshHeader *mcMeshEncoding_header(
+    const void *buffer,
+    size_t size);
+
+/**
+ * Decodes the given encoded mesh directly into flat arrays ready to upload to
+ * a GPU.
+ *
+ * \param buffer The encoded mesh, which must have been validated with
+ * mcMeshEncoding_header().
+ * \param positions An array of three floats per vertex for the positions, or
+ * NULL.
+ * \param normals An array of three floats per vertex for the normals, or
+ * NULL.
+ * \param indices An array of numIndices vertex indices, or NULL.
+ * \param faceSizes An array of numFaces face sizes, or NULL. Face sizes are
+ * only needed for meshes that are not triangle meshes.
+ * \return Zero if the face section of the encoded mesh is malformed.
+ */
+int mcMeshEncoding_decodeArrays(
+    const void *buffer,
+    float *positions,
+    float *normals,
+    unsigned int *indices,
+    unsigned char *faceSizes);
+
+/**
+ * Decodes the given encoded mesh, adding its vertices and faces to the given
+ * initialized mesh.
+ *
+ * \return Zero if \p buffer does not hold a valid encoded mesh, in which case
+ * \p mesh is left unchanged.
+ */
+int mcMeshEncoding_decode(
+    const void *buffer,
+    size_t size,
+    mcMesh *mesh);
+
+/** @} */
+
+/** @} */
+
+#endif
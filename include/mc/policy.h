@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_POLICY_H_
+#define MC_POLICY_H_
+
+/**
+ * \addtogroup libmc
+ * @{
+ */
+
+/**
+ * \defgroup mcPolicy mcPolicy
+ */
+
+/**
+ * \addtogroup mcPolicy
+ * @{
+ */
+
+/** \file mc/policy.h
+ *
+ * This file contains the calibration behind the policy algorithm flags, such
+ * as MC_CPU_PERFORMANCE_ALGORITHM and MC_LOW_MEMORY_ALGORITHM. The first time
+ * a policy flag is used, libmc times the candidate algorithms on a small test
+ * field on the current machine. Each policy then picks the algorithm, thread
+ * count and block size that best meet its goal from those timings.
+ */
+
+#include <mc/algorithms.h>
+#include <mc/mesh.h>
+#include <mc/scalarField.h>
+#include <mc/vector.h>
+
+/** The number of concrete algorithms that policies choose between. */
+#define MC_POLICY_NUM_CANDIDATES 2
+/** The number of block sizes tried during calibration. */
+#define MC_POLICY_NUM_BLOCK_SIZES 2
+
+/**
+ * The timings measured by the policy calibration.
+ */
+typedef struct mcPolicyCalibration {
+  /** The candidate algorithms, in the order of their timings. */
+  mcAlgorithmFlag candidates[MC_POLICY_NUM_CANDIDATES];
+  /** The time in seconds per cube taken by each candidate algorithm on a
+   * single thread. */
+  float cubeCost[MC_POLICY_NUM_CANDIDATES];
+  /** The block sizes tried, in cubes along each axis. */
+  unsigned int blockSizes[MC_POLICY_NUM_BLOCK_SIZES];
+  /** The time in seconds per cube taken by the fastest candidate when the
+   * lattice is split into blocks of each size and extracted with maxThreads
+   * threads, including welding the blocks back together. Blocks are not
+   * timed, and their costs are zero, when only one thread is available. */
+  float blockCost[MC_POLICY_NUM_BLOCK_SIZES];
+  /** The number of threads available for extracting blocks. */
+  unsigned int maxThreads;
+} mcPolicyCalibration;
+
+/**
+ * A concrete way to extract an isosurface, as chosen for a policy.
+ */
+typedef struct mcPolicy {
+  /** The isosurface extraction algorithm. */
+  mcAlgorithmFlag algorithm;
+  /** The number of threads that extract blocks at the same time. */
+  unsigned int numThreads;
+  /** The number of cubes along each axis of the blocks that the lattice is
+   * split into, or zero to extract the whole lattice at once. */
+  unsigned int blockSize;
+} mcPolicy;
+
+/**
+ * Returns the policy calibration for this machine. The calibration is run on
+ * the first call only, and the same results are returned afterwards. It is
+ * safe to call this from several threads.
+ */
+const mcPolicyCalibration *mcPolicy_calibration();
+
+/**
+ * Chooses a concrete algorithm, thread count and block size for the given
+ * policy flag and lattice resolution, calibrating first if needed.
+ *
+ * - MC_CPU_PERFORMANCE_ALGORITHM takes the fastest algorithm and block size.
+ * - MC_CPU_BALANCE_ALGORITHM and MC_DEFAULT_ALGORITHM take Marching Cubes 33,
+ *   whose meshes have no holes, unless it is much slower than the fastest
+ *   algorithm on this machine. MC_DEFAULT_ALGORITHM always runs on a single
+ *   thread without blocks, so that scalar fields need not be thread-safe.
+ * - MC_CPU_QUALITY_ALGORITHM always takes Marching Cubes 33.
+ * - MC_LOW_MEMORY_ALGORITHM takes the fastest algorithm on a single thread
+ *   without blocks. These algorithms keep only two slices of the lattice, and
+ *   blocks would need a welder holding every vertex of the mesh.
+ *
+ * Lattices are only split into blocks for the MC_CPU_* flags, and only when
+ * that was faster during calibration and there are enough blocks to keep
+ * every thread busy.
+ *
+ * \param policy One of the policy flags listed above.
+ * \param x_res The number of samples along the x-axis.
+ * \param y_res The number of samples along the y-axis.
+ * \param z_res The number of samples along the z-axis.
+ * \param result The chosen policy.
+ */
+void mcPolicy_select(
+    mcAlgorithmFlag policy,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    mcPolicy *result);
+
+/**
+ * Extracts an isosurface as described by the given policy. If the policy
+ * splits the lattice into blocks, the blocks are extracted in parallel and
+ * welded into \p mesh, so the scalar field must be safe to call from several
+ * threads. Each sample is still evaluated at exactly the same position that
+ * extracting the whole lattice at once would use, so the blocks meet without
+ * cracks. If \p sf is mcScalarFieldDescriptor_scalarField(), each block is
+ * given the lattice sampler of the descriptor along with the bounds of the
+ * block within the whole lattice.
+ *
+ * \param policy The algorithm, thread count and block size to use.
+ * \param sf The scalar field to extract an isosurface from.
+ * \param args Arguments passed to the scalar field.
+ * \param x_res The number of samples along the x-axis.
+ * \param y_res The number of samples along the y-axis.
+ * \param z_res The number of samples along the z-axis.
+ * \param min The position of the first sample.
+ * \param max The position of the last sample.
+ * \param mesh An initialized mesh that receives the isosurface.
+ */
+void mcPolicy_isosurfaceFromField(
+    const mcPolicy *policy,
+    mcScalarFieldWithArgs sf,
+    const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max,
+    mcMesh *mesh);
+
+/** @} */
+
+/** @} */
+
+#endif
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_SAMPLE_GRID_H_
+#define MC_SAMPLE_GRID_H_
+
+/**
+ * \addtogroup libmc
+ * @{
+ */
+
+/**
+ * \defgroup mcSampleGrid mcSampleGrid
+ */
+
+/**
+ * \addtogroup mcSampleGrid
+ * @{
+ */
+
+/** \file mc/sampleGrid.h
+ *
+ * This file contains a lattice of scalar field samples that is evaluated once
+ * and can then be passed to any isosurface extraction algorithm in place of
+ * the scalar field itself. When a scalar field is expensive to evaluate, this
+ * avoids sampling it again for every algorithm or pass that visits the same
+ * lattice.
+ */
+
+#include <mc/scalarField.h>
+#include <mc/vector.h>
+
+/**
+ * A regular lattice of samples of a scalar field between two corners.
+ *
+ * A sample grid may also be a view of the samples of another sample grid,
+ * taking every stride-th sample along each axis. Views do not own their
+ * samples, and must not outlive the grid that does.
+ */
+typedef struct mcSampleGrid {
+  /** The sample values, with x varying fastest. */
+  float *samples;
+  /** The number of samples stored along each axis. */
+  unsigned int size[3];
+  /** The number of samples in this grid (or view) along each axis. */
+  unsigned int res[3];
+  /** The distance between consecutive stored samples used by this grid. */
+  unsigned int stride;
+  /** The positions of the first and last samples. */
+  mcVec3 min, max;
+  /** The distance between samples of this grid along each axis. */
+  mcVec3 delta;
+  int ownsSamples;
+} mcSampleGrid;
+
+/**
+ * Initializes a sample grid by sampling the given scalar field over a regular
+ * lattice. Samples are taken in parallel when libmc is built with OpenMP, so
+ * the scalar field must be safe to call from several threads.
+ *
+ * If \p sf is mcScalarFieldDescriptor_scalarField(), the whole lattice is
+ * sampled with the lattice sampler of the descriptor instead, and samples far
+ * from the isosurface may only keep their sign.
+ *
+ * \param self The sample grid to initialize.
+ * \param sf The scalar field to sample.
+ * \param args Auxiliary arguments to the scalar field function.
+ * \param x_res The number of samples along the x-axis.
+ * \param y_res The number of samples along the y-axis.
+ * \param z_res The number of samples along the z-axis.
+ * \param min The position of the first sample.
+ * \param max The position of the last sample.
+ */
+void mcSampleGrid_init(
+    mcSampleGrid *self,
+    mcScalarFieldWithArgs sf,
+    const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max);
+
+/**
+ * Initializes a sample grid by sampling the given scalar field coarse to fine,
+ * so that the number of samples taken grows with the area of the isosurface
+ * rather than the volume of the lattice.
+ *
+ * The field is first sampled at every \p step-th lattice point along each
+ * axis. Coarse cells whose corners do not all lie on the same side of the
+ * isosurface are refined by sampling every lattice point within them, along
+ * with the coarse cells up to \p dilation cells away. The samples of all other
+ * cells are trilinearly interpolated from their coarse corners. Sampled cells
+ * build exactly the same isosurface as mcSampleGrid_init() would, and a
+ * dilation of at least one also keeps the normals estimated from the samples
+ * around them.
+ *
+ * Features smaller than a coarse cell that fit entirely between coarse
+ * samples, such as thin walls or small islands, are missed unless they lie
+ * within the dilation of a refined cell. Larger dilations trade samples for
+ * safety.
+ *
+ * \param self The sample grid to initialize.
+ * \param sf The scalar field to sample.
+ * \param args Auxiliary arguments to the scalar field function.
+ * \param x_res The number of samples along the x-axis.
+ * \param y_res The number of samples along the y-axis.
+ * \param z_res The number of samples along the z-axis.
+ * \param min The position of the first sample.
+ * \param max The position of the last sample.
+ * \param step The number of fine samples along each edge of a coarse cell.
+ * \param dilation The number of coarse cells around each cell containing the
+ * isosurface that are refined as well.
+ */
+void mcSampleGrid_initCoarseToFine(
+    mcSampleGrid *self,
+    mcScalarFieldWithArgs sf,
+    const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max,
+    unsigned int step, unsigned int dilation);
+
+/**
+ * Initializes a view of every other sample of the given sample grid along each
+ * axis, which covers the same bounds at half the resolution. If the resolution
+ * of \p other along an axis is even, the view stops one sample short of the
+ * maximum along that axis.
+ *
+ * This allows coarse cells, such as the regular cells next to transvoxel
+ * transition cells, to be built from the same samples as the fine cells.
+ *
+ * \param self The sample grid view to initialize.
+ * \param other The sample grid to view, which must have a resolution of at
+ * least two along each axis.
+ */
+void mcSampleGrid_initHalfResolution(
+    mcSampleGrid *self,
+    const mcSampleGrid *other);
+
+/**
+ * Frees the samples held by the given sample grid, unless it is a view.
+ *
+ * \param self The sample grid to destroy.
+ */
+void mcSampleGrid_destroy(
+    mcSampleGrid *self);
+
+/**
+ * Returns the sample at the given lattice coordinates of the sample grid.
+ */
+static inline float mcSampleGrid_sample(
+    const mcSampleGrid *self,
+    unsigned int x, unsigned int y, unsigned int z)
+{
+  return self->samples[
+    ((z * self->stride) * self->size[1] + y * self->stride) * self->size[0]
+    + x * self->stride];
+}
+
+/**
+ * A scalar field function with args that reads from the sample grid given as
+ * \p args. Positions on the lattice of the sample grid return the stored
+ * samples exactly, and other positions are trilinearly interpolated from the
+ * surrounding samples.
+ *
+ * Passing this function with a sample grid to an isosurface extraction
+ * algorithm using the same resolution and bounds as the sample grid builds
+ * the same isosurface as the original scalar field, since the algorithm only
+ * samples the lattice. Algorithms that sample between lattice points, such as
+ * those that relax or refine vertex positions, see the interpolated field
+ * instead.
+ */
+float mcSampleGrid_scalarField(
+    float x, float y, float z,
+    const void *args);
+
+/** @} */
+
+/** @} */
+
+#endif
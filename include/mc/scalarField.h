@@ -29,6 +29,8 @@
  * @{
  */
 
+#include <mc/vector.h>
+
 /**
  * The function signature for a scalar field in libmc.
  *
@@ -46,6 +48,94 @@ typedef float (*mcScalarField)(float x, float y, float z);
 typedef float (*mcScalarFieldWithArgs)(
     float x, float y, float z, const void *args);
 
+/**
+ * The function signature for sampling a block of a regular lattice of a scalar
+ * field in a single call. The lattice has its first sample at \p min and a
+ * distance of \p delta between samples. The block consists of the res[0] by
+ * res[1] by res[2] samples starting at the lattice coordinates \p start, so
+ * the sample with block coordinates (i, j, k) lies at
+ * min->x + (float)(start[0] + i) * delta->x along the x-axis, and so on for
+ * the other axes. It is stored in samples[i + (j + k * res[1]) * res[0]].
+ *
+ * Samples near the isosurface must hold exactly the value of the scalar field
+ * at their position, but samples far from it need only have the right sign.
+ *
+ * \p scratch points to a pointer that is NULL before the first call. The
+ * sampler may store memory allocated with malloc() there and reuse it in later
+ * calls with the same scratch pointer, which sample blocks of the same lattice
+ * that only differ in their start and resolution along the z-axis. The caller
+ * frees the scratch memory once it is done sampling.
+ *
+ * \sa mcScalarFieldDescriptor
+ */
+typedef void (*mcLatticeSampler)(
+    const void *args,
+    const mcVec3 *min, const mcVec3 *delta,
+    const unsigned int *start, const unsigned int *res,
+    void **scratch,
+    float *samples);
+
+/**
+ * Describes a scalar field along with an optional lattice sampler that knows
+ * how to sample it faster than one point at a time. Fields with structure
+ * that a lattice sampler can exploit, such as mcHeightField, mcLipschitzField
+ * and mcFieldProgram, provide a descriptor of their own.
+ *
+ * To use a descriptor, pass mcScalarFieldDescriptor_scalarField() to any
+ * builder entry point, with the descriptor as the scalar field arguments. The
+ * samplers of the extraction algorithms then use the lattice sampler wherever
+ * they sample whole lattices.
+ */
+typedef struct mcScalarFieldDescriptor {
+  /** The scalar field. */
+  mcScalarFieldWithArgs sf;
+  /** Arguments passed to the scalar field and the lattice sampler. */
+  const void *args;
+  /** The lattice sampler, or NULL to evaluate the scalar field at every
+   * sample. */
+  mcLatticeSampler sampleLattice;
+} mcScalarFieldDescriptor;
+
+/**
+ * Initializes a descriptor for the given scalar field without a lattice
+ * sampler.
+ */
+void mcScalarFieldDescriptor_init(
+    mcScalarFieldDescriptor *self,
+    mcScalarFieldWithArgs sf,
+    const void *args);
+
+/**
+ * Initializes a descriptor from a scalar field passed to a builder entry
+ * point. If \p sf is mcScalarFieldDescriptor_scalarField(), the descriptor
+ * given as \p args is copied. Otherwise, the descriptor describes \p sf
+ * without a lattice sampler.
+ */
+void mcScalarFieldDescriptor_initFromField(
+    mcScalarFieldDescriptor *self,
+    mcScalarFieldWithArgs sf,
+    const void *args);
+
+/**
+ * A scalar field that evaluates the field described by the descriptor passed
+ * as its arguments.
+ */
+float mcScalarFieldDescriptor_scalarField(
+    float x, float y, float z,
+    const void *args);
+
+/**
+ * Samples a block of a regular lattice of the described field, as described
+ * for mcLatticeSampler. Fields without a lattice sampler are evaluated at
+ * every sample, which gives exactly the value of the field everywhere.
+ */
+void mcScalarFieldDescriptor_sampleLattice(
+    const mcScalarFieldDescriptor *self,
+    const mcVec3 *min, const mcVec3 *delta,
+    const unsigned int *start, const unsigned int *res,
+    void **scratch,
+    float *samples);
+
 /** @} */
 
 #endif
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_VERTEX_CACHE_H_
+#define MC_VERTEX_CACHE_H_
+
+/**
+ * \addtogroup libmc
+ * @{
+ */
+
+/**
+ * \defgroup mcVertexCache mcVertexCache
+ */
+
+/**
+ * \addtogroup mcVertexCache
+ * @{
+ */
+
+/** \file mc/vertexCache.h
+ *
+ * This file contains routines for reordering the triangles and vertices of
+ * meshes so that they render efficiently on GPUs.
+ *
+ * The isosurface extraction algorithms generate triangles in the order that
+ * they sweep the lattice, which makes poor use of the post-transform vertex
+ * cache of a GPU. These routines reorder triangles so that triangles sharing
+ * vertices are drawn close together, and then renumber the vertices in the
+ * order that they are first used so that vertex fetches are mostly
+ * sequential.
+ */
+
+#include <mc/mesh.h>
+
+/** The number of vertices in the simulated cache that triangles are ordered
+ * for by default. */
+#define MC_VERTEX_CACHE_DEFAULT_SIZE 32
+
+/**
+ * Reorders the given triangles for vertex cache locality in place, using the
+ * greedy algorithm described by Tom Forsyth in "Linear-Speed Vertex Cache
+ * Optimisation." Each triangle is kept intact, including its winding.
+ *
+ * \param indices The vertex indices of the triangles, three per triangle.
+ * \param numTriangles The number of triangles.
+ * \param numVertices One more than the largest vertex index.
+ * \param cacheSize The size of the simulated least recently used cache.
+ */
+void mcVertexCache_optimizeTriangles(
+    unsigned int *indices,
+    unsigned int numTriangles,
+    unsigned int numVertices,
+    unsigned int cacheSize);
+
+/**
+ * Renumbers vertices in the order that they are first referenced by the given
+ * indices, and rewrites the indices in place.
+ *
+ * \param indices The vertex indices to rewrite.
+ * \param numIndices The number of vertex indices.
+ * \param numVertices One more than the largest vertex index.
+ * \param remap An array of \p numVertices elements in which to store the new
+ * index of each vertex, or UINT_MAX for vertices that are never referenced.
+ * \return The number of vertices referenced by the indices.
+ */
+unsigned int mcVertexCache_optimizeVertexFetch(
+    unsigned int *indices,
+    unsigned int numIndices,
+    unsigned int numVertices,
+    unsigned int *remap);
+
+/**
+ * Simulates a first-in first-out post-transform vertex cache of the given
+ * size and returns the average cache miss ratio (ACMR), which is the number
+ * of vertices transformed per triangle. The ACMR ranges from 3.0 for a cache
+ * that never hits down to about 0.5 for a regular grid of triangles.
+ */
+float mcVertexCache_averageCacheMissRatio(
+    const unsigned int *indices,
+    unsigned int numTriangles,
+    unsigned int cacheSize);
+
+/**
+ * Reorders the faces of the given mesh with mcVertexCache_optimizeTriangles()
+ * and then its vertices with mcVertexCache_optimizeVertexFetch(). Faces are
+ * only reordered for triangle meshes. Vertices not referenced by any face are
+ * removed from the mesh.
+ */
+void mcVertexCache_optimizeMesh(
+    mcMesh *mesh,
+    unsigned int cacheSize);
+
+/**
+ * Computes the average cache miss ratio of the given triangle mesh with
+ * mcVertexCache_averageCacheMissRatio().
+ */
+float mcVertexCache_meshAverageCacheMissRatio(
+    const mcMesh *mesh,
+    unsigned int cacheSize);
+
+/** @} */
+
+/** @} */
+
+#endif
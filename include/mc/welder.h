@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MC_WELDER_H_
+#define MC_WELDER_H_
+
+/**
+ * \addtogroup libmc
+ * @{
+ */
+
+/**
+ * \defgroup mcWelder mcWelder
+ */
+
+/**
+ * \addtogroup mcWelder
+ * @{
+ */
+
+/** \file mc/welder.h
+ *
+ * This file contains the mcWelder structure, which merges meshes built
+ * separately for neighboring parts of the same scalar field into a single
+ * mesh without duplicate vertices along their shared boundaries.
+ */
+
+#include <stdint.h>
+
+#include <mc/mesh.h>
+
+/** The number of key steps along each lattice edge. Vertices closer than
+ * this fraction of the lattice spacing may be welded together. */
+#define MC_WELDER_SUBDIVISIONS 256
+/** Vertices with the same key are only welded if they lie within this
+ * fraction of the lattice spacing of each other along every axis, plus a few
+ * units of floating point rounding at their distance from the origin. This
+ * allows for rounding, but keeps apart distinct vertices close to the same
+ * sample. */
+#define MC_WELDER_TOLERANCE (1.0f / 65536.0f)
+
+/**
+ * Welds meshes into a merged mesh. Each vertex is keyed by its position
+ * quantized to a fine integer grid aligned with the sampling lattice, and
+ * vertices with equal keys from different meshes are merged. Since the
+ * vertices along chunk boundaries lie on lattice edges that both chunks sample
+ * identically, their keys match exactly even when their floating point
+ * positions differ by rounding.
+ *
+ * Distinct vertices near the same sample can also share a key. Vertices of the
+ * same mesh are therefore never merged with each other, and a vertex is only
+ * merged with the closest earlier vertex with its key that lies within
+ * MC_WELDER_TOLERANCE.
+ *
+ * The welder keeps its hash table between calls, so chunks can be welded into
+ * the merged mesh one at a time as they are built.
+ */
+typedef struct mcWelder {
+  /** The merged mesh that meshes are welded into. */
+  mcMesh *mesh;
+  /** The distance between adjacent lattice samples along each axis. */
+  mcVec3 delta;
+  /** The quantized key of each hash table slot, three integers per slot. */
+  int64_t *keys;
+  /** The merged vertex index in each hash table slot, or -1 for empty
+   * slots. */
+  int *indices;
+  unsigned int tableSize, numEntries;
+} mcWelder;
+
+/**
+ * Initializes a welder that welds meshes into the given mesh. Any vertices
+ * already in \p mesh, such as those of a previously merged mesh, are entered
+ * into the welder so that new meshes are welded onto them.
+ *
+ * \param self The welder to initialize.
+ * \param mesh An initialized mesh that receives the welded meshes.
+ * \param delta The distance between adjacent lattice samples along each axis,
+ * which must be the same for every mesh welded.
+ */
+void mcWelder_init(
+    mcWelder *self,
+    mcMesh *mesh,
+    const mcVec3 *delta);
+
+/**
+ * Frees the hash table of the given welder. The merged mesh is left intact.
+ */
+void mcWelder_destroy(
+    mcWelder *self);
+
+/**
+ * Welds the given mesh into the merged mesh.
+ *
+ * \param self The welder.
+ * \param mesh The mesh to add.
+ * \param offset The position of the mesh space origin of \p mesh within the
+ * mesh space of the merged mesh. For a mesh built by the isosurface builder,
+ * this is the \p min it was built with minus the \p min of the first mesh.
+ * The offset should be a whole number of lattice steps along each axis.
+ */
+void mcWelder_addMesh(
+    mcWelder *self,
+    const mcMesh *mesh,
+    const mcVec3 *offset);
+
+/**
+ * Welds several meshes into the given output mesh with a temporary
+ * mcWelder.
+ *
+ * \param meshes The meshes to weld.
+ * \param offsets The offset of each mesh, as given to mcWelder_addMesh().
+ * \param numMeshes The number of meshes to weld.
+ * \param delta The distance between adjacent lattice samples along each axis.
+ * \param output An initialized mesh that receives the welded meshes.
+ */
+void mcWelder_weldMeshes(
+    const mcMesh *const *meshes,
+    const mcVec3 *offsets,
+    unsigned int numMeshes,
+    const mcVec3 *delta,
+    mcMesh *output);
+
+/** @} */
+
+/** @} */
+
+#endif
@@ -44,6 +44,22 @@ namespace mc {
       int numLines() const { return m_internal->numLines; }
 
       int numIndices() const { return 2 * m_internal->numLines; }
+
+      int numPolylines() const { return m_internal->numPolylines; }
+
+      /** Returns the ordered vertex indices of the given polyline. */
+      const int *polyline(int i) const {
+        return &m_internal->polylineIndices[m_internal->polylineOffsets[i]];
+      }
+
+      int polylineSize(int i) const {
+        return m_internal->polylineOffsets[i + 1]
+          - m_internal->polylineOffsets[i];
+      }
+
+      int numPolylineIndices() const {
+        return m_internal->numPolylineIndices;
+      }
   };
 }
 
@@ -43,6 +43,8 @@ namespace mc {
       ContourBuilder();
       ~ContourBuilder();
 
+      void setFormat(mcContourFormat format);
+
       const Contour *buildContour(
           ScalarField &sf,
           mcAlgorithmFlag algorithm,
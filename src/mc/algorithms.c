@@ -50,6 +50,9 @@ mcAlgorithmFlag mcAlgorithm_stringToFlag(const char *string) {
     STRING_FLAG(MIDPOINT_MARCHING_CUBES),
     STRING_FLAG(NIELSON_DUAL),
     STRING_FLAG(ORIGINAL_MARCHING_CUBES),
+    STRING_FLAG(ADAPTIVE_DUAL_CONTOURING),
+    STRING_FLAG(ADAPTIVE_MARCHING_SQUARES),
+    STRING_FLAG(MARCHING_CUBES_33),
   };
   for (int i = 0; i < sizeof(table) / sizeof(table[0]); ++i) {
     if (strcmp(string, table[i].string) == 0) {
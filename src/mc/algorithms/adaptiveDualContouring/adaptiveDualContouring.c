@@ -0,0 +1,625 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <mc/algorithms/adaptiveDualContouring/adaptiveDualContouring.h>
+#include <mc/algorithms/common/cube.h>
+#include <mc/algorithms/common/qef.h>
+#include <mc/algorithms/simple/simple_tables.h>
+#include <mc/common/octNode.h>
+#include <mc/mesh.h>
+#include <mc/scalarField.h>
+#include <mc/vector.h>
+
+/* How far, in units of the lattice spacing, a cell vertex may stray outside
+ * of its cell before the vertex is pulled back to the mass point */
+#define MC_ADAPTIVE_DUAL_CONTOURING_CELL_EPSILON 1.0e-3f
+
+/**
+ * The samples of the entire lattice. Unlike the slice-by-slice algorithms,
+ * the octree is built bottom-up over the whole lattice before any faces are
+ * generated, so all of the samples are kept.
+ */
+typedef struct mcAdaptiveDualContouringLattice {
+  float *samples;
+  int res[3];
+  float delta[3];
+} mcAdaptiveDualContouringLattice;
+
+/**
+ * The data stored in each octree node that intersects the isosurface. The
+ * quadratic error function and normals of an internal node are the sums of
+ * those of its children, so that the node can be collapsed into a leaf.
+ */
+typedef struct mcAdaptiveDualContouringCell {
+  /** The tangent planes at the edge intersections within the cell, in
+   * lattice coordinates. */
+  mcQef qef;
+  /** The sum of the unit surface normals at the edge intersections, in mesh
+   * space. */
+  mcVec3 normal;
+  /** The position of the cell's vertex in lattice coordinates. */
+  mcVec3 vertex;
+  /** Nonzero if this cell is a leaf whose isosurface is a single sheet, which
+   * makes the cell a candidate for being collapsed into its parent. */
+  int collapsible;
+  /** The index of the cell's vertex in the mesh, or -1 if this cell is not a
+   * leaf. */
+  int vertexIndex;
+} mcAdaptiveDualContouringCell;
+
+void mcAdaptiveDualContouringParams_default(
+    mcAdaptiveDualContouringParams *params)
+{
+  params->type = MC_ADAPTIVE_DUAL_CONTOURING_PARAMS;
+  params->tolerance = 0.01f;
+  params->triangulate = 1;
+}
+
+static inline float mcAdaptiveDualContouring_sample(
+    const mcAdaptiveDualContouringLattice *lattice, int x, int y, int z)
+{
+  return lattice->samples[x + y * lattice->res[0]
+    + z * lattice->res[0] * lattice->res[1]];
+}
+
+/**
+ * Estimates the gradient at the given lattice point in lattice coordinates,
+ * using central differences within the lattice and one-sided differences at
+ * its boundaries.
+ */
+void mcAdaptiveDualContouring_gradient(
+    const mcAdaptiveDualContouringLattice *lattice, const int *pos,
+    float *gradient)
+{
+  for (int axis = 0; axis < 3; ++axis) {
+    int a[3] = { pos[0], pos[1], pos[2] };
+    int b[3] = { pos[0], pos[1], pos[2] };
+    if (a[axis] > 0)
+      a[axis] -= 1;
+    if (b[axis] < lattice->res[axis] - 1)
+      b[axis] += 1;
+    gradient[axis] =
+      (mcAdaptiveDualContouring_sample(lattice, b[0], b[1], b[2])
+       - mcAdaptiveDualContouring_sample(lattice, a[0], a[1], a[2]))
+      / (float)(b[axis] - a[axis]);
+  }
+}
+
+/**
+ * Returns nonzero if the marching cubes triangulation of the given cube
+ * configuration is a single connected patch.
+ */
+int mcAdaptiveDualContouring_isSinglePatch(unsigned int cube) {
+  int parents[MC_CUBE_NUM_EDGES];
+  int root = -1;
+  for (int edge = 0; edge < MC_CUBE_NUM_EDGES; ++edge)
+    parents[edge] = edge;
+  for (int i = 0; i < MC_SIMPLE_MAX_TRIANGLES; ++i) {
+    const int *triangle =
+      mcSimple_triangulationTable[cube].triangles[i].edgeIntersections;
+    if (triangle[0] == -1)
+      break;  /* No more triangles */
+    for (int j = 1; j < 3; ++j) {
+      int a = triangle[0], b = triangle[j];
+      while (parents[a] != a)
+        a = parents[a];
+      while (parents[b] != b)
+        b = parents[b];
+      parents[b] = a;
+    }
+  }
+  /* Check that every edge intersection shares a single root */
+  const int *edges = mcSimple_edgeIntersectionTable[cube].edges;
+  for (int i = 0; i < MC_CUBE_NUM_EDGES && edges[i] != -1; ++i) {
+    int edge = edges[i];
+    while (parents[edge] != edge)
+      edge = parents[edge];
+    if (root == -1)
+      root = edge;
+    else if (root != edge)
+      return 0;
+  }
+  return 1;
+}
+
+/**
+ * Returns the marching cubes configuration of the cube with the given size
+ * whose first corner is at the given lattice point.
+ */
+unsigned int mcAdaptiveDualContouring_cubeConfiguration(
+    const mcAdaptiveDualContouringLattice *lattice, const int *pos, int size)
+{
+  unsigned int cube = 0;
+  for (unsigned int sampleIndex = 0; sampleIndex < 8; ++sampleIndex) {
+    unsigned int rel[3];
+    mcCube_sampleRelativePosition(sampleIndex, rel);
+    cube |= (mcAdaptiveDualContouring_sample(lattice,
+          pos[0] + rel[0] * size,
+          pos[1] + rel[1] * size,
+          pos[2] + rel[2] * size) >= 0.0f ? 0 : 1) << sampleIndex;
+  }
+  return cube;
+}
+
+/**
+ * Implements the topological safety test of Ju et al. for collapsing an
+ * octree node of the given size. The sign at the midpoint of each edge of the
+ * node must agree with the sign at one of the edge's endpoints, and likewise
+ * for the center of each face and the center of the node with respect to
+ * their corners. Otherwise the finer cells resolve surface details that a
+ * single cell cannot represent.
+ */
+int mcAdaptiveDualContouring_preservesTopology(
+    const mcAdaptiveDualContouringLattice *lattice, const int *pos, int size)
+{
+  int half = size / 2;
+  /* Visit each of the 27 lattice points at the corners, edge midpoints, face
+   * centers and center of the node, with digits 0, 1 and 2 along each axis
+   * selecting pos, pos + half and pos + size */
+  for (int i = 0; i < 27; ++i) {
+    int digits[3] = { i % 3, (i / 3) % 3, i / 9 };
+    if (digits[0] != 1 && digits[1] != 1 && digits[2] != 1)
+      continue;  /* Corners are trivially consistent with themselves */
+    int inside = mcAdaptiveDualContouring_sample(lattice,
+        pos[0] + digits[0] * half,
+        pos[1] + digits[1] * half,
+        pos[2] + digits[2] * half) < 0.0f;
+    int agrees = 0;
+    for (unsigned int sampleIndex = 0; sampleIndex < 8 && !agrees;
+        ++sampleIndex)
+    {
+      unsigned int rel[3];
+      int matches = 1;
+      mcCube_sampleRelativePosition(sampleIndex, rel);
+      /* Only consider the corners of the edge or face that contains the
+       * point */
+      for (int axis = 0; axis < 3; ++axis) {
+        if (digits[axis] != 1 && rel[axis] * 2 != digits[axis])
+          matches = 0;
+      }
+      if (!matches)
+        continue;
+      agrees = inside == (mcAdaptiveDualContouring_sample(lattice,
+            pos[0] + rel[0] * size,
+            pos[1] + rel[1] * size,
+            pos[2] + rel[2] * size) < 0.0f);
+    }
+    if (!agrees)
+      return 0;
+  }
+  return 1;
+}
+
+/**
+ * Returns nonzero if a lattice edge along one of the edges of the octree node
+ * of the given size still generates a face once the node is collapsed into a
+ * leaf. Faces are only generated for edges with a voxel cube on every side,
+ * and the voxel cubes within a leaf share a single vertex, so a node whose
+ * surface only meets the boundary of the lattice would lose every one of its
+ * faces. The four voxel cubes about an edge of a leaf always lie in four
+ * different leaves, however the rest of the octree is collapsed, so such an
+ * edge keeps its face.
+ */
+int mcAdaptiveDualContouring_keepsFace(
+    const mcAdaptiveDualContouringLattice *lattice, const int *pos, int size)
+{
+  for (int axis = 0; axis < 3; ++axis) {
+    int u = (axis + 1) % 3, v = (axis + 2) % 3;
+    for (int j = 0; j <= size; j += size) {
+      for (int k = 0; k <= size; k += size) {
+        int edge[3];
+        edge[u] = pos[u] + j;
+        edge[v] = pos[v] + k;
+        if (edge[u] < 1 || edge[u] >= lattice->res[u] - 1
+            || edge[v] < 1 || edge[v] >= lattice->res[v] - 1)
+          continue;  /* Boundary edges of the lattice have no face */
+        for (int i = 0; i < size; ++i) {
+          edge[axis] = pos[axis] + i;
+          int inside = mcAdaptiveDualContouring_sample(lattice,
+              edge[0], edge[1], edge[2]) < 0.0f;
+          edge[axis] += 1;
+          if (inside != (mcAdaptiveDualContouring_sample(lattice,
+                  edge[0], edge[1], edge[2]) < 0.0f))
+            return 1;
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+/**
+ * Returns nonzero if the given vertex lies within the cube with the given
+ * size whose first corner is at the given lattice point.
+ */
+int mcAdaptiveDualContouring_vertexInCell(
+    const mcVec3 *vertex, const int *pos, int size)
+{
+  const float coord[3] = { vertex->x, vertex->y, vertex->z };
+  for (int axis = 0; axis < 3; ++axis) {
+    if (coord[axis] < (float)pos[axis]
+        - MC_ADAPTIVE_DUAL_CONTOURING_CELL_EPSILON)
+      return 0;
+    if (coord[axis] > (float)(pos[axis] + size)
+        + MC_ADAPTIVE_DUAL_CONTOURING_CELL_EPSILON)
+      return 0;
+  }
+  return 1;
+}
+
+/**
+ * Computes the Hermite data for the voxel cube at the given lattice
+ * coordinates and stores it in \p cell. Returns zero if the voxel cube does
+ * not intersect the isosurface.
+ */
+int mcAdaptiveDualContouring_computeVoxel(
+    const mcAdaptiveDualContouringLattice *lattice, const int *pos,
+    mcAdaptiveDualContouringCell *cell)
+{
+  unsigned int cube =
+    mcAdaptiveDualContouring_cubeConfiguration(lattice, pos, 1);
+  if (cube == 0x00 || cube == 0xff)
+    return 0;
+  mcQef_init(&cell->qef);
+  cell->normal.x = cell->normal.y = cell->normal.z = 0.0f;
+  const int *edges = mcSimple_edgeIntersectionTable[cube].edges;
+  for (int i = 0; i < MC_CUBE_NUM_EDGES && edges[i] != -1; ++i) {
+    unsigned int sampleIndices[2];
+    int samplePos[2][3];
+    float values[2], gradients[2][3];
+    mcCube_edgeSampleIndices(edges[i], sampleIndices);
+    for (int j = 0; j < 2; ++j) {
+      unsigned int rel[3];
+      mcCube_sampleRelativePosition(sampleIndices[j], rel);
+      for (int axis = 0; axis < 3; ++axis)
+        samplePos[j][axis] = pos[axis] + rel[axis];
+      values[j] = mcAdaptiveDualContouring_sample(lattice,
+          samplePos[j][0], samplePos[j][1], samplePos[j][2]);
+      mcAdaptiveDualContouring_gradient(lattice, samplePos[j], gradients[j]);
+    }
+    /* Interpolate the edge intersection and its gradient */
+    float t = values[0] / (values[0] - values[1]);
+    float point[3], gradient[3];
+    for (int axis = 0; axis < 3; ++axis) {
+      point[axis] = (1.0f - t) * samplePos[0][axis] + t * samplePos[1][axis];
+      gradient[axis] = (1.0f - t) * gradients[0][axis]
+        + t * gradients[1][axis];
+    }
+    mcVec3 intersection = { .x = point[0], .y = point[1], .z = point[2] };
+    mcVec3 latticeNormal = {
+      .x = gradient[0], .y = gradient[1], .z = gradient[2] };
+    if (mcVec3_length(&latticeNormal) == 0.0f) {
+      /* Fall back to the direction of the edge itself */
+      latticeNormal.x = (float)(samplePos[1][0] - samplePos[0][0]);
+      latticeNormal.y = (float)(samplePos[1][1] - samplePos[0][1]);
+      latticeNormal.z = (float)(samplePos[1][2] - samplePos[0][2]);
+      if (values[1] < values[0])
+        mcVec3_scalarProduct(-1.0f, &latticeNormal, &latticeNormal);
+    }
+    /* The tangent plane is found in lattice coordinates, but the vertex
+     * normal is given in mesh space */
+    mcVec3 normal = {
+      .x = latticeNormal.x / lattice->delta[0],
+      .y = latticeNormal.y / lattice->delta[1],
+      .z = latticeNormal.z / lattice->delta[2] };
+    mcVec3_normalize(&latticeNormal, &latticeNormal);
+    mcVec3_normalize(&normal, &normal);
+    mcQef_addPlane(&cell->qef, &intersection, &latticeNormal);
+    mcVec3_add(&cell->normal, &normal, &cell->normal);
+  }
+  /* Place the vertex at the minimizer of the quadratic error function, unless
+   * the minimizer falls outside of the voxel cube */
+  mcQef_solve(&cell->qef, &cell->vertex);
+  if (!mcAdaptiveDualContouring_vertexInCell(&cell->vertex, pos, 1)) {
+    mcQef_massPoint(&cell->qef, &cell->vertex);
+  }
+  cell->collapsible = mcAdaptiveDualContouring_isSinglePatch(cube);
+  cell->vertexIndex = -1;
+  return 1;
+}
+
+/**
+ * Frees the cell data stored in the given node and all of its descendants.
+ */
+void mcAdaptiveDualContouring_freeCells(mcOctNode *node) {
+  for (int i = 0; i < 8; ++i) {
+    if (node->children[i])
+      mcAdaptiveDualContouring_freeCells(node->children[i]);
+  }
+  free(node->data);
+  node->data = NULL;
+}
+
+/**
+ * Builds the octree beneath the given node from the bottom up, creating a
+ * child for each octant that intersects the isosurface. The node is then
+ * collapsed into a leaf if its children are all collapsible leaves, the
+ * combined quadratic error is within the tolerance, the collapse does not
+ * change the topology of the surface, and the leaf still has a face. Returns zero if no part of the node
+ * intersects the isosurface, in which case the node has no cell data.
+ */
+int mcAdaptiveDualContouring_buildNode(
+    const mcAdaptiveDualContouringLattice *lattice,
+    const mcAdaptiveDualContouringParams *params,
+    mcOctNode *node)
+{
+  int size = 1 << node->level;
+  int half = size / 2;
+  int collapsible = 1, numChildren = 0;
+  mcAdaptiveDualContouringCell *cell =
+    (mcAdaptiveDualContouringCell*)malloc(
+        sizeof(mcAdaptiveDualContouringCell));
+  mcQef_init(&cell->qef);
+  cell->normal.x = cell->normal.y = cell->normal.z = 0.0f;
+  cell->vertexIndex = -1;
+  for (int i = 0; i < 8; ++i) {
+    mcAdaptiveDualContouringCell voxel;
+    mcAdaptiveDualContouringCell *childCell;
+    mcOctNode *child;
+    int childPos[3];
+    int outside = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+      childPos[axis] = node->pos.coord[axis] + ((i >> axis) & 1) * half;
+      if (childPos[axis] >= lattice->res[axis] - 1)
+        outside = 1;
+    }
+    if (outside)
+      continue;  /* The octant lies beyond the last voxel cube */
+    if (node->level == 1) {
+      /* The children are individual voxel cubes */
+      if (!mcAdaptiveDualContouring_computeVoxel(lattice, childPos, &voxel))
+        continue;
+      child = mcOctNode_createChild(node, i);
+      childCell = (mcAdaptiveDualContouringCell*)malloc(
+          sizeof(mcAdaptiveDualContouringCell));
+      *childCell = voxel;
+      child->data = childCell;
+    } else {
+      child = mcOctNode_createChild(node, i);
+      if (!mcAdaptiveDualContouring_buildNode(lattice, params, child)) {
+        mcOctNode_destroy(child);
+        free(child);
+        node->children[i] = NULL;
+        continue;
+      }
+      childCell = (mcAdaptiveDualContouringCell*)child->data;
+    }
+    mcQef_add(&cell->qef, &childCell->qef);
+    mcVec3_add(&cell->normal, &childCell->normal, &cell->normal);
+    if (!childCell->collapsible)
+      collapsible = 0;
+    numChildren += 1;
+  }
+  if (numChildren == 0) {
+    free(cell);
+    return 0;
+  }
+  node->data = cell;
+  cell->collapsible = 0;
+  if (!collapsible)
+    return 1;
+  /* Nodes straddling the far boundary of the lattice are never collapsed */
+  for (int axis = 0; axis < 3; ++axis) {
+    if (node->pos.coord[axis] + size > lattice->res[axis] - 1)
+      return 1;
+  }
+  unsigned int cube = mcAdaptiveDualContouring_cubeConfiguration(
+      lattice, node->pos.coord, size);
+  if (cube == 0x00 || cube == 0xff
+      || !mcAdaptiveDualContouring_isSinglePatch(cube)
+      || !mcAdaptiveDualContouring_preservesTopology(
+        lattice, node->pos.coord, size)
+      || !mcAdaptiveDualContouring_keepsFace(
+        lattice, node->pos.coord, size))
+  {
+    return 1;
+  }
+  float error = mcQef_solve(&cell->qef, &cell->vertex);
+  if (error > params->tolerance
+      || !mcAdaptiveDualContouring_vertexInCell(
+        &cell->vertex, node->pos.coord, size))
+  {
+    return 1;
+  }
+  /* Collapse the node into a leaf */
+  for (int i = 0; i < 8; ++i) {
+    if (node->children[i])
+      mcAdaptiveDualContouring_freeCells(node->children[i]);
+  }
+  mcOctNode_destroy(node);
+  cell->collapsible = 1;
+  return 1;
+}
+
+/**
+ * Adds the vertex of every leaf cell beneath the given node to the mesh.
+ */
+void mcAdaptiveDualContouring_addVertices(
+    const mcAdaptiveDualContouringLattice *lattice,
+    mcOctNode *node,
+    mcMesh *mesh)
+{
+  int isLeaf = 1;
+  for (int i = 0; i < 8; ++i) {
+    if (node->children[i]) {
+      mcAdaptiveDualContouring_addVertices(lattice, node->children[i], mesh);
+      isLeaf = 0;
+    }
+  }
+  if (!isLeaf || !node->data)
+    return;
+  mcAdaptiveDualContouringCell *cell =
+    (mcAdaptiveDualContouringCell*)node->data;
+  mcVertex vertex;
+  /* NOTE: The positions we compute are in mesh space coordinates, in which
+   * min is at the origin. */
+  vertex.pos.x = cell->vertex.x * lattice->delta[0];
+  vertex.pos.y = cell->vertex.y * lattice->delta[1];
+  vertex.pos.z = cell->vertex.z * lattice->delta[2];
+  vertex.norm = cell->normal;
+  if (mcVec3_length(&vertex.norm) > 0.0f)
+    mcVec3_normalize(&vertex.norm, &vertex.norm);
+  cell->vertexIndex = mcMesh_addVertex(mesh, &vertex);
+}
+
+/**
+ * Returns the vertex index of the leaf cell containing the voxel cube at the
+ * given lattice coordinates.
+ */
+int mcAdaptiveDualContouring_leafVertex(const mcOctNode *root, const int *pos)
+{
+  const mcOctNode *node = root;
+  while (node->level > 0) {
+    int index = 0;
+    for (int axis = 0; axis < 3; ++axis)
+      index |= ((pos[axis] >> (node->level - 1)) & 1) << axis;
+    if (!node->children[index])
+      break;
+    node = node->children[index];
+  }
+  assert(node->data);
+  assert(((const mcAdaptiveDualContouringCell*)node->data)->vertexIndex != -1);
+  return ((const mcAdaptiveDualContouringCell*)node->data)->vertexIndex;
+}
+
+void mcAdaptiveDualContouring_isosurfaceFromField(
+    mcScalarFieldWithArgs sf, const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max,
+    const mcAdaptiveDualContouringParams *params,
+    mcMesh *mesh)
+{
+  mcAdaptiveDualContouringParams defaultParams;
+  if (params == NULL) {
+    mcAdaptiveDualContouringParams_default(&defaultParams);
+    params = &defaultParams;
+  }
+  assert(params->type == MC_ADAPTIVE_DUAL_CONTOURING_PARAMS);
+  assert(x_res >= 2 && y_res >= 2 && z_res >= 2);
+  /* Sample the entire lattice */
+  mcAdaptiveDualContouringLattice lattice;
+  lattice.res[0] = x_res;
+  lattice.res[1] = y_res;
+  lattice.res[2] = z_res;
+  lattice.delta[0] = (max->x - min->x) / (float)(x_res - 1);
+  lattice.delta[1] = (max->y - min->y) / (float)(y_res - 1);
+  lattice.delta[2] = (max->z - min->z) / (float)(z_res - 1);
+  lattice.samples = (float*)malloc(sizeof(float) * x_res * y_res * z_res);
+  mcScalarFieldDescriptor field;
+  mcScalarFieldDescriptor_initFromField(&field, sf, args);
+  mcVec3 delta;
+  delta.x = lattice.delta[0];
+  delta.y = lattice.delta[1];
+  delta.z = lattice.delta[2];
+  const unsigned int start[3] = { 0, 0, 0 };
+  const unsigned int res[3] = { x_res, y_res, z_res };
+  void *scratch = NULL;
+  mcScalarFieldDescriptor_sampleLattice(&field, min, &delta,
+      start, res, &scratch, lattice.samples);
+  free(scratch);
+  /* Make a root node at the origin of the lattice large enough to contain
+   * every voxel cube */
+  mcOctNode root;
+  mcOctNode_init(&root);
+  root.level = 1;
+  while ((1u << root.level) < x_res - 1
+      || (1u << root.level) < y_res - 1
+      || (1u << root.level) < z_res - 1)
+  {
+    root.level += 1;
+  }
+  mcAdaptiveDualContouring_buildNode(&lattice, params, &root);
+  mcAdaptiveDualContouring_addVertices(&lattice, &root, mesh);
+  /* Generate a face for every lattice edge crossing the isosurface that is
+   * surrounded by four voxel cubes. Faces between cells of different sizes
+   * meet at shared vertices, so the mesh has no cracks. */
+  mcFace quad, triangle;
+  mcFace_init(&quad, 4);
+  mcFace_init(&triangle, 3);
+  for (int z = 0; z < (int)z_res; ++z) {
+    for (int y = 0; y < (int)y_res; ++y) {
+      for (int x = 0; x < (int)x_res; ++x) {
+        int pos[3] = { x, y, z };
+        int inside = mcAdaptiveDualContouring_sample(&lattice, x, y, z) < 0.0f;
+        for (int axis = 0; axis < 3; ++axis) {
+          int u = (axis + 1) % 3, v = (axis + 2) % 3;
+          /* The four voxel cubes about the edge are given counter-clockwise
+           * about the positive direction of the edge */
+          static const int offsets[4][2] = {
+            { -1, -1 }, { 0, -1 }, { 0, 0 }, { -1, 0 } };
+          int next[3] = { x, y, z };
+          int vertexIndices[4], numIndices = 0;
+          next[axis] += 1;
+          if (next[axis] >= lattice.res[axis]
+              || pos[u] < 1 || pos[u] >= lattice.res[u] - 1
+              || pos[v] < 1 || pos[v] >= lattice.res[v] - 1)
+            continue;  /* Boundary edges are left open */
+          if (inside == (mcAdaptiveDualContouring_sample(&lattice,
+                  next[0], next[1], next[2]) < 0.0f))
+            continue;
+          for (int i = 0; i < 4; ++i) {
+            int cellPos[3] = { x, y, z };
+            cellPos[u] += offsets[inside ? i : 3 - i][0];
+            cellPos[v] += offsets[inside ? i : 3 - i][1];
+            int index = mcAdaptiveDualContouring_leafVertex(&root, cellPos);
+            /* Collapsed cells can appear more than once about an edge */
+            if (numIndices > 0 && vertexIndices[numIndices - 1] == index)
+              continue;
+            vertexIndices[numIndices++] = index;
+          }
+          if (numIndices > 1 && vertexIndices[numIndices - 1]
+              == vertexIndices[0])
+            numIndices -= 1;
+          if (numIndices == 3) {
+            for (int i = 0; i < 3; ++i)
+              triangle.indices[i] = vertexIndices[i];
+            mcMesh_addFace(mesh, &triangle);
+          } else if (numIndices == 4 && !params->triangulate) {
+            for (int i = 0; i < 4; ++i)
+              quad.indices[i] = vertexIndices[i];
+            mcMesh_addFace(mesh, &quad);
+          } else if (numIndices == 4) {
+            /* Split the quad along the diagonal through its first vertex */
+            triangle.indices[0] = vertexIndices[0];
+            triangle.indices[1] = vertexIndices[1];
+            triangle.indices[2] = vertexIndices[2];
+            mcMesh_addFace(mesh, &triangle);
+            triangle.indices[1] = vertexIndices[2];
+            triangle.indices[2] = vertexIndices[3];
+            mcMesh_addFace(mesh, &triangle);
+          }
+        }
+      }
+    }
+  }
+  /* Free our resources */
+  mcAdaptiveDualContouring_freeCells(&root);
+  mcOctNode_destroy(&root);
+  free(lattice.samples);
+  mcFace_destroy(&quad);
+  mcFace_destroy(&triangle);
+}
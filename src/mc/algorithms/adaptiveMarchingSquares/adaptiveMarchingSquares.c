@@ -21,20 +21,470 @@
  * IN THE SOFTWARE.
  */
 
-#include <mc/common/quadNode.h>
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
-void mcAdaptiveMarchingSquares_contourFromQuadtree(
-    mcQuadNode *root)
+#include <mc/algorithms/adaptiveMarchingSquares/adaptiveMarchingSquares.h>
+
+/**
+ * The lattice being contoured. Only the samples that the quadtree needs are
+ * ever taken, so samples are kept in a hash table keyed on their lattice
+ * index rather than in an array covering the whole lattice. A second hash
+ * table maps the lattice edges crossing the contour to their vertices.
+ */
+typedef struct mcAdaptiveMarchingSquaresLattice {
+  mcScalarFieldWithArgs sf;
+  const void *args;
+  int res[2];
+  float delta[2];
+  mcVec2 min;
+  int64_t *sampleKeys;
+  float *sampleValues;
+  unsigned int sampleTableSize, numSamples;
+  int64_t *vertexKeys;
+  int *vertexIndices;
+  unsigned int vertexTableSize, numVertices;
+} mcAdaptiveMarchingSquaresLattice;
+
+/** Lattice coordinates of the points on the boundary of a leaf cell. */
+typedef struct mcAdaptiveMarchingSquaresPoint {
+  int pos[2];
+} mcAdaptiveMarchingSquaresPoint;
+
+void mcAdaptiveMarchingSquaresParams_default(
+    mcAdaptiveMarchingSquaresParams *params)
+{
+  params->type = MC_ADAPTIVE_MARCHING_SQUARES_PARAMS;
+  params->coarsestLevel = 3;
+}
+
+/**
+ * Returns the slot of the given key in an open addressing hash table, which
+ * holds either the key or -1 if the key is not in the table.
+ */
+unsigned int mcAdaptiveMarchingSquares_findSlot(
+    const int64_t *keys, unsigned int tableSize, int64_t key)
 {
-  /* TODO: Iterate over the quad tree */
-  mcQuadNodeIterator i;
+  unsigned int slot = (unsigned int)(((uint64_t)key * 0x9e3779b97f4a7c15ull)
+      >> 32) & (tableSize - 1);
+  while (keys[slot] != -1 && keys[slot] != key)
+    slot = (slot + 1) & (tableSize - 1);
+  return slot;
+}
 
-  for (
-      i = mcQuadNode_begin(root);
-      i.current != NULL; 
-      mcQuadNodeIterator_next(&i))
+/**
+ * Doubles the size of the sample hash table.
+ */
+void mcAdaptiveMarchingSquares_growSamples(
+    mcAdaptiveMarchingSquaresLattice *self)
+{
+  unsigned int tableSize = self->sampleTableSize * 2;
+  int64_t *keys = (int64_t*)malloc(sizeof(int64_t) * tableSize);
+  float *values = (float*)malloc(sizeof(float) * tableSize);
+  memset(keys, -1, sizeof(int64_t) * tableSize);
+  for (unsigned int i = 0; i < self->sampleTableSize; ++i) {
+    if (self->sampleKeys[i] == -1)
+      continue;
+    unsigned int slot = mcAdaptiveMarchingSquares_findSlot(
+        keys, tableSize, self->sampleKeys[i]);
+    keys[slot] = self->sampleKeys[i];
+    values[slot] = self->sampleValues[i];
+  }
+  free(self->sampleKeys);
+  free(self->sampleValues);
+  self->sampleKeys = keys;
+  self->sampleValues = values;
+  self->sampleTableSize = tableSize;
+}
+
+/**
+ * Doubles the size of the vertex hash table.
+ */
+void mcAdaptiveMarchingSquares_growVertices(
+    mcAdaptiveMarchingSquaresLattice *self)
+{
+  unsigned int tableSize = self->vertexTableSize * 2;
+  int64_t *keys = (int64_t*)malloc(sizeof(int64_t) * tableSize);
+  int *indices = (int*)malloc(sizeof(int) * tableSize);
+  memset(keys, -1, sizeof(int64_t) * tableSize);
+  for (unsigned int i = 0; i < self->vertexTableSize; ++i) {
+    if (self->vertexKeys[i] == -1)
+      continue;
+    unsigned int slot = mcAdaptiveMarchingSquares_findSlot(
+        keys, tableSize, self->vertexKeys[i]);
+    keys[slot] = self->vertexKeys[i];
+    indices[slot] = self->vertexIndices[i];
+  }
+  free(self->vertexKeys);
+  free(self->vertexIndices);
+  self->vertexKeys = keys;
+  self->vertexIndices = indices;
+  self->vertexTableSize = tableSize;
+}
+
+/**
+ * Returns the sample at the given lattice point, sampling the scalar field
+ * the first time each lattice point is needed.
+ */
+float mcAdaptiveMarchingSquares_sample(
+    mcAdaptiveMarchingSquaresLattice *self,
+    int x, int y)
+{
+  assert(x >= 0 && x < self->res[0] && y >= 0 && y < self->res[1]);
+  int64_t key = (int64_t)y * self->res[0] + x;
+  unsigned int slot = mcAdaptiveMarchingSquares_findSlot(
+      self->sampleKeys, self->sampleTableSize, key);
+  if (self->sampleKeys[slot] == key)
+    return self->sampleValues[slot];
+  float value = self->sf(
+      self->min.x + (float)x * self->delta[0],
+      self->min.y + (float)y * self->delta[1],
+      0.0f,
+      self->args);
+  self->sampleKeys[slot] = key;
+  self->sampleValues[slot] = value;
+  /* Keep the table at most half full */
+  if (++self->numSamples * 2 > self->sampleTableSize)
+    mcAdaptiveMarchingSquares_growSamples(self);
+  return value;
+}
+
+/**
+ * Returns the vertex where the contour crosses the axis-aligned lattice
+ * segment between the given points. Each segment is keyed on its lower point,
+ * its axis and its length, which is always a power of two.
+ */
+int mcAdaptiveMarchingSquares_edgeVertex(
+    mcAdaptiveMarchingSquaresLattice *self,
+    const int *a, const int *b,
+    mcContour *contour)
+{
+  int axis = a[0] == b[0] ? 1 : 0;
+  const int *lower = a[axis] < b[axis] ? a : b;
+  const int *upper = a[axis] < b[axis] ? b : a;
+  int length = upper[axis] - lower[axis], level = 0;
+  while ((1 << level) < length)
+    ++level;
+  int64_t key = (((int64_t)lower[1] * self->res[0] + lower[0]) << 6)
+    | (axis << 5) | level;
+  unsigned int slot = mcAdaptiveMarchingSquares_findSlot(
+      self->vertexKeys, self->vertexTableSize, key);
+  if (self->vertexKeys[slot] == key)
+    return self->vertexIndices[slot];
+  /* Interpolate from the lower point, so that the vertex position does not
+   * depend on which cell computes it */
+  float values[2];
+  values[0] = mcAdaptiveMarchingSquares_sample(self, lower[0], lower[1]);
+  values[1] = mcAdaptiveMarchingSquares_sample(self, upper[0], upper[1]);
+  float weight = fabs(values[0] / (values[0] - values[1]));
+  mcVec3 latticePos[2];
+  /* NOTE: These lattice positions are in contour space coordinates, in which
+   * min is at the origin. */
+  latticePos[0].x = (float)lower[0] * self->delta[0];
+  latticePos[0].y = (float)lower[1] * self->delta[1];
+  latticePos[0].z = 0.0f;
+  latticePos[1].x = (float)upper[0] * self->delta[0];
+  latticePos[1].y = (float)upper[1] * self->delta[1];
+  latticePos[1].z = 0.0f;
+  mcVertex vertex;
+  vertex.pos = mcVec3_lerp(&latticePos[0], &latticePos[1], weight);
+  int index = mcContour_addVertex(contour, &vertex);
+  self->vertexKeys[slot] = key;
+  self->vertexIndices[slot] = index;
+  if (++self->numVertices * 2 > self->vertexTableSize)
+    mcAdaptiveMarchingSquares_growVertices(self);
+  return index;
+}
+
+/**
+ * Refines the quadtree beneath the given node. A node is subdivided if it is
+ * above the coarsest level, if it extends beyond the last lattice square, or
+ * if any of the nine samples at its corners, edge midpoints and center differ
+ * in sign. Children lying entirely beyond the lattice are not created.
+ */
+void mcAdaptiveMarchingSquares_refine(
+    mcAdaptiveMarchingSquaresLattice *lattice,
+    const mcAdaptiveMarchingSquaresParams *params,
+    mcQuadNode *node)
+{
+  if (node->level == 0)
+    return;  /* Individual lattice squares cannot be refined */
+  int size = 1 << node->level, half = size / 2;
+  int x0 = node->pos.coord[0], y0 = node->pos.coord[1];
+  int subdivide = 0;
+  if (node->level > (int)params->coarsestLevel
+      || x0 + size > lattice->res[0] - 1
+      || y0 + size > lattice->res[1] - 1)
   {
-    mcQuadNode *n = i.current;
-    /* TODO: Something */
+    subdivide = 1;
+  } else {
+    int inside = mcAdaptiveMarchingSquares_sample(lattice, x0, y0) < 0.0f;
+    for (int i = 0; i < 9 && !subdivide; ++i) {
+      int x = x0 + (i % 3) * half, y = y0 + (i / 3) * half;
+      if ((mcAdaptiveMarchingSquares_sample(lattice, x, y) < 0.0f) != inside)
+        subdivide = 1;
+    }
+  }
+  if (!subdivide)
+    return;
+  for (int i = 0; i < 4; ++i) {
+    if (x0 + (i & 1) * half >= lattice->res[0] - 1
+        || y0 + (i >> 1) * half >= lattice->res[1] - 1)
+      continue;  /* The quadrant lies beyond the last lattice square */
+    mcQuadNode *child = mcQuadNode_createChild(node, i);
+    mcAdaptiveMarchingSquares_refine(lattice, params, child);
+  }
+}
+
+/**
+ * Returns the node at the given level whose lower corner is at the given
+ * lattice coordinates, or the leaf containing that position if the tree is
+ * not refined that far. Returns NULL for positions outside of the lattice.
+ */
+const mcQuadNode *mcAdaptiveMarchingSquares_findNode(
+    const mcQuadNode *root,
+    int x, int y, int level)
+{
+  if (x < 0 || y < 0 || x >= (1 << root->level) || y >= (1 << root->level))
+    return NULL;
+  const mcQuadNode *node = root;
+  while (node->level > level && node->children[0] != NULL) {
+    int index = ((x >> (node->level - 1)) & 1)
+      | (((y >> (node->level - 1)) & 1) << 1);
+    node = node->children[index];
+    if (node == NULL)
+      return NULL;  /* Beyond the last lattice square */
+  }
+  return node;
+}
+
+/**
+ * Appends the lower corners of the leaves beneath the given node that touch
+ * its side facing the given direction along the given axis, in increasing
+ * order along the other axis.
+ */
+void mcAdaptiveMarchingSquares_sideCorners(
+    const mcQuadNode *node,
+    int axis, int side,
+    int *coords, int *numCoords)
+{
+  if (node->children[0] == NULL) {
+    coords[(*numCoords)++] = node->pos.coord[1 - axis];
+    return;
+  }
+  for (int i = 0; i < 2; ++i) {
+    int index = (side << axis) | (i << (1 - axis));
+    if (node->children[index] != NULL)
+      mcAdaptiveMarchingSquares_sideCorners(node->children[index],
+          axis, side, coords, numCoords);
+  }
+}
+
+/**
+ * Finds the points on the boundary of the given leaf along one of its edges.
+ * The coordinates of the points along the edge are stored in increasing
+ * order, starting with the lower end of the edge and excluding the upper end.
+ * Corners of smaller neighboring leaves along the edge are included.
+ *
+ * \param axis The axis perpendicular to the edge.
+ * \param side Zero for the edge at the lower side of the leaf along \p axis,
+ * one for the edge at the upper side.
+ * \param coords Storage for up to 2^level coordinates.
+ * \param numCoords Receives the number of coordinates stored.
+ */
+void mcAdaptiveMarchingSquares_edgeCoords(
+    const mcQuadNode *root,
+    const mcQuadNode *leaf,
+    int axis, int side,
+    int *coords, int *numCoords)
+{
+  int size = 1 << leaf->level;
+  int neighborPos[2] = { leaf->pos.coord[0], leaf->pos.coord[1] };
+  neighborPos[axis] += side ? size : -size;
+  const mcQuadNode *neighbor = mcAdaptiveMarchingSquares_findNode(root,
+      neighborPos[0], neighborPos[1], leaf->level);
+  *numCoords = 0;
+  if (neighbor != NULL && neighbor->level == leaf->level) {
+    /* The neighbor touches this leaf with its opposite side */
+    mcAdaptiveMarchingSquares_sideCorners(neighbor, axis, !side,
+        coords, numCoords);
+  } else {
+    /* The neighbor is a leaf at least as large as this leaf, or this edge
+     * lies on the boundary of the lattice */
+    coords[(*numCoords)++] = leaf->pos.coord[1 - axis];
+  }
+}
+
+/**
+ * Adds the contour lines within the given leaf cell. The boundary of the leaf
+ * is walked counter-clockwise, including the corners of smaller neighboring
+ * leaves, and each crossing where the boundary leaves the inside of the
+ * contour is joined to the next crossing where it enters again. This agrees
+ * with the orientation of the lines in the marching squares line table.
+ */
+void mcAdaptiveMarchingSquares_contourLeaf(
+    mcAdaptiveMarchingSquaresLattice *lattice,
+    const mcQuadNode *root,
+    const mcQuadNode *leaf,
+    int *coords,
+    mcAdaptiveMarchingSquaresPoint *points,
+    int *crossings,
+    mcContour *contour)
+{
+  /* The bottom, right, top and left edges in counter-clockwise order */
+  static const int edges[4][3] = {
+    /* axis, side, reverse */
+    { 1, 0, 0 }, { 0, 1, 0 }, { 1, 1, 1 }, { 0, 0, 1 } };
+  int size = 1 << leaf->level;
+  int numPoints = 0;
+  for (int edge = 0; edge < 4; ++edge) {
+    int axis = edges[edge][0], side = edges[edge][1];
+    int numCoords;
+    mcAdaptiveMarchingSquares_edgeCoords(root, leaf, axis, side,
+        coords, &numCoords);
+    int fixed = leaf->pos.coord[axis] + (side ? size : 0);
+    for (int i = 0; i < numCoords; ++i) {
+      mcAdaptiveMarchingSquaresPoint *point = &points[numPoints++];
+      point->pos[axis] = fixed;
+      if (!edges[edge][2]) {
+        point->pos[1 - axis] = coords[i];
+      } else {
+        /* Walk from the upper end of the edge back towards its lower end */
+        point->pos[1 - axis] = i == 0
+          ? leaf->pos.coord[1 - axis] + size : coords[numCoords - i];
+      }
+    }
+  }
+  /* Find the crossings of the boundary, noting whether each one leaves the
+   * inside of the contour */
+  int numCrossings = 0, firstExit = -1;
+  int inside = mcAdaptiveMarchingSquares_sample(lattice,
+      points[0].pos[0], points[0].pos[1]) < 0.0f;
+  int firstInside = inside;
+  for (int i = 0; i < numPoints; ++i) {
+    const mcAdaptiveMarchingSquaresPoint *next = &points[(i + 1) % numPoints];
+    int nextInside = i + 1 < numPoints
+      ? mcAdaptiveMarchingSquares_sample(lattice,
+          next->pos[0], next->pos[1]) < 0.0f
+      : firstInside;
+    if (nextInside != inside) {
+      if (inside && firstExit == -1)
+        firstExit = numCrossings;
+      crossings[numCrossings++] = mcAdaptiveMarchingSquares_edgeVertex(
+          lattice, points[i].pos, next->pos, contour);
+    }
+    inside = nextInside;
+  }
+  assert(numCrossings % 2 == 0);
+  /* Crossings alternate between leaving and entering the inside */
+  for (int i = 0; i < numCrossings; i += 2) {
+    mcLine line;
+    line.a = crossings[(firstExit + i) % numCrossings];
+    line.b = crossings[(firstExit + i + 1) % numCrossings];
+    mcContour_addLine(contour, &line);
+  }
+}
+
+/**
+ * Adds the contour lines within every leaf beneath the given node.
+ */
+void mcAdaptiveMarchingSquares_contourNode(
+    mcAdaptiveMarchingSquaresLattice *lattice,
+    const mcQuadNode *root,
+    const mcQuadNode *node,
+    int *coords,
+    mcAdaptiveMarchingSquaresPoint *points,
+    int *crossings,
+    mcContour *contour)
+{
+  if (node->children[0] == NULL) {
+    mcAdaptiveMarchingSquares_contourLeaf(lattice, root, node,
+        coords, points, crossings, contour);
+    return;
+  }
+  for (int i = 0; i < 4; ++i) {
+    if (node->children[i] != NULL)
+      mcAdaptiveMarchingSquares_contourNode(lattice, root, node->children[i],
+          coords, points, crossings, contour);
+  }
+}
+
+/**
+ * Contours the lattice over an already refined quadtree, whose leaves are the
+ * cells of the contour.
+ */
+void mcAdaptiveMarchingSquares_contourFromQuadtree(
+    mcAdaptiveMarchingSquaresLattice *lattice,
+    const mcQuadNode *root,
+    int maxLeafLevel,
+    mcContour *contour)
+{
+  /* No leaf has more boundary points than lattice points on its boundary */
+  int maxSize = 1 << maxLeafLevel;
+  int *coords = (int*)malloc(sizeof(int) * maxSize);
+  mcAdaptiveMarchingSquaresPoint *points =
+    (mcAdaptiveMarchingSquaresPoint*)malloc(
+        sizeof(mcAdaptiveMarchingSquaresPoint) * 4 * maxSize);
+  int *crossings = (int*)malloc(sizeof(int) * 4 * maxSize);
+  mcAdaptiveMarchingSquares_contourNode(lattice, root, root,
+      coords, points, crossings, contour);
+  free(crossings);
+  free(points);
+  free(coords);
+}
+
+void mcAdaptiveMarchingSquares_contourFromField(
+    mcScalarFieldWithArgs sf, const void *args,
+    unsigned int x_res, unsigned int y_res,
+    const mcVec2 *min, const mcVec2 *max,
+    const mcAdaptiveMarchingSquaresParams *params,
+    mcContour *contour)
+{
+  static const unsigned int INIT_TABLE_SIZE = 1024;
+  mcAdaptiveMarchingSquaresParams defaultParams;
+  if (params == NULL) {
+    mcAdaptiveMarchingSquaresParams_default(&defaultParams);
+    params = &defaultParams;
   }
+  assert(params->type == MC_ADAPTIVE_MARCHING_SQUARES_PARAMS);
+  assert(x_res >= 2 && y_res >= 2);
+  mcAdaptiveMarchingSquaresLattice lattice;
+  lattice.sf = sf;
+  lattice.args = args;
+  lattice.res[0] = x_res;
+  lattice.res[1] = y_res;
+  lattice.delta[0] = fabs(max->x - min->x) / (float)(x_res - 1);
+  lattice.delta[1] = fabs(max->y - min->y) / (float)(y_res - 1);
+  lattice.min = *min;
+  lattice.sampleTableSize = INIT_TABLE_SIZE;
+  lattice.sampleKeys = (int64_t*)malloc(sizeof(int64_t) * INIT_TABLE_SIZE);
+  lattice.sampleValues = (float*)malloc(sizeof(float) * INIT_TABLE_SIZE);
+  memset(lattice.sampleKeys, -1, sizeof(int64_t) * INIT_TABLE_SIZE);
+  lattice.numSamples = 0;
+  lattice.vertexTableSize = INIT_TABLE_SIZE;
+  lattice.vertexKeys = (int64_t*)malloc(sizeof(int64_t) * INIT_TABLE_SIZE);
+  lattice.vertexIndices = (int*)malloc(sizeof(int) * INIT_TABLE_SIZE);
+  memset(lattice.vertexKeys, -1, sizeof(int64_t) * INIT_TABLE_SIZE);
+  lattice.numVertices = 0;
+  /* Make a root node at the origin of the lattice large enough to contain
+   * every lattice square */
+  mcQuadNode root;
+  mcQuadNode_init(&root);
+  root.level = 1;
+  while ((1u << root.level) < x_res - 1 || (1u << root.level) < y_res - 1)
+    root.level += 1;
+  mcAdaptiveMarchingSquares_refine(&lattice, params, &root);
+  mcAdaptiveMarchingSquares_contourFromQuadtree(&lattice, &root,
+      root.level < (int)params->coarsestLevel
+      ? root.level : (int)params->coarsestLevel,
+      contour);
+  /* Free our resources */
+  mcQuadNode_destroy(&root);
+  free(lattice.sampleKeys);
+  free(lattice.sampleValues);
+  free(lattice.vertexKeys);
+  free(lattice.vertexIndices);
 }
@@ -459,6 +459,23 @@ unsigned int mcCube_translateEdge(unsigned int edge, unsigned int face) {
   return mcCube_edgeTranslationTable[(face << 4) + edge];
 }
 
+void mcCube_faceSampleIndices(unsigned int face, unsigned int *sampleIndices) {
+  typedef struct FaceSamples {
+    int sampleIndices[4];
+  } FaceSamples;
+  static const FaceSamples table[] = {
+    { .sampleIndices = { 0, 1, 5, 4 } },  /* Front face */
+    { .sampleIndices = { 1, 3, 7, 5 } },  /* Left face */
+    { .sampleIndices = { 4, 5, 7, 6 } },  /* Top face */
+    { .sampleIndices = { 0, 2, 3, 1 } },  /* Bottom face */
+    { .sampleIndices = { 0, 4, 6, 2 } },  /* Right face */
+    { .sampleIndices = { 2, 6, 7, 3 } },  /* Back face */
+  };
+  assert(face < MC_CUBE_NUM_FACES);
+  for (int i = 0; i < 4; ++i)
+    sampleIndices[i] = table[face].sampleIndices[i];
+}
+
 int mcCube_getCubeFace(int cube, int faceIndex) {
   int result = 0;
 #define FACE_BIT(in, out) \
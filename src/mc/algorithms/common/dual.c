@@ -30,35 +30,45 @@
 
 /**
  * \internal
- * A struct to store a vertex index and the angle the vertex makes relative to
- * the first vertex in the patch/polygon.
+ * Computes a "pseudo-angle" for the given vector in the plane. The
+ * pseudo-angle lies in the range [0, 4) and increases monotonically with the
+ * true angle of the vector measured counter-clockwise from the x-axis, which
+ * is all we need in order to sort vectors by angle. No trigonometry is
+ * involved.
  * \endinternal
  */
-typedef struct VertexAngle {
-  /** The vertex index of the vertex being considered. */
-  int vertexIndex;
-  /** The angle that this vertex makes relative to the first vertex in the
-   * patch/polygon. */
-  float angle;
-} VertexAngle;
+float mcDual_pseudoAngle(float x, float y) {
+  float sum = fabs(x) + fabs(y);
+  if (sum == 0.0f)
+    return 0.0f;
+  float t = y / sum;  /* Ranges from -1 to 1 */
+  if (x < 0.0f)
+    return 2.0f - t;  /* Second and third quadrants */
+  if (y < 0.0f)
+    return 4.0f + t;  /* Fourth quadrant */
+  return t;  /* First quadrant */
+}
 
 /**
  * \internal
- * Comparison routine for sorting vertices by angle for correct winding order.
+ * Sorts the dual mesh face vertex indices in the range [begin, end) by their
+ * keys. Dual faces have only a handful of vertices, so insertion sort is
+ * appropriate here.
+ * \endinternal
  */
-int compVertexAngle(const VertexAngle *u, const VertexAngle *v) {
-  float theta_u, theta_v;
-  theta_u = u->angle;
-  if (theta_u < 0.0f)
-    theta_u += 2.0f * (float)M_PI;
-  theta_v = v->angle;
-  if (theta_v < 0.0f)
-    theta_v += 2.0f * (float)M_PI;
-  if (theta_u < theta_v)
-    return -1;
-  if (theta_u > theta_v)
-    return 1;
-  return 0;
+void mcDual_sortByKey(unsigned int *indices, float *keys, int begin, int end) {
+  for (int i = begin + 1; i < end; ++i) {
+    unsigned int index = indices[i];
+    float key = keys[i];
+    int j = i - 1;
+    while (j >= begin && keys[j] > key) {
+      indices[j + 1] = indices[j];
+      keys[j + 1] = keys[j];
+      j -= 1;
+    }
+    indices[j + 1] = index;
+    keys[j + 1] = key;
+  }
 }
 
 /**
@@ -66,120 +76,140 @@ int compVertexAngle(const VertexAngle *u, const VertexAngle *v) {
  */
 void mcDual_makeDual(
     const mcMesh *mesh,
-    int maxFacesPerVertex,
     mcMesh *dual)
 {
-  maxFacesPerVertex += 42;  /* XXX */
-  /* TODO: Allocate space to record faces related by their shared vertices */
-  /* TODO: We could use a struct here with pointers to a single pool of vertex faces */
-  int *adjacentFaces = (int*)malloc(sizeof(int) * mesh->numVertices * (maxFacesPerVertex + 1));
-  memset(adjacentFaces, 0, sizeof(int) * mesh->numVertices * (maxFacesPerVertex + 1));
-  /* TODO: Iterate over the faces to determine their connectivity */
-  for (int i = 0; i < mesh->numFaces; ++i) {
-    mcFace *face;
-    face = &mesh->faces[i];
-    /* TODO: Iterate over the face vertex indices to gather vertex faces */
+  int numVertices = (int)mesh->numVertices;
+  int numFaces = (int)mesh->numFaces;
+  /* Build a compressed sparse row (CSR) structure relating each vertex to its
+   * adjacent faces. The faces adjacent to vertex i are stored in
+   * adjacentFaces from offsets[i] up to (but not including) offsets[i + 1].
+   * This is a counting sort of the face indices by vertex index. */
+  int *offsets = (int*)calloc(numVertices + 1, sizeof(int));
+  for (int i = 0; i < numFaces; ++i) {
+    const mcFace *face = &mesh->faces[i];
     for (int j = 0; j < face->numIndices; ++j) {
-      int *numAdjacentFaces;
-      int vertexIndex = face->indices[j];
-      numAdjacentFaces = &adjacentFaces[vertexIndex * (maxFacesPerVertex + 1)];
-      assert(*numAdjacentFaces < maxFacesPerVertex);
-      adjacentFaces[vertexIndex * (maxFacesPerVertex + 1) + 1 + *numAdjacentFaces] = i;
-      *numAdjacentFaces += 1;
+      offsets[face->indices[j] + 1] += 1;
     }
   }
-  /* We cache the resulting vertex index for each face midpoint so that we
-   * don't end up with polygon soup */
-  int *midpoints = (int*)malloc(sizeof(int) * mesh->numFaces);
-  memset(midpoints, -1, sizeof(int) * mesh->numFaces);
+  for (int i = 0; i < numVertices; ++i) {
+    offsets[i + 1] += offsets[i];
+  }
+  int numAdjacencies = offsets[numVertices];
+  int *adjacentFaces = (int*)malloc(sizeof(int) * numAdjacencies);
+  int *cursor = (int*)malloc(sizeof(int) * numVertices);
+  memcpy(cursor, offsets, sizeof(int) * numVertices);
+  for (int i = 0; i < numFaces; ++i) {
+    const mcFace *face = &mesh->faces[i];
+    for (int j = 0; j < face->numIndices; ++j) {
+      adjacentFaces[cursor[face->indices[j]]++] = i;
+    }
+  }
+  free(cursor);
   /* Iterate over the mesh faces; each face will produce a vertex in the dual
-   * mesh */
-  for (int i = 0; i < mesh->numFaces; ++i) {
-    mcFace *face = &mesh->faces[i];
-    mcVertex midpoint;
+   * mesh. Since the dual mesh vertices are added in face order, the vertex
+   * index of the midpoint of face i is firstMidpoint + i, which saves us from
+   * caching midpoint vertex indices. */
+  unsigned int firstMidpoint = dual->numVertices;
+  mcVertex *midpoints = (mcVertex*)malloc(sizeof(mcVertex) * numFaces);
+#pragma omp parallel for schedule(static)
+  for (int i = 0; i < numFaces; ++i) {
+    const mcFace *face = &mesh->faces[i];
+    mcVertex *midpoint = &midpoints[i];
     /* Compute the midpoint as the average of this face's vertices */
-    midpoint.pos.x = midpoint.pos.y = midpoint.pos.z = 0.0f;
-    midpoint.norm.x = midpoint.norm.y = midpoint.norm.z = 0.0f;
+    midpoint->pos.x = midpoint->pos.y = midpoint->pos.z = 0.0f;
+    midpoint->norm.x = midpoint->norm.y = midpoint->norm.z = 0.0f;
     for (int j = 0; j < face->numIndices; ++j) {
-      mcVertex *vertex = &mesh->vertices[face->indices[j]];
-      midpoint.pos.x += vertex->pos.x;
-      midpoint.pos.y += vertex->pos.y;
-      midpoint.pos.z += vertex->pos.z;
-      midpoint.norm.x += vertex->norm.x;
-      midpoint.norm.y += vertex->norm.y;
-      midpoint.norm.z += vertex->norm.z;
+      const mcVertex *vertex = &mesh->vertices[face->indices[j]];
+      midpoint->pos.x += vertex->pos.x;
+      midpoint->pos.y += vertex->pos.y;
+      midpoint->pos.z += vertex->pos.z;
+      midpoint->norm.x += vertex->norm.x;
+      midpoint->norm.y += vertex->norm.y;
+      midpoint->norm.z += vertex->norm.z;
     }
-    midpoint.pos.x /= (float)face->numIndices;
-    midpoint.pos.y /= (float)face->numIndices;
-    midpoint.pos.z /= (float)face->numIndices;
-    midpoint.norm.x /= (float)face->numIndices;
-    midpoint.norm.y /= (float)face->numIndices;
-    midpoint.norm.z /= (float)face->numIndices;
-    /* Add the midpoint computed to the dual mesh */
-    midpoints[i] = mcMesh_addVertex(dual, &midpoint);
+    midpoint->pos.x /= (float)face->numIndices;
+    midpoint->pos.y /= (float)face->numIndices;
+    midpoint->pos.z /= (float)face->numIndices;
+    midpoint->norm.x /= (float)face->numIndices;
+    midpoint->norm.y /= (float)face->numIndices;
+    midpoint->norm.z /= (float)face->numIndices;
   }
-  /* TODO: Iterate over the mesh vertices; each mesh vertex will produce a face
-   * in the dual mesh */
-  for (int i = 0; i < mesh->numVertices; ++i) {
-    int numAdjacentFaces;
-    int adjacentFaceIndex, midpointIndex;
-    mcFace face;
-    mcVec3 midpointVector, referenceHand;
-    mcVec3 *meshPos, *meshNorm, *midpoint;
-    VertexAngle *angles;
-    /* TODO: Iterate over the faces adjacent to this vertex */
-    numAdjacentFaces = adjacentFaces[i * (maxFacesPerVertex + 1)];
-    if (numAdjacentFaces < 3) {
+  /* Add the midpoints computed to the dual mesh */
+  for (int i = 0; i < numFaces; ++i) {
+    mcMesh_addVertex(dual, &midpoints[i]);
+  }
+  /* Iterate over the mesh vertices; each mesh vertex will produce a face in
+   * the dual mesh. The dual face vertex indices are written into a flat
+   * buffer with the same layout as the adjacency structure, along with a sort
+   * key for each index, so that the vertices can be processed in parallel
+   * without allocating any memory. */
+  unsigned int *dualIndices =
+    (unsigned int*)malloc(sizeof(unsigned int) * numAdjacencies);
+  float *keys = (float*)malloc(sizeof(float) * numAdjacencies);
+#pragma omp parallel for schedule(static)
+  for (int i = 0; i < numVertices; ++i) {
+    int begin = offsets[i], end = offsets[i + 1];
+    const mcVec3 *meshPos;
+    mcVec3 normal, tangent, bitangent, midpointVector;
+    if (end - begin < 3) {
       /* Don't generate faces for points or lines */
       continue;
     }
-    mcFace_init(&face, numAdjacentFaces);
-    /* TODO: We determine the winding order of the vertices on the dual mesh
-     * face by sorting the angles that the midpoints make with regards to the
-     * surface normal on the  */
     meshPos = &mesh->vertices[i].pos;
-    meshNorm = &mesh->vertices[i].norm;
-    adjacentFaceIndex = adjacentFaces[i * (maxFacesPerVertex + 1) + 1];
-    midpointIndex = midpoints[adjacentFaceIndex];
-    midpoint = &dual->vertices[midpointIndex].pos;
-    mcVec3_subtract(midpoint, meshPos, &midpointVector);
-    mcVec3_cross(meshNorm, &midpointVector, &referenceHand);
-    mcVec3_normalize(&referenceHand, &referenceHand);
-    /* FIXME: Get rid of this malloc */
-    angles = (VertexAngle*)malloc(sizeof(VertexAngle) * numAdjacentFaces);
-    angles[0].vertexIndex = midpointIndex;
-    angles[0].angle = 0.0f;
-    for (int j = 1; j < numAdjacentFaces; ++j) {
-      int faceIndex;
-      mcVec3 currentHand, cross;
-      float sinTheta, cosTheta, angle;
-      /* TODO: Determine the angle that this vector makes relative reference
-       * hand and the mesh normal vector  */
-      faceIndex = adjacentFaces[i * (maxFacesPerVertex + 1) + 1 + j];
-      midpointIndex = midpoints[faceIndex];
-      midpoint = &dual->vertices[midpoints[faceIndex]].pos;
-      mcVec3_subtract(midpoint, meshPos, &midpointVector);
-      mcVec3_cross(meshNorm, &midpointVector, &currentHand);
-      mcVec3_normalize(&currentHand, &currentHand);
-      mcVec3_cross(&referenceHand, &currentHand, &cross);
-      sinTheta = mcVec3_length(&cross);
-      cosTheta = mcVec3_dot(&referenceHand, &currentHand);
-      angle = atan2(sinTheta, cosTheta);
-      angles[j].vertexIndex = midpointIndex;
-      angles[j].angle = angle;
+    normal = mesh->vertices[i].norm;
+    if (mcVec3_length(&normal) == 0.0f) {
+      /* This mesh does not have a normal for this vertex, so we approximate
+       * one as the sum of the adjacent face midpoint normals */
+      for (int j = begin; j < end; ++j) {
+        const mcFace *face = &mesh->faces[adjacentFaces[j]];
+        for (int k = 0; k < face->numIndices; ++k) {
+          /* Newell's method for the polygon normal */
+          const mcVec3 *u = &mesh->vertices[face->indices[k]].pos;
+          const mcVec3 *v =
+            &mesh->vertices[face->indices[(k + 1) % face->numIndices]].pos;
+          normal.x += (u->y - v->y) * (u->z + v->z);
+          normal.y += (u->z - v->z) * (u->x + v->x);
+          normal.z += (u->x - v->x) * (u->y + v->y);
+        }
+      }
     }
-    /* TODO: Sort the vertices on the dual mesh face by angle so that they are
-     * in the correct winding order */
-    qsort(angles, numAdjacentFaces, sizeof(VertexAngle),
-        (int (*)(const void *, const void *))compVertexAngle);
-    /* TODO: Add the vertices to our new dual mesh face in correct winding
-     * order */
-    for (int j = 0; j < numAdjacentFaces; ++j) {
-      face.indices[j] = angles[j].vertexIndex;
+    mcVec3_normalize(&normal, &normal);
+    /* We determine the winding order of the vertices on the dual mesh face by
+     * sorting the angles that the midpoints make about the surface normal.
+     * The angles are measured in the tangent plane, relative to the first
+     * midpoint. */
+    mcVec3_subtract(&midpoints[adjacentFaces[begin]].pos, meshPos,
+        &midpointVector);
+    mcVec3_scalarProduct(mcVec3_dot(&normal, &midpointVector), &normal,
+        &tangent);
+    mcVec3_subtract(&midpointVector, &tangent, &tangent);
+    mcVec3_cross(&normal, &tangent, &bitangent);
+    for (int j = begin; j < end; ++j) {
+      int faceIndex = adjacentFaces[j];
+      mcVec3_subtract(&midpoints[faceIndex].pos, meshPos, &midpointVector);
+      dualIndices[j] = firstMidpoint + faceIndex;
+      keys[j] = mcDual_pseudoAngle(
+          mcVec3_dot(&midpointVector, &tangent),
+          mcVec3_dot(&midpointVector, &bitangent));
     }
-    /* Add the face to the dual mesh */
+    /* Sort the vertices on the dual mesh face by angle so that they are in
+     * the correct winding order */
+    mcDual_sortByKey(dualIndices, keys, begin, end);
+  }
+  /* Add the faces to the dual mesh. Since mcMesh_addFace() copies the face,
+   * our face can simply point into the flat index buffer. */
+  for (int i = 0; i < numVertices; ++i) {
+    mcFace face;
+    if (offsets[i + 1] - offsets[i] < 3)
+      continue;
+    face.indices = &dualIndices[offsets[i]];
+    face.numIndices = offsets[i + 1] - offsets[i];
     mcMesh_addFace(dual, &face);
-    /* FIXME: We need a pool so that freeing this face memory is cheap */
-    mcFace_destroy(&face);
   }
+  /* Free our resources */
+  free(keys);
+  free(dualIndices);
+  free(midpoints);
+  free(adjacentFaces);
+  free(offsets);
 }
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include <mc/algorithms/common/qef.h>
+
+/* Eigenvalues of A^T A smaller than this fraction of the largest eigenvalue
+ * are treated as zero when solving for the minimizer. */
+#define MC_QEF_EIGENVALUE_TOLERANCE 0.1
+#define MC_QEF_MAX_SWEEPS 8
+
+void mcQef_init(mcQef *self) {
+  memset(self->ata, 0, sizeof(self->ata));
+  memset(self->atb, 0, sizeof(self->atb));
+  self->btb = 0.0;
+  memset(self->pointSum, 0, sizeof(self->pointSum));
+  self->numPoints = 0;
+}
+
+void mcQef_addPlane(mcQef *self, const mcVec3 *point, const mcVec3 *normal) {
+  double n[3] = { normal->x, normal->y, normal->z };
+  double p[3] = { point->x, point->y, point->z };
+  double d = n[0] * p[0] + n[1] * p[1] + n[2] * p[2];
+  self->ata[0] += n[0] * n[0];
+  self->ata[1] += n[0] * n[1];
+  self->ata[2] += n[0] * n[2];
+  self->ata[3] += n[1] * n[1];
+  self->ata[4] += n[1] * n[2];
+  self->ata[5] += n[2] * n[2];
+  self->atb[0] += n[0] * d;
+  self->atb[1] += n[1] * d;
+  self->atb[2] += n[2] * d;
+  self->btb += d * d;
+  for (int i = 0; i < 3; ++i)
+    self->pointSum[i] += p[i];
+  self->numPoints += 1;
+}
+
+void mcQef_add(mcQef *self, const mcQef *other) {
+  int i;
+  for (i = 0; i < 6; ++i)
+    self->ata[i] += other->ata[i];
+  for (i = 0; i < 3; ++i)
+    self->atb[i] += other->atb[i];
+  self->btb += other->btb;
+  for (i = 0; i < 3; ++i)
+    self->pointSum[i] += other->pointSum[i];
+  self->numPoints += other->numPoints;
+}
+
+void mcQef_massPoint(const mcQef *self, mcVec3 *point) {
+  assert(self->numPoints > 0);
+  point->x = self->pointSum[0] / self->numPoints;
+  point->y = self->pointSum[1] / self->numPoints;
+  point->z = self->pointSum[2] / self->numPoints;
+}
+
+float mcQef_error(const mcQef *self, const mcVec3 *point) {
+  /* x^T A^T A x - 2 x^T A^T b + b^T b */
+  double x = point->x, y = point->y, z = point->z;
+  double error =
+      self->ata[0] * x * x
+    + self->ata[3] * y * y
+    + self->ata[5] * z * z
+    + 2.0 * (self->ata[1] * x * y + self->ata[2] * x * z
+        + self->ata[4] * y * z)
+    - 2.0 * (self->atb[0] * x + self->atb[1] * y + self->atb[2] * z)
+    + self->btb;
+  /* Rounding can make the error slightly negative */
+  return error > 0.0 ? (float)error : 0.0f;
+}
+
+/* Diagonalizes the symmetric 3x3 matrix a with cyclic Jacobi rotations. On
+ * return the diagonal of a holds the eigenvalues and the columns of v hold the
+ * corresponding eigenvectors. */
+void mcQef_eigen(double a[3][3], double v[3][3]) {
+  int i, j, p, q, sweep;
+  for (i = 0; i < 3; ++i) {
+    for (j = 0; j < 3; ++j) {
+      v[i][j] = i == j ? 1.0 : 0.0;
+    }
+  }
+  for (sweep = 0; sweep < MC_QEF_MAX_SWEEPS; ++sweep) {
+    double offDiagonal = a[0][1] * a[0][1] + a[0][2] * a[0][2]
+      + a[1][2] * a[1][2];
+    if (offDiagonal < 1.0e-20)
+      break;
+    for (p = 0; p < 2; ++p) {
+      for (q = p + 1; q < 3; ++q) {
+        double theta, t, c, s;
+        if (a[p][q] == 0.0)
+          continue;
+        /* Choose the rotation that zeroes a[p][q] */
+        theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+        t = (theta >= 0.0 ? 1.0 : -1.0)
+          / (fabs(theta) + sqrt(theta * theta + 1.0));
+        c = 1.0 / sqrt(t * t + 1.0);
+        s = t * c;
+        /* Apply the rotation a' = J^T a J and accumulate v' = v J */
+        for (i = 0; i < 3; ++i) {
+          double aip = a[i][p], aiq = a[i][q];
+          a[i][p] = c * aip - s * aiq;
+          a[i][q] = s * aip + c * aiq;
+        }
+        for (i = 0; i < 3; ++i) {
+          double api = a[p][i], aqi = a[q][i];
+          a[p][i] = c * api - s * aqi;
+          a[q][i] = s * api + c * aqi;
+        }
+        for (i = 0; i < 3; ++i) {
+          double vip = v[i][p], viq = v[i][q];
+          v[i][p] = c * vip - s * viq;
+          v[i][q] = s * vip + c * viq;
+        }
+      }
+    }
+  }
+}
+
+float mcQef_solve(const mcQef *self, mcVec3 *point) {
+  double a[3][3], v[3][3], massPoint[3], r[3], x[3], maxEigenvalue;
+  int i, j;
+
+  assert(self->numPoints > 0);
+
+  for (i = 0; i < 3; ++i)
+    massPoint[i] = self->pointSum[i] / self->numPoints;
+
+  a[0][0] = self->ata[0];
+  a[0][1] = a[1][0] = self->ata[1];
+  a[0][2] = a[2][0] = self->ata[2];
+  a[1][1] = self->ata[3];
+  a[1][2] = a[2][1] = self->ata[4];
+  a[2][2] = self->ata[5];
+
+  /* Solve for the offset from the mass point, so that the directions we
+   * truncate leave the minimizer at the mass point along them */
+  for (i = 0; i < 3; ++i) {
+    r[i] = self->atb[i];
+    for (j = 0; j < 3; ++j)
+      r[i] -= a[i][j] * massPoint[j];
+  }
+
+  mcQef_eigen(a, v);
+
+  maxEigenvalue = 0.0;
+  for (i = 0; i < 3; ++i) {
+    if (fabs(a[i][i]) > maxEigenvalue)
+      maxEigenvalue = fabs(a[i][i]);
+  }
+
+  /* x = massPoint + V diag(1 / lambda) V^T r */
+  for (i = 0; i < 3; ++i)
+    x[i] = massPoint[i];
+  for (j = 0; j < 3; ++j) {
+    double lambda = a[j][j], projection;
+    if (fabs(lambda) <= MC_QEF_EIGENVALUE_TOLERANCE * maxEigenvalue
+        || lambda == 0.0)
+      continue;
+    projection = (v[0][j] * r[0] + v[1][j] * r[1] + v[2][j] * r[2]) / lambda;
+    for (i = 0; i < 3; ++i)
+      x[i] += v[i][j] * projection;
+  }
+
+  point->x = x[0];
+  point->y = x[1];
+  point->z = x[2];
+
+  return mcQef_error(self, point);
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <mc/algorithms/common/sampleSlices.h>
+
+void mcSampleSlices_sampleSlice(mcSampleSlices *self, int z, int slice) {
+  const unsigned int start[3] = { 0, 0, z };
+  const unsigned int res[3] = { self->x_res, self->y_res, 1 };
+  mcVec3 delta;
+  delta.x = self->delta_x;
+  delta.y = self->delta_y;
+  delta.z = self->delta_z;
+  /* Every slice crosses the same columns of the lattice, so the lattice
+   * sampler may keep what it learned about them in the scratch memory */
+  mcScalarFieldDescriptor_sampleLattice(&self->field,
+      &self->min, &delta,
+      start, res,
+      &self->scratch,
+      &self->samples[slice * self->x_res * self->y_res]);
+}
+
+void mcSampleSlices_init(mcSampleSlices *self,
+    mcScalarFieldWithArgs sf, const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max)
+{
+  mcScalarFieldDescriptor_initFromField(&self->field, sf, args);
+  self->x_res = x_res;
+  self->y_res = y_res;
+  self->z_res = z_res;
+  self->min = *min;
+  self->delta_x = fabs(max->x - min->x) / (float)(x_res - 1);
+  self->delta_y = fabs(max->y - min->y) / (float)(y_res - 1);
+  self->delta_z = fabs(max->z - min->z) / (float)(z_res - 1);
+  self->samples = (float*)malloc(
+      sizeof(float) * x_res * y_res * MC_SAMPLE_SLICES_NUM_SLICES);
+  self->scratch = NULL;
+  /* Sample the first two slices. The current slice sits just before the
+   * lattice, so that advancing makes slice 0 current and samples slice 2. */
+  self->z = -1;
+  self->slice = MC_SAMPLE_SLICES_NUM_SLICES - 1;
+  for (int z = 0; z < 2 && z < (int)z_res; ++z) {
+    mcSampleSlices_sampleSlice(self, z, z);
+  }
+}
+
+void mcSampleSlices_destroy(mcSampleSlices *self) {
+  free(self->samples);
+  free(self->scratch);
+}
+
+void mcSampleSlices_advance(mcSampleSlices *self) {
+  self->z += 1;
+  self->slice = (self->slice + 1) % MC_SAMPLE_SLICES_NUM_SLICES;
+  if (self->z + 2 < (int)self->z_res) {  /* Don't sample past the maximum resolution */
+    mcSampleSlices_sampleSlice(self, self->z + 2,
+        (self->slice + 2) % MC_SAMPLE_SLICES_NUM_SLICES);
+  }
+}
+
+void mcSampleSlices_gradient(const mcSampleSlices *self,
+    unsigned int x, unsigned int y, int dz,
+    mcVec3 *gradient)
+{
+  int z = self->z + dz;
+  assert(x < self->x_res);
+  assert(y < self->y_res);
+  assert(z >= 0 && z < (int)self->z_res);
+  /* FIXME: I'm not so sure delta_x is the correct divisor */
+  gradient->x =
+    (mcSampleSlices_value(self, x + (x < self->x_res - 1 ? 1 : 0), y, dz)
+     - mcSampleSlices_value(self, x - (x > 0 ? 1 : 0), y, dz)
+    ) / self->delta_x;
+  /* FIXME: I'm not so sure delta_y is the correct divisor */
+  gradient->y =
+    (mcSampleSlices_value(self, x, y + (y < self->y_res - 1 ? 1 : 0), dz)
+     - mcSampleSlices_value(self, x, y - (y > 0 ? 1 : 0), dz)
+    ) / self->delta_y;
+  /* FIXME: I'm not so sure delta_z is the correct divisor */
+  gradient->z =
+    (mcSampleSlices_value(self, x, y, dz + (z < (int)self->z_res - 1 ? 1 : 0))
+     - mcSampleSlices_value(self, x, y, dz - (z > 0 ? 1 : 0))
+    ) / self->delta_z;
+}
@@ -32,9 +32,6 @@
 #include <mc/algorithms/common/surfaceNet.h>
 
 mcSurfaceNodePos mcSurfaceNodePos_opposite(mcSurfaceNodePos pos) {
-  typedef struct PosPair {
-    mcSurfaceNodePos pos[2];
-  } PosPair;
   mcSurfaceNodePos table[] = {
     MC_SURFACE_NODE_BACK,  // FRONT
     MC_SURFACE_NODE_RIGHT,  // LEFT
@@ -47,45 +44,26 @@ mcSurfaceNodePos mcSurfaceNodePos_opposite(mcSurfaceNodePos pos) {
   return table[pos];
 }
 
-void mcSurfaceNode_init(mcSurfaceNode *self) {
-  /* Set all neighbor pointers to NULL */
-  memset(self->neighbors, 0, sizeof(mcSurfaceNode*) * 6);
-}
-
-void mcSurfaceNode_destroy(mcSurfaceNode *self) {
-  /* TODO: Inform neighbors that our node is destroyed? Might harm performance
-   * of surface net destruction. */
-}
-
-void mcSurfaceNode_addNeighbor(
-    mcSurfaceNode *self, mcSurfaceNode *neighbor, mcSurfaceNodePos pos)
-{
-  mcSurfaceNodePos opposite;
-  assert(self->neighbors[pos] == NULL);
-  self->neighbors[pos] = neighbor;
-  opposite = mcSurfaceNodePos_opposite(pos);
-  assert(neighbor->neighbors[opposite] == NULL);
-  neighbor->neighbors[opposite] = self;
-}
-
-/* TODO: Maybe MC_SURFACE_NET_NODES_PER_BLOCK should double with each block
- * allocated? That complicates things. */
-const int MC_SURFACE_NET_NODES_PER_BLOCK = 1024;
-const int MC_SURFACE_NET_INIT_POOL_SIZE = 16;
+const int MC_SURFACE_NET_INIT_SIZE_NODES = 1024;
 
 void mcSurfaceNet_init(mcSurfaceNet *self) {
   self->numNodes = 0;
-  self->numBlocks = 0;
-  self->nodePool = (mcSurfaceNode**)malloc(
-      sizeof(mcSurfaceNode*) * MC_SURFACE_NET_INIT_POOL_SIZE);
-  self->poolSize = MC_SURFACE_NET_INIT_POOL_SIZE;
+  self->sizeNodes = MC_SURFACE_NET_INIT_SIZE_NODES;
+  self->pos = (mcVec3*)malloc(sizeof(mcVec3) * self->sizeNodes);
+  self->oldPos = (mcVec3*)malloc(sizeof(mcVec3) * self->sizeNodes);
+  self->neighbors = (int32_t*)malloc(sizeof(int32_t) * 6 * self->sizeNodes);
+  self->latticePos =
+    (unsigned int*)malloc(sizeof(unsigned int) * 3 * self->sizeNodes);
+  self->vertexIndices =
+    (unsigned int*)malloc(sizeof(unsigned int) * self->sizeNodes);
 }
 
 void mcSurfaceNet_destroy(mcSurfaceNet *self) {
-  for (int i = 0; i < self->numBlocks; ++i) {
-    free(self->nodePool[i]);
-  }
-  free(self->nodePool);
+  free(self->vertexIndices);
+  free(self->latticePos);
+  free(self->neighbors);
+  free(self->oldPos);
+  free(self->pos);
 }
 
 void mcSurfaceNet_build(mcSurfaceNet *self,
@@ -97,134 +75,167 @@ void mcSurfaceNet_build(mcSurfaceNet *self,
   float delta_y = fabs(max->y - min->y) / (float)(res_y - 1);
   float delta_z = fabs(max->z - min->z) / (float)(res_z - 1);
 
+  /* Keep two slices of samples so that each sample is only taken once. The
+   * slice at index 0 is the back of the current voxel slice, and the slice at
+   * index 1 is the front. */
+  float *sampleBuffer = (float*)malloc(sizeof(float) * res_x * res_y * 2);
+  float *sampleSlices[2];
+  sampleSlices[0] = &sampleBuffer[0];
+  sampleSlices[1] = &sampleBuffer[res_x * res_y];
   /* Keep a slice, line, and voxel buffer of surface nodes so that we can
    * find nodes relative to the current node. */
-  mcSurfaceNode **prevSlice =
-    (mcSurfaceNode**)malloc(sizeof(mcSurfaceNode*) * (res_x - 1) * (res_y - 1));
+  int32_t *prevSlice =
+    (int32_t*)malloc(sizeof(int32_t) * (res_x - 1) * (res_y - 1));
+  int32_t *prevLine = (int32_t*)malloc(sizeof(int32_t) * (res_x - 1));
+  int32_t prevVoxel;
   /* The start of the algorithm has no previous slice */
-  memset(prevSlice, 0, sizeof(mcSurfaceNode*) * (res_x - 1) * (res_y - 1));
-  mcSurfaceNode **prevLine = 
-    (mcSurfaceNode**)malloc(sizeof(mcSurfaceNode*) * (res_x - 1));
-  mcSurfaceNode *prevVoxel;
+  for (unsigned int i = 0; i < (res_x - 1) * (res_y - 1); ++i) {
+    prevSlice[i] = MC_SURFACE_NET_NO_NEIGHBOR;
+  }
+  /* Sample the first slice */
+  mcScalarFieldDescriptor field;
+  mcScalarFieldDescriptor_initFromField(&field, sf, args);
+  mcVec3 delta;
+  delta.x = delta_x;
+  delta.y = delta_y;
+  delta.z = delta_z;
+  unsigned int start[3] = { 0, 0, 0 };
+  const unsigned int sliceRes[3] = { res_x, res_y, 1 };
+  void *scratch = NULL;
+  mcScalarFieldDescriptor_sampleLattice(&field, min, &delta,
+      start, sliceRes, &scratch, sampleSlices[0]);
   /* We start by generating the surface net */
   /* Iterate over the cube lattice (the dual of the sample lattice) */
   for (unsigned int z = 0; z < res_z - 1; ++z) {
+    /* Sample the next slice */
+    start[2] = z + 1;
+    mcScalarFieldDescriptor_sampleLattice(&field, min, &delta,
+        start, sliceRes, &scratch, sampleSlices[1]);
     /* The start of a new slice has no previous line */
-    memset(prevLine, 0, sizeof(mcSurfaceNode*) * (res_x - 1));
+    for (unsigned int x = 0; x < res_x - 1; ++x) {
+      prevLine[x] = MC_SURFACE_NET_NO_NEIGHBOR;
+    }
     for (unsigned int y = 0; y < res_y - 1; ++y) {
       /* The start of a new line has no previous voxel */
-      prevVoxel = NULL;
+      prevVoxel = MC_SURFACE_NET_NO_NEIGHBOR;
       for (unsigned int x = 0; x < res_x - 1; ++x) {
         unsigned int cube;
         float samples[8];
         /* Gather a sample from each of the cube's eight vertices */
-        /* TODO: Many of these samples can be stored/retrieved from a cache */
         for (unsigned int sampleIndex = 0; sampleIndex < 8; ++sampleIndex) {
           /* Determine this sample's relative position in the cube */
           unsigned int pos[3];
           mcCube_sampleRelativePosition(sampleIndex, pos);
-          samples[sampleIndex] = sf(
-              min->x + (x + pos[0]) * delta_x,
-              min->y + (y + pos[1]) * delta_y,
-              min->z + (z + pos[2]) * delta_z,
-              args);
+          samples[sampleIndex] =
+            sampleSlices[pos[2]][(y + pos[1]) * res_x + x + pos[0]];
         }
         /* Determine the cube configuration from our samples */
         cube = mcCube_cubeConfigurationFromSamples(samples);
+        int32_t node = MC_SURFACE_NET_NO_NEIGHBOR;
         if (cube != 0x00 && cube != 0xff) {
           /* Add cubes that intersect the surface to the surface net */
-          mcSurfaceNode *node, *bottomNeighbor, *frontNeighbor, *rightNeighbor;
-          /* Create a surface node for this surface cube */
-          node = mcSurfaceNet_getNextNode(self);
+          mcVec3 pos;
           /* Set the node position to the center of the voxel cube */
-          node->pos.x = min->x + x * delta_x + delta_x / 2.0f;
-          node->pos.y = min->y + y * delta_y + delta_y / 2.0f;
-          node->pos.z = min->z + z * delta_z + delta_z / 2.0f;
-          /* Store the lattice position of the node */
-          node->latticePos[0] = x;
-          node->latticePos[1] = y;
-          node->latticePos[2] = z;
+          pos.x = min->x + x * delta_x + delta_x / 2.0f;
+          pos.y = min->y + y * delta_y + delta_y / 2.0f;
+          pos.z = min->z + z * delta_z + delta_z / 2.0f;
+          /* Create a surface node for this surface cube */
+          node = mcSurfaceNet_addNode(self, &pos, x, y, z);
           /* Connect surface node to neighboring surface nodes */
-          bottomNeighbor = prevSlice[y * (res_x - 1) + x];
-          if (bottomNeighbor != NULL) {
-            mcSurfaceNode_addNeighbor(
-                node, bottomNeighbor, MC_SURFACE_NODE_BOTTOM);
+          if (prevSlice[y * (res_x - 1) + x] != MC_SURFACE_NET_NO_NEIGHBOR) {
+            mcSurfaceNet_addNeighbor(self,
+                node, prevSlice[y * (res_x - 1) + x], MC_SURFACE_NODE_BOTTOM);
           }
-          frontNeighbor = prevLine[x];
-          if (frontNeighbor != NULL) {
-            mcSurfaceNode_addNeighbor(
-                node, frontNeighbor, MC_SURFACE_NODE_FRONT);
+          if (prevLine[x] != MC_SURFACE_NET_NO_NEIGHBOR) {
+            mcSurfaceNet_addNeighbor(self,
+                node, prevLine[x], MC_SURFACE_NODE_FRONT);
           }
-          rightNeighbor = prevVoxel;
-          if (rightNeighbor != NULL) {
-            mcSurfaceNode_addNeighbor(
-                node, rightNeighbor, MC_SURFACE_NODE_RIGHT);
+          if (prevVoxel != MC_SURFACE_NET_NO_NEIGHBOR) {
+            mcSurfaceNet_addNeighbor(self,
+                node, prevVoxel, MC_SURFACE_NODE_RIGHT);
           }
-          /* Record this surface node in the prev node buffers */
-          prevSlice[y * (res_x - 1) + x] = node;
-          prevLine[x] = node;
-          prevVoxel = node;
-        } else {
-          /* Record the absence of a surface node node as NULL in the prev node
-           * buffers */
-          prevSlice[y * (res_x - 1) + x] = NULL;
-          prevLine[x] = NULL;
-          prevVoxel = NULL;
         }
+        /* Record this surface node (or its absence) in the prev node
+         * buffers */
+        prevSlice[y * (res_x - 1) + x] = node;
+        prevLine[x] = node;
+        prevVoxel = node;
       }
     }
+    /* The front sample slice becomes the back sample slice */
+    float *temp = sampleSlices[0];
+    sampleSlices[0] = sampleSlices[1];
+    sampleSlices[1] = temp;
   }
   /* Free our allocated resources */
+  free(scratch);
   free(prevLine);
   free(prevSlice);
+  free(sampleBuffer);
 }
 
 void mcSurfaceNet_updateOldPos(mcSurfaceNet *self) {
-  /* Iterate through each node and set the old node position to the node's
-   * current position. */
-  for (int i = 0; i < self->numNodes; ++i) {
-    mcSurfaceNode *node;
-    node = mcSurfaceNet_getNode(self, i);
-    node->oldPos = node->pos;
-  }
+  /* Set the old position of each node to the node's current position */
+  memcpy(self->oldPos, self->pos, sizeof(mcVec3) * self->numNodes);
 }
 
-void mcSurfaceNet_growBlockPool(mcSurfaceNet *self) {
-  /* Double the size of the node pool */
-  mcSurfaceNode **newPool = (mcSurfaceNode**)malloc(
-      sizeof(mcSurfaceNode**) * self->poolSize * 2);
-  memcpy(newPool, self->nodePool, sizeof(mcSurfaceNode**) * self->poolSize);
-  free(self->nodePool);
-  self->nodePool = newPool;
-  self->poolSize *= 2;
+void *mcSurfaceNet_growArray(void *array, size_t elementSize,
+    unsigned int size)
+{
+  /* Double the size of the given node array */
+  void *newArray = malloc(elementSize * size * 2);
+  memcpy(newArray, array, elementSize * size);
+  free(array);
+  return newArray;
 }
 
-void mcSurfaceNet_addNodeBlock(mcSurfaceNet *self) {
-  /* Make sure we can reference as many blocks */
-  if (self->numBlocks >= self->poolSize) {
-    mcSurfaceNet_growBlockPool(self);
-  }
-  self->nodePool[self->numBlocks++] = (mcSurfaceNode*)malloc(
-        sizeof(mcSurfaceNode) * MC_SURFACE_NET_NODES_PER_BLOCK);
+void mcSurfaceNet_growNodes(mcSurfaceNet *self) {
+  /* Double the size of each of the node arrays. Since nodes refer to each
+   * other by index, the nodes are free to move. */
+  self->pos = (mcVec3*)mcSurfaceNet_growArray(
+      self->pos, sizeof(mcVec3), self->sizeNodes);
+  self->oldPos = (mcVec3*)mcSurfaceNet_growArray(
+      self->oldPos, sizeof(mcVec3), self->sizeNodes);
+  self->neighbors = (int32_t*)mcSurfaceNet_growArray(
+      self->neighbors, sizeof(int32_t) * 6, self->sizeNodes);
+  self->latticePos = (unsigned int*)mcSurfaceNet_growArray(
+      self->latticePos, sizeof(unsigned int) * 3, self->sizeNodes);
+  self->vertexIndices = (unsigned int*)mcSurfaceNet_growArray(
+      self->vertexIndices, sizeof(unsigned int), self->sizeNodes);
+  self->sizeNodes *= 2;
 }
 
-mcSurfaceNode *mcSurfaceNet_getNode(mcSurfaceNet *self, unsigned int i) {
-  assert(i < self->numNodes);
-  assert(i / MC_SURFACE_NET_NODES_PER_BLOCK < self->numBlocks);
-  return self->nodePool[i / MC_SURFACE_NET_NODES_PER_BLOCK]
-          + i % MC_SURFACE_NET_NODES_PER_BLOCK;
+unsigned int mcSurfaceNet_addNode(mcSurfaceNet *self, const mcVec3 *pos,
+    unsigned int x, unsigned int y, unsigned int z)
+{
+  unsigned int node;
+  /* Make sure we have memory allocated for this node */
+  if (self->numNodes >= self->sizeNodes) {
+    mcSurfaceNet_growNodes(self);
+  }
+  node = self->numNodes++;
+  self->pos[node] = *pos;
+  self->oldPos[node] = *pos;
+  for (int i = 0; i < 6; ++i) {
+    self->neighbors[node * 6 + i] = MC_SURFACE_NET_NO_NEIGHBOR;
+  }
+  self->latticePos[node * 3 + 0] = x;
+  self->latticePos[node * 3 + 1] = y;
+  self->latticePos[node * 3 + 2] = z;
+  self->vertexIndices[node] = 0;
+  return node;
 }
 
-mcSurfaceNode *mcSurfaceNet_getNextNode(mcSurfaceNet *self) {
-  mcSurfaceNode *nextNode;
-  /* Make sure we have a block allocated for this node */
-  if (self->numNodes / MC_SURFACE_NET_NODES_PER_BLOCK >= self->numBlocks) {
-    mcSurfaceNet_addNodeBlock(self);
-  }
-  /* Get the address for the next node in the correct block */
-  nextNode = self->nodePool[self->numNodes / MC_SURFACE_NET_NODES_PER_BLOCK]
-              + self->numNodes % MC_SURFACE_NET_NODES_PER_BLOCK;
-  mcSurfaceNode_init(nextNode);
-  self->numNodes += 1;
-  return nextNode;
+void mcSurfaceNet_addNeighbor(mcSurfaceNet *self,
+    unsigned int node, unsigned int neighbor, mcSurfaceNodePos pos)
+{
+  mcSurfaceNodePos opposite;
+  assert(node < self->numNodes);
+  assert(neighbor < self->numNodes);
+  assert(self->neighbors[node * 6 + pos] == MC_SURFACE_NET_NO_NEIGHBOR);
+  self->neighbors[node * 6 + pos] = neighbor;
+  opposite = mcSurfaceNodePos_opposite(pos);
+  assert(self->neighbors[neighbor * 6 + opposite]
+      == MC_SURFACE_NET_NO_NEIGHBOR);
+  self->neighbors[neighbor * 6 + opposite] = node;
 }
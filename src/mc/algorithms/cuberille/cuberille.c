@@ -24,151 +24,173 @@
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
-#include <string.h>
 
-#include <stdio.h> /* XXX */
-
-#include <mc/algorithms/common/surfaceNet.h>
+#include <mc/algorithms/common/cube.h>
+#include <mc/algorithms/common/sampleSlices.h>
 #include <mc/algorithms/cuberille/cuberille.h>
 #include <mc/mesh.h>
 #include <mc/vector.h>
 
+void mcCuberilleParams_default(mcCuberilleParams *params) {
+  params->type = MC_CUBERILLE_PARAMS;
+  params->triangulate = 1;
+}
+
+/**
+ * Adds the face between two samples on opposite sides of the isosurface. The
+ * corners of the face are the vertices of the four voxel cubes about the
+ * lattice edge between the samples, given counter-clockwise about the
+ * positive direction of that edge.
+ */
+void mcCuberille_addFace(const int *vertexIndices, int reverse,
+    const mcCuberilleParams *params, mcFace *quad, mcFace *triangle,
+    mcMesh *mesh)
+{
+  for (int i = 0; i < 4; ++i) {
+    assert(vertexIndices[i] != -1);
+    quad->indices[i] = vertexIndices[reverse ? 3 - i : i];
+  }
+  if (!params->triangulate) {
+    mcMesh_addFace(mesh, quad);
+    return;
+  }
+  /* Split the quad along the diagonal through its first vertex */
+  triangle->indices[0] = quad->indices[0];
+  triangle->indices[1] = quad->indices[1];
+  triangle->indices[2] = quad->indices[2];
+  mcMesh_addFace(mesh, triangle);
+  triangle->indices[1] = quad->indices[2];
+  triangle->indices[2] = quad->indices[3];
+  mcMesh_addFace(mesh, triangle);
+}
+
 void mcCuberille_isosurfaceFromField(
     mcScalarFieldWithArgs sf, const void *args,
     unsigned int res_x, unsigned int res_y, unsigned int res_z,
     const mcVec3 *min, const mcVec3 *max,
-    mcCuberilleParams *params,
+    const mcCuberilleParams *params,
     mcMesh *mesh)
 {
-  /* FIXME: Read the params */
-  mcSurfaceNet surfaceNet;
-  mcFace triangle;
-  float delta_x = fabs(max->x - min->x) / (float)(res_x - 1);
-  float delta_y = fabs(max->y - min->y) / (float)(res_y - 1);
-  float delta_z = fabs(max->z - min->z) / (float)(res_z - 1);
-  /* Initialize the surface net structure */
-  mcSurfaceNet_init(&surfaceNet);
-  /* Build the surface net from samples of our scalar field */
-  mcSurfaceNet_build(&surfaceNet,
-      sf, args,
-      res_x, res_y, res_z,
-      min, max);
-  fprintf(stderr, "numNodes: %d\n", surfaceNet.numNodes);
-  /* Now that we have the surface net, we generate a vertex for each surface
-   * node */
-  mcFace_init(&triangle, 3);
-  for (int i = 0; i < surfaceNet.numNodes; ++i) {
-    mcSurfaceNode *node;
-    mcVertex vertex;
-    node = mcSurfaceNet_getNode(&surfaceNet, i);
-    /* NOTE: These lattice positions are in mesh space coordinates,
-     * not sample space coordinates. The vertices of the mesh we
-     * generate must be in mesh space coordinates in which min is
-     * at the origin. */
-    mcVec3_subtract(&node->pos, min, &vertex.pos);
-    /* TODO: Calculate the surface normal */
-    /* NOTE: Since cubes have sharp corners, we need multiple vertices in
-     * strategic places in order to accurately represent the sharp angles.
-     * Corners require three vertices, edges require two vertices, and flat
-     * surfaces require only one vertex.
-     *
-     * TODO: In order to classify vertices, we can use a lookup table. For
-     * instance, given the two neighbors nodes that make a triangle, we can
-     * determine the direction the normal points. Given the neighbor
-     * connectivity in all 6 directions, we can determine the type of node
-     * (corner, edge, or flat) and also all of the normal directions we need to
-     * compute.
-     *
-     * TODO: There are many reasonable strategies for generating a cuberille
-     * mesh. We can generate triangles or quads.
-     */
-    /* Add the vertex for this node to the mesh */
-    node->vertexIndex = mcMesh_addVertex(mesh, &vertex);
+  mcCuberilleParams defaultParams;
+  if (params == NULL) {
+    mcCuberilleParams_default(&defaultParams);
+    params = &defaultParams;
   }
-  /* With the vertex indices generated, we can now generate triangles */
-  for (int i = 0; i < surfaceNet.numNodes; ++i) {
-    mcSurfaceNode *node, *frontNeighbor, *leftNeighbor, *topNeighbor,
-                  *bottomNeighbor, *rightNeighbor, *backNeighbor;
-    node = mcSurfaceNet_getNode(&surfaceNet, i);
-    /* We look for pairs of neighboring nodes in order to generate quads.  See
-     * Gibson, "Constrained Elastic Surface Nets: Generating Smooth Models from
-     * Binary Segmented Data."
-     * Note that we must avoid generating redundant triangles, since each quad
-     * has two possible triangulations. We make the decision arbitrarily. */
-    frontNeighbor = node->neighbors[MC_SURFACE_NODE_FRONT];
-    leftNeighbor = node->neighbors[MC_SURFACE_NODE_LEFT];
-    topNeighbor = node->neighbors[MC_SURFACE_NODE_TOP];
-    bottomNeighbor = node->neighbors[MC_SURFACE_NODE_BOTTOM];
-    rightNeighbor = node->neighbors[MC_SURFACE_NODE_RIGHT];
-    backNeighbor = node->neighbors[MC_SURFACE_NODE_BACK];
-    /* TODO: Maybe add an option for changing the triangulation and/or chosing
-     * an optimal triangulation. */
-    /* TODO: Make sure the winding order of these triangles is correct */
-    /* LEFT+FRONT and BACK+RIGHT or LEFT+BACK and FRONT+RIGHT */
-    if (leftNeighbor && frontNeighbor
-        && leftNeighbor->neighbors[MC_SURFACE_NODE_FRONT])
-    {
-      assert(leftNeighbor->neighbors[MC_SURFACE_NODE_FRONT]
-          == frontNeighbor->neighbors[MC_SURFACE_NODE_LEFT]);
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = leftNeighbor->vertexIndex;
-      triangle.indices[2] = frontNeighbor->vertexIndex;
-      mcMesh_addFace(mesh, &triangle);
-    }
-    if (backNeighbor && rightNeighbor
-        && backNeighbor->neighbors[MC_SURFACE_NODE_RIGHT])
-    {
-      assert(backNeighbor->neighbors[MC_SURFACE_NODE_RIGHT]
-          == rightNeighbor->neighbors[MC_SURFACE_NODE_BACK]);
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = backNeighbor->vertexIndex;
-      triangle.indices[2] = rightNeighbor->vertexIndex;
-      mcMesh_addFace(mesh, &triangle);
-    }
-    /* FRONT+TOP and BOTTOM+BACK or FRONT+BOTTOM and TOP+BACK */
-    if (frontNeighbor && topNeighbor
-        && frontNeighbor->neighbors[MC_SURFACE_NODE_TOP])
-    {
-      assert(frontNeighbor->neighbors[MC_SURFACE_NODE_TOP]
-          == topNeighbor->neighbors[MC_SURFACE_NODE_FRONT]);
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = frontNeighbor->vertexIndex;
-      triangle.indices[2] = topNeighbor->vertexIndex;
-      mcMesh_addFace(mesh, &triangle);
-    }
-    if (bottomNeighbor && backNeighbor
-        && bottomNeighbor->neighbors[MC_SURFACE_NODE_BACK])
-    {
-      assert(bottomNeighbor->neighbors[MC_SURFACE_NODE_BACK]
-          == backNeighbor->neighbors[MC_SURFACE_NODE_BOTTOM]);
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = bottomNeighbor->vertexIndex;
-      triangle.indices[2] = backNeighbor->vertexIndex;
-      mcMesh_addFace(mesh, &triangle);
+  assert(params->type == MC_CUBERILLE_PARAMS);
+  /* The cuberille surface is the boundary of the union of the cubes centered
+   * at each sample below the isosurface. Every lattice edge between samples
+   * on opposite sides of the isosurface crosses one square face of this
+   * boundary, and the corners of that square are the centers of the four
+   * voxel cubes about the edge. We give each voxel cube that intersects the
+   * isosurface a single vertex at its center, so that neighboring faces share
+   * vertices, and emit the faces directly as the lattice is swept slice by
+   * slice. */
+  mcFace quad, triangle;
+  mcFace_init(&quad, 4);
+  mcFace_init(&triangle, 3);
+  mcSampleSlices slices;
+  mcSampleSlices_init(&slices, sf, args, res_x, res_y, res_z, min, max);
+  float delta_x = slices.delta_x;
+  float delta_y = slices.delta_y;
+  float delta_z = slices.delta_z;
+  /* Vertex indices for the voxel cubes in the current and previous slices,
+   * or -1 for voxel cubes that do not intersect the isosurface */
+  int *previousSlice = (int*)malloc(sizeof(int) * (res_x - 1) * (res_y - 1));
+  int *currentSlice = (int*)malloc(sizeof(int) * (res_x - 1) * (res_y - 1));
+  /* Iterate over the cube lattice */
+  for (unsigned int z = 0; z < res_z - 1; ++z) {
+    mcSampleSlices_advance(&slices);
+    for (unsigned int y = 0; y < res_y - 1; ++y) {
+      for (unsigned int x = 0; x < res_x - 1; ++x) {
+        float samples[8];
+        unsigned int cube = 0;
+        for (unsigned int sampleIndex = 0; sampleIndex < 8; ++sampleIndex) {
+          unsigned int pos[3];
+          mcCube_sampleRelativePosition(sampleIndex, pos);
+          samples[sampleIndex] = mcSampleSlices_value(&slices,
+              x + pos[0], y + pos[1], pos[2]);
+          cube |= (samples[sampleIndex] >= 0.0f ? 1 : 0) << sampleIndex;
+        }
+        if (cube == 0x00 || cube == 0xff) {
+          currentSlice[x + y * (res_x - 1)] = -1;
+          continue;
+        }
+        mcVertex vertex;
+        /* NOTE: The positions we compute are in mesh space coordinates, in
+         * which min is at the origin. */
+        vertex.pos.x = ((float)x + 0.5f) * delta_x;
+        vertex.pos.y = ((float)y + 0.5f) * delta_y;
+        vertex.pos.z = ((float)z + 0.5f) * delta_z;
+        /* Estimate the gradient at the center of the voxel cube from the
+         * differences across its four parallel edges along each axis */
+        vertex.norm.x = (samples[1] - samples[0] + samples[3] - samples[2]
+            + samples[5] - samples[4] + samples[7] - samples[6]) / delta_x;
+        vertex.norm.y = (samples[2] - samples[0] + samples[3] - samples[1]
+            + samples[6] - samples[4] + samples[7] - samples[5]) / delta_y;
+        vertex.norm.z = (samples[4] - samples[0] + samples[5] - samples[1]
+            + samples[6] - samples[2] + samples[7] - samples[3]) / delta_z;
+        if (mcVec3_length(&vertex.norm) > 0.0f)
+          mcVec3_normalize(&vertex.norm, &vertex.norm);
+        currentSlice[x + y * (res_x - 1)] = mcMesh_addVertex(mesh, &vertex);
+      }
     }
-    /* LEFT+TOP and BOTTOM+RIGHT or LEFT+BOTTOM and TOP+RIGHT */
-    if (leftNeighbor && topNeighbor
-        && leftNeighbor->neighbors[MC_SURFACE_NODE_TOP])
-    {
-      assert(leftNeighbor->neighbors[MC_SURFACE_NODE_TOP]
-          == topNeighbor->neighbors[MC_SURFACE_NODE_LEFT]);
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = leftNeighbor->vertexIndex;
-      triangle.indices[2] = topNeighbor->vertexIndex;
-      mcMesh_addFace(mesh, &triangle);
+    /* Emit the faces crossing the lattice edges whose four voxel cubes have
+     * all been visited. Lattice edges on the boundary of the lattice have
+     * fewer than four voxel cubes and are left open. */
+    for (unsigned int y = 1; y < res_y - 1; ++y) {
+      for (unsigned int x = 1; x < res_x - 1; ++x) {
+        int vertexIndices[4];
+        int inside = mcSampleSlices_value(&slices, x, y, 0) < 0.0f;
+        /* The edge parallel to the z-axis between this slice and the next */
+        if (inside != (mcSampleSlices_value(&slices, x, y, 1) < 0.0f)) {
+          vertexIndices[0] = currentSlice[(x - 1) + (y - 1) * (res_x - 1)];
+          vertexIndices[1] = currentSlice[x + (y - 1) * (res_x - 1)];
+          vertexIndices[2] = currentSlice[x + y * (res_x - 1)];
+          vertexIndices[3] = currentSlice[(x - 1) + y * (res_x - 1)];
+          mcCuberille_addFace(vertexIndices, !inside, params,
+              &quad, &triangle, mesh);
+        }
+      }
     }
-    if (bottomNeighbor && rightNeighbor
-        && bottomNeighbor->neighbors[MC_SURFACE_NODE_RIGHT])
-    {
-      assert(bottomNeighbor->neighbors[MC_SURFACE_NODE_RIGHT]
-          == rightNeighbor->neighbors[MC_SURFACE_NODE_BOTTOM]);
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = bottomNeighbor->vertexIndex;
-      triangle.indices[2] = rightNeighbor->vertexIndex;
-      mcMesh_addFace(mesh, &triangle);
+    if (z > 0) {
+      for (unsigned int y = 0; y < res_y; ++y) {
+        for (unsigned int x = 0; x < res_x; ++x) {
+          int vertexIndices[4];
+          int inside = mcSampleSlices_value(&slices, x, y, 0) < 0.0f;
+          /* The edge parallel to the x-axis */
+          if (x < res_x - 1 && y > 0 && y < res_y - 1
+              && inside != (mcSampleSlices_value(&slices, x + 1, y, 0) < 0.0f))
+          {
+            vertexIndices[0] = previousSlice[x + (y - 1) * (res_x - 1)];
+            vertexIndices[1] = previousSlice[x + y * (res_x - 1)];
+            vertexIndices[2] = currentSlice[x + y * (res_x - 1)];
+            vertexIndices[3] = currentSlice[x + (y - 1) * (res_x - 1)];
+            mcCuberille_addFace(vertexIndices, !inside, params,
+                &quad, &triangle, mesh);
+          }
+          /* The edge parallel to the y-axis */
+          if (y < res_y - 1 && x > 0 && x < res_x - 1
+              && inside != (mcSampleSlices_value(&slices, x, y + 1, 0) < 0.0f))
+          {
+            vertexIndices[0] = previousSlice[(x - 1) + y * (res_x - 1)];
+            vertexIndices[1] = currentSlice[(x - 1) + y * (res_x - 1)];
+            vertexIndices[2] = currentSlice[x + y * (res_x - 1)];
+            vertexIndices[3] = previousSlice[x + y * (res_x - 1)];
+            mcCuberille_addFace(vertexIndices, !inside, params,
+                &quad, &triangle, mesh);
+          }
+        }
+      }
     }
+    /* Make the current slice the previous one */
+    int *temp = previousSlice;
+    previousSlice = currentSlice;
+    currentSlice = temp;
   }
   /* Free our resources */
+  free(previousSlice);
+  free(currentSlice);
+  mcSampleSlices_destroy(&slices);
+  mcFace_destroy(&quad);
   mcFace_destroy(&triangle);
-  mcSurfaceNet_destroy(&surfaceNet);
 }
@@ -21,4 +21,266 @@
  * IN THE SOFTWARE.
  */
 
-/* TODO */
+#include <math.h>
+#include <stdlib.h>
+
+#include <mc/algorithms/common/cube.h>
+#include <mc/algorithms/common/sampleSlices.h>
+#include <mc/algorithms/cubes33/cubes33.h>
+#include <mc/mesh.h>
+
+#include "cubes33_tables.c"
+
+/**
+ * This file implements Marching Cubes 33. The tables generated by
+ * generate_tables.c hold one triangulation for every combination of test
+ * results that can apply to each cube configuration, so the only work beyond
+ * simple marching cubes is deciding those tests for the few cubes that need
+ * them.
+ */
+
+/* The samples at the bottom of the four z-axis cube edges, in cyclic order */
+static const unsigned int mcCubes33_zEdgeSamples[] = { 0, 1, 3, 2 };
+
+/**
+ * Decides the face test for the given face with the asymptotic decider, and
+ * returns 1 if the inside samples on the face are connected across it.
+ */
+int mcCubes33_faceTest(unsigned int face, const float *values) {
+  unsigned int s[4];
+  mcCube_faceSampleIndices(face, s);
+  /* The bilinear interpolant on the face has a saddle with value
+   * (v0 * v2 - v1 * v3) / (v0 + v2 - v1 - v3), which connects samples 0 and 2
+   * when it lies on their side of the isosurface */
+  float q = values[s[0]] * values[s[2]] - values[s[1]] * values[s[3]];
+  return values[s[0]] < 0.0f ? q > 0.0f : q < 0.0f;
+}
+
+/**
+ * Decides the given interior test, and returns 1 if some slice of the cube
+ * perpendicular to the z-axis connects the two diagonal z-axis edges of the
+ * test on the side of the isosurface being tested.
+ */
+int mcCubes33_interiorTest(unsigned int test, const float *values) {
+  int diagonal = test >> 1;
+  int inside = !(test & 1);
+  float lo = 0.0f, hi = 1.0f;
+  float v[4], dv[4];
+  /* Find the range of slices in which the diagonal edges lie on the tested
+   * side while the other two edges lie on the opposite side. Edges 0 and 2
+   * make up the diagonal, edges 1 and 3 the other diagonal. */
+  for (int i = 0; i < 4; ++i) {
+    unsigned int bottom = mcCubes33_zEdgeSamples[(diagonal + i) % 4];
+    int side = (i & 1) ? !inside : inside;
+    v[i] = values[bottom];
+    dv[i] = values[bottom + 4] - values[bottom];
+    int bottomOnSide = (v[i] < 0.0f) == side;
+    int topOnSide = (values[bottom + 4] < 0.0f) == side;
+    if (bottomOnSide && topOnSide)
+      continue;
+    if (!bottomOnSide && !topOnSide)
+      return 0;
+    float t = -v[i] / dv[i];
+    if (bottomOnSide)
+      hi = fminf(hi, t);
+    else
+      lo = fmaxf(lo, t);
+  }
+  if (lo > hi)
+    return 0;
+  /* Within this range, the slice connects the diagonal edges when its saddle
+   * lies on the tested side, which is when q(t) > 0 for the quadratic
+   * q(t) = v0(t) * v2(t) - v1(t) * v3(t). */
+  float a = dv[0] * dv[2] - dv[1] * dv[3];
+  float b = v[0] * dv[2] + v[2] * dv[0] - v[1] * dv[3] - v[3] * dv[1];
+  float c = v[0] * v[2] - v[1] * v[3];
+  float t[3] = { lo, hi, lo };
+  if (a < 0.0f)
+    t[2] = fminf(fmaxf(-b / (2.0f * a), lo), hi);
+  for (int i = 0; i < 3; ++i) {
+    if ((a * t[i] + b) * t[i] + c > 0.0f)
+      return 1;
+  }
+  return 0;
+}
+
+unsigned int mcCubes33_subcase(unsigned int tests, const float *values) {
+  unsigned int subcase = 0;
+  for (int test = 0, bit = 0; tests != 0; ++test, tests >>= 1) {
+    if (!(tests & 1))
+      continue;
+    int result = test < MC_CUBES33_NUM_FACE_TESTS
+      ? mcCubes33_faceTest(test, values)
+      : mcCubes33_interiorTest(test - MC_CUBES33_NUM_FACE_TESTS, values);
+    subcase |= result << bit++;
+  }
+  return subcase;
+}
+
+void mcCubes33_isosurfaceFromField(
+    mcScalarFieldWithArgs sf, const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max,
+    mcMesh *mesh)
+{
+  float delta[3];
+  delta[0] = fabs(max->x - min->x) / (float)(x_res - 1);
+  delta[1] = fabs(max->y - min->y) / (float)(y_res - 1);
+  delta[2] = fabs(max->z - min->z) / (float)(z_res - 1);
+  /* Locate each cube edge relative to the cube's zero sample, so that edge
+   * intersections can be found in the vertex buffers below without any
+   * branching on the edge number */
+  int edgeAxis[MC_CUBE_NUM_EDGES];
+  unsigned int edgeSamples[MC_CUBE_NUM_EDGES][2];
+  unsigned int edgeOrigin[MC_CUBE_NUM_EDGES][3];
+  for (int edge = 0; edge < MC_CUBE_NUM_EDGES; ++edge) {
+    unsigned int pos[2][3];
+    mcCube_edgeSampleIndices(edge, edgeSamples[edge]);
+    mcCube_sampleRelativePosition(edgeSamples[edge][0], pos[0]);
+    mcCube_sampleRelativePosition(edgeSamples[edge][1], pos[1]);
+    edgeAxis[edge] = pos[0][0] != pos[1][0] ? 0
+      : pos[0][1] != pos[1][1] ? 1 : 2;
+    for (int i = 0; i < 3; ++i)
+      edgeOrigin[edge][i] = pos[0][i] < pos[1][i] ? pos[0][i] : pos[1][i];
+  }
+  /* As in simple marching cubes, we take advantage of slice-to-slice
+   * coherence by keeping the mesh vertices on the lattice edges of the two
+   * lattice slices bounding the current layer of cubes, as well as the
+   * vertices on the lattice edges between those slices. Index 0 refers to
+   * slice z and index 1 to slice z + 1. */
+  unsigned int sliceSize = x_res * y_res;
+  int *xEdgeVertices[2], *yEdgeVertices[2];
+  for (int i = 0; i < 2; ++i) {
+    xEdgeVertices[i] = (int*)malloc(sizeof(int) * sliceSize);
+    yEdgeVertices[i] = (int*)malloc(sizeof(int) * sliceSize);
+  }
+  int *zEdgeVertices = (int*)malloc(sizeof(int) * sliceSize);
+  for (unsigned int i = 0; i < sliceSize; ++i)
+    xEdgeVertices[1][i] = yEdgeVertices[1][i] = -1;
+  mcSampleSlices slices;
+  mcSampleSlices_init(&slices, sf, args, x_res, y_res, z_res, min, max);
+  mcFace triangle;
+  mcFace_init(&triangle, 3);
+  for (int z = 0; z < z_res - 1; ++z) {
+    /* Rotate the sample buffer and get samples for next slice */
+    mcSampleSlices_advance(&slices);
+    /* Rotate the vertex buffers so that slice z + 1 becomes slice z */
+    int *temp;
+    temp = xEdgeVertices[0];
+    xEdgeVertices[0] = xEdgeVertices[1];
+    xEdgeVertices[1] = temp;
+    temp = yEdgeVertices[0];
+    yEdgeVertices[0] = yEdgeVertices[1];
+    yEdgeVertices[1] = temp;
+    for (unsigned int i = 0; i < sliceSize; ++i) {
+      xEdgeVertices[1][i] = yEdgeVertices[1][i] = zEdgeVertices[i] = -1;
+    }
+    for (int y = 0; y < y_res - 1; ++y) {
+      for (int x = 0; x < x_res - 1; ++x) {
+        /* Determine the cube configuration */
+        float values[MC_CUBE_NUM_VERTICES];
+        unsigned int cube = 0;
+        for (unsigned int sampleIndex = 0; sampleIndex < 8; ++sampleIndex) {
+          values[sampleIndex] = mcSampleSlices_value(&slices,
+              x + (sampleIndex & 1), y + ((sampleIndex >> 1) & 1),
+              sampleIndex >> 2);
+          cube |= (values[sampleIndex] >= 0.0f ? 0 : 1) << sampleIndex;
+        }
+        if (cube == 0x00 || cube == 0xff)
+          continue;
+        /* Find the subcase for this cube. Only cubes with ambiguous faces or
+         * an ambiguous interior have tests to decide. */
+        unsigned int subcase = mcCubes33_subcaseTable[cube];
+        unsigned int tests = mcCubes33_testTable[cube];
+        if (tests)
+          subcase += mcCubes33_subcase(tests, values);
+        const unsigned char *t =
+          &mcCubes33_triangleTable[mcCubes33_triangleOffsetTable[subcase]];
+        const unsigned char *end =
+          &mcCubes33_triangleTable[mcCubes33_triangleOffsetTable[subcase + 1]];
+        /* Add the triangles for this subcase, finding or making the vertex for
+         * each edge intersection */
+        int vertices[MC_CUBE_NUM_EDGES + 1];
+        for (int edge = 0; edge <= MC_CUBE_NUM_EDGES; ++edge)
+          vertices[edge] = -1;
+        for (; t < end; t += 3) {
+          for (int i = 0; i < 3; ++i) {
+            int edge = t[i];
+            if (vertices[edge] != -1) {
+              triangle.indices[i] = vertices[edge];
+              continue;
+            }
+            unsigned int mask = 1 << edge;
+            if (edge == MC_CUBES33_CENTER_VERTEX)
+              mask = mcCubes33_centerTable[subcase];
+            for (int e = 0; e < MC_CUBE_NUM_EDGES; ++e) {
+              if (!(mask & (1 << e)) || vertices[e] != -1)
+                continue;
+              const unsigned int *o = edgeOrigin[e];
+              unsigned int index = (x + o[0]) + (y + o[1]) * x_res;
+              int *vertexIndex = edgeAxis[e] == 0 ? &xEdgeVertices[o[2]][index]
+                : edgeAxis[e] == 1 ? &yEdgeVertices[o[2]][index]
+                : &zEdgeVertices[index];
+              if (*vertexIndex == -1) {
+                /* The mesh vertex for this edge intersection has not been
+                 * generated yet */
+                mcVec3 latticePos[2], gradients[2];
+                for (int j = 0; j < 2; ++j) {
+                  unsigned int pos[3];
+                  mcCube_sampleRelativePosition(edgeSamples[e][j], pos);
+                  /* NOTE: These lattice positions are in mesh space
+                   * coordinates, in which min is at the origin. */
+                  latticePos[j].x = (float)(x + pos[0]) * delta[0];
+                  latticePos[j].y = (float)(y + pos[1]) * delta[1];
+                  latticePos[j].z = (float)(z + pos[2]) * delta[2];
+                  mcSampleSlices_gradient(&slices, x + pos[0], y + pos[1],
+                      pos[2], &gradients[j]);
+                }
+                float v0 = values[edgeSamples[e][0]];
+                float v1 = values[edgeSamples[e][1]];
+                float weight = fabs(v0 / (v0 - v1));
+                mcVertex vertex;
+                vertex.pos = mcVec3_lerp(&latticePos[0], &latticePos[1],
+                    weight);
+                vertex.norm = mcVec3_lerp(&gradients[0], &gradients[1],
+                    weight);
+                mcVec3_normalize(&vertex.norm, &vertex.norm);
+                *vertexIndex = mcMesh_addVertex(mesh, &vertex);
+              }
+              vertices[e] = *vertexIndex;
+            }
+            if (edge == MC_CUBES33_CENTER_VERTEX) {
+              /* The vertex at the center of the isosurface within this cube
+               * is the average of the edge intersections around it */
+              mcVertex center;
+              float count = 0.0f;
+              center.pos.x = center.pos.y = center.pos.z = 0.0f;
+              center.norm.x = center.norm.y = center.norm.z = 0.0f;
+              for (int e = 0; e < MC_CUBE_NUM_EDGES; ++e) {
+                if (!(mask & (1 << e)))
+                  continue;
+                const mcVertex *vertex = &mesh->vertices[vertices[e]];
+                mcVec3_add(&center.pos, &vertex->pos, &center.pos);
+                mcVec3_add(&center.norm, &vertex->norm, &center.norm);
+                count += 1.0f;
+              }
+              mcVec3_scalarProduct(1.0f / count, &center.pos, &center.pos);
+              mcVec3_normalize(&center.norm, &center.norm);
+              vertices[edge] = mcMesh_addVertex(mesh, &center);
+            }
+            triangle.indices[i] = vertices[edge];
+          }
+          mcMesh_addFace(mesh, &triangle);
+        }
+      }
+    }
+  }
+  /* Free our resources */
+  mcFace_destroy(&triangle);
+  mcSampleSlices_destroy(&slices);
+  for (int i = 0; i < 2; ++i) {
+    free(xEdgeVertices[i]);
+    free(yEdgeVertices[i]);
+  }
+  free(zEdgeVertices);
+}
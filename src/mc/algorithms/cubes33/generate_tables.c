@@ -0,0 +1,681 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mc/algorithms/common/cube.h>
+#include <mc/algorithms/cubes33/common.h>
+
+/*
+ * This program generates the tables for the Marching Cubes 33 algorithm.
+ *
+ * Rather than transcribing the 33 cases and their subcases by hand, the
+ * triangulation for each cube configuration and each combination of test
+ * results is derived from the topology of the trilinear interpolant:
+ *
+ * - Two samples on the same side of the isosurface are connected along the
+ *   cube surface if they share an edge, or if they lie diagonally across an
+ *   ambiguous face whose face test (the asymptotic decider) says that side of
+ *   the isosurface is connected across the face.
+ * - The isosurface crosses each face in segments between edge intersections,
+ *   which join into closed loops on the cube surface. Each loop normally
+ *   bounds its own disk inside the cube.
+ * - The only other way the trilinear interpolant connects two regions is
+ *   through the cube interior. Every slice of the cube perpendicular to the
+ *   z-axis is bilinear, so two regions connect through the interior exactly
+ *   when some slice connects two diagonal z-axis edges. When an interior test
+ *   finds such a slice, the loops around the two regions bound a single tube
+ *   instead of two disks.
+ *
+ * Disks are triangulated with the minimum total diagonal length, and tubes by
+ * zipping their two loops together, using edge midpoints as the vertex
+ * positions. Triangle edges lying in a cube face are avoided, if necessary by
+ * fanning around a vertex at the center of the cube.
+ */
+
+#define MAX_LOOPS MC_CUBE_NUM_EDGES
+#define MAX_TRIANGLES 64
+#define FACE_PENALTY 100.0f
+
+typedef struct Loop {
+  int edges[MC_CUBE_NUM_EDGES];
+  int numEdges;
+  int insideRegion, outsideRegion;
+  int used;
+} Loop;
+
+typedef struct Subcase {
+  unsigned char triangles[MAX_TRIANGLES][3];
+  int numTriangles;
+  unsigned int centerEdges;
+} Subcase;
+
+/* The samples at the bottom of the four z-axis cube edges, in cyclic order */
+static const unsigned int zEdgeSamples[] = { 0, 1, 3, 2 };
+
+int countBits(unsigned int bits) {
+  int count = 0;
+  for (; bits; bits &= bits - 1)
+    ++count;
+  return count;
+}
+
+int isInside(unsigned int cube, unsigned int sample) {
+  return (cube >> sample) & 1;
+}
+
+int findRegion(int *regions, int sample) {
+  while (regions[sample] != sample) {
+    regions[sample] = regions[regions[sample]];
+    sample = regions[sample];
+  }
+  return sample;
+}
+
+void joinRegions(int *regions, int a, int b) {
+  regions[findRegion(regions, a)] = findRegion(regions, b);
+}
+
+void samplePosition(unsigned int sample, float *pos) {
+  unsigned int rel[3];
+  mcCube_sampleRelativePosition(sample, rel);
+  for (int i = 0; i < 3; ++i)
+    pos[i] = (float)rel[i];
+}
+
+void edgeMidpoint(unsigned int edge, float *pos) {
+  unsigned int sampleIndices[2];
+  float a[3], b[3];
+  mcCube_edgeSampleIndices(edge, sampleIndices);
+  samplePosition(sampleIndices[0], a);
+  samplePosition(sampleIndices[1], b);
+  for (int i = 0; i < 3; ++i)
+    pos[i] = 0.5f * (a[i] + b[i]);
+}
+
+float edgeDistance(unsigned int a, unsigned int b) {
+  float p[3], q[3], d = 0.0f;
+  edgeMidpoint(a, p);
+  edgeMidpoint(b, q);
+  for (int i = 0; i < 3; ++i)
+    d += (p[i] - q[i]) * (p[i] - q[i]);
+  return sqrtf(d);
+}
+
+/**
+ * Returns true if the two given edges lie on a common cube face. A triangle
+ * edge between two such edge intersections would lie in the face, where the
+ * neighboring cube could use the same edge, so such diagonals are avoided.
+ */
+int shareFace(unsigned int a, unsigned int b) {
+  unsigned int facesA[2], facesB[2];
+  mcCube_edgeFaces(a, facesA);
+  mcCube_edgeFaces(b, facesB);
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 2; ++j) {
+      if (facesA[i] == facesB[j])
+        return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Returns the cost of a triangle edge between the two given edge
+ * intersections that is not on the cube surface. Diagonals lying in a cube face
+ * are heavily penalized.
+ */
+float diagonalCost(unsigned int a, unsigned int b) {
+  return edgeDistance(a, b) + (shareFace(a, b) ? FACE_PENALTY : 0.0f);
+}
+
+unsigned int insideSample(unsigned int cube, unsigned int edge, int inside) {
+  unsigned int sampleIndices[2];
+  mcCube_edgeSampleIndices(edge, sampleIndices);
+  return isInside(cube, sampleIndices[0]) == inside
+    ? sampleIndices[0] : sampleIndices[1];
+}
+
+/**
+ * Returns the tests that apply to the given cube configuration, with face test
+ * i in bit i and interior test i in bit (MC_CUBES33_NUM_FACE_TESTS + i).
+ */
+unsigned int computeTests(unsigned int cube) {
+  unsigned int tests = 0;
+  for (int face = 0; face < MC_CUBE_NUM_FACES; ++face) {
+    if (mcCube_isAmbiguousFace(mcCube_getCubeFace(cube, face)))
+      tests |= 1 << face;
+  }
+  for (int test = 0; test < MC_CUBES33_NUM_INTERIOR_TESTS; ++test) {
+    /* An interior test applies if both diagonal z-axis edges can lie on the
+     * tested side of the isosurface while the other two z-axis edges lie on
+     * the other side */
+    int diagonal = test >> 1;
+    int inside = !(test & 1);
+    int possible = 1;
+    for (int i = 0; i < 4; ++i) {
+      unsigned int bottom = zEdgeSamples[i];
+      int side = (i & 1) == diagonal ? inside : !inside;
+      if (isInside(cube, bottom) != side && isInside(cube, bottom + 4) != side)
+        possible = 0;
+    }
+    if (possible)
+      tests |= 1 << (MC_CUBES33_NUM_FACE_TESTS + test);
+  }
+  return tests;
+}
+
+/**
+ * Adds the segment between the given edge intersections on the given face,
+ * oriented so that the outside of the isosurface lies to the left when the
+ * face is viewed from outside the cube. This matches the triangle winding
+ * order of the simple marching cubes tables.
+ */
+void addSegment(unsigned int cube, unsigned int face, int a, int b, int *next) {
+  unsigned int sampleIndices[4];
+  float center[3] = { 0.0f, 0.0f, 0.0f }, normal[3], p[3], q[3], s[3];
+  mcCube_faceSampleIndices(face, sampleIndices);
+  for (int i = 0; i < 4; ++i) {
+    float pos[3];
+    samplePosition(sampleIndices[i], pos);
+    for (int j = 0; j < 3; ++j)
+      center[j] += 0.25f * pos[j];
+  }
+  for (int i = 0; i < 3; ++i)
+    normal[i] = center[i] - 0.5f;
+  edgeMidpoint(a, p);
+  edgeMidpoint(b, q);
+  samplePosition(insideSample(cube, a, 1), s);
+  float d[3], v[3];
+  for (int i = 0; i < 3; ++i) {
+    d[i] = q[i] - p[i];
+    v[i] = s[i] - 0.5f * (p[i] + q[i]);
+  }
+  float left[3] = {
+    normal[1] * d[2] - normal[2] * d[1],
+    normal[2] * d[0] - normal[0] * d[2],
+    normal[0] * d[1] - normal[1] * d[0] };
+  if (left[0] * v[0] + left[1] * v[1] + left[2] * v[2] > 0.0f) {
+    /* The inside is on the left, so reverse the segment */
+    int temp = a;
+    a = b;
+    b = temp;
+  }
+  assert(next[a] == -1);
+  next[a] = b;
+}
+
+void addTriangle(Subcase *subcase, int a, int b, int c) {
+  assert(subcase->numTriangles < MAX_TRIANGLES);
+  subcase->triangles[subcase->numTriangles][0] = a;
+  subcase->triangles[subcase->numTriangles][1] = b;
+  subcase->triangles[subcase->numTriangles][2] = c;
+  subcase->numTriangles += 1;
+}
+
+/**
+ * Triangulates the disk bounded by the given loop, choosing the triangulation
+ * with the least total diagonal length. Some loops cannot be triangulated
+ * without a diagonal lying in a cube face; these are fanned around a vertex at
+ * the center of the loop instead, as Marching Cubes 33 does for cases such as
+ * 7.3 and 13.5.1.
+ */
+void triangulateDisk(const Loop *loop, Subcase *subcase) {
+  int n = loop->numEdges;
+  float cost[MAX_LOOPS][MAX_LOOPS];
+  int split[MAX_LOOPS][MAX_LOOPS];
+  for (int length = 1; length < n; ++length) {
+    for (int i = 0; i + length < n; ++i) {
+      int j = i + length;
+      cost[i][j] = 0.0f;
+      split[i][j] = -1;
+      if (length < 2)
+        continue;
+      for (int k = i + 1; k < j; ++k) {
+        float c = cost[i][k] + cost[k][j];
+        if (k - i > 1)
+          c += diagonalCost(loop->edges[i], loop->edges[k]);
+        if (j - k > 1)
+          c += diagonalCost(loop->edges[k], loop->edges[j]);
+        if (split[i][j] == -1 || c < cost[i][j]) {
+          cost[i][j] = c;
+          split[i][j] = k;
+        }
+      }
+    }
+  }
+  if (cost[0][n - 1] >= FACE_PENALTY && subcase->centerEdges == 0) {
+    for (int i = 0; i < n; ++i) {
+      addTriangle(subcase, loop->edges[i], loop->edges[(i + 1) % n],
+          MC_CUBES33_CENTER_VERTEX);
+      subcase->centerEdges |= 1 << loop->edges[i];
+    }
+    return;
+  }
+  /* Walk the splits to emit the triangles */
+  int stack[MAX_LOOPS][2], top = 0;
+  stack[top][0] = 0;
+  stack[top][1] = n - 1;
+  ++top;
+  while (top > 0) {
+    --top;
+    int i = stack[top][0], j = stack[top][1];
+    if (j - i < 2)
+      continue;
+    int k = split[i][j];
+    addTriangle(subcase,
+        loop->edges[i], loop->edges[k], loop->edges[j]);
+    stack[top][0] = i; stack[top][1] = k; ++top;
+    stack[top][0] = k; stack[top][1] = j; ++top;
+  }
+}
+
+/**
+ * Computes the least cost of the rungs zipping together the two given loops,
+ * starting from the rung between a(i0) and b(j0). Walking forward along one
+ * loop walks backward along the other, so cost[k][l] is the least cost after
+ * taking k steps forward along a and l steps backward along b, or negative if
+ * that rung cannot be reached. Each step adds one triangle and one rung.
+ *
+ * When closed is set, the zipper goes all the way around both loops. Any
+ * closed zipper can be started on a step along a that follows a step along b,
+ * so only those are considered, which keeps the rungs from repeating.
+ * Otherwise the zipper stops short of going around either loop.
+ */
+void zipTube(
+    const Loop *a, const Loop *b, int i0, int j0, int closed,
+    float cost[MAX_LOOPS + 1][MAX_LOOPS + 1],
+    int fromA[MAX_LOOPS + 1][MAX_LOOPS + 1])
+{
+  int n = a->numEdges, m = b->numEdges;
+  for (int k = 0; k <= n; ++k) {
+    for (int l = 0; l <= m; ++l) {
+      int i = (i0 + k) % n, j = ((j0 - l) % m + m) % m;
+      if (k == 0 && l == 0) {
+        cost[k][l] = diagonalCost(a->edges[i], b->edges[j]);
+        continue;
+      }
+      cost[k][l] = -1.0f;
+      if (closed ? (k == 0 || (l == m && k < n) || (k == n && l == 0))
+          : (k == n || l == m))
+        continue;
+      float viaA = k > 0 ? cost[k - 1][l] : -1.0f;
+      float viaB = l > 0 ? cost[k][l - 1] : -1.0f;
+      if (viaA < 0.0f && viaB < 0.0f)
+        continue;
+      fromA[k][l] = viaB < 0.0f || (viaA >= 0.0f && viaA <= viaB);
+      cost[k][l] = (fromA[k][l] ? viaA : viaB)
+        + diagonalCost(a->edges[i], b->edges[j]);
+    }
+  }
+}
+
+/**
+ * Triangulates the tube between the two given loops by zipping them together
+ * with the least total rung cost. Some tubes cannot be zipped without rungs
+ * lying in a cube face; if it avoids some of them, these are zipped part of the
+ * way and the rest is fanned around a vertex at the center of the tube, as
+ * Marching Cubes 33 does for cases such as 6.1.2 and 10.1.2.
+ */
+void triangulateTube(const Loop *a, const Loop *b, Subcase *subcase) {
+  int n = a->numEdges, m = b->numEdges;
+#define A(index) (a->edges[((index) % n + n) % n])
+#define B(index) (b->edges[((index) % m + m) % m])
+  float cost[MAX_LOOPS + 1][MAX_LOOPS + 1];
+  int fromA[MAX_LOOPS + 1][MAX_LOOPS + 1];
+  float bestCost = -1.0f;
+  int bestStart[2] = { 0, 0 }, bestEnd[2] = { n, m };
+  int bestFromA[MAX_LOOPS + 1][MAX_LOOPS + 1];
+  for (int i0 = 0; i0 < n; ++i0) {
+    for (int j0 = 0; j0 < m; ++j0) {
+      zipTube(a, b, i0, j0, 1, cost, fromA);
+      if (cost[n][m] >= 0.0f && (bestCost < 0.0f || cost[n][m] < bestCost)) {
+        bestCost = cost[n][m];
+        bestStart[0] = i0;
+        bestStart[1] = j0;
+        memcpy(bestFromA, fromA, sizeof(fromA));
+      }
+    }
+  }
+  int fan = 0;
+  if ((bestCost < 0.0f || bestCost >= FACE_PENALTY)
+      && subcase->centerEdges == 0)
+  {
+    /* Zip the tube from one rung to another, and fan the rest around the
+     * center vertex. Both rungs are counted in the cost. */
+    float bestFanCost = -1.0f;
+    int fanStart[2] = { 0, 0 }, fanEnd[2] = { 0, 0 };
+    int fanFromA[MAX_LOOPS + 1][MAX_LOOPS + 1];
+    for (int i0 = 0; i0 < n; ++i0) {
+      for (int j0 = 0; j0 < m; ++j0) {
+        zipTube(a, b, i0, j0, 0, cost, fromA);
+        for (int k = 1; k < n; ++k) {
+          for (int l = 1; l < m; ++l) {
+            if (cost[k][l] < 0.0f
+                || (bestFanCost >= 0.0f && cost[k][l] >= bestFanCost))
+              continue;
+            bestFanCost = cost[k][l];
+            fanStart[0] = i0;
+            fanStart[1] = j0;
+            fanEnd[0] = k;
+            fanEnd[1] = l;
+            memcpy(fanFromA, fromA, sizeof(fromA));
+          }
+        }
+      }
+    }
+    if (bestFanCost >= 0.0f
+        && (bestCost < 0.0f || bestFanCost < bestCost))
+    {
+      fan = 1;
+      memcpy(bestStart, fanStart, sizeof(fanStart));
+      memcpy(bestEnd, fanEnd, sizeof(fanEnd));
+      memcpy(bestFromA, fanFromA, sizeof(fanFromA));
+    }
+  }
+  assert(fan || bestCost >= 0.0f);
+  /* Walk the best path backward from the final rung to emit the triangles */
+  for (int k = bestEnd[0], l = bestEnd[1]; k > 0 || l > 0; ) {
+    int i = bestStart[0] + k, j = bestStart[1] - l;
+    if (bestFromA[k][l]) {
+      addTriangle(subcase, A(i - 1), A(i), B(j));
+      --k;
+    } else {
+      addTriangle(subcase, B(j), B(j + 1), A(i));
+      --l;
+    }
+  }
+  if (fan) {
+    int i0 = bestStart[0], j0 = bestStart[1];
+    int i1 = i0 + bestEnd[0], j1 = j0 - bestEnd[1];
+    for (int i = i1; i < i0 + n; ++i)
+      addTriangle(subcase, A(i), A(i + 1), MC_CUBES33_CENTER_VERTEX);
+    addTriangle(subcase, A(i0), B(j0), MC_CUBES33_CENTER_VERTEX);
+    for (int j = j0 - m; j < j1; ++j)
+      addTriangle(subcase, B(j), B(j + 1), MC_CUBES33_CENTER_VERTEX);
+    addTriangle(subcase, B(j1), A(i1), MC_CUBES33_CENTER_VERTEX);
+    for (int i = 0; i < n; ++i)
+      subcase->centerEdges |= 1 << A(i);
+    for (int j = 0; j < m; ++j)
+      subcase->centerEdges |= 1 << B(j);
+  }
+#undef A
+#undef B
+}
+
+/**
+ * Computes the triangles for the given cube configuration given the results
+ * of its tests. Bit i of results holds the result of the ith test in tests,
+ * counting only the tests that apply.
+ */
+void computeSubcase(
+    unsigned int cube, unsigned int tests, unsigned int results,
+    Subcase *subcase)
+{
+  int faceResults[MC_CUBE_NUM_FACES] = { 0 };
+  int interiorResults[MC_CUBES33_NUM_INTERIOR_TESTS] = { 0 };
+  for (int test = 0, bit = 0; test < MC_CUBES33_NUM_TESTS; ++test) {
+    if (!(tests & (1 << test)))
+      continue;
+    int result = (results >> bit++) & 1;
+    if (test < MC_CUBES33_NUM_FACE_TESTS)
+      faceResults[test] = result;
+    else
+      interiorResults[test - MC_CUBES33_NUM_FACE_TESTS] = result;
+  }
+  subcase->numTriangles = 0;
+  subcase->centerEdges = 0;
+
+  /* Find the regions on either side of the isosurface along the cube surface */
+  int regions[MC_CUBE_NUM_VERTICES];
+  for (int i = 0; i < MC_CUBE_NUM_VERTICES; ++i)
+    regions[i] = i;
+  for (int edge = 0; edge < MC_CUBE_NUM_EDGES; ++edge) {
+    unsigned int sampleIndices[2];
+    mcCube_edgeSampleIndices(edge, sampleIndices);
+    if (isInside(cube, sampleIndices[0]) == isInside(cube, sampleIndices[1]))
+      joinRegions(regions, sampleIndices[0], sampleIndices[1]);
+  }
+  int next[MC_CUBE_NUM_EDGES];
+  memset(next, -1, sizeof(next));
+  for (int face = 0; face < MC_CUBE_NUM_FACES; ++face) {
+    unsigned int s[4];
+    int edges[4], numEdges = 0;
+    mcCube_faceSampleIndices(face, s);
+    for (int i = 0; i < 4; ++i) {
+      edges[i] = -1;
+      if (isInside(cube, s[i]) != isInside(cube, s[(i + 1) % 4])) {
+        edges[i] = mcCube_sampleIndicesToEdge(s[i], s[(i + 1) % 4]);
+        ++numEdges;
+      }
+    }
+    if (numEdges == 2) {
+      int a = -1, b = -1;
+      for (int i = 0; i < 4; ++i) {
+        if (edges[i] == -1)
+          continue;
+        if (a == -1)
+          a = edges[i];
+        else
+          b = edges[i];
+      }
+      addSegment(cube, face, a, b, next);
+    } else if (numEdges == 4) {
+      /* The face test tells us whether the inside samples connect across the
+       * face */
+      if (isInside(cube, s[0]) == faceResults[face]) {
+        /* Samples 0 and 2 are connected; cut off samples 1 and 3 */
+        joinRegions(regions, s[0], s[2]);
+        addSegment(cube, face, edges[0], edges[1], next);
+        addSegment(cube, face, edges[2], edges[3], next);
+      } else {
+        /* Samples 1 and 3 are connected; cut off samples 0 and 2 */
+        joinRegions(regions, s[1], s[3]);
+        addSegment(cube, face, edges[3], edges[0], next);
+        addSegment(cube, face, edges[1], edges[2], next);
+      }
+    }
+  }
+
+  /* Trace the segments into loops */
+  Loop loops[MAX_LOOPS];
+  int numLoops = 0;
+  int visited[MC_CUBE_NUM_EDGES] = { 0 };
+  for (int edge = 0; edge < MC_CUBE_NUM_EDGES; ++edge) {
+    if (next[edge] == -1 || visited[edge])
+      continue;
+    Loop *loop = &loops[numLoops++];
+    loop->numEdges = 0;
+    loop->used = 0;
+    for (int e = edge; !visited[e]; e = next[e]) {
+      assert(next[e] != -1);
+      visited[e] = 1;
+      loop->edges[loop->numEdges++] = e;
+    }
+    loop->insideRegion = findRegion(regions, insideSample(cube, edge, 1));
+    loop->outsideRegion = findRegion(regions, insideSample(cube, edge, 0));
+  }
+
+  /* Connect regions through the cube interior with tubes */
+  int interiorRegions[MC_CUBE_NUM_VERTICES];
+  memcpy(interiorRegions, regions, sizeof(regions));
+  for (int test = 0; test < MC_CUBES33_NUM_INTERIOR_TESTS; ++test) {
+    if (!interiorResults[test])
+      continue;
+    int diagonal = test >> 1;
+    int inside = !(test & 1);
+    int samples[2];
+    for (int i = 0; i < 2; ++i) {
+      unsigned int bottom = zEdgeSamples[diagonal + 2 * i];
+      samples[i] = isInside(cube, bottom) == inside ? bottom : bottom + 4;
+    }
+    if (findRegion(interiorRegions, samples[0])
+        == findRegion(interiorRegions, samples[1]))
+      continue;  /* These regions are already connected */
+    Loop *tube[2] = { NULL, NULL };
+    int valid = 1;
+    for (int i = 0; i < 2; ++i) {
+      int region = findRegion(regions, samples[i]);
+      for (int j = 0; j < numLoops; ++j) {
+        if ((inside ? loops[j].insideRegion : loops[j].outsideRegion)
+            != region)
+          continue;
+        if (tube[i] != NULL || loops[j].used)
+          valid = 0;
+        tube[i] = &loops[j];
+      }
+      if (tube[i] == NULL)
+        valid = 0;
+    }
+    if (!valid)
+      continue;  /* The trilinear interpolant cannot produce this tube */
+    triangulateTube(tube[0], tube[1], subcase);
+    tube[0]->used = tube[1]->used = 1;
+    joinRegions(interiorRegions, samples[0], samples[1]);
+  }
+
+  /* Every other loop bounds a disk */
+  for (int i = 0; i < numLoops; ++i) {
+    if (!loops[i].used)
+      triangulateDisk(&loops[i], subcase);
+  }
+}
+
+void printTestTable(const unsigned int *testTable, FILE *fh) {
+  fprintf(fh, "const unsigned short mcCubes33_testTable[] = {\n");
+  for (unsigned int cube = 0; cube <= 0xff; ++cube) {
+    if (cube % 8 == 0)
+      fprintf(fh, "  ");
+    fprintf(fh, "0x%03x,", testTable[cube]);
+    fprintf(fh, (cube + 1) % 8 == 0 ? "\n" : " ");
+  }
+  fprintf(fh, "};\n");
+}
+
+void printSubcaseTable(const unsigned int *subcaseTable, FILE *fh) {
+  fprintf(fh, "const unsigned short mcCubes33_subcaseTable[] = {\n");
+  for (unsigned int cube = 0; cube <= 0xff; ++cube) {
+    if (cube % 8 == 0)
+      fprintf(fh, "  ");
+    fprintf(fh, "%5d,", subcaseTable[cube]);
+    fprintf(fh, (cube + 1) % 8 == 0 ? "\n" : " ");
+  }
+  fprintf(fh, "};\n");
+}
+
+void printTriangleTables(
+    const Subcase *subcases, unsigned int numSubcases,
+    FILE *fh)
+{
+  unsigned int offset = 0;
+  fprintf(fh, "const unsigned int mcCubes33_triangleOffsetTable[] = {\n");
+  for (unsigned int i = 0; i <= numSubcases; ++i) {
+    if (i % 8 == 0)
+      fprintf(fh, "  ");
+    fprintf(fh, "%6d,", offset);
+    fprintf(fh, (i + 1) % 8 == 0 || i == numSubcases ? "\n" : " ");
+    if (i < numSubcases)
+      offset += 3 * subcases[i].numTriangles;
+  }
+  fprintf(fh, "};\n\n");
+  fprintf(fh, "const unsigned short mcCubes33_centerTable[] = {\n");
+  for (unsigned int i = 0; i < numSubcases; ++i) {
+    if (i % 8 == 0)
+      fprintf(fh, "  ");
+    fprintf(fh, "0x%03x,", subcases[i].centerEdges);
+    fprintf(fh, (i + 1) % 8 == 0 || i + 1 == numSubcases ? "\n" : " ");
+  }
+  fprintf(fh, "};\n\n");
+  fprintf(fh, "const unsigned char mcCubes33_triangleTable[] = {\n");
+  for (unsigned int i = 0; i < numSubcases; ++i) {
+    if (subcases[i].numTriangles == 0)
+      continue;
+    fprintf(fh, " ");
+    for (int j = 0; j < subcases[i].numTriangles; ++j) {
+      fprintf(fh, " %2d, %2d, %2d,",
+          subcases[i].triangles[j][0],
+          subcases[i].triangles[j][1],
+          subcases[i].triangles[j][2]);
+    }
+    fprintf(fh, "  /* Subcase %d */\n", i);
+  }
+  fprintf(fh, "};\n");
+}
+
+void print_usage() {
+  fprintf(stderr,
+      "Usage:\n"
+      "cubes33_generate_tables [filename]\n\n"
+      "Where [filename] is one of the following:\n"
+      "    cubes33_tables.c\n"
+      );
+}
+
+int main(int argc, char **argv) {
+  /* Parse the arguments to determine which file we are generating */
+  if (argc != 2 || strcmp(argv[1], "cubes33_tables.c") != 0) {
+    print_usage();
+    return EXIT_FAILURE;
+  }
+
+  /* Count the subcases so that we can allocate the tables */
+  unsigned int *testTable =
+    (unsigned int*)malloc(sizeof(unsigned int) * 256);
+  unsigned int *subcaseTable =
+    (unsigned int*)malloc(sizeof(unsigned int) * 256);
+  unsigned int numSubcases = 0;
+  for (unsigned int cube = 0; cube <= 0xff; ++cube) {
+    testTable[cube] = computeTests(cube);
+    subcaseTable[cube] = numSubcases;
+    numSubcases += 1 << countBits(testTable[cube]);
+  }
+
+  /* Compute the triangles for every combination of test results */
+  Subcase *subcases = (Subcase*)malloc(sizeof(Subcase) * numSubcases);
+  for (unsigned int cube = 0; cube <= 0xff; ++cube) {
+    unsigned int count = 1 << countBits(testTable[cube]);
+    for (unsigned int results = 0; results < count; ++results) {
+      computeSubcase(cube, testTable[cube], results,
+          &subcases[subcaseTable[cube] + results]);
+    }
+  }
+
+  /* Print the tables */
+  fprintf(stdout, "#include <mc/algorithms/cubes33/common.h>\n\n");
+  printTestTable(testTable, stdout);
+  fprintf(stdout, "\n");
+  printSubcaseTable(subcaseTable, stdout);
+  fprintf(stdout, "\n");
+  printTriangleTables(subcases, numSubcases, stdout);
+
+  /* Free our resources */
+  free(testTable);
+  free(subcaseTable);
+  free(subcases);
+
+  return EXIT_SUCCESS;
+}
@@ -21,32 +21,238 @@
  * IN THE SOFTWARE.
  */
 
-#include <mc/algorithms/common/dual.h>
-#include <mc/algorithms/patch.h>
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
 
+#include <mc/algorithms/common/cube.h>
+#include <mc/algorithms/common/sampleSlices.h>
+#include <mc/algorithms/dualMarchingCubes/dualMarchingCubes.h>
+#include <mc/algorithms/simple/simple_tables.h>
+
+/**
+ * The dual vertices generated for a single voxel cube. Each edge of the cube
+ * that intersects the isosurface belongs to exactly one marching cubes patch,
+ * and each patch generates exactly one dual vertex.
+ */
+typedef struct mcDualMarchingCubesVoxel {
+  /** The dual vertex index for the patch containing each edge, or -1 for
+   * edges that do not intersect the isosurface. */
+  int vertexIndices[MC_CUBE_NUM_EDGES];
+} mcDualMarchingCubesVoxel;
+
+int mcDualMarchingCubes_findPatch(int *parents, int edge) {
+  while (parents[edge] != edge) {
+    parents[edge] = parents[parents[edge]];
+    edge = parents[edge];
+  }
+  return edge;
+}
+
+/**
+ * Computes the dual vertices of the patches within the voxel cube at the
+ * given lattice coordinates, and adds them to the mesh.
+ *
+ * The patches are the connected components of the marching cubes
+ * triangulation for the cube configuration. The dual vertex of each patch is
+ * the average of its edge intersections, which is the same midpoint that
+ * mcDual_makeDual() computes for each face of the MC-Patch mesh.
+ */
+void mcDualMarchingCubes_addPatchVertices(
+    const mcSampleSlices *slices,
+    unsigned int x, unsigned int y, unsigned int cube,
+    mcDualMarchingCubesVoxel *voxel,
+    mcMesh *mesh)
+{
+  int parents[MC_CUBE_NUM_EDGES];
+  mcVertex edgeVertices[MC_CUBE_NUM_EDGES];
+  mcVertex patchVertices[MC_CUBE_NUM_EDGES];
+  int numPatchEdges[MC_CUBE_NUM_EDGES];
+  int patchVertexIndices[MC_CUBE_NUM_EDGES];
+  const int *edges = mcSimple_edgeIntersectionTable[cube].edges;
+  /* Join the edge intersections of each triangle into patches */
+  for (int edge = 0; edge < MC_CUBE_NUM_EDGES; ++edge) {
+    parents[edge] = edge;
+    voxel->vertexIndices[edge] = -1;
+  }
+  for (int i = 0; i < MC_SIMPLE_MAX_TRIANGLES; ++i) {
+    const int *triangle =
+      mcSimple_triangulationTable[cube].triangles[i].edgeIntersections;
+    if (triangle[0] == -1)
+      break;  /* No more triangles */
+    for (int j = 1; j < 3; ++j) {
+      parents[mcDualMarchingCubes_findPatch(parents, triangle[j])] =
+        mcDualMarchingCubes_findPatch(parents, triangle[0]);
+    }
+  }
+  /* Compute the edge intersections and sum them into their patches */
+  for (int i = 0; i < MC_CUBE_NUM_EDGES && edges[i] != -1; ++i) {
+    unsigned int sampleIndices[2];
+    float values[2];
+    mcVec3 latticePos[2], gradients[2];
+    mcVertex *vertex = &edgeVertices[edges[i]];
+    mcCube_edgeSampleIndices(edges[i], sampleIndices);
+    for (int j = 0; j < 2; ++j) {
+      unsigned int pos[3];
+      mcCube_sampleRelativePosition(sampleIndices[j], pos);
+      /* NOTE: These lattice positions are in mesh space coordinates, in which
+       * min is at the origin. */
+      latticePos[j].x = (float)(x + pos[0]) * slices->delta_x;
+      latticePos[j].y = (float)(y + pos[1]) * slices->delta_y;
+      latticePos[j].z = (float)(slices->z + pos[2]) * slices->delta_z;
+      values[j] = mcSampleSlices_value(slices, x + pos[0], y + pos[1], pos[2]);
+      mcSampleSlices_gradient(slices, x + pos[0], y + pos[1], pos[2],
+          &gradients[j]);
+    }
+    float weight = fabs(values[0] / (values[0] - values[1]));
+    vertex->pos = mcVec3_lerp(&latticePos[0], &latticePos[1], weight);
+    vertex->norm = mcVec3_lerp(&gradients[0], &gradients[1], weight);
+    mcVec3_normalize(&vertex->norm, &vertex->norm);
+  }
+  for (int edge = 0; edge < MC_CUBE_NUM_EDGES; ++edge) {
+    numPatchEdges[edge] = 0;
+    patchVertexIndices[edge] = -1;
+    patchVertices[edge].pos.x = patchVertices[edge].pos.y =
+      patchVertices[edge].pos.z = 0.0f;
+    patchVertices[edge].norm.x = patchVertices[edge].norm.y =
+      patchVertices[edge].norm.z = 0.0f;
+  }
+  for (int i = 0; i < MC_CUBE_NUM_EDGES && edges[i] != -1; ++i) {
+    int patch = mcDualMarchingCubes_findPatch(parents, edges[i]);
+    mcVec3_add(&patchVertices[patch].pos, &edgeVertices[edges[i]].pos,
+        &patchVertices[patch].pos);
+    mcVec3_add(&patchVertices[patch].norm, &edgeVertices[edges[i]].norm,
+        &patchVertices[patch].norm);
+    numPatchEdges[patch] += 1;
+  }
+  /* Add one dual vertex for each patch, in order of the patch's first edge */
+  for (int i = 0; i < MC_CUBE_NUM_EDGES && edges[i] != -1; ++i) {
+    int patch = mcDualMarchingCubes_findPatch(parents, edges[i]);
+    if (patchVertexIndices[patch] == -1) {
+      mcVertex *vertex = &patchVertices[patch];
+      mcVec3_scalarProduct(1.0f / (float)numPatchEdges[patch], &vertex->pos,
+          &vertex->pos);
+      if (mcVec3_length(&vertex->norm) > 0.0f)
+        mcVec3_normalize(&vertex->norm, &vertex->norm);
+      patchVertexIndices[patch] = mcMesh_addVertex(mesh, vertex);
+    }
+    voxel->vertexIndices[edges[i]] = patchVertexIndices[patch];
+  }
+}
+
+/**
+ * Computes the MC-Dual surface in a single sweep of the sample lattice.
+ *
+ * Every edge intersection of the marching cubes surface corresponds to a face
+ * of the dual surface whose vertices are the dual vertices of the (up to
+ * four) voxel cubes sharing that lattice edge. We visit voxel cubes in the
+ * same slice-by-slice order as the simple marching cubes algorithm, so the
+ * last voxel cube to share a given edge is always the one at the greatest
+ * lattice coordinates. That voxel cube emits the dual face. Only the voxels
+ * of the current and previous slices need to be kept.
+ */
 void mcDualMarchingCubes_isosurfaceFromField(
     mcScalarFieldWithArgs sf, const void *args,
     unsigned int x_res, unsigned int y_res, unsigned int z_res,
     const mcVec3 *min, const mcVec3 *max,
     mcMesh *mesh)
 {
-  mcMesh cubesMesh;
-  mcMesh *dualMesh = mesh;
-
-  mcMesh_init(&cubesMesh);
-  mcPatch_isosurfaceFromField(
-      sf, args,
-      x_res, y_res, z_res,
-      min, max,
-      &cubesMesh);
-
-  /* The maximum number of adjacent faces in a marching cubes mesh is four. See
-   * Nielson for details. */
-  mcDual_makeDual(
-      &cubesMesh,  /* mesh */
-      4,  /* maxFacesPerVertex */
-      dualMesh  /* dual */
-      );
-
-  mcMesh_destroy(&cubesMesh);
+  /* Offsets of the voxel cubes about a lattice edge, counter-clockwise about
+   * the positive direction of the edge */
+  static const int offsets[4][2] = {
+    { -1, -1 }, { 0, -1 }, { 0, 0 }, { -1, 0 } };
+  const int res[3] = { x_res, y_res, z_res };
+  mcFace face;
+  mcFace_init(&face, 4);
+  mcSampleSlices slices;
+  mcSampleSlices_init(&slices, sf, args, x_res, y_res, z_res, min, max);
+  mcDualMarchingCubesVoxel *previousSlice = (mcDualMarchingCubesVoxel*)malloc(
+      sizeof(mcDualMarchingCubesVoxel) * (x_res - 1) * (y_res - 1));
+  mcDualMarchingCubesVoxel *currentSlice = (mcDualMarchingCubesVoxel*)malloc(
+      sizeof(mcDualMarchingCubesVoxel) * (x_res - 1) * (y_res - 1));
+  /* Iterate over the cube lattice */
+  for (int z = 0; z < z_res - 1; ++z) {
+    mcSampleSlices_advance(&slices);
+    for (int y = 0; y < y_res - 1; ++y) {
+      for (int x = 0; x < x_res - 1; ++x) {
+        const int voxelPos[3] = { x, y, z };
+        mcDualMarchingCubesVoxel *voxel = &currentSlice[x + y * (x_res - 1)];
+        /* Determine the cube configuration index by iterating over the eight
+         * cube vertices */
+        unsigned int cube = 0;
+        for (unsigned int sampleIndex = 0; sampleIndex < 8; ++sampleIndex) {
+          unsigned int pos[3];
+          mcCube_sampleRelativePosition(sampleIndex, pos);
+          cube |= (mcSampleSlices_value(&slices, x + pos[0], y + pos[1], pos[2])
+              >= 0.0f ? 0 : 1) << sampleIndex;
+        }
+        mcDualMarchingCubes_addPatchVertices(&slices, x, y, cube, voxel, mesh);
+        /* Emit the dual faces for the intersected edges that no voxel cube
+         * later in the sweep shares with this one */
+        for (int edge = 0; edge < MC_CUBE_NUM_EDGES; ++edge) {
+          unsigned int sampleIndices[2], rel[3];
+          int axis, u, v, latticePos[3], numIndices;
+          if (voxel->vertexIndices[edge] == -1)
+            continue;  /* This edge does not intersect the isosurface */
+          mcCube_edgeSampleIndices(edge, sampleIndices);
+          mcCube_sampleRelativePosition(sampleIndices[0], rel);
+          axis = (sampleIndices[0] ^ sampleIndices[1]) >> 1;
+          u = (axis + 1) % 3;
+          v = (axis + 2) % 3;
+          /* Edges on the far side of this cube are shared with later voxel
+           * cubes, unless this cube is the last along that axis */
+          if ((rel[u] && voxelPos[u] < res[u] - 2)
+              || (rel[v] && voxelPos[v] < res[v] - 2))
+            continue;
+          for (int i = 0; i < 3; ++i)
+            latticePos[i] = voxelPos[i] + rel[i];
+          /* Gather the dual vertices about this edge */
+          int indices[4];
+          numIndices = 0;
+          for (int i = 0; i < 4; ++i) {
+            int cubePos[3];
+            unsigned int a;
+            const mcDualMarchingCubesVoxel *neighbor;
+            cubePos[axis] = latticePos[axis];
+            cubePos[u] = latticePos[u] + offsets[i][0];
+            cubePos[v] = latticePos[v] + offsets[i][1];
+            if (cubePos[u] < 0 || cubePos[u] >= res[u] - 1
+                || cubePos[v] < 0 || cubePos[v] >= res[v] - 1)
+              continue;  /* No voxel cube beyond the lattice */
+            neighbor = (cubePos[2] == z ? currentSlice : previousSlice)
+              + cubePos[0] + cubePos[1] * (x_res - 1);
+            a = (latticePos[0] - cubePos[0])
+              | (latticePos[1] - cubePos[1]) << 1
+              | (latticePos[2] - cubePos[2]) << 2;
+            /* NOTE: The edge always intersects the isosurface, so every voxel
+             * cube sharing it has a patch containing it */
+            indices[numIndices] = neighbor->vertexIndices[
+              mcCube_sampleIndicesToEdge(a, a | (1 << axis))];
+            assert(indices[numIndices] != -1);
+            numIndices += 1;
+          }
+          if (numIndices < 3)
+            continue;  /* Too few voxel cubes on the edge of the lattice */
+          /* The dual face must face the same way as the gradient, which
+           * points from the sample below the isosurface to the one above */
+          int reverse = !mcCube_sampleValue(sampleIndices[0], cube);
+          if (face.numIndices != numIndices) {
+            mcFace_destroy(&face);
+            mcFace_init(&face, numIndices);
+          }
+          for (int i = 0; i < numIndices; ++i)
+            face.indices[i] = indices[reverse ? numIndices - 1 - i : i];
+          mcMesh_addFace(mesh, &face);
+        }
+      }
+    }
+    /* Make the current slice the previous one */
+    mcDualMarchingCubesVoxel *temp = previousSlice;
+    previousSlice = currentSlice;
+    currentSlice = temp;
+  }
+  free(previousSlice);
+  free(currentSlice);
+  mcSampleSlices_destroy(&slices);
+  mcFace_destroy(&face);
 }
@@ -22,60 +22,89 @@
  */
 
 #include <assert.h>
+#include <float.h>
 #include <math.h>
 #include <stddef.h>
 
 #include <mc/algorithms/common/cube.h>
 
 #include <mc/algorithms/common/surfaceNet.h>
+#include <mc/algorithms/elasticSurfaceNet/elasticSurfaceNet.h>
 
 #define max(a, b) ((a) > (b) ? (a) : (b))
 #define min(a, b) ((a) < (b) ? (a) : (b))
 #define squared(a) ((a) * (a))
 
-float mcElasticSurfaceNet_nodeEnergy(const mcSurfaceNode *node) {
-  float energy;
-  /* TODO: Sum up the square of the distance to each of our existing neighbors */
-  energy = 0.0f;
-  for (unsigned int i = 0; i < MC_CUBE_NUM_FACES; ++i) {
-    float distanceSquared;
-    mcSurfaceNode *neighbor;
-    neighbor = node->neighbors[i];
-    if (neighbor == NULL)
-      continue;
-    distanceSquared = squared(neighbor->oldPos.x - node->pos.x)
-      + squared(neighbor->oldPos.y - node->pos.y)
-      + squared(neighbor->oldPos.z - node->pos.z);
-    energy += distanceSquared;
-  }
-  return energy;
+void mcElasticSurfaceNetParams_default(mcElasticSurfaceNetParams *params) {
+  params->type = MC_ELASTIC_SURFACE_NET_PARAMS;
+  params->maxIterations = 1000;
+  params->weight = 0.5f;
+  params->energyTolerance = 1.0e-4f;
 }
 
-void mcElasticSurfaceNet_nodeNegihborsMidpoint(const mcSurfaceNode *node, mcVec3 *midpoint) {
-  int numNeighbors;
-  /* TODO: Average the position of all neighboring nodes */
-  numNeighbors = 0;
-  midpoint->x = 0.0f;
-  midpoint->y = 0.0f;
-  midpoint->z = 0.0f;
-  for (unsigned int i = 0; i < MC_CUBE_NUM_FACES; ++i) {
-    mcSurfaceNode *neighbor;
-    neighbor = node->neighbors[i];
-    if (neighbor == NULL)
+/**
+ * Performs a single Jacobi relaxation step on the given surface net. Each
+ * surface node is moved towards the midpoint of its neighbors' old positions
+ * and then restricted to within its voxel cube. Since new positions are only
+ * computed from old positions, the nodes can be relaxed in parallel.
+ *
+ * Returns the total energy of the surface net at the old positions, measured
+ * as the sum of the squared distances between neighboring nodes.
+ */
+float mcElasticSurfaceNet_relax(
+    mcSurfaceNet *surfaceNet,
+    float weight,
+    const mcVec3 *min, const mcVec3 *delta)
+{
+  const mcVec3 *oldPos = surfaceNet->oldPos;
+  const int32_t *neighbors = surfaceNet->neighbors;
+  const unsigned int *latticePos = surfaceNet->latticePos;
+  mcVec3 *pos = surfaceNet->pos;
+  int numNodes = (int)surfaceNet->numNodes;
+  float energy = 0.0f;
+#pragma omp parallel for reduction(+:energy) schedule(static)
+  for (int i = 0; i < numNodes; ++i) {
+    mcVec3 midpoint, newPos;
+    int numNeighbors = 0;
+    midpoint.x = midpoint.y = midpoint.z = 0.0f;
+    /* Average the old positions of all neighboring nodes and accumulate the
+     * energy between this node and its neighbors */
+    for (int j = 0; j < MC_CUBE_NUM_FACES; ++j) {
+      int32_t neighbor = neighbors[i * 6 + j];
+      if (neighbor == MC_SURFACE_NET_NO_NEIGHBOR)
+        continue;
+      numNeighbors += 1;
+      midpoint.x += oldPos[neighbor].x;
+      midpoint.y += oldPos[neighbor].y;
+      midpoint.z += oldPos[neighbor].z;
+      energy += squared(oldPos[neighbor].x - oldPos[i].x)
+        + squared(oldPos[neighbor].y - oldPos[i].y)
+        + squared(oldPos[neighbor].z - oldPos[i].z);
+    }
+    if (numNeighbors == 0) {
+      /* Nodes without neighbors stay where they are */
+      pos[i] = oldPos[i];
       continue;
-    numNeighbors += 1;
-    midpoint->x += neighbor->pos.x;
-    midpoint->y += neighbor->pos.y;
-    midpoint->z += neighbor->pos.z;
-  }
-  if (numNeighbors == 0) {
-    /* The midpoint is trivial for a node with no neighbors */
-    *midpoint = node->pos;
-    return;
+    }
+    midpoint.x /= (float)numNeighbors;
+    midpoint.y /= (float)numNeighbors;
+    midpoint.z /= (float)numNeighbors;
+    /* Nudge the node towards the midpoint of its neighbor nodes */
+    newPos.x = oldPos[i].x + weight * (midpoint.x - oldPos[i].x);
+    newPos.y = oldPos[i].y + weight * (midpoint.y - oldPos[i].y);
+    newPos.z = oldPos[i].z + weight * (midpoint.z - oldPos[i].z);
+    /* Restrict the new position to within the voxel cube */
+    const unsigned int *lattice = &latticePos[i * 3];
+    newPos.x = max(newPos.x, min->x + (float)lattice[0] * delta->x);
+    newPos.x = min(newPos.x, min->x + (float)(lattice[0] + 1) * delta->x);
+    newPos.y = max(newPos.y, min->y + (float)lattice[1] * delta->y);
+    newPos.y = min(newPos.y, min->y + (float)(lattice[1] + 1) * delta->y);
+    newPos.z = max(newPos.z, min->z + (float)lattice[2] * delta->z);
+    newPos.z = min(newPos.z, min->z + (float)(lattice[2] + 1) * delta->z);
+    pos[i] = newPos;
   }
-  midpoint->x /= (float)numNeighbors;
-  midpoint->y /= (float)numNeighbors;
-  midpoint->z /= (float)numNeighbors;
+  /* Each pair of neighbors was counted twice */
+  return 0.5f * energy;
 }
 
 /**
@@ -88,13 +117,21 @@ void mcElasticSurfaceNet_isosurfaceFromField(
     mcScalarFieldWithArgs sf, const void *args,
     unsigned int res_x, unsigned int res_y, unsigned int res_z,
     const mcVec3 *min, const mcVec3 *max,
+    const mcElasticSurfaceNetParams *params,
     mcMesh *mesh)
 {
+  mcElasticSurfaceNetParams defaultParams;
   mcSurfaceNet surfaceNet;
   mcFace triangle;
-  float delta_x = fabs(max->x - min->x) / (float)(res_x - 1);
-  float delta_y = fabs(max->y - min->y) / (float)(res_y - 1);
-  float delta_z = fabs(max->z - min->z) / (float)(res_z - 1);
+  mcVec3 delta;
+  delta.x = fabs(max->x - min->x) / (float)(res_x - 1);
+  delta.y = fabs(max->y - min->y) / (float)(res_y - 1);
+  delta.z = fabs(max->z - min->z) / (float)(res_z - 1);
+  if (params == NULL) {
+    mcElasticSurfaceNetParams_default(&defaultParams);
+    params = &defaultParams;
+  }
+  assert(params->type == MC_ELASTIC_SURFACE_NET_PARAMS);
   /* Initialize the surface net structure */
   mcSurfaceNet_init(&surfaceNet);
   /* Build the surface net from samples of our scalar field */
@@ -102,152 +139,126 @@ void mcElasticSurfaceNet_isosurfaceFromField(
       sf, args,
       res_x, res_y, res_z,
       min, max);
-  /* TODO: Iteratively relax the position of surface nodes to reduce the total
-   * energy between neighboring nodes */
-  /* TODO: Make the number of iterations configurable */
-  /* TODO: Automatically detect when the total energy is below a suitable threshold */
-  static const int MAX_ITERATIONS = 3000;
-  for (int i = 0; i < MAX_ITERATIONS; ++i) {
-    /* TODO: Record the current position of the surface nodes as their old
+  /* Iteratively relax the position of surface nodes to reduce the total
+   * energy between neighboring nodes. We stop once the energy no longer
+   * decreases significantly between iterations. */
+  float prevEnergy = FLT_MAX;
+  for (unsigned int i = 0; i < params->maxIterations; ++i) {
+    float energy;
+    /* Record the current position of the surface nodes as their old
      * positions */
     mcSurfaceNet_updateOldPos(&surfaceNet);
-    /* TODO: We relax surface node positions by "nudging" surface nodes to
-     * reduce the measured energy between nodes. Energy is measured as the sum
-     * of the square distances between neighbors.
-     */
-    for (unsigned int j = 0; j < surfaceNet.numNodes; ++j) {
-      mcSurfaceNode *node;
-      mcVec3 initialPos, midpoint;
-      float initial, final;
-      node = mcSurfaceNet_getNode(&surfaceNet, j);
-      /* TODO: Measure the initial energy of this node */
-      initial = mcElasticSurfaceNet_nodeEnergy(node);
-      /* TODO: Nudge the node towards the centerpoint of its neighbor nodes */
-      mcElasticSurfaceNet_nodeNegihborsMidpoint(node, &midpoint);
-      const float WEIGHT = 0.001f;
-      node->pos.x = (1.0f - WEIGHT) * node->oldPos.x + WEIGHT * midpoint.x;
-      node->pos.y = (1.0f - WEIGHT) * node->oldPos.y + WEIGHT * midpoint.y;
-      node->pos.z = (1.0f - WEIGHT) * node->oldPos.z + WEIGHT * midpoint.z;
-      /* Restrict the new position to within the voxel cube */
-      node->pos.x = max(node->pos.x,
-          min->x + (float)node->latticePos[0] * delta_x);
-      node->pos.x = min(node->pos.x,
-          min->x + (float)(node->latticePos[0] + 1) * delta_x);
-      node->pos.y = max(node->pos.y,
-          min->y + (float)node->latticePos[1] * delta_y);
-      node->pos.y = min(node->pos.y,
-          min->y + (float)(node->latticePos[1] + 1) * delta_y);
-      node->pos.z = max(node->pos.z,
-          min->z + (float)node->latticePos[2] * delta_z);
-      node->pos.z = min(node->pos.z,
-          min->z + (float)(node->latticePos[2] + 1) * delta_z);
-      /* Measure the final energy of this node and compare */
-      final = mcElasticSurfaceNet_nodeEnergy(node);
-      if (final > initial) {
-        node->pos = initialPos;
-      }
-    }
+    energy = mcElasticSurfaceNet_relax(&surfaceNet,
+        params->weight, min, &delta);
+    if (prevEnergy - energy <= params->energyTolerance * prevEnergy)
+      break;
+    prevEnergy = energy;
   }
   /* Now that the vertices are in their final positions, we can add them to the
    * mesh and generate vertex indices */
   mcFace_init(&triangle, 3);
   for (int i = 0; i < surfaceNet.numNodes; ++i) {
-    mcSurfaceNode *node;
     mcVertex vertex;
-    node = mcSurfaceNet_getNode(&surfaceNet, i);
-    vertex.pos = node->pos;
+    vertex.pos = surfaceNet.pos[i];
     /* TODO: Calculate the surface normal */
-    node->vertexIndex = mcMesh_addVertex(mesh, &vertex);
-    /* XXX: Draw a triangle here so we can tell where the vertices are going */
-    triangle.indices[0] = node->vertexIndex;
-    vertex.pos.x += delta_x * 0.1;
-    triangle.indices[1] = mcMesh_addVertex(mesh, &vertex);
-    vertex.pos.y += delta_y * 0.1;
-    triangle.indices[2] = mcMesh_addVertex(mesh, &vertex);
-    mcMesh_addFace(mesh, &triangle);
+    surfaceNet.vertexIndices[i] = mcMesh_addVertex(mesh, &vertex);
   }
   /* With the vertex indices generated, we can now generate triangles */
+  const int32_t *neighbors = surfaceNet.neighbors;
+  const unsigned int *vertexIndices = surfaceNet.vertexIndices;
   for (int i = 0; i < surfaceNet.numNodes; ++i) {
-    mcSurfaceNode *node, *frontNeighbor, *leftNeighbor, *topNeighbor,
-                  *bottomNeighbor, *rightNeighbor, *backNeighbor;
-    node = mcSurfaceNet_getNode(&surfaceNet, i);
+    int32_t frontNeighbor, leftNeighbor, topNeighbor,
+            bottomNeighbor, rightNeighbor, backNeighbor;
     /* We look for pairs of neighboring nodes in order to generate quads.  See
      * Gibson, "Constrained Elastic Surface Nets: Generating Smooth Models from
      * Binary Segmented Data."
      * Note that we must avoid generating redundant triangles, since each quad
      * has two possible triangulations. We make the decision arbitrarily. */
-    frontNeighbor = node->neighbors[MC_SURFACE_NODE_FRONT];
-    leftNeighbor = node->neighbors[MC_SURFACE_NODE_LEFT];
-    topNeighbor = node->neighbors[MC_SURFACE_NODE_TOP];
-    bottomNeighbor = node->neighbors[MC_SURFACE_NODE_BOTTOM];
-    rightNeighbor = node->neighbors[MC_SURFACE_NODE_RIGHT];
-    backNeighbor = node->neighbors[MC_SURFACE_NODE_BACK];
+    frontNeighbor = neighbors[i * 6 + MC_SURFACE_NODE_FRONT];
+    leftNeighbor = neighbors[i * 6 + MC_SURFACE_NODE_LEFT];
+    topNeighbor = neighbors[i * 6 + MC_SURFACE_NODE_TOP];
+    bottomNeighbor = neighbors[i * 6 + MC_SURFACE_NODE_BOTTOM];
+    rightNeighbor = neighbors[i * 6 + MC_SURFACE_NODE_RIGHT];
+    backNeighbor = neighbors[i * 6 + MC_SURFACE_NODE_BACK];
     /* TODO: Maybe add an option for changing the triangulation and/or chosing
      * an optimal triangulation. */
     /* TODO: Make sure the winding order of these triangles is correct */
     /* LEFT+FRONT and BACK+RIGHT or LEFT+BACK and FRONT+RIGHT */
-    if (leftNeighbor && frontNeighbor
-        && leftNeighbor->neighbors[MC_SURFACE_NODE_FRONT])
+    if (leftNeighbor != MC_SURFACE_NET_NO_NEIGHBOR
+        && frontNeighbor != MC_SURFACE_NET_NO_NEIGHBOR
+        && neighbors[leftNeighbor * 6 + MC_SURFACE_NODE_FRONT]
+            != MC_SURFACE_NET_NO_NEIGHBOR)
     {
-      assert(leftNeighbor->neighbors[MC_SURFACE_NODE_FRONT]
-          == frontNeighbor->neighbors[MC_SURFACE_NODE_LEFT]);
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = leftNeighbor->vertexIndex;
-      triangle.indices[2] = frontNeighbor->vertexIndex;
+      assert(neighbors[leftNeighbor * 6 + MC_SURFACE_NODE_FRONT]
+          == neighbors[frontNeighbor * 6 + MC_SURFACE_NODE_LEFT]);
+      triangle.indices[0] = vertexIndices[i];
+      triangle.indices[1] = vertexIndices[leftNeighbor];
+      triangle.indices[2] = vertexIndices[frontNeighbor];
       mcMesh_addFace(mesh, &triangle);
     }
-    if (backNeighbor && rightNeighbor
-        && backNeighbor->neighbors[MC_SURFACE_NODE_RIGHT])
+    if (backNeighbor != MC_SURFACE_NET_NO_NEIGHBOR
+        && rightNeighbor != MC_SURFACE_NET_NO_NEIGHBOR
+        && neighbors[backNeighbor * 6 + MC_SURFACE_NODE_RIGHT]
+            != MC_SURFACE_NET_NO_NEIGHBOR)
     {
-      assert(backNeighbor->neighbors[MC_SURFACE_NODE_RIGHT]
-          == rightNeighbor->neighbors[MC_SURFACE_NODE_BACK]);
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = backNeighbor->vertexIndex;
-      triangle.indices[2] = rightNeighbor->vertexIndex;
+      assert(neighbors[backNeighbor * 6 + MC_SURFACE_NODE_RIGHT]
+          == neighbors[rightNeighbor * 6 + MC_SURFACE_NODE_BACK]);
+      triangle.indices[0] = vertexIndices[i];
+      triangle.indices[1] = vertexIndices[backNeighbor];
+      triangle.indices[2] = vertexIndices[rightNeighbor];
       mcMesh_addFace(mesh, &triangle);
     }
     /* FRONT+TOP and BOTTOM+BACK or FRONT+BOTTOM and TOP+BACK */
-    if (frontNeighbor && topNeighbor
-        && frontNeighbor->neighbors[MC_SURFACE_NODE_TOP])
+    if (frontNeighbor != MC_SURFACE_NET_NO_NEIGHBOR
+        && topNeighbor != MC_SURFACE_NET_NO_NEIGHBOR
+        && neighbors[frontNeighbor * 6 + MC_SURFACE_NODE_TOP]
+            != MC_SURFACE_NET_NO_NEIGHBOR)
     {
-      assert(frontNeighbor->neighbors[MC_SURFACE_NODE_TOP]
-          == topNeighbor->neighbors[MC_SURFACE_NODE_FRONT]);
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = frontNeighbor->vertexIndex;
-      triangle.indices[2] = topNeighbor->vertexIndex;
+      assert(neighbors[frontNeighbor * 6 + MC_SURFACE_NODE_TOP]
+          == neighbors[topNeighbor * 6 + MC_SURFACE_NODE_FRONT]);
+      triangle.indices[0] = vertexIndices[i];
+      triangle.indices[1] = vertexIndices[frontNeighbor];
+      triangle.indices[2] = vertexIndices[topNeighbor];
       mcMesh_addFace(mesh, &triangle);
     }
-    if (bottomNeighbor && backNeighbor
-        && bottomNeighbor->neighbors[MC_SURFACE_NODE_BACK])
+    if (bottomNeighbor != MC_SURFACE_NET_NO_NEIGHBOR
+        && backNeighbor != MC_SURFACE_NET_NO_NEIGHBOR
+        && neighbors[bottomNeighbor * 6 + MC_SURFACE_NODE_BACK]
+            != MC_SURFACE_NET_NO_NEIGHBOR)
     {
-      assert(bottomNeighbor->neighbors[MC_SURFACE_NODE_BACK]
-          == backNeighbor->neighbors[MC_SURFACE_NODE_BOTTOM]);
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = bottomNeighbor->vertexIndex;
-      triangle.indices[2] = backNeighbor->vertexIndex;
+      assert(neighbors[bottomNeighbor * 6 + MC_SURFACE_NODE_BACK]
+          == neighbors[backNeighbor * 6 + MC_SURFACE_NODE_BOTTOM]);
+      triangle.indices[0] = vertexIndices[i];
+      triangle.indices[1] = vertexIndices[bottomNeighbor];
+      triangle.indices[2] = vertexIndices[backNeighbor];
       mcMesh_addFace(mesh, &triangle);
     }
     /* LEFT+TOP and BOTTOM+RIGHT or LEFT+BOTTOM and TOP+RIGHT */
-    if (leftNeighbor && topNeighbor
-        && leftNeighbor->neighbors[MC_SURFACE_NODE_TOP])
+    if (leftNeighbor != MC_SURFACE_NET_NO_NEIGHBOR
+        && topNeighbor != MC_SURFACE_NET_NO_NEIGHBOR
+        && neighbors[leftNeighbor * 6 + MC_SURFACE_NODE_TOP]
+            != MC_SURFACE_NET_NO_NEIGHBOR)
     {
-      assert(leftNeighbor->neighbors[MC_SURFACE_NODE_TOP]
-          == topNeighbor->neighbors[MC_SURFACE_NODE_LEFT]);
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = leftNeighbor->vertexIndex;
-      triangle.indices[2] = topNeighbor->vertexIndex;
+      assert(neighbors[leftNeighbor * 6 + MC_SURFACE_NODE_TOP]
+          == neighbors[topNeighbor * 6 + MC_SURFACE_NODE_LEFT]);
+      triangle.indices[0] = vertexIndices[i];
+      triangle.indices[1] = vertexIndices[leftNeighbor];
+      triangle.indices[2] = vertexIndices[topNeighbor];
       mcMesh_addFace(mesh, &triangle);
     }
-    if (bottomNeighbor && rightNeighbor
-        && bottomNeighbor->neighbors[MC_SURFACE_NODE_RIGHT])
+    if (bottomNeighbor != MC_SURFACE_NET_NO_NEIGHBOR
+        && rightNeighbor != MC_SURFACE_NET_NO_NEIGHBOR
+        && neighbors[bottomNeighbor * 6 + MC_SURFACE_NODE_RIGHT]
+            != MC_SURFACE_NET_NO_NEIGHBOR)
     {
-      assert(bottomNeighbor->neighbors[MC_SURFACE_NODE_RIGHT]
-          == rightNeighbor->neighbors[MC_SURFACE_NODE_BOTTOM]);
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = bottomNeighbor->vertexIndex;
-      triangle.indices[2] = rightNeighbor->vertexIndex;
+      assert(neighbors[bottomNeighbor * 6 + MC_SURFACE_NODE_RIGHT]
+          == neighbors[rightNeighbor * 6 + MC_SURFACE_NODE_BOTTOM]);
+      triangle.indices[0] = vertexIndices[i];
+      triangle.indices[1] = vertexIndices[bottomNeighbor];
+      triangle.indices[2] = vertexIndices[rightNeighbor];
       mcMesh_addFace(mesh, &triangle);
     }
   }
   mcFace_destroy(&triangle);
+  mcSurfaceNet_destroy(&surfaceNet);
 }
@@ -23,16 +23,71 @@
 
 #include <assert.h>
 #include <math.h>
-#include <stdio.h>
+#include <stdlib.h>
 
 #include <mc/algorithms/common/square.h>
 #include <mc/algorithms/marchingSquares/common.h>
+#include <mc/scalarField.h>
 
 #include <mc/algorithms/marchingSquares/marchingSquares.h>
 
 #include "marching_squares_tables.c"
 #include "marching_squares_line_tables.c"
 
+void mcMarchingSquares_sampleRow(
+    const mcScalarFieldDescriptor *field,
+    unsigned int x_res, int y,
+    const mcVec2 *min, float delta_x, float delta_y,
+    float *row)
+{
+  /* The contour lies in the plane z = 0 */
+  const unsigned int start[3] = { 0, y, 0 };
+  const unsigned int res[3] = { x_res, 1, 1 };
+  mcVec3 origin, delta;
+  origin.x = min->x;
+  origin.y = min->y;
+  origin.z = 0.0f;
+  delta.x = delta_x;
+  delta.y = delta_y;
+  delta.z = 0.0f;
+  /* Rows do not share any columns along the z-axis, so there is nothing to
+   * keep between rows */
+  void *scratch = NULL;
+  mcScalarFieldDescriptor_sampleLattice(field, &origin, &delta,
+      start, res, &scratch, row);
+  free(scratch);
+}
+
+int mcMarchingSquares_edgeVertex(
+    int edge, int x, int y,
+    const float *samples,
+    float delta_x, float delta_y,
+    mcContour *contour)
+{
+  /* Determine the sample indices on this edge */
+  int sampleIndices[2];
+  mcSquare_edgeSampleIndices(edge, sampleIndices);
+  /* Compute the lattice positions on this edge */
+  mcVec3 latticePos[2];
+  for (int i = 0; i < 2; ++i) {
+    int rel[2];
+    mcSquare_sampleRelativePosition(sampleIndices[i], rel);
+    latticePos[i].x = (float)(x + rel[0]) * delta_x;
+    latticePos[i].y = (float)(y + rel[1]) * delta_y;
+    latticePos[i].z = 0.0f;
+  }
+  /* Interpolate between the sample values at each vertex */
+  float a = samples[sampleIndices[0]], b = samples[sampleIndices[1]];
+  float weight = fabs(a / (a - b));
+  /* The corresponding edge vertex must lie on the edge between the
+   * lattice points, so we interpolate between these points. */
+  mcVertex vertex;
+  vertex.pos = mcVec3_lerp(&latticePos[0], &latticePos[1], weight);
+  /* TODO: Compute the curve normal */
+  /* Add this vertex to the contour */
+  return mcContour_addVertex(contour, &vertex);
+}
+
 void mcMarchingSquares_contourFromField(
     mcScalarFieldWithArgs sf, const void *args,
     unsigned int x_res, unsigned int y_res,
@@ -41,68 +96,57 @@ void mcMarchingSquares_contourFromField(
 {
   float delta_x = fabs(max->x - min->x) / (float)(x_res - 1);
   float delta_y = fabs(max->y - min->y) / (float)(y_res - 1);
-  /* TODO: Make a cache of sample values */
+  /* We keep two rows of samples so that each sample is only evaluated once.
+   * The vertex on edge 2 of each square in the previous line is kept in the
+   * line buffer, since it is the vertex on edge 0 of the square above it.
+   * Likewise, the vertex on edge 1 of the previous square is the vertex on
+   * edge 3 of the current square. Sharing these vertices is what allows the
+   * contour segments to be chained into polylines. */
+  float *rows = (float*)malloc(sizeof(float) * x_res * 2);
+  int *lineVertices = (int*)malloc(sizeof(int) * x_res);
+  float *prevRow = &rows[0], *row = &rows[x_res];
+  mcScalarFieldDescriptor field;
+  mcScalarFieldDescriptor_initFromField(&field, sf, args);
+  mcMarchingSquares_sampleRow(&field, x_res, 0, min, delta_x, delta_y,
+      prevRow);
   /* Loop over the sample lattice */
   for (int y = 0; y < y_res - 1; ++y) {
+    mcMarchingSquares_sampleRow(&field, x_res, y + 1, min, delta_x, delta_y,
+        row);
+    int voxelVertex = -1;
     for (int x = 0; x < x_res - 1; ++x) {
       /* Determine the configuration of this square */
+      float samples[4];
+      samples[0] = prevRow[x];
+      samples[1] = prevRow[x + 1];
+      samples[2] = row[x];
+      samples[3] = row[x + 1];
       int square = 0;
       for (int sampleIndex = 0; sampleIndex < 4; ++sampleIndex) {
-        int pos[2];
-        mcSquare_sampleRelativePosition(sampleIndex, pos);
-        /* TODO: Retrieve the sample value from a buffer */
-        float sample = sf(min->x + (float)(x + pos[0]) * delta_x,
-                          min->y + (float)(y + pos[1]) * delta_y,
-                          0.0f,
-                          args);
-        square |= (sample >= 0.0f ? 0 : 1) << sampleIndex;
+        square |= (samples[sampleIndex] >= 0.0f ? 0 : 1) << sampleIndex;
       }
-      fprintf(stderr, "square: 0x%01x\n", square);
-      /* Generate vertices for this square configuration */
-      mcMarchingSquares_EdgeIntersectionList *intersectionList =
-        &mcMarchingSquares_edgeIntersectionTable[square];
-      int intersectionIndex = 0;
+      /* Generate vertices for this square configuration, reusing the
+       * vertices of neighboring squares where possible */
       int vertexIndices[4];
       for (int edge = 0; edge < 4; ++edge) {
+        int sampleIndices[2];
+        mcSquare_edgeSampleIndices(edge, sampleIndices);
         vertexIndices[edge] = -1;
-        int edgeIntersection = intersectionList->edges[intersectionIndex];
-        if (edge == edgeIntersection) {
-          /* TODO: Look for the vertex index of this edge in our buffers */
-          /* Determine the sample indices on this edge */
-          int sampleIndices[2];
-          mcSquare_edgeSampleIndices(edge, sampleIndices);
-          /* Compute the lattice positions and samples on this edge */
-          mcVec3 latticePos[2];
-          float values[2];
-          for (int i = 0; i < 2; ++i) {
-            int rel[2], abs[2];
-            mcSquare_sampleRelativePosition(sampleIndices[i], rel);
-            abs[0] = x + rel[0];
-            abs[1] = y + rel[1];
-            latticePos[i].x = (float)(abs[0]) * delta_x;
-            latticePos[i].y = (float)(abs[1]) * delta_y;
-            latticePos[i].z = 0.0f;
-            /* TODO: Retrieve this sample value from a buffer */
-            values[i] = sf(
-                min->x + latticePos[i].x,
-                min->y + latticePos[i].y,
-                0.0f,
-                args);
-          }
-          /* Interpolate between the sample values at each vertex */
-          float weight = fabs(values[0] / (values[0] - values[1]));
-          /* The corresponding edge vertex must lie on the edge between the
-           * lattice points, so we interpolate between these points. */
-          mcVertex vertex;
-          vertex.pos = mcVec3_lerp(&latticePos[0], &latticePos[1], weight);
-          /* TODO: Compute the curve normal */
-          /* Add this vertex to the contour */
-          vertexIndices[edge] = mcContour_addVertex(contour, &vertex);
-          fprintf(stderr, "added contour vertex: %d\n",
-              vertexIndices[edge]);
-          intersectionIndex += 1;
+        if (mcSquare_sampleValue(square, sampleIndices[0])
+            == mcSquare_sampleValue(square, sampleIndices[1]))
+          continue;  /* No intersection on this edge */
+        if (edge == 0 && y > 0) {
+          vertexIndices[edge] = lineVertices[x];
+        } else if (edge == 3 && x > 0) {
+          vertexIndices[edge] = voxelVertex;
+        } else {
+          vertexIndices[edge] = mcMarchingSquares_edgeVertex(
+              edge, x, y, samples, delta_x, delta_y, contour);
         }
+        assert(vertexIndices[edge] != -1);
       }
+      lineVertices[x] = vertexIndices[2];
+      voxelVertex = vertexIndices[1];
       /* Look in the line table for the lines corresponding to this
        * square configuration */
       for (int i = 0; i < MC_MARCHING_SQUARES_MAX_NUM_LINES; ++i) {
@@ -117,5 +161,11 @@ void mcMarchingSquares_contourFromField(
         mcContour_addLine(contour, &line);
       }
     }
+    /* Swap the sample rows */
+    float *temp = prevRow;
+    prevRow = row;
+    row = temp;
   }
+  free(lineVertices);
+  free(rows);
 }
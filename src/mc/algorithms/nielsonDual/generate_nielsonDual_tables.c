@@ -29,374 +29,164 @@
 #include <mc/algorithms/common/cube.h>
 #include <mc/algorithms/nielsonDual/common.h>
 
-#include "../common/canonical_cube_orientations.h"
-
-#define get_byte(num, byte) (((num) & (0xff << (8 * byte))) >> (8 * byte))
+/**
+ * Computes the fan normal of the surface patch whose edge intersections are
+ * given in cyclic order, assuming that all edge intersections occur at the
+ * midpoint of each respective edge.
+ */
+mcVec3 patchNormal(const int *edges, int numEdges) {
+  mcVec3 points[MC_CUBE_NUM_EDGES], normal;
+  for (int i = 0; i < numEdges; ++i) {
+    unsigned int sampleIndices[2];
+    mcVec3 vertices[2];
+    mcCube_edgeSampleIndices(edges[i], sampleIndices);
+    for (int j = 0; j < 2; ++j) {
+      unsigned int pos[3];
+      mcCube_sampleRelativePosition(sampleIndices[j], pos);
+      vertices[j].x = pos[0] ? 1.0f : 0.0f;
+      vertices[j].y = pos[1] ? 1.0f : 0.0f;
+      vertices[j].z = pos[2] ? 1.0f : 0.0f;
+    }
+    points[i] = mcVec3_lerp(&vertices[0], &vertices[1], 0.5f);
+  }
+  normal.x = normal.y = normal.z = 0.0f;
+  for (int i = 1; i + 1 < numEdges; ++i) {
+    mcVec3 tangent[2], triangleNormal;
+    mcVec3_subtract(&points[i], &points[0], &tangent[0]);
+    mcVec3_subtract(&points[i + 1], &points[0], &tangent[1]);
+    mcVec3_cross(&tangent[1], &tangent[0], &triangleNormal);
+    mcVec3_add(&normal, &triangleNormal, &normal);
+  }
+  return normal;
+}
 
 void computeVertexList(int cube, mcNielsonDualVertexList *list) {
+  /* For each edge, the two edges it is connected to by a segment of the
+   * isosurface on either of the cube faces adjacent to that edge, and the
+   * faces those segments lie on */
+  int links[MC_CUBE_NUM_EDGES][2], linkFaces[MC_CUBE_NUM_EDGES][2];
+  int numLinks[MC_CUBE_NUM_EDGES];
+  int visited[MC_CUBE_NUM_EDGES];
   int vertexIndex;
 
   /* Initialize the list with all values -1 */
   memset(list, -1, sizeof(mcNielsonDualVertexList));
 
-  /* Determine this cube's canonical orientation and the rotation sequence that
-   * brings it into that orientation */
-  unsigned int canonical = mcCube_canonicalOrientation(cube);
-  unsigned int sequence = mcCube_canonicalRotationSequence(cube);
-
-  /* Generate the list of vertices for the given cube configuration */
-  vertexIndex = 0;
-#define vertex_3_edgeIntersections(a, b, c) \
-  do { \
-    int *ei = list->vertices[vertexIndex].edgeIntersections; \
-    ei[0] = a; \
-    ei[1] = b; \
-    ei[2] = c; \
-    for (int i = 3; i < MC_CUBE_NUM_EDGES; ++i) \
-      ei[i] = -1; \
-  } while(0)
-#define vertex_4_edgeIntersections(a, b, c, d) \
-  do { \
-    int *ei = list->vertices[vertexIndex].edgeIntersections; \
-    ei[0] = a; \
-    ei[1] = b; \
-    ei[2] = c; \
-    ei[3] = d; \
-    for (int i = 4; i < MC_CUBE_NUM_EDGES; ++i) \
-      ei[i] = -1; \
-  } while(0)
-#define vertex_5_edgeIntersections(a, b, c, d, e) \
-  do { \
-    int *ei = list->vertices[vertexIndex].edgeIntersections; \
-    ei[0] = a; \
-    ei[1] = b; \
-    ei[2] = c; \
-    ei[3] = d; \
-    ei[4] = e; \
-    for (int i = 5; i < MC_CUBE_NUM_EDGES; ++i) \
-      ei[i] = -1; \
-  } while(0)
-#define vertex_6_edgeIntersections(a, b, c, d, e, f) \
-  do { \
-    int *ei = list->vertices[vertexIndex].edgeIntersections; \
-    ei[0] = a; \
-    ei[1] = b; \
-    ei[2] = c; \
-    ei[3] = d; \
-    ei[4] = e; \
-    ei[5] = f; \
-    for (int i = 6; i < MC_CUBE_NUM_EDGES; ++i) \
-      ei[i] = -1; \
-  } while(0)
-#define vertex_3_connectivity(a, b, c) \
-  do { \
-    int *conn = list->vertices[vertexIndex].connectivity; \
-    conn[0] = a; \
-    conn[1] = b; \
-    conn[2] = c; \
-    for (int i = 3; i < MC_CUBE_NUM_FACES; ++i) \
-      conn[i] = -1; \
-  } while(0)
-#define vertex_4_connectivity(a, b, c, d) \
-  do { \
-    int *conn = list->vertices[vertexIndex].connectivity; \
-    conn[0] = a; \
-    conn[1] = b; \
-    conn[2] = c; \
-    conn[3] = d; \
-    for (int i = 4; i < MC_CUBE_NUM_FACES; ++i) \
-      conn[i] = -1; \
-  } while(0)
-#define vertex_5_connectivity(a, b, c, d, e) \
-  do { \
-    int *conn = list->vertices[vertexIndex].connectivity; \
-    conn[0] = a; \
-    conn[1] = b; \
-    conn[2] = c; \
-    conn[3] = d; \
-    conn[4] = e; \
-    for (int i = 5; i < MC_CUBE_NUM_FACES; ++i) \
-      conn[i] = -1; \
-  } while(0)
-#define vertex_6_connectivity(a, b, c, d, e, f) \
-  do { \
-    int *conn = list->vertices[vertexIndex].connectivity; \
-    conn[0] = a; \
-    conn[1] = b; \
-    conn[2] = c; \
-    conn[3] = d; \
-    conn[4] = e; \
-    conn[5] = f; \
-    for (int i = 6; i < MC_CUBE_NUM_FACES; ++i) \
-      conn[i] = -1; \
-  } while(0)
-  switch (canonical) {
-    case MC_CUBE_CANONICAL_ORIENTATION_0:
-      /* This is the case where all samples are above the isosurface. Not very
-       * interesting. */
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_1:
-      /* This is a simple case with only one sample below the isosurface. This
-       * generates a single vertex which is connected to the three faces at
-       * that corner. */
-      vertex_3_edgeIntersections(0, 8, 3);
-      vertex_3_connectivity(0, 3, 4);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_2:
-      /* This is the case where two samples on the same voxel edge are below
-       * the isosurface. This generates a single vertex which is connected to
-       * the four faces near that edge. */
-      vertex_4_edgeIntersections(1, 9, 8, 3);
-      vertex_4_connectivity(0, 1, 3, 4);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_3:
-      /* This case has two sample points on the same face that are below the
-       * isosurface. These samples are diagonal from each other, so this is an
-       * ambiguous face. */
-      vertex_3_edgeIntersections(0, 8, 3);
-      vertex_3_connectivity(0, 3, 4);
-      ++vertexIndex;
-      vertex_3_edgeIntersections(1, 2, 11);
-      vertex_3_connectivity(0, 1, 2);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_4:
-      /* This case has three sample points below the surface that form an "L"
-       * shape on one face. This generates a single vertex that connects with
-       * that face as well as the four adjacent faces. */
-      vertex_5_edgeIntersections(2, 11, 9, 8, 3);
-      vertex_5_connectivity(0, 1, 2, 3, 4);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_5:
-      /* This case has four samples on the front face below the isosurface and
-       * four samples on the back face above the isosurface. This generates a
-       * single vertex that connects with the four faces adjacent to the front
-       * face. */
-    vertex_4_edgeIntersections(8, 10, 11, 9);
-    vertex_4_connectivity(1, 2, 3, 4);
-    ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_6:
-      /* This case has two samples below the isosurface on opposite corners of
-       * the cube. This generates two separate vertices near these samples
-       * which collectively connect to all cube faces. */
-      vertex_3_edgeIntersections(1, 2, 11);
-      vertex_3_connectivity(0, 1, 2);
-      ++vertexIndex;
-      vertex_3_edgeIntersections(4, 7, 8);
-      vertex_3_connectivity(3, 4, 5);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_7:
-      /* This case has two samples below the isosurface that share an edge and
-       * a third sample in a corner diagonal to this edge on the front face,
-       * creating an ambiguous face. This generates two vertices, one of which
-       * is connected to the faces near that edge, and the other connected to
-       * the faces on that corner. */
-      vertex_4_edgeIntersections(0, 4, 7, 3);
-      vertex_4_connectivity(0, 3, 4, 5);
-      ++vertexIndex;
-      vertex_3_edgeIntersections(1, 2, 11);
-      vertex_3_connectivity(0, 1, 2);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_8:
-      /* This case has four samples below the isosurface that form a serpentine
-       * "Z" shape when following the voxel cube edges viewed from the outside
-       * of the isosurface. This generates a single vertex that connects
-       * through all voxel cube faces. */
-      vertex_6_edgeIntersections(2, 11, 9, 4, 7, 3);
-      vertex_6_connectivity(0, 1, 2, 3, 4, 5);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_9:
-      /* This case has the three samples surrounding vertex zero below the
-       * isosurface. This generates three separate vertices in the corners with
-       * those samples that are each connected to the three faces in their
-       * respective corner. */
-      vertex_3_edgeIntersections(0, 1, 9);
-      vertex_3_connectivity(0, 1, 3);
-      ++vertexIndex;
-      vertex_3_edgeIntersections(2, 3, 10);
-      vertex_3_connectivity(0, 2, 4);
-      ++vertexIndex;
-      vertex_3_edgeIntersections(4, 7, 8);
-      vertex_3_connectivity(3, 4, 5);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_10:
-      /* This case has the four samples nearest vertex zero below the
-       * isosurface. This makes a hexagon shape where it intsersects the voxel
-       * cube. This generates a single vertex that connects through all voxel
-       * faces. */
-      vertex_6_edgeIntersections(1, 9, 4, 7, 10, 2);
-      vertex_6_connectivity(0, 1, 2, 3, 4, 5);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_11:
-      /* This case has four samples below the isosurface that form a serpentine
-       * "S" shape when following the voxel cube edges viewed from the outside
-       * of the isosurface. This generates a single vertex that connects
-       * through all voxel cube faces. */
-      vertex_6_edgeIntersections(0, 4, 7, 10, 11, 1);
-      vertex_6_connectivity(0, 1, 2, 3, 4, 5);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_12:
-      /* This case has three samples below the isosurface that form an L shape
-       * on one face, and a fourth sample in the corner apart from the other
-       * three. This generates two vertices. */
-      vertex_5_edgeIntersections(0, 3, 10, 11, 9);
-      vertex_5_connectivity(0, 1, 2, 3, 4);
-      ++vertexIndex;
-      vertex_3_edgeIntersections(4, 7, 8);
-      vertex_3_connectivity(3, 4, 5);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_13:
-      /* This case has all four samples on the front face below the isosurface,
-       * as well as a fifth sample on the back face that is below the
-       * isosurface. The vertices above the isosurface form an "L" shape on one
-       * face. One vertex is generated which connects to the faces near the
-       * face with the vertices above the isosurface. This is analogous to
-       * MC_CUBE_CANONICAL_ORIENTATION_4. */
-      vertex_5_edgeIntersections(4, 7, 10, 11, 9);
-      vertex_5_connectivity(1, 2, 3, 4, 5);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_14:
-      /* This case has two samples on the same voxel edge below the isosurface,
-       * and an additional two samples below the isosurface on the edge
-       * diagonal to the first edge. This generates two vertices. These
-       * vertices connect with the fourfaces nearest their respective edges. */
-      vertex_4_edgeIntersections(1, 3, 10, 11);
-      vertex_4_connectivity(0, 1, 2, 4);
-      ++vertexIndex;
-      vertex_4_edgeIntersections(5, 7, 8, 9);
-      vertex_4_connectivity(1, 3, 4, 5);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_15:
-      /* This case has two samples along the same voxel edge above the
-       * isosurface, and a third sample in a corner diagonal to the first two
-       * also above the isosurface. This generates two vertices, the first is
-       * connected to the faces near that edge, and the second is connected to
-       * the faces near that corner. */
-      vertex_4_edgeIntersections(5, 7, 10, 11);
-      vertex_4_connectivity(1, 2, 4, 5);
-      ++vertexIndex;
-      vertex_3_edgeIntersections(0, 9, 1);
-      vertex_3_connectivity(0, 1, 3);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_16:
-      /* This case has two samples on the same edge which are above the
-       * isosurface. This generates a single vertex which is connected to the
-       * faces around that edge. */
-      vertex_4_edgeIntersections(5, 7, 10, 11);
-      vertex_4_connectivity(1, 2, 4, 5);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_17:
-      /* This case has four samples on separate voxel cube corners below the
-       * isosurface. This generates four separate vertices, each connecting to
-       * the three faces adjacent to their respective sample point. */
-      vertex_3_edgeIntersections(0, 1, 9);
-      vertex_3_connectivity(0, 1, 3);
-      ++vertexIndex;
-      vertex_3_edgeIntersections(2, 3, 10);
-      vertex_3_connectivity(0, 2, 4);
-      ++vertexIndex;
-      vertex_3_edgeIntersections(4, 7, 8);
-      vertex_3_connectivity(3, 4, 5);
-      ++vertexIndex;
-      vertex_3_edgeIntersections(5, 11, 6);
-      vertex_3_connectivity(1, 2, 5);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_18:
-      /* This case has three samples above the isosurface in separate corners
-       * of the voxel cube. This generates three vertices which connect to the
-       * faces in their respective corners. */
-      vertex_3_edgeIntersections(1, 11, 2);
-      vertex_3_connectivity(0, 1, 2);
-      ++vertexIndex;
-      vertex_3_edgeIntersections(4, 5, 9);
-      vertex_3_connectivity(1, 3, 5);
-      ++vertexIndex;
-      vertex_3_edgeIntersections(6, 7, 10);
-      vertex_3_connectivity(2, 4, 5);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_19:
-      /* This case has two sample points on the same face diagonal from each
-       * other above the isosurface. This generates two vertices which connect
-       * through the faces in their respective corners. */
-      vertex_3_edgeIntersections(4, 5, 9);
-      vertex_3_connectivity(1, 3, 5);
-      ++vertexIndex;
-      vertex_3_edgeIntersections(6, 7, 10);
-      vertex_3_connectivity(2, 4, 5);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_20:
-      /* This case has two sample points above the isosurface which are not on
-       * the same face. This generates two vertices which connect through the
-       * voxel faces in their respective corners. */
-      vertex_3_edgeIntersections(0, 9, 1);
-      vertex_3_connectivity(0, 1, 3);
-      ++vertexIndex;
-      vertex_3_edgeIntersections(6, 7, 10);
-      vertex_3_connectivity(2, 4, 5);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_21:
-      /* This case has a single sample point above the isosurface. This
-       * generates a single vertex which connects through the faces adjacent to
-       * that sample point. */
-      vertex_3_edgeIntersections(6, 7, 10);
-      vertex_3_connectivity(2, 4, 5);
-      ++vertexIndex;
-      break;
-    case MC_CUBE_CANONICAL_ORIENTATION_22:
-      /* This is the case where all samples are below the isosurface. Not very
-       * interesting. */
-      break;
+  /* NOTE: The vertex lists used to be written out by hand for each canonical
+   * orientation and rotated into place, but the hand-written edge numbers did
+   * not agree with mc/algorithms/common/cube.h for many configurations. We
+   * now derive each vertex directly from the sample values of the cube, so
+   * every intersected edge belongs to exactly one vertex by construction. */
+  for (int edge = 0; edge < MC_CUBE_NUM_EDGES; ++edge) {
+    numLinks[edge] = 0;
+    visited[edge] = 0;
   }
-
-  /* Rotate the edge intersections and face connectivities into their true
-   * positions */
-  for (int i = 0; i < MC_NIELSON_DUAL_MAX_VERTICES; ++i) {
-    mcNielsonDualVertex *vertex;
-    vertex = &list->vertices[i];
-    if (vertex->edgeIntersections[0] == -1)
-      break;  /* No more vertices to consider */
-    /* Rotate the edge intersections back */
-    for (int j = 0; j < MC_CUBE_NUM_EDGES; ++j) {
-      if (vertex->edgeIntersections[j] == -1)
-        break;  /* No more edge intersections to consider */
-      /* Rotate the edge intersection about the y-axis */
-      for (int k = 0; k < get_byte(sequence, 2); ++k) {
-        vertex->edgeIntersections[j] =
-          mcCube_rotateEdgeReverseY(vertex->edgeIntersections[j]);
+  /* Walk each cube face and connect the edge intersections on that face with
+   * segments of the isosurface */
+  for (int face = 0; face < MC_CUBE_NUM_FACES; ++face) {
+    unsigned int samples[4];
+    int values[4], edges[4], intersected[4];
+    int numIntersected = 0;
+    mcCube_faceSampleIndices(face, samples);
+    for (int i = 0; i < 4; ++i)
+      values[i] = mcCube_sampleValue(samples[i], cube);
+    /* Face edge i lies between face samples i and i + 1 */
+    for (int i = 0; i < 4; ++i) {
+      edges[i] = mcCube_sampleIndicesToEdge(samples[i], samples[(i + 1) % 4]);
+      assert(edges[i] != -1);
+      if (values[i] != values[(i + 1) % 4])
+        intersected[numIntersected++] = edges[i];
+    }
+    int pairs[2][2], numPairs = 0;
+    if (numIntersected == 2) {
+      pairs[numPairs][0] = intersected[0];
+      pairs[numPairs][1] = intersected[1];
+      ++numPairs;
+    } else if (numIntersected == 4) {
+      /* This is an ambiguous face. We separate the two samples above the
+       * isosurface from each other by connecting the two edges around each
+       * of them. Since the choice only depends on the samples on this face,
+       * both voxel cubes sharing the face agree and the mesh stays closed. */
+      for (int i = 0; i < 4; ++i) {
+        if (values[i] == 0)
+          continue;
+        pairs[numPairs][0] = edges[(i + 3) % 4];
+        pairs[numPairs][1] = edges[i];
+        ++numPairs;
       }
-      /* Rotate the edge intersection about the x-axis */
-      for (int k = 0; k < get_byte(sequence, 1); ++k) {
-        vertex->edgeIntersections[j] =
-          mcCube_rotateEdgeReverseX(vertex->edgeIntersections[j]);
+    }
+    for (int i = 0; i < numPairs; ++i) {
+      int a = pairs[i][0], b = pairs[i][1];
+      assert(numLinks[a] < 2 && numLinks[b] < 2);
+      linkFaces[a][numLinks[a]] = face;
+      links[a][numLinks[a]++] = b;
+      linkFaces[b][numLinks[b]] = face;
+      links[b][numLinks[b]++] = a;
+    }
+  }
+
+  /* Each closed loop of segments is the boundary of a surface patch, and
+   * generates a single vertex */
+  vertexIndex = 0;
+  for (int edge = 0; edge < MC_CUBE_NUM_EDGES; ++edge) {
+    int edges[MC_CUBE_NUM_EDGES], faces[MC_CUBE_NUM_FACES];
+    int numEdges, numFaces, current, previous;
+    if (visited[edge] || numLinks[edge] == 0)
+      continue;
+    /* Every intersected edge lies on two faces, and so on two segments */
+    assert(numLinks[edge] == 2);
+    assert(vertexIndex < MC_NIELSON_DUAL_MAX_VERTICES);
+    numEdges = numFaces = 0;
+    previous = -1;
+    current = edge;
+    while (!visited[current]) {
+      int next = links[current][0] != previous ? 0 : 1;
+      int face = linkFaces[current][next];
+      int seen = 0;
+      visited[current] = 1;
+      edges[numEdges++] = current;
+      for (int i = 0; i < numFaces; ++i) {
+        if (faces[i] == face)
+          seen = 1;
       }
-      /* Rotate the edge intersection about the z-axis */
-      for (int k = 0; k < get_byte(sequence, 0); ++k) {
-        vertex->edgeIntersections[j] =
-          mcCube_rotateEdgeReverseZ(vertex->edgeIntersections[j]);
+      if (!seen)
+        faces[numFaces++] = face;
+      previous = current;
+      current = links[current][next];
+    }
+    assert(current == edge);
+    /* Wind the edge intersections so that the normal of the patch points
+     * towards the samples above the isosurface, which is the direction of
+     * the gradient used for vertex normals at runtime */
+    mcVec3 normal = patchNormal(edges, numEdges);
+    mcVec3 direction;
+    direction.x = direction.y = direction.z = 0.0f;
+    for (int i = 0; i < numEdges; ++i) {
+      unsigned int sampleIndices[2], pos[2][3];
+      float sign;
+      mcCube_edgeSampleIndices(edges[i], sampleIndices);
+      mcCube_sampleRelativePosition(sampleIndices[0], pos[0]);
+      mcCube_sampleRelativePosition(sampleIndices[1], pos[1]);
+      sign = mcCube_sampleValue(sampleIndices[1], cube) ? 1.0f : -1.0f;
+      direction.x += sign * ((float)pos[1][0] - (float)pos[0][0]);
+      direction.y += sign * ((float)pos[1][1] - (float)pos[0][1]);
+      direction.z += sign * ((float)pos[1][2] - (float)pos[0][2]);
+    }
+    if (mcVec3_dot(&normal, &direction) < 0.0f) {
+      for (int i = 1, j = numEdges - 1; i < j; ++i, --j) {
+        int temp = edges[i];
+        edges[i] = edges[j];
+        edges[j] = temp;
       }
     }
-    /* TODO: Rotate the face connections back */
-    /* NOTE: We might not need the face connectivity. I have not found a use
-     * for it yet. */
+    /* Store the vertex */
+    int *ei = list->vertices[vertexIndex].edgeIntersections;
+    int *conn = list->vertices[vertexIndex].connectivity;
+    for (int i = 0; i < numEdges; ++i)
+      ei[i] = edges[i];
+    for (int i = 0; i < numFaces; ++i)
+      conn[i] = faces[i];
+    ++vertexIndex;
   }
 }
 
@@ -28,6 +28,7 @@
 #include <string.h>
 
 #include <mc/algorithms/common/cube.h>
+#include <mc/algorithms/common/sampleSlices.h>
 
 #include <mc/algorithms/nielsonDual/common.h>
 #include <mc/algorithms/nielsonDual/nielsonDual.h>
@@ -40,6 +41,50 @@
  * the quad patch generated and move on.
  */
 
+/**
+ * Estimates the surface normal at a vertex within the voxel cube at the given
+ * lattice coordinates by trilinear interpolation of the gradients at the cube
+ * samples. Phantom samples beyond the lattice use the gradient of the nearest
+ * lattice sample. The gradients come from the sample buffer, so no additional
+ * scalar field evaluations are made.
+ *
+ * Returns zero if the interpolated gradient vanishes, in which case the
+ * normal is left untouched.
+ */
+int mcNielsonDual_vertexNormal(const mcSampleSlices *slices,
+    int x, int y, const mcVec3 *pos, mcVec3 *normal)
+{
+  mcVec3 sum;
+  sum.x = sum.y = sum.z = 0.0f;
+  for (unsigned int sampleIndex = 0; sampleIndex < 8; ++sampleIndex) {
+    unsigned int rel[3];
+    int abs[3];
+    mcVec3 gradient;
+    float weight;
+    mcCube_sampleRelativePosition(sampleIndex, rel);
+    weight = (rel[0] ? pos->x : 1.0f - pos->x)
+      * (rel[1] ? pos->y : 1.0f - pos->y)
+      * (rel[2] ? pos->z : 1.0f - pos->z);
+    if (weight == 0.0f)
+      continue;
+    /* Clamp phantom samples to the edge of the lattice */
+    abs[0] = x + rel[0];
+    abs[1] = y + rel[1];
+    abs[2] = slices->z + rel[2];
+    abs[0] = abs[0] < 0 ? 0 : abs[0] >= (int)slices->x_res ? slices->x_res - 1 : abs[0];
+    abs[1] = abs[1] < 0 ? 0 : abs[1] >= (int)slices->y_res ? slices->y_res - 1 : abs[1];
+    abs[2] = abs[2] < 0 ? 0 : abs[2] >= (int)slices->z_res ? slices->z_res - 1 : abs[2];
+    mcSampleSlices_gradient(slices, abs[0], abs[1], abs[2] - slices->z,
+        &gradient);
+    mcVec3_scalarProduct(weight, &gradient, &gradient);
+    mcVec3_add(&sum, &gradient, &sum);
+  }
+  if (mcVec3_length(&sum) == 0.0f)
+    return 0;
+  mcVec3_normalize(&sum, normal);
+  return 1;
+}
+
 /**
  * This routine implements the MC-Dual isosurface extraction algorithm as
  * described by Nielson in "Dual Marching Cubes." This does not implement the
@@ -51,12 +96,16 @@ void mcNielsonDual_isosurfaceFromField(
     const mcVec3 *min, const mcVec3 *max,
     mcMesh *mesh)
 {
-  mcFace triangle, quad;
-  mcFace_init(&triangle, 3);
+  mcFace quad;
   mcFace_init(&quad, 4);
-  float delta_x = fabs(max->x - min->x) / (float)(x_res - 1);
-  float delta_y = fabs(max->y - min->y) / (float)(y_res - 1);
-  float delta_z = fabs(max->z - min->z) / (float)(z_res - 1);
+  /* Samples are kept in a circular buffer of lattice slices, so that each
+   * lattice point is evaluated exactly once and the gradients needed for
+   * vertex normals are available without further evaluations. */
+  mcSampleSlices slices;
+  mcSampleSlices_init(&slices, sf, args, x_res, y_res, z_res, min, max);
+  float delta_x = slices.delta_x;
+  float delta_y = slices.delta_y;
+  float delta_z = slices.delta_z;
   /* We allocate some buffers to facilitate constructing mesh topology.
    *
    * Note that the buffers extend beyond the cube lattice structure specified
@@ -64,256 +113,216 @@ void mcNielsonDual_isosurfaceFromField(
    * above the isosurface for the edge cases to avoid the problem of
    * inaccessible buffers and nonmanifold geometry. */
   /* This struct defines the connecting vector interface between a voxel cube
-   * and the voxel cube in the next slice. */
+   * and its neighboring voxel cubes. */
   typedef struct Voxel {
     /* NOTE: We should only need to store two vertex indices here since there
-     * are only two possible vertices that interface through the top face, but
+     * are only two possible vertices that interface through any one face, but
      * we allocate space for four so that we can use the
      * mcNielsonDual_vertexIndexLookupTable to quickly find the vertex index we
      * need. */
     int vertexIndices[MC_NIELSON_DUAL_MAX_VERTICES];
     int cube;
   } Voxel;
+  /* Only two slices of voxels are needed. The voxels in the previous line and
+   * the previous voxel in the current line have already been written to the
+   * current slice by the time we need them. */
   Voxel *previousSlice = (Voxel*)malloc(
       sizeof(Voxel) * (x_res + 1) * (y_res + 1));
   Voxel *currentSlice = (Voxel*)malloc(
       sizeof(Voxel) * (x_res + 1) * (y_res + 1));
-  Voxel *previousLine = (Voxel*)malloc(sizeof(Voxel) * (x_res + 1));
-  Voxel *currentLine = (Voxel*)malloc(sizeof(Voxel) * (x_res + 1));
-  Voxel *previousVoxel  = (Voxel*)malloc(sizeof(Voxel));
-  Voxel *currentVoxel  = (Voxel*)malloc(sizeof(Voxel));
-#ifndef NDEBUG
-  /* Set canary values for our vertex indices */
-  memset(previousSlice, -1, sizeof(Voxel) * (x_res + 1) * (y_res + 1));
-  memset(previousLine, -1, sizeof(Voxel) * (x_res + 1));
-  memset(previousVoxel, -1, sizeof(Voxel));
-#endif
+#define voxel_index(x, y) (((x) + 1) + ((y) + 1) * (x_res + 1))
   /* Iterate over the cube lattice */
   for (int z = -1; z < (int)z_res; ++z) {
-#ifndef NDEBUG
-    /* Set canary values for our slice vertex indices */
-    memset(currentSlice, -1, sizeof(Voxel) * (x_res + 1) * (y_res + 1));
-#endif
+    /* The first layer of voxel cubes only touches lattice slice 0, which the
+     * sample buffer already holds */
+    if (z >= 0)
+      mcSampleSlices_advance(&slices);
     for (int y = -1; y < (int)y_res; ++y) {
-#ifndef NDEBUG
-      /* Set canary values for our line vertex indices */
-      memset(currentLine, -1, sizeof(Voxel) * (x_res + 1));
-#endif
       for (int x = -1; x < (int)x_res; ++x) {
-#ifndef NDEBUG
-        /* Set canary values for our voxel vertex indices */
-        memset(currentVoxel, -1, sizeof(Voxel));
-#endif
+        Voxel *currentVoxel = &currentSlice[voxel_index(x, y)];
         /* Determine the cube configuration index by iterating over the eight
          * cube vertices */
         unsigned int cube = 0;
         for (unsigned int sampleIndex = 0; sampleIndex < 8; ++sampleIndex) {
           int pos[3];
           float sample;
-          /* Determine this sample's relative position in the cube and sample
-           * that point */
-          /* TODO: Cache these sample values (see
-           * src/mc/algorihms/patch/patch.c for example). */
+          /* Determine this sample's relative position in the cube and look up
+           * that sample */
           mcCube_sampleRelativePosition(sampleIndex, (unsigned int*)pos);
           if ((x + pos[0] < 0) || (y + pos[1] < 0) || (z + pos[2] < 0)
               || (x + pos[0] >= x_res) || (y + pos[1] >= y_res) || (z + pos[2] >= z_res))
           {
-            /* TODO: Fill the previous voxel buffers with cubes consistent with
-             * a lattice grid that extends beyond the minimum and maximum
-             * resolution resolutions, with samples beyond the resolutions
-             * always above the isosurface.
-             *
-             * NOTE: We would also need to fudge voxel cubes past the maximum
-             * resolution by looping to the very edge of the sample lattice.
-             * Without doing so, a lot of the samples at the edges would be
-             * ignored.
+            /* Samples beyond the lattice are phantom samples that are always
+             * above the isosurface, which closes the mesh at the edges of
+             * the lattice.
              *
              * NOTE: What if the user wants non-manifold geometry?
              */
             sample = 1.0f;
           } else {
-            sample = sf(min->x + (x + pos[0]) * delta_x,
-                min->y + (y + pos[1]) * delta_y,
-                min->z + (z + pos[2]) * delta_z,
-                args);
+            sample = mcSampleSlices_value(&slices,
+                x + pos[0], y + pos[1], pos[2]);
           }
           /* Add the bit this sample contributes to the cube */
           cube |= (sample >= 0.0f ? 1 : 0) << sampleIndex;
         }
-        /* Store this cube configuration in our buffers */
+        /* Store this cube configuration in our buffers. Vertex indices we do
+         * not generate are always reset, so that the buffers are consistent
+         * whatever cube configuration they held previously. */
         currentVoxel->cube = cube;
-        currentLine[x + 1].cube = cube;
-        currentSlice[(x + 1) + (y + 1) * (x_res + 1)].cube = cube;
-        if (cube != 0x00 && cube != 0xff) { /* Skip the trivial cases */
-          /* Look up vertices we need to generate for the given cube
-           * configuration */
-          const mcNielsonDualCookedVertexList *list =
-            &mcNielsonDual_midpointVertexTable[cube];
-          int vertexIndex;
-          for (int i = 0; i < list->numVertices; ++i) {
-            mcVertex vertex;
-            /* NOTE: The table has enough information to know the exact position
-             * of this vertex. We can add it to the mesh as is. The surface
-             * normal can be estimated at this point by interpolation of lattice
-             * gradiants, or even something simpler. */
-            /* NOTE: The positions we compute are in mesh space coordinates,
-             * not sample spac ecoordinates. The vertices of the mesh we
-             * generate must be in mesh space coordinates in which min is at
-             * the origin. */
-            /* Compute the absolute position of this vertex */
-            vertex.pos.x = ((float)x + list->vertices[i].pos.x) * delta_x;
-            vertex.pos.y = ((float)y + list->vertices[i].pos.y) * delta_y;
-            vertex.pos.z = ((float)z + list->vertices[i].pos.z) * delta_z;
-            /* The normal is also retrieved from the table */
-            /* TODO: Support computing more accurate normals from sample values */
+        for (int i = 0; i < MC_NIELSON_DUAL_MAX_VERTICES; ++i)
+          currentVoxel->vertexIndices[i] = -1;
+        if (cube == 0x00 || cube == 0xff)
+          continue;  /* Skip the trivial cases */
+        /* Look up vertices we need to generate for the given cube
+         * configuration */
+        const mcNielsonDualCookedVertexList *list =
+          &mcNielsonDual_midpointVertexTable[cube];
+        for (int i = 0; i < list->numVertices; ++i) {
+          mcVertex vertex;
+          /* NOTE: The table has enough information to know the exact position
+           * of this vertex. We can add it to the mesh as is. */
+          /* NOTE: The positions we compute are in mesh space coordinates,
+           * not sample spac ecoordinates. The vertices of the mesh we
+           * generate must be in mesh space coordinates in which min is at
+           * the origin. */
+          /* Compute the absolute position of this vertex */
+          vertex.pos.x = ((float)x + list->vertices[i].pos.x) * delta_x;
+          vertex.pos.y = ((float)y + list->vertices[i].pos.y) * delta_y;
+          vertex.pos.z = ((float)z + list->vertices[i].pos.z) * delta_z;
+          /* Estimate the surface normal from the sample gradients, falling
+           * back to the normal from the table where the gradient vanishes */
+          if (!mcNielsonDual_vertexNormal(&slices, x, y,
+                &list->vertices[i].pos, &vertex.norm))
+          {
             vertex.norm = list->vertices[i].norm;
-            /* Add this vertex to the mesh */
-            vertexIndex = mcMesh_addVertex(mesh, &vertex);
-            /* Store this vertex index in our buffers */
-            currentVoxel->vertexIndices[i] = vertexIndex;
-            currentLine[x + 1].vertexIndices[i] = vertexIndex;
-            currentSlice[(x + 1) + (y + 1) * (x_res + 1)].vertexIndices[i] = vertexIndex;
           }
-          /* TODO: Iterate over the three edges for which we have generated
-           * enough vertices to make its respective quad. */
-          for (int i = 0; i < 3; ++i) {
-            int edge, faces[2];
-            int skip = 0;
-            switch (i) {
-              case 0:
-                edge = 0;
-                faces[0] = MC_CUBE_FACE_FRONT;
-                faces[1] = MC_CUBE_FACE_BOTTOM;
-                if (y < 0 || z < 0)
-                  skip = 1;
-                break;
-              case 1:
-                edge = 3;
-                faces[0] = MC_CUBE_FACE_FRONT;
-                faces[1] = MC_CUBE_FACE_RIGHT;
-                if (x < 0 || y < 0)
-                  skip = 1;
-                break;
-              case 2:
-                edge = 8;
-                faces[0] = MC_CUBE_FACE_BOTTOM;
-                faces[1] = MC_CUBE_FACE_RIGHT;
-                if (x < 0 || z < 0)
-                  skip = 1;
-                break;
-            }
-            if (skip)
-              break;  /* Skip edge cases where we have not generated vertices in
-                         the neighboring voxel */
-            int lookupIndex, vertexIndices[4];
-            Voxel *voxel;
-            /* Get the vertex index for this edge */
-            voxel = currentVoxel;
-            lookupIndex = mcNielsonDual_vertexIndexLookupTable[
-              (edge << 8) + cube];
-            if (lookupIndex == -1) {
-              /* This edge does not have an associated vertex, so it must not
-               * intersect the isosurface. Skip this edge. */
-              /* TODO: Add an assertion here that checks the sample values? */
-              continue;
-            }
-            assert(voxel->vertexIndices[lookupIndex] != -1);
-            vertexIndices[0] = voxel->vertexIndices[lookupIndex];
-            /* Find the cubes near this edge for the two easy cases */
-            for (int j = 0; j < 2; ++j) {
-              switch (faces[j]) {
-                case MC_CUBE_FACE_FRONT:
-                  assert(y >= 0);
-                  voxel = &previousLine[(x + 1)];
-                  break;
-                case MC_CUBE_FACE_BOTTOM:
-                  assert(z >= 0);
-                  voxel = &previousSlice[(x + 1) + (y + 1) * (x_res + 1)];
-                  break;
-                case MC_CUBE_FACE_RIGHT:
-                  assert(x >= 0);
-                  voxel = previousVoxel;
-                  break;
-              }
-              /* Use the mcNielsonDual_vertexIndexLookupTable to find the vertex
-               * indices for this edge and voxel cube configuration. */
-              /* NOTE: The translated edge of the given face/edge combination is
-               * the index of the given edge with respect to the voxel cube on
-               * the other side of the given face. */
-              lookupIndex = mcNielsonDual_vertexIndexLookupTable[
-                (mcCube_translateEdge(edge, faces[j]) << 8) + voxel->cube];
-              /* Find the vertex index for this voxel. This index must exist. */
-              assert(lookupIndex != -1);
-              assert(voxel->vertexIndices[lookupIndex] != -1);
-              vertexIndices[j + 1] = voxel->vertexIndices[lookupIndex];
-            }
-            /* Find the voxel cube diagonal to this edge, which is somewhat more
-             * complicated */
-            switch (edge) {
-              case 0:
-                /* The diagonal cube is on the bottom-front */
-                assert(y >= 0);
-                assert(z >= 0);
-                voxel = &previousSlice[(x + 1) + (y + 1 - 1) * (x_res + 1)];
+          /* Add this vertex to the mesh and store its index in our buffers */
+          currentVoxel->vertexIndices[i] = mcMesh_addVertex(mesh, &vertex);
+        }
+        /* Iterate over the three edges for which we have generated enough
+         * vertices to make its respective quad. */
+        for (int i = 0; i < 3; ++i) {
+          int edge, faces[2];
+          int skip = 0;
+          switch (i) {
+            case 0:
+              edge = 0;
+              faces[0] = MC_CUBE_FACE_FRONT;
+              faces[1] = MC_CUBE_FACE_BOTTOM;
+              if (y < 0 || z < 0)
+                skip = 1;
+              break;
+            case 1:
+              edge = 3;
+              faces[0] = MC_CUBE_FACE_FRONT;
+              faces[1] = MC_CUBE_FACE_RIGHT;
+              if (x < 0 || y < 0)
+                skip = 1;
+              break;
+            case 2:
+              edge = 8;
+              faces[0] = MC_CUBE_FACE_BOTTOM;
+              faces[1] = MC_CUBE_FACE_RIGHT;
+              if (x < 0 || z < 0)
+                skip = 1;
+              break;
+          }
+          if (skip)
+            continue;  /* Skip edge cases where we have not generated vertices
+                          in the neighboring voxel */
+          int lookupIndex, vertexIndices[4];
+          const Voxel *voxels[4];
+          int edges[4];
+          /* Get the vertex index for this edge */
+          lookupIndex = mcNielsonDual_vertexIndexLookupTable[
+            (edge << 8) + cube];
+          if (lookupIndex == -1) {
+            /* This edge does not have an associated vertex, so it must not
+             * intersect the isosurface. Skip this edge. */
+            /* TODO: Add an assertion here that checks the sample values? */
+            continue;
+          }
+          /* Find the cubes near this edge. The voxels in front of and to the
+           * right of the current voxel are in the current slice. */
+          voxels[0] = currentVoxel;
+          edges[0] = edge;
+          for (int j = 0; j < 2; ++j) {
+            switch (faces[j]) {
+              case MC_CUBE_FACE_FRONT:
+                voxels[j + 1] = &currentSlice[voxel_index(x, y - 1)];
                 break;
-              case 3:
-                /* The diagonal cube is on the front-right */
-                assert(x >= 0);
-                assert(y >= 0);
-                voxel = &previousLine[x + 1 - 1];
+              case MC_CUBE_FACE_BOTTOM:
+                voxels[j + 1] = &previousSlice[voxel_index(x, y)];
                 break;
-              case 8:
-                /* The diagonal cube is on the bottom-right */
-                assert(x >= 0);
-                assert(z >= 0);
-                voxel = &previousSlice[(x + 1 - 1) + (y + 1) * (x_res + 1)];
+              case MC_CUBE_FACE_RIGHT:
+                voxels[j + 1] = &currentSlice[voxel_index(x - 1, y)];
                 break;
             }
+            /* NOTE: The translated edge of the given face/edge combination is
+             * the index of the given edge with respect to the voxel cube on
+             * the other side of the given face. */
+            edges[j + 1] = mcCube_translateEdge(edge, faces[j]);
+          }
+          /* Find the voxel cube diagonal to this edge */
+          switch (edge) {
+            case 0:
+              /* The diagonal cube is on the bottom-front */
+              voxels[3] = &previousSlice[voxel_index(x, y - 1)];
+              break;
+            case 3:
+              /* The diagonal cube is on the front-right */
+              voxels[3] = &currentSlice[voxel_index(x - 1, y - 1)];
+              break;
+            case 8:
+              /* The diagonal cube is on the bottom-right */
+              voxels[3] = &previousSlice[voxel_index(x - 1, y)];
+              break;
+          }
+          edges[3] = mcCube_translateEdge(edges[1], faces[1]);
+          /* Use the mcNielsonDual_vertexIndexLookupTable to find the vertex
+           * indices for this edge in each voxel cube configuration. */
+          for (int j = 0; j < 4; ++j) {
             lookupIndex = mcNielsonDual_vertexIndexLookupTable[
-              (mcCube_translateEdge(mcCube_translateEdge(edge, faces[0]), faces[1]) << 8)
-                + voxel->cube];
-            /* Find the vertex index for this voxel. This index must exist. */
+              (edges[j] << 8) + voxels[j]->cube];
+            /* Every voxel around an intersected edge has a vertex on that
+             * edge */
             assert(lookupIndex != -1);
-            assert(voxel->vertexIndices[lookupIndex] != -1);
-            vertexIndices[3] = voxel->vertexIndices[lookupIndex];
-            /* The signs of the samples on this edge to determine the correct
-             * winding order. Enough information is available to quickly
-             * determine the winding order from our winding order lookup table,
-             * which returns the next face in the correct winding. */
-            int winding = mcNielsonDual_windingTable[(edge << 8) + cube];
-            quad.indices[0] = vertexIndices[0];
-            quad.indices[2] = vertexIndices[3];
-            if (winding == faces[0]) {
-              quad.indices[1] = vertexIndices[1];
-              quad.indices[3] = vertexIndices[2];
-            } else {
-              /* The winding table must agree with the faces adjacent to this
-               * edge */
-              assert(winding == faces[1]);
-              quad.indices[1] = vertexIndices[2];
-              quad.indices[3] = vertexIndices[1];
-            }
-            /* Add the quad to the mesh */
-            mcMesh_addFace(mesh, &quad);
-            /* TODO: Support triangulated meshes. */
-            /* TODO: Determine the best triangulation based on angles. */
+            assert(voxels[j]->vertexIndices[lookupIndex] != -1);
+            vertexIndices[j] = voxels[j]->vertexIndices[lookupIndex];
+          }
+          /* The signs of the samples on this edge to determine the correct
+           * winding order. Enough information is available to quickly
+           * determine the winding order from our winding order lookup table,
+           * which returns the next face in the correct winding. */
+          int winding = mcNielsonDual_windingTable[(edge << 8) + cube];
+          quad.indices[0] = vertexIndices[0];
+          quad.indices[2] = vertexIndices[3];
+          if (winding == faces[0]) {
+            quad.indices[1] = vertexIndices[1];
+            quad.indices[3] = vertexIndices[2];
+          } else {
+            /* The winding table must agree with the faces adjacent to this
+             * edge */
+            assert(winding == faces[1]);
+            quad.indices[1] = vertexIndices[2];
+            quad.indices[3] = vertexIndices[1];
           }
+          /* Add the quad to the mesh */
+          mcMesh_addFace(mesh, &quad);
+          /* TODO: Support triangulated meshes. */
+          /* TODO: Determine the best triangulation based on angles. */
         }
-        /* Make the current voxel the previous one */
-        Voxel *temp = previousVoxel;
-        previousVoxel = currentVoxel;
-        currentVoxel = temp;
       }
-      /* Make the current line the previous one */
-      Voxel *temp = previousLine;
-      previousLine = currentLine;
-      currentLine = temp;
     }
     /* Make the current slice the previous one */
     Voxel *temp = previousSlice;
     previousSlice = currentSlice;
     currentSlice = temp;
   }
-  mcFace_destroy(&triangle);
+#undef voxel_index
+  free(previousSlice);
+  free(currentSlice);
+  mcSampleSlices_destroy(&slices);
   mcFace_destroy(&quad);
 }
@@ -23,10 +23,10 @@
 
 #include <assert.h>
 #include <math.h>
-#include <stdio.h>
 #include <stdlib.h>
 
 #include <mc/algorithms/common/cube.h>
+#include <mc/algorithms/common/sampleSlices.h>
 #include <mc/algorithms/patch/common.h>
 #include <mc/algorithms/simple/simple_tables.h>
 
@@ -34,8 +34,6 @@
 
 #include "patch_tables.c"
 
-#define mod(a, b) ((a) % (b) < 0 ? (a) % (b) + (b) : (a) % (b))
-
 /* NOTE: This algorithm is nearly identical to the algorithm in
  * src/mc/algorithms/simple/simple.c. Any changes to this algorithm should be
  * reflected in the other one. */
@@ -97,42 +95,16 @@ void mcPatch_isosurfaceFromField(
   Voxel *currentVoxel = (Voxel*)malloc(sizeof(Voxel));
   /* A sample buffer of four slices is needed in order to calculate the vertex
    * normals. The buffer must contain samples from the current cube as well as
-   * samples from slices before and after the current cube's samples. We store
-   * these slices in a circular buffer. The current sample slice index always
-   * points to the slice containing the sample for the zero vertex on the
-   * current cube.
+   * samples from slices before and after the current cube's samples. These
+   * slices are kept in the circular buffer of mcSampleSlices, whose current
+   * slice always contains the sample for the zero vertex on the current cube.
    */
-  float *samples = (float*)malloc(sizeof(float) * x_res * y_res * 4);
-  int sampleSliceIndex = 3;
-  /* Initialize the sample buffer */
-  for (int z = 0; z < 2; ++z) {
-    for (int y = 0; y < y_res; ++y) {
-      for (int x = 0; x < x_res; ++x) {
-        int i = x + y * x_res + z * x_res * y_res;
-        samples[i] = sf(
-            min->x + (float)x * delta_x,
-            min->y + (float)y * delta_y,
-            min->z + (float)z * delta_z,
-            args);
-      }
-    }
-  }
+  mcSampleSlices slices;
+  mcSampleSlices_init(&slices, sf, args, x_res, y_res, z_res, min, max);
   /* Iterate over the cube lattice */
   for (int z = 0; z < z_res - 1; ++z) {
     /* Rotate the sample buffer and get samples for next slice */
-    sampleSliceIndex = (sampleSliceIndex + 1) % 4;
-    if (z + 2 < z_res) {  /* Don't sample past the maximum resolution */
-      for (int y = 0; y < y_res; ++y) {
-        for (int x = 0; x < x_res; ++x) {
-          int i = x + y * x_res + ((sampleSliceIndex + 2) % 4) * x_res * y_res;
-          samples[i] = sf(
-              min->x + (float)x * delta_x,
-              min->y + (float)y * delta_y,
-              min->z + (float)(z + 2) * delta_z,
-              args);
-        }
-      }
-    }
+    mcSampleSlices_advance(&slices);
     for (int y = 0; y < y_res - 1; ++y) {
       for (int x = 0; x < x_res - 1; ++x) {
         /* Determine the cube configuration index by iterating over the eight
@@ -140,23 +112,12 @@ void mcPatch_isosurfaceFromField(
         unsigned int cube = 0;
         for (unsigned int sampleIndex = 0; sampleIndex < 8; ++sampleIndex) {
           unsigned int pos[3];
-          unsigned int i;
           /* Determine this sample's relative position in the cube and sample
            * buffer */
           mcCube_sampleRelativePosition(sampleIndex, pos);
-          i = x + pos[0]
-              + (y + pos[1]) * x_res
-              + ((sampleSliceIndex + pos[2]) % 4) * x_res * y_res;
-#ifndef __EMSCRIPTEN__
-          /* NOTE: This assertion does not work with Emscripten for
-           * some reason */
-          assert(samples[i] == sf(min->x + (x + pos[0]) * delta_x,
-                                  min->y + (y + pos[1]) * delta_y,
-                                  min->z + (z + pos[2]) * delta_z,
-                                  args));
-#endif
           /* Add the bit this sample contributes to the cube */
-          cube |= (samples[i] >= 0.0f ? 0 : 1) << sampleIndex;
+          cube |= (mcSampleSlices_value(&slices, x + pos[0], y + pos[1], pos[2])
+              >= 0.0f ? 0 : 1) << sampleIndex;
         }
         /* Look in the edge table for the edges that intersect the
          * isosurface */
@@ -257,7 +218,6 @@ void mcPatch_isosurfaceFromField(
               mcCube_edgeSampleIndices(edge, sampleIndices);
               for (unsigned int i = 0; i < 2; ++i) {
                 unsigned int pos[3], abs[3];
-                int j;
                 mcCube_sampleRelativePosition(sampleIndices[i], pos);
                 abs[0] = x + pos[0];
                 abs[1] = y + pos[1];
@@ -269,53 +229,15 @@ void mcPatch_isosurfaceFromField(
                 latticePos[i].x = (float)(abs[0]) * delta_x;
                 latticePos[i].y = (float)(abs[1]) * delta_y;
                 latticePos[i].z = (float)(abs[2]) * delta_z;
-                /* Find the sample in our samples buffer */
-                j = abs[0]
-                    + abs[1] * x_res
-                    + ((sampleSliceIndex + pos[2]) % 4) * x_res * y_res;
-#ifndef __EMSCRIPTEN__
-                /* NOTE: This assertion does not work with Emscripten for
-                 * some reason */
-                assert(samples[j] == sf(min->x + latticePos[i].x,
-                                        min->y + latticePos[i].y,
-                                        min->z + latticePos[i].z,
-                                        args));
-#endif
-                values[i] = samples[j];
+                values[i] = mcSampleSlices_value(&slices,
+                    abs[0], abs[1], pos[2]);
                 /* Calculate the surface normal by estimating the gradiant of
                  * the scalar field at the cube samples, and then
                  * interpolating between the two gradiants. (see Lorensen,
                  * "Marching Cubes: A High Resolution 3D Surface Construction
                  * Algorihm") */
-                /* FIXME: I'm not so sure delta_x is the correct divisor */
-                gradiants[i].x =
-                  (samples[abs[0] + ((abs[0] < x_res - 1) ? 1 : 0)
-                           + abs[1] * x_res
-                           + ((sampleSliceIndex + pos[2]) % 4) * x_res * y_res]
-                   - samples[abs[0] - (abs[0] > 0 ? 1 : 0)
-                             + abs[1] * x_res
-                             + ((sampleSliceIndex + pos[2]) % 4) * x_res * y_res]
-                  ) / delta_x;
-                /* FIXME: I'm not so sure delta_y is the correct divisor */
-                gradiants[i].y =
-                  (samples[abs[0]
-                           + (abs[1] + ((abs[1] < y_res - 1) ? 1 : 0)) * x_res
-                           + ((sampleSliceIndex + pos[2]) % 4) * x_res * y_res]
-                   - samples[abs[0]
-                             + (abs[1] - (abs[1] > 0 ? 1 : 0)) * x_res
-                             + ((sampleSliceIndex + pos[2]) % 4) * x_res * y_res]
-                  ) / delta_y;
-                /* FIXME: I'm not so sure delta_z is the correct divisor */
-                gradiants[i].z =
-                  (samples[abs[0]
-                           + abs[1] * x_res
-                           + ((sampleSliceIndex + pos[2] + ((abs[2] < z_res - 1) ? 1 : 0)) % 4)
-                             * x_res * y_res]
-                   - samples[abs[0]
-                             + abs[1] * x_res
-                             + mod((sampleSliceIndex + pos[2] - (abs[2] > 0 ? 1 : 0)), 4)
-                               * x_res * y_res]
-                  ) / delta_z;
+                mcSampleSlices_gradient(&slices, abs[0], abs[1], pos[2],
+                    &gradiants[i]);
               }
               /* Interpolate between the sample values at each vertex */
               float weight = fabs(values[0] / (values[0] - values[1]));
@@ -372,7 +294,6 @@ void mcPatch_isosurfaceFromField(
         for (int i = 0; i < MC_PATCH_MAX_PATCHES; ++i) {
           mcFace face;
           const mcPatch_Patch *patch = &mcPatch_patchTable[cube].patches[i];
-          fprintf(stderr, "patch->numEdgeIntersections: %d\n", patch->numEdgeIntersections);
           if (patch->numEdgeIntersections == 0)
             break;  /* No more patches */
           /* Add the vertex indices to the face */
@@ -401,7 +322,7 @@ void mcPatch_isosurfaceFromField(
     currentSlice = temp;
   }
   /* Free our resources */
-  free(samples);
+  mcSampleSlices_destroy(&slices);
   free(previousVoxel);
   free(currentVoxel);
   free(previousLine);
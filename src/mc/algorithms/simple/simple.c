@@ -28,6 +28,7 @@
 #include <string.h>
 
 #include <mc/algorithms/common/cube.h>
+#include <mc/algorithms/common/sampleSlices.h>
 #include <mc/isosurfaceBuilder.h>
 #include <mc/mesh.h>
 
@@ -37,8 +38,6 @@
 
 #define max(a, b) ((a) > (b) ? (a) : (b))
 
-#define mod(a, b) ((a) % (b) < 0 ? (a) % (b) + (b) : (a) % (b))
-
 /**
  * This file implements the simple marching cubes algorithm as described by
  * Lorensen in "Marching Cubes: A high Resolution 3D Surface Construction
@@ -110,42 +109,16 @@ void mcSimple_isosurfaceFromField(
   Voxel *currentVoxel = (Voxel*)malloc(sizeof(Voxel));
   /* A sample buffer of four slices is needed in order to calculate the vertex
    * normals. The buffer must contain samples from the current cube as well as
-   * samples from slices before and after the current cube's samples. We store
-   * these slices in a circular buffer. The current sample slice index always
-   * points to the slice containing the sample for the zero vertex on the
-   * current cube.
+   * samples from slices before and after the current cube's samples. These
+   * slices are kept in the circular buffer of mcSampleSlices, whose current
+   * slice always contains the sample for the zero vertex on the current cube.
    */
-  float *samples = (float*)malloc(sizeof(float) * x_res * y_res * 4);
-  int sampleSliceIndex = 3;
-  /* Initialize the sample buffer */
-  for (int z = 0; z < 2; ++z) {
-    for (int y = 0; y < y_res; ++y) {
-      for (int x = 0; x < x_res; ++x) {
-        int i = x + y * x_res + z * x_res * y_res;
-        samples[i] = sf(
-            min->x + (float)x * delta_x,
-            min->y + (float)y * delta_y,
-            min->z + (float)z * delta_z,
-            args);
-      }
-    }
-  }
+  mcSampleSlices slices;
+  mcSampleSlices_init(&slices, sf, args, x_res, y_res, z_res, min, max);
   /* Iterate over the cube lattice */
   for (int z = 0; z < z_res - 1; ++z) {
     /* Rotate the sample buffer and get samples for next slice */
-    sampleSliceIndex = (sampleSliceIndex + 1) % 4;
-    if (z + 2 < z_res) {  /* Don't sample past the maximum resolution */
-      for (int y = 0; y < y_res; ++y) {
-        for (int x = 0; x < x_res; ++x) {
-          int i = x + y * x_res + ((sampleSliceIndex + 2) % 4) * x_res * y_res;
-          samples[i] = sf(
-              min->x + (float)x * delta_x,
-              min->y + (float)y * delta_y,
-              min->z + (float)(z + 2) * delta_z,
-              args);
-        }
-      }
-    }
+    mcSampleSlices_advance(&slices);
     for (int y = 0; y < y_res - 1; ++y) {
       for (int x = 0; x < x_res - 1; ++x) {
         /* Determine the cube configuration index by iterating over the eight
@@ -153,23 +126,12 @@ void mcSimple_isosurfaceFromField(
         unsigned int cube = 0;
         for (unsigned int sampleIndex = 0; sampleIndex < 8; ++sampleIndex) {
           unsigned int pos[3];
-          unsigned int i;
           /* Determine this sample's relative position in the cube and sample
            * buffer */
           mcCube_sampleRelativePosition(sampleIndex, pos);
-          i = x + pos[0]
-              + (y + pos[1]) * x_res
-              + ((sampleSliceIndex + pos[2]) % 4) * x_res * y_res;
-#if 0
-          /* NOTE: This assertion does not work with Emscripten for
-           * some reason */
-          assert(samples[i] == sf(min->x + (x + pos[0]) * delta_x,
-                                  min->y + (y + pos[1]) * delta_y,
-                                  min->z + (z + pos[2]) * delta_z,
-                                  args));
-#endif
           /* Add the bit this sample contributes to the cube */
-          cube |= (samples[i] >= 0.0f ? 0 : 1) << sampleIndex;
+          cube |= (mcSampleSlices_value(&slices, x + pos[0], y + pos[1], pos[2])
+              >= 0.0f ? 0 : 1) << sampleIndex;
         }
         /* Look in the edge table for the edges that intersect the
          * isosurface */
@@ -268,7 +230,6 @@ void mcSimple_isosurfaceFromField(
               mcCube_edgeSampleIndices(edge, sampleIndices);
               for (unsigned int i = 0; i < 2; ++i) {
                 unsigned int pos[3], abs[3];
-                int j;
                 mcCube_sampleRelativePosition(sampleIndices[i], pos);
                 abs[0] = x + pos[0];
                 abs[1] = y + pos[1];
@@ -280,53 +241,15 @@ void mcSimple_isosurfaceFromField(
                 latticePos[i].x = (float)(abs[0]) * delta_x;
                 latticePos[i].y = (float)(abs[1]) * delta_y;
                 latticePos[i].z = (float)(abs[2]) * delta_z;
-                /* Find the sample in our samples buffer */
-                j = abs[0]
-                    + abs[1] * x_res
-                    + ((sampleSliceIndex + pos[2]) % 4) * x_res * y_res;
-#if 0
-                /* NOTE: This assertion does not work with Emscripten for
-                 * some reason */
-                assert(samples[j] == sf(min->x + latticePos[i].x,
-                                        min->y + latticePos[i].y,
-                                        min->z + latticePos[i].z,
-                                        args));
-#endif
-                values[i] = samples[j];
+                values[i] = mcSampleSlices_value(&slices,
+                    abs[0], abs[1], pos[2]);
                 /* Calculate the surface normal by estimating the gradient of
                  * the scalar field at the cube samples, and then
                  * interpolating between the two gradients. (see Lorensen,
                  * "Marching Cubes: A High Resolution 3D Surface Construction
                  * Algorihm") */
-                /* FIXME: I'm not so sure delta_x is the correct divisor */
-                gradients[i].x =
-                  (samples[abs[0] + ((abs[0] < x_res - 1) ? 1 : 0)
-                           + abs[1] * x_res
-                           + ((sampleSliceIndex + pos[2]) % 4) * x_res * y_res]
-                   - samples[abs[0] - (abs[0] > 0 ? 1 : 0)
-                             + abs[1] * x_res
-                             + ((sampleSliceIndex + pos[2]) % 4) * x_res * y_res]
-                  ) / delta_x;
-                /* FIXME: I'm not so sure delta_y is the correct divisor */
-                gradients[i].y =
-                  (samples[abs[0]
-                           + (abs[1] + ((abs[1] < y_res - 1) ? 1 : 0)) * x_res
-                           + ((sampleSliceIndex + pos[2]) % 4) * x_res * y_res]
-                   - samples[abs[0]
-                             + (abs[1] - (abs[1] > 0 ? 1 : 0)) * x_res
-                             + ((sampleSliceIndex + pos[2]) % 4) * x_res * y_res]
-                  ) / delta_y;
-                /* FIXME: I'm not so sure delta_z is the correct divisor */
-                gradients[i].z =
-                  (samples[abs[0]
-                           + abs[1] * x_res
-                           + ((sampleSliceIndex + pos[2] + ((abs[2] < z_res - 1) ? 1 : 0)) % 4)
-                             * x_res * y_res]
-                   - samples[abs[0]
-                             + abs[1] * x_res
-                             + mod((sampleSliceIndex + pos[2] - (abs[2] > 0 ? 1 : 0)), 4)
-                               * x_res * y_res]
-                  ) / delta_z;
+                mcSampleSlices_gradient(&slices, abs[0], abs[1], pos[2],
+                    &gradients[i]);
               }
               /* Interpolate between the sample values at each vertex */
               float weight = fabs(values[0] / (values[0] - values[1]));
@@ -409,7 +332,7 @@ void mcSimple_isosurfaceFromField(
     currentSlice = temp;
   }
   /* Free our resources */
-  free(samples);
+  mcSampleSlices_destroy(&slices);
   free(previousVoxel);
   free(currentVoxel);
   free(previousLine);
@@ -21,4 +21,501 @@
  * IN THE SOFTWARE.
  */
 
-/* TODO */
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mc/algorithms/common/cube.h>
+#include <mc/algorithms/common/sampleSlices.h>
+#include <mc/algorithms/simple/simple_tables.h>
+#include <mc/algorithms/snapmc/snapmc.h>
+#include <mc/mesh.h>
+
+void mcSnapMCParams_default(mcSnapMCParams *params) {
+  params->type = MC_SNAP_MC_PARAMS;
+  params->snapThreshold = 0.3f;
+}
+
+/* The largest number of triangles around the vertices on the six lattice
+ * edges incident to a lattice point. Each of these vertices lies in four voxel
+ * cubes, with at most five triangles around it in each. */
+#define MC_SNAP_MC_MAX_TRIANGLES 128
+
+/**
+ * The marching cubes mesh that SnapMC snaps vertices of. Each vertex lies on
+ * the lattice edge between two lattice points, at the given weight from the
+ * first point to the second.
+ */
+typedef struct mcSnapMCMesh {
+  mcVertex *vertices;
+  unsigned int *endpoints;  /* Two lattice point indices per vertex */
+  float *weights;
+  unsigned int numVertices, sizeVertices;
+  unsigned int *triangles;  /* Three vertex indices per triangle */
+  unsigned int numTriangles, sizeTriangles;
+} mcSnapMCMesh;
+
+/**
+ * A vertex on a lattice edge incident to the given lattice point. Sorting
+ * these by lattice point gathers the vertices around each lattice point.
+ */
+typedef struct mcSnapMCIncidence {
+  unsigned int point, vertex;
+} mcSnapMCIncidence;
+
+int mcSnapMCIncidence_compare(const void *a, const void *b) {
+  const mcSnapMCIncidence *u = (const mcSnapMCIncidence*)a;
+  const mcSnapMCIncidence *v = (const mcSnapMCIncidence*)b;
+  if (u->point != v->point)
+    return u->point < v->point ? -1 : 1;
+  if (u->vertex != v->vertex)
+    return u->vertex < v->vertex ? -1 : 1;
+  return 0;
+}
+
+unsigned int mcSnapMCMesh_addVertex(mcSnapMCMesh *self,
+    const mcVertex *vertex, unsigned int a, unsigned int b, float weight)
+{
+  if (self->numVertices >= self->sizeVertices) {
+    /* Double the size of the vertex arrays */
+    unsigned int size = self->sizeVertices * 2;
+    mcVertex *vertices = (mcVertex*)malloc(sizeof(mcVertex) * size);
+    unsigned int *endpoints =
+      (unsigned int*)malloc(sizeof(unsigned int) * 2 * size);
+    float *weights = (float*)malloc(sizeof(float) * size);
+    memcpy(vertices, self->vertices, sizeof(mcVertex) * self->numVertices);
+    memcpy(endpoints, self->endpoints,
+        sizeof(unsigned int) * 2 * self->numVertices);
+    memcpy(weights, self->weights, sizeof(float) * self->numVertices);
+    free(self->vertices);
+    free(self->endpoints);
+    free(self->weights);
+    self->vertices = vertices;
+    self->endpoints = endpoints;
+    self->weights = weights;
+    self->sizeVertices = size;
+  }
+  self->vertices[self->numVertices] = *vertex;
+  self->endpoints[self->numVertices * 2] = a;
+  self->endpoints[self->numVertices * 2 + 1] = b;
+  self->weights[self->numVertices] = weight;
+  return self->numVertices++;
+}
+
+void mcSnapMCMesh_addTriangle(mcSnapMCMesh *self, const int *indices) {
+  if (self->numTriangles >= self->sizeTriangles) {
+    /* Double the size of the triangle array */
+    unsigned int size = self->sizeTriangles * 2;
+    unsigned int *triangles =
+      (unsigned int*)malloc(sizeof(unsigned int) * 3 * size);
+    memcpy(triangles, self->triangles,
+        sizeof(unsigned int) * 3 * self->numTriangles);
+    free(self->triangles);
+    self->triangles = triangles;
+    self->sizeTriangles = size;
+  }
+  for (int i = 0; i < 3; ++i)
+    self->triangles[self->numTriangles * 3 + i] = indices[i];
+  self->numTriangles += 1;
+}
+
+/**
+ * Extracts the plain marching cubes mesh of the given scalar field, recording
+ * the lattice edge and weight of each vertex.
+ */
+void mcSnapMC_extract(
+    mcScalarFieldWithArgs sf, const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max,
+    mcSnapMCMesh *result)
+{
+  float delta[3];
+  delta[0] = fabs(max->x - min->x) / (float)(x_res - 1);
+  delta[1] = fabs(max->y - min->y) / (float)(y_res - 1);
+  delta[2] = fabs(max->z - min->z) / (float)(z_res - 1);
+  unsigned int sliceSize = x_res * y_res;
+  /* Like simple marching cubes, we take advantage of slice-to-slice coherence
+   * by keeping the mesh vertices on the lattice edges of the two lattice
+   * slices bounding the current layer of voxel cubes. Index 0 refers to the
+   * current slice z and index 1 to slice z + 1. */
+  int *xEdgeVertices[2], *yEdgeVertices[2];
+  for (int i = 0; i < 2; ++i) {
+    xEdgeVertices[i] = (int*)malloc(sizeof(int) * sliceSize);
+    yEdgeVertices[i] = (int*)malloc(sizeof(int) * sliceSize);
+  }
+  int *zEdgeVertices = (int*)malloc(sizeof(int) * sliceSize);
+  for (unsigned int i = 0; i < sliceSize; ++i)
+    xEdgeVertices[1][i] = yEdgeVertices[1][i] = -1;
+  mcSampleSlices slices;
+  mcSampleSlices_init(&slices, sf, args, x_res, y_res, z_res, min, max);
+  for (int z = 0; z < z_res - 1; ++z) {
+    /* Rotate the sample buffer and get samples for next slice */
+    mcSampleSlices_advance(&slices);
+    /* Rotate the vertex buffers so that slice z + 1 becomes slice z */
+    int *temp;
+    temp = xEdgeVertices[0];
+    xEdgeVertices[0] = xEdgeVertices[1];
+    xEdgeVertices[1] = temp;
+    temp = yEdgeVertices[0];
+    yEdgeVertices[0] = yEdgeVertices[1];
+    yEdgeVertices[1] = temp;
+    for (unsigned int i = 0; i < sliceSize; ++i)
+      xEdgeVertices[1][i] = yEdgeVertices[1][i] = zEdgeVertices[i] = -1;
+    for (int y = 0; y < y_res - 1; ++y) {
+      for (int x = 0; x < x_res - 1; ++x) {
+        /* Determine the cube configuration from the samples */
+        unsigned int cube = 0;
+        float values[8];
+        for (unsigned int sampleIndex = 0; sampleIndex < 8; ++sampleIndex) {
+          unsigned int pos[3];
+          mcCube_sampleRelativePosition(sampleIndex, pos);
+          values[sampleIndex] = mcSampleSlices_value(&slices,
+              x + pos[0], y + pos[1], pos[2]);
+          cube |= (values[sampleIndex] >= 0.0f ? 0 : 1) << sampleIndex;
+        }
+        if (cube == 0x00 || cube == 0xff)
+          continue;
+        /* Find or make the vertex for each edge intersection */
+        int vertexIndices[MC_CUBE_NUM_EDGES];
+        const int *edges = mcSimple_edgeIntersectionTable[cube].edges;
+        for (int i = 0; i < MC_CUBE_NUM_EDGES && edges[i] != -1; ++i) {
+          int edge = edges[i];
+          unsigned int sampleIndices[2], pos[2][3];
+          mcCube_edgeSampleIndices(edge, sampleIndices);
+          mcCube_sampleRelativePosition(sampleIndices[0], pos[0]);
+          mcCube_sampleRelativePosition(sampleIndices[1], pos[1]);
+          /* Sample indices are given from least to greatest, so the first
+           * sample lies at the lower end of the edge */
+          int axis = pos[0][0] != pos[1][0] ? 0
+            : pos[0][1] != pos[1][1] ? 1 : 2;
+          unsigned int index = (x + pos[0][0]) + (y + pos[0][1]) * x_res;
+          int *vertexIndex = axis == 0 ? &xEdgeVertices[pos[0][2]][index]
+            : axis == 1 ? &yEdgeVertices[pos[0][2]][index]
+            : &zEdgeVertices[index];
+          if (*vertexIndex == -1) {
+            /* The mesh vertex for this edge intersection has not been
+             * generated yet */
+            float weight = fabs(values[sampleIndices[0]]
+                / (values[sampleIndices[0]] - values[sampleIndices[1]]));
+            mcVec3 latticePos[2], gradients[2];
+            unsigned int points[2];
+            for (int j = 0; j < 2; ++j) {
+              /* NOTE: These lattice positions are in mesh space coordinates,
+               * in which min is at the origin. */
+              latticePos[j].x = (float)(x + pos[j][0]) * delta[0];
+              latticePos[j].y = (float)(y + pos[j][1]) * delta[1];
+              latticePos[j].z = (float)(z + pos[j][2]) * delta[2];
+              mcSampleSlices_gradient(&slices, x + pos[j][0], y + pos[j][1],
+                  pos[j][2], &gradients[j]);
+              points[j] = (x + pos[j][0])
+                + (y + pos[j][1]) * x_res
+                + (z + pos[j][2]) * sliceSize;
+            }
+            mcVertex vertex;
+            vertex.pos = mcVec3_lerp(&latticePos[0], &latticePos[1], weight);
+            vertex.norm = mcVec3_lerp(&gradients[0], &gradients[1], weight);
+            if (mcVec3_length(&vertex.norm) > 0.0f)
+              mcVec3_normalize(&vertex.norm, &vertex.norm);
+            *vertexIndex = mcSnapMCMesh_addVertex(result, &vertex,
+                points[0], points[1], weight);
+          }
+          vertexIndices[edge] = *vertexIndex;
+        }
+        /* Add the triangles for this cube configuration */
+        for (int j = 0; j < MC_SIMPLE_MAX_TRIANGLES; ++j) {
+          const mcSimpleTriangle *t =
+            &mcSimple_triangulationTable[cube].triangles[j];
+          if (t->edgeIntersections[0] == -1)
+            break;  /* No more triangles */
+          int indices[3];
+          for (int k = 0; k < 3; ++k)
+            indices[k] = vertexIndices[t->edgeIntersections[k]];
+          mcSnapMCMesh_addTriangle(result, indices);
+        }
+      }
+    }
+  }
+  /* Free our resources */
+  mcSampleSlices_destroy(&slices);
+  for (int i = 0; i < 2; ++i) {
+    free(xEdgeVertices[i]);
+    free(yEdgeVertices[i]);
+  }
+  free(zEdgeVertices);
+}
+
+/**
+ * Checks whether the given triangles around a vertex, given as the two other
+ * vertices of each triangle in winding order, form a single fan. That is the
+ * case when the edges from the first to the second vertex of each triangle
+ * link up into a single path or a single cycle of at least three vertices,
+ * so that each edge from the center vertex is shared by at most two
+ * consistently wound triangles.
+ */
+int mcSnapMC_isFan(const unsigned int *link, int numLink) {
+  int next[MC_SNAP_MC_MAX_TRIANGLES], hasPrevious[MC_SNAP_MC_MAX_TRIANGLES];
+  if (numLink == 0)
+    return 0;
+  assert(numLink <= MC_SNAP_MC_MAX_TRIANGLES);
+  for (int i = 0; i < numLink; ++i)
+    next[i] = -1;
+  for (int i = 0; i < numLink; ++i)
+    hasPrevious[i] = 0;
+  /* Connect each link edge to the link edge that starts where it ends */
+  for (int i = 0; i < numLink; ++i) {
+    for (int j = 0; j < numLink; ++j) {
+      if (i == j)
+        continue;
+      if (link[i * 2] == link[j * 2] || link[i * 2 + 1] == link[j * 2 + 1])
+        return 0;  /* Two triangles wind through a vertex the same way */
+      if (link[i * 2 + 1] != link[j * 2])
+        continue;
+      next[i] = j;
+      hasPrevious[j] = 1;
+    }
+  }
+  /* Follow the link from its start, or from anywhere if it is a cycle */
+  int start = 0;
+  for (int i = 0; i < numLink; ++i) {
+    if (!hasPrevious[i]) {
+      start = i;
+      break;
+    }
+  }
+  int count = 0, current = start;
+  do {
+    count += 1;
+    current = next[current];
+  } while (current != -1 && current != start);
+  if (count != numLink)
+    return 0;  /* The triangles form more than one fan */
+  if (current == start && numLink < 3)
+    return 0;  /* Two triangles on top of each other */
+  return 1;
+}
+
+/**
+ * Snaps the given vertices, which lie on the lattice edges incident to a
+ * lattice point, to a single vertex at that lattice point, unless doing so
+ * would make the mesh non-manifold. Returns nonzero if the vertices were
+ * snapped.
+ */
+int mcSnapMC_snap(
+    mcSnapMCMesh *mesh,
+    const unsigned int *vertexTriangles,
+    const unsigned int *vertexTriangleOffsets,
+    unsigned int *representatives,
+    int *deadTriangles,
+    const unsigned int *members,
+    int numMembers,
+    const mcVec3 *pos)
+{
+  unsigned int triangles[MC_SNAP_MC_MAX_TRIANGLES],
+               link[MC_SNAP_MC_MAX_TRIANGLES * 2];
+  int numTriangles = 0, numLink = 0;
+  unsigned int center = members[0];
+  /* Gather the triangles around the vertices being snapped */
+  for (int i = 0; i < numMembers; ++i) {
+    for (unsigned int j = vertexTriangleOffsets[members[i]];
+        j < vertexTriangleOffsets[members[i] + 1]; ++j)
+    {
+      unsigned int t = vertexTriangles[j];
+      int seen = 0;
+      if (deadTriangles[t])
+        continue;
+      for (int k = 0; k < numTriangles; ++k) {
+        if (triangles[k] == t)
+          seen = 1;
+      }
+      if (seen)
+        continue;
+      assert(numTriangles < MC_SNAP_MC_MAX_TRIANGLES);
+      triangles[numTriangles++] = t;
+    }
+  }
+  /* Each triangle that keeps exactly one corner at the snapped vertex
+   * contributes the edge opposite that corner to the link of the snapped
+   * vertex. Triangles with more than one corner there collapse. */
+  for (int i = 0; i < numTriangles; ++i) {
+    unsigned int corners[3];
+    int numCenter = 0, first = 0;
+    for (int j = 0; j < 3; ++j) {
+      corners[j] = representatives[mesh->triangles[triangles[i] * 3 + j]];
+      for (int k = 0; k < numMembers; ++k) {
+        if (corners[j] == members[k])
+          corners[j] = center;
+      }
+      if (corners[j] == center) {
+        numCenter += 1;
+        first = j;
+      }
+    }
+    if (numCenter != 1)
+      continue;
+    link[numLink * 2] = corners[(first + 1) % 3];
+    link[numLink * 2 + 1] = corners[(first + 2) % 3];
+    numLink += 1;
+  }
+  if (!mcSnapMC_isFan(link, numLink))
+    return 0;
+  /* Merge the vertices into the center vertex at the lattice point, with the
+   * average of their normals */
+  mcVec3 norm;
+  norm.x = norm.y = norm.z = 0.0f;
+  for (int i = 0; i < numMembers; ++i) {
+    mcVec3_add(&norm, &mesh->vertices[members[i]].norm, &norm);
+    representatives[members[i]] = center;
+  }
+  if (mcVec3_length(&norm) > 0.0f)
+    mcVec3_normalize(&norm, &norm);
+  mesh->vertices[center].pos = *pos;
+  mesh->vertices[center].norm = norm;
+  /* Discard the triangles that collapsed */
+  for (int i = 0; i < numTriangles; ++i) {
+    const unsigned int *t = &mesh->triangles[triangles[i] * 3];
+    unsigned int a = representatives[t[0]], b = representatives[t[1]],
+                 c = representatives[t[2]];
+    if (a == b || b == c || c == a)
+      deadTriangles[triangles[i]] = 1;
+  }
+  return 1;
+}
+
+void mcSnapMC_isosurfaceFromField(
+    mcScalarFieldWithArgs sf, const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max,
+    const mcSnapMCParams *params,
+    mcMesh *mesh)
+{
+  mcSnapMCParams defaultParams;
+  if (params == NULL) {
+    mcSnapMCParams_default(&defaultParams);
+    params = &defaultParams;
+  }
+  assert(params->type == MC_SNAP_MC_PARAMS);
+  float delta[3];
+  delta[0] = fabs(max->x - min->x) / (float)(x_res - 1);
+  delta[1] = fabs(max->y - min->y) / (float)(y_res - 1);
+  delta[2] = fabs(max->z - min->z) / (float)(z_res - 1);
+  /* Snapping merges vertices of the marching cubes mesh, which can only be
+   * checked against the triangles around those vertices. We therefore
+   * extract the whole marching cubes mesh before snapping. */
+  mcSnapMCMesh mc;
+  mc.sizeVertices = mc.sizeTriangles = 1024;
+  mc.numVertices = mc.numTriangles = 0;
+  mc.vertices = (mcVertex*)malloc(sizeof(mcVertex) * mc.sizeVertices);
+  mc.endpoints = (unsigned int*)malloc(
+      sizeof(unsigned int) * 2 * mc.sizeVertices);
+  mc.weights = (float*)malloc(sizeof(float) * mc.sizeVertices);
+  mc.triangles = (unsigned int*)malloc(
+      sizeof(unsigned int) * 3 * mc.sizeTriangles);
+  mcSnapMC_extract(sf, args, x_res, y_res, z_res, min, max, &mc);
+  /* Find the triangles around each vertex */
+  unsigned int *vertexTriangleOffsets = (unsigned int*)malloc(
+      sizeof(unsigned int) * (mc.numVertices + 1));
+  unsigned int *vertexTriangles = (unsigned int*)malloc(
+      sizeof(unsigned int) * 3 * mc.numTriangles);
+  memset(vertexTriangleOffsets, 0,
+      sizeof(unsigned int) * (mc.numVertices + 1));
+  for (unsigned int i = 0; i < mc.numTriangles * 3; ++i)
+    vertexTriangleOffsets[mc.triangles[i] + 1] += 1;
+  for (unsigned int i = 0; i < mc.numVertices; ++i)
+    vertexTriangleOffsets[i + 1] += vertexTriangleOffsets[i];
+  for (unsigned int i = 0; i < mc.numTriangles * 3; ++i) {
+    /* Use the offsets of the next vertex as insertion points, which leaves
+     * them at the offsets of each vertex once we are done */
+    vertexTriangles[vertexTriangleOffsets[mc.triangles[i]]++] = i / 3;
+  }
+  for (unsigned int i = mc.numVertices; i > 0; --i)
+    vertexTriangleOffsets[i] = vertexTriangleOffsets[i - 1];
+  vertexTriangleOffsets[0] = 0;
+  /* Gather the vertices around each lattice point */
+  mcSnapMCIncidence *incidences = (mcSnapMCIncidence*)malloc(
+      sizeof(mcSnapMCIncidence) * 2 * mc.numVertices);
+  for (unsigned int i = 0; i < mc.numVertices; ++i) {
+    for (int j = 0; j < 2; ++j) {
+      incidences[i * 2 + j].point = mc.endpoints[i * 2 + j];
+      incidences[i * 2 + j].vertex = i;
+    }
+  }
+  qsort(incidences, 2 * mc.numVertices, sizeof(mcSnapMCIncidence),
+      mcSnapMCIncidence_compare);
+  unsigned int *representatives = (unsigned int*)malloc(
+      sizeof(unsigned int) * mc.numVertices);
+  int *snappedVertices = (int*)malloc(sizeof(int) * mc.numVertices);
+  int *deadTriangles = (int*)malloc(sizeof(int) * mc.numTriangles);
+  for (unsigned int i = 0; i < mc.numVertices; ++i) {
+    representatives[i] = i;
+    snappedVertices[i] = 0;
+  }
+  for (unsigned int i = 0; i < mc.numTriangles; ++i)
+    deadTriangles[i] = 0;
+  /* Snap each lattice point with an edge intersection closer than the snap
+   * threshold to it. The vertices on the lattice edges incident to that point
+   * are merged into a single vertex at the point, unless a neighboring point
+   * already claimed them or merging them would make the mesh non-manifold.
+   * Skipping such snaps keeps the mesh as manifold as plain marching cubes,
+   * without the extended tables of Raman and Wenger. */
+  for (unsigned int i = 0; i < 2 * mc.numVertices; ) {
+    unsigned int point = incidences[i].point;
+    unsigned int members[6];
+    int numMembers = 0, close = 0;
+    for (; i < 2 * mc.numVertices && incidences[i].point == point; ++i) {
+      unsigned int vertex = incidences[i].vertex;
+      /* The distance from this point to the edge intersection, as a fraction
+       * of the edge length */
+      float distance = mc.endpoints[vertex * 2] == point
+        ? mc.weights[vertex] : 1.0f - mc.weights[vertex];
+      if (distance < params->snapThreshold)
+        close = 1;
+      if (snappedVertices[vertex])
+        continue;
+      assert(numMembers < 6);
+      members[numMembers++] = vertex;
+    }
+    if (!close || numMembers == 0)
+      continue;
+    mcVec3 pos;
+    pos.x = (float)(point % x_res) * delta[0];
+    pos.y = (float)(point / x_res % y_res) * delta[1];
+    pos.z = (float)(point / (x_res * y_res)) * delta[2];
+    if (mcSnapMC_snap(&mc, vertexTriangles, vertexTriangleOffsets,
+          representatives, deadTriangles, members, numMembers, &pos))
+    {
+      for (int j = 0; j < numMembers; ++j)
+        snappedVertices[members[j]] = 1;
+    }
+  }
+  /* Add the remaining vertices and triangles to the mesh */
+  int *meshIndices = (int*)malloc(sizeof(int) * mc.numVertices);
+  for (unsigned int i = 0; i < mc.numVertices; ++i)
+    meshIndices[i] = -1;
+  mcFace triangle;
+  mcFace_init(&triangle, 3);
+  for (unsigned int i = 0; i < mc.numTriangles; ++i) {
+    if (deadTriangles[i])
+      continue;
+    for (int j = 0; j < 3; ++j) {
+      unsigned int vertex = representatives[mc.triangles[i * 3 + j]];
+      if (meshIndices[vertex] == -1)
+        meshIndices[vertex] = mcMesh_addVertex(mesh, &mc.vertices[vertex]);
+      triangle.indices[j] = meshIndices[vertex];
+    }
+    mcMesh_addFace(mesh, &triangle);
+  }
+  /* Free our resources */
+  mcFace_destroy(&triangle);
+  free(meshIndices);
+  free(deadTriangles);
+  free(snappedVertices);
+  free(representatives);
+  free(incidences);
+  free(vertexTriangles);
+  free(vertexTriangleOffsets);
+  free(mc.triangles);
+  free(mc.weights);
+  free(mc.endpoints);
+  free(mc.vertices);
+}
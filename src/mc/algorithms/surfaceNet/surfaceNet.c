@@ -26,8 +26,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include <stdio.h>  /* XXX */
-
 #include <mc/algorithms/common/cube.h>
 
 #include <mc/algorithms/common/surfaceNet.h>
@@ -51,116 +49,36 @@ void mcSurfaceNet_isosurfaceFromField(
   mcFace triangle;
   /* Initialize the surface net structure */
   mcSurfaceNet_init(&surfaceNet);
-  /* Keep a slice, line, and voxel buffer of surface nodes so that we can
-   * find nodes relative to the current node. */
-  mcSurfaceNode **prevSlice =
-    (mcSurfaceNode**)malloc(sizeof(mcSurfaceNode*) * (res_x - 1) * (res_y - 1));
-  memset(prevSlice, 0, sizeof(mcSurfaceNode*) * (res_x - 1) * (res_y - 1));
-  mcSurfaceNode **prevLine = 
-    (mcSurfaceNode**)malloc(sizeof(mcSurfaceNode*) * (res_x - 1));
-  mcSurfaceNode *prevVoxel;
-  /* Iterate over the voxel cube lattice */
-  for (unsigned int z = 0; z < res_z - 1; ++z) {
-    /* The start of a new slice has no previous line */
-    memset(prevLine, 0, sizeof(mcSurfaceNode*) * (res_x - 1));
-    for (unsigned int y = 0; y < res_y - 1; ++y) {
-      /* The start of a new line has no previous voxel */
-      prevVoxel = NULL;
-      for (unsigned int x = 0; x < res_x - 1; ++x) {
-        /* Determine the cube configuration index by iterating over the eight
-         * cube vertices.
-         * NOTE: Copied from mc/algorithms/simple/simple.c
-         */
-        unsigned int cube = 0;
-        for (unsigned int sampleIndex = 0; sampleIndex < 8; ++sampleIndex) {
-          /* Determine this sample's relative position in the cube */
-          unsigned int pos[3];
-          float sample;
-          mcCube_sampleRelativePosition(sampleIndex, pos);
-          /* TODO: Many of these sample values can be stored/retrieved from a
-           * cache */
-          sample = sf(
-              min->x + (x + pos[0]) * delta_x,
-              min->y + (y + pos[1]) * delta_y,
-              min->z + (z + pos[2]) * delta_z,
-              args);
-          fprintf(stderr, "sample: %g\n", sample);  /* XXX */
-          /* Add the bit this sample contributes to the cube */
-          cube |= (sample >= 0.0f ? 1 : 0) << sampleIndex;
-        }
-        fprintf(stderr, "cube: 0x%02x\n", cube);  /* XXX */
-        assert(cube <= 0xff);
-        /* Check for surface cubes, i.e. cubes that intersect the isosurface */
-        if (cube != 0x00 && cube != 0xff) {
-          mcSurfaceNode *node, *bottomNeighbor, *frontNeighbor, *leftNeighbor;
-          /* Create a node for this surface cube */
-          node = mcSurfaceNet_getNextNode(&surfaceNet);
-          /* Set the node position to the center of the voxel cube */
-          node->pos.x = min->x + x * delta_x + delta_x / 2.0f;
-          node->pos.y = min->y + y * delta_y + delta_y / 2.0f;
-          node->pos.z = min->z + z * delta_z + delta_z / 2.0f;
-          /* Store the lattice position of the node */
-          node->latticePos[0] = x;
-          node->latticePos[1] = y;
-          node->latticePos[2] = z;
-          /* Connect surface node to neighboring surface nodes */
-          bottomNeighbor = prevSlice[y * (res_x - 1) + x];
-          if (bottomNeighbor != NULL) {
-            mcSurfaceNode_addNeighbor(
-                node, bottomNeighbor, MC_SURFACE_NODE_BOTTOM);
-          }
-          frontNeighbor = prevLine[x];
-          if (frontNeighbor != NULL) {
-            mcSurfaceNode_addNeighbor(
-                node, frontNeighbor, MC_SURFACE_NODE_FRONT);
-          }
-          leftNeighbor = prevVoxel;
-          if (leftNeighbor != NULL) {
-            mcSurfaceNode_addNeighbor(
-                node, leftNeighbor, MC_SURFACE_NODE_LEFT);
-          }
-          /* Record this surface node in the prev node buffers */
-          prevSlice[y * (res_x - 1) + x] = node;
-          prevLine[x] = node;
-          prevVoxel = node;
-        } else {
-          /* Record the absence of a surface node node as NULL in the prev node
-           * buffers */
-          prevSlice[y * (res_x - 1) + x] = NULL;
-          prevLine[x] = NULL;
-          prevVoxel = NULL;
-        }
-      }
-    }
-  }
+  /* Build the surface net from samples of our scalar field */
+  mcSurfaceNet_build(&surfaceNet,
+      sf, args,
+      res_x, res_y, res_z,
+      min, max);
   /* TODO: Now that the surface net has been built, we iterate to improve it */
   /* TODO: Allow the number of iterations to be passed as an argument */
   static const int MAX_ITERATIONS = 300;
   for (int i = 0; i < MAX_ITERATIONS; ++i) {
-    fprintf(stderr, "iteration: %d\n", i);
     /* Update the old position of all nodes */
-    for (int j = 0; j < surfaceNet.numNodes; ++j) {
-      mcSurfaceNode *node;
-      node = mcSurfaceNet_getNode(&surfaceNet, j);
-      node->oldPos = node->pos;
-    }
+    mcSurfaceNet_updateOldPos(&surfaceNet);
     /* Iterate over the surface net */
     for (int j = 0; j < surfaceNet.numNodes; ++j) {
-      mcSurfaceNode *node;
+      const int32_t *neighbors = &surfaceNet.neighbors[j * 6];
+      const unsigned int *latticePos = &surfaceNet.latticePos[j * 3];
+      const mcVec3 *oldPos = surfaceNet.oldPos;
       mcVec3 midPoint, newPos;
       int numNeighbors;
-      node = mcSurfaceNet_getNode(&surfaceNet, j);
       /* TODO: Relax the position of surface nodes to reduce energy between
        * neighboring nodes */
       /* Compute a point equidistant among neighbor positions */
       numNeighbors = 0;
+      midPoint.x = midPoint.y = midPoint.z = 0.0f;
       for (int k = 0; k < 6; ++k) {
-        if (node->neighbors[k] == NULL)
+        if (neighbors[k] == MC_SURFACE_NET_NO_NEIGHBOR)
           continue;
         numNeighbors += 1;
-        midPoint.x += node->neighbors[k]->oldPos.x;
-        midPoint.y += node->neighbors[k]->oldPos.y;
-        midPoint.z += node->neighbors[k]->oldPos.z;
+        midPoint.x += oldPos[neighbors[k]].x;
+        midPoint.y += oldPos[neighbors[k]].y;
+        midPoint.z += oldPos[neighbors[k]].z;
       }
       if (numNeighbors > 0) {
         midPoint.x /= (float)numNeighbors;
@@ -168,40 +86,38 @@ void mcSurfaceNet_isosurfaceFromField(
         midPoint.z /= (float)numNeighbors;
         /* TODO: Weight the midpoint into the new position */
         const float WEIGHT = 1.0f;
-        newPos.x = (1.0f - WEIGHT) * node->pos.x + WEIGHT * midPoint.x;
-        newPos.y = (1.0f - WEIGHT) * node->pos.y + WEIGHT * midPoint.y;
-        newPos.z = (1.0f - WEIGHT) * node->pos.z + WEIGHT * midPoint.z;
+        newPos.x = (1.0f - WEIGHT) * surfaceNet.pos[j].x + WEIGHT * midPoint.x;
+        newPos.y = (1.0f - WEIGHT) * surfaceNet.pos[j].y + WEIGHT * midPoint.y;
+        newPos.z = (1.0f - WEIGHT) * surfaceNet.pos[j].z + WEIGHT * midPoint.z;
         /* Restrict the new position to within the voxel cube */
         newPos.x = max(newPos.x,
-            min->x + (float)node->latticePos[0] * delta_x);
+            min->x + (float)latticePos[0] * delta_x);
         newPos.x = min(newPos.x,
-            min->x + (float)(node->latticePos[0] + 1) * delta_x);
+            min->x + (float)(latticePos[0] + 1) * delta_x);
         newPos.y = max(newPos.y,
-            min->y + (float)node->latticePos[1] * delta_y);
+            min->y + (float)latticePos[1] * delta_y);
         newPos.y = min(newPos.y,
-            min->y + (float)(node->latticePos[1] + 1) * delta_y);
+            min->y + (float)(latticePos[1] + 1) * delta_y);
         newPos.z = max(newPos.z,
-            min->z + (float)node->latticePos[2] * delta_z);
+            min->z + (float)latticePos[2] * delta_z);
         newPos.z = min(newPos.z,
-            min->z + (float)(node->latticePos[2] + 1) * delta_z);
+            min->z + (float)(latticePos[2] + 1) * delta_z);
         /* Compute old and new energy as sum of squared distance to neighbors */
         float oldEnergy, newEnergy;
         oldEnergy = newEnergy = 0.0f;
         for (int k = 0; k < 6; ++k) {
-          if (node->neighbors[k] == NULL)
+          if (neighbors[k] == MC_SURFACE_NET_NO_NEIGHBOR)
             continue;
-          oldEnergy += squared(node->neighbors[k]->oldPos.x - node->oldPos.x)
-            + squared(node->neighbors[k]->oldPos.y - node->oldPos.y)
-            + squared(node->neighbors[k]->oldPos.z - node->oldPos.z);
-          newEnergy += squared(node->neighbors[k]->oldPos.x - newPos.x)
-            + squared(node->neighbors[k]->oldPos.y - newPos.y)
-            + squared(node->neighbors[k]->oldPos.z - newPos.z);
+          oldEnergy += squared(oldPos[neighbors[k]].x - oldPos[j].x)
+            + squared(oldPos[neighbors[k]].y - oldPos[j].y)
+            + squared(oldPos[neighbors[k]].z - oldPos[j].z);
+          newEnergy += squared(oldPos[neighbors[k]].x - newPos.x)
+            + squared(oldPos[neighbors[k]].y - newPos.y)
+            + squared(oldPos[neighbors[k]].z - newPos.z);
         }
-        fprintf(stderr, "oldEnergy: %g, newEnergy: %g\n",
-            oldEnergy, newEnergy);
         if (newEnergy < oldEnergy) {
           /* Set the new surface node position */
-          node->pos = newPos;
+          surfaceNet.pos[j] = newPos;
         }
       }
     }
@@ -210,28 +126,33 @@ void mcSurfaceNet_isosurfaceFromField(
    * vertices */
   /* Iterate over the surface net */
   for (int i = 0; i < surfaceNet.numNodes; ++i) {
-    mcSurfaceNode *node;
     mcVertex vertex;
-    node = mcSurfaceNet_getNode(&surfaceNet, i);
-    vertex.pos = node->pos;
+    vertex.pos = surfaceNet.pos[i];
     /* TODO: Calculate the vertex normal */
     /* Add the vertex for this node to the mesh */
-    node->vertexIndex = mcMesh_addVertex(mesh, &vertex);
+    surfaceNet.vertexIndices[i] = mcMesh_addVertex(mesh, &vertex);
   }
   /* TODO: With the surface net optimized, we now generate triangles from it */
   /* TODO: Initialize the placeholder triangle */
   mcFace_init(&triangle, 3);
   /* TODO: Iterate over the surface net */
   for (int i = 0; i < surfaceNet.numNodes; ++i) {
-    mcSurfaceNode *node, *leftNeighbor, *rightNeighbor, *topNeighbor,
-                  *bottomNeighbor, *frontNeighbor, *backNeighbor;
-    node = mcSurfaceNet_getNode(&surfaceNet, i);
-    leftNeighbor = node->neighbors[MC_SURFACE_NODE_LEFT];
-    rightNeighbor = node->neighbors[MC_SURFACE_NODE_RIGHT];
-    topNeighbor = node->neighbors[MC_SURFACE_NODE_TOP];
-    bottomNeighbor = node->neighbors[MC_SURFACE_NODE_BOTTOM];
-    frontNeighbor = node->neighbors[MC_SURFACE_NODE_FRONT];
-    backNeighbor = node->neighbors[MC_SURFACE_NODE_BACK];
+    const int32_t *neighbors = &surfaceNet.neighbors[i * 6];
+    const unsigned int *vertexIndices = surfaceNet.vertexIndices;
+    int32_t leftNeighbor, rightNeighbor, topNeighbor,
+            bottomNeighbor, frontNeighbor, backNeighbor;
+    /* NOTE: mcSurfaceNet_build() links the previous voxel along the x-axis
+     * as the RIGHT neighbor (the convention the elastic surface net relies
+     * on), whereas this algorithm has always treated it as the LEFT neighbor.
+     * We swap the two here so that the triangle pairs chosen below, and hence
+     * the generated mesh, are unchanged. */
+    leftNeighbor = neighbors[MC_SURFACE_NODE_RIGHT];
+    rightNeighbor = neighbors[MC_SURFACE_NODE_LEFT];
+    topNeighbor = neighbors[MC_SURFACE_NODE_TOP];
+    bottomNeighbor = neighbors[MC_SURFACE_NODE_BOTTOM];
+    frontNeighbor = neighbors[MC_SURFACE_NODE_FRONT];
+    backNeighbor = neighbors[MC_SURFACE_NODE_BACK];
+#define HAS(neighbor) ((neighbor) != MC_SURFACE_NET_NO_NEIGHBOR)
     /* Generate triangles, taking care not to generate any redundant
      * triangles */
     /* FIXME: Mind the winding order of triangle */
@@ -239,90 +160,46 @@ void mcSurfaceNet_isosurfaceFromField(
      * choose arbitrarily which triangle pairs to generate. */
     /* Look for pairs of neighbors with which we can create triangles */
     /* LEFT+FRONT and BACK+RIGHT or LEFT+BACK and FRONT+RIGHT */
-    if (leftNeighbor && frontNeighbor) {
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = leftNeighbor->vertexIndex;
-      triangle.indices[2] = frontNeighbor->vertexIndex;
-      mcMesh_addFace(mesh, &triangle);
-    }
-    if (backNeighbor && rightNeighbor) {
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = backNeighbor->vertexIndex;
-      triangle.indices[2] = rightNeighbor->vertexIndex;
+    if (HAS(leftNeighbor) && HAS(frontNeighbor)) {
+      triangle.indices[0] = vertexIndices[i];
+      triangle.indices[1] = vertexIndices[leftNeighbor];
+      triangle.indices[2] = vertexIndices[frontNeighbor];
       mcMesh_addFace(mesh, &triangle);
     }
-    /*
-    if (leftNeighbor && backNeighbor) {
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = leftNeighbor->vertexIndex;
-      triangle.indices[2] = backNeighbor->vertexIndex;
+    if (HAS(backNeighbor) && HAS(rightNeighbor)) {
+      triangle.indices[0] = vertexIndices[i];
+      triangle.indices[1] = vertexIndices[backNeighbor];
+      triangle.indices[2] = vertexIndices[rightNeighbor];
       mcMesh_addFace(mesh, &triangle);
     }
-    if (frontNeighbor && rightNeighbor) {
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = frontNeighbor->vertexIndex;
-      triangle.indices[2] = rightNeighbor->vertexIndex;
-      mcMesh_addFace(mesh, &triangle);
-    }
-    */
     /* FRONT+TOP and BOTTOM+BACK or FRONT+BOTTOM and TOP+BACK */
-    if (frontNeighbor && topNeighbor) {
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = frontNeighbor->vertexIndex;
-      triangle.indices[2] = topNeighbor->vertexIndex;
-      mcMesh_addFace(mesh, &triangle);
-    }
-    if (bottomNeighbor && backNeighbor) {
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = bottomNeighbor->vertexIndex;
-      triangle.indices[2] = backNeighbor->vertexIndex;
-      mcMesh_addFace(mesh, &triangle);
-    }
-    /*
-    if (frontNeighbor && bottomNeighbor) {
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = frontNeighbor->vertexIndex;
-      triangle.indices[2] = bottomNeighbor->vertexIndex;
+    if (HAS(frontNeighbor) && HAS(topNeighbor)) {
+      triangle.indices[0] = vertexIndices[i];
+      triangle.indices[1] = vertexIndices[frontNeighbor];
+      triangle.indices[2] = vertexIndices[topNeighbor];
       mcMesh_addFace(mesh, &triangle);
     }
-    if (topNeighbor && backNeighbor) {
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = topNeighbor->vertexIndex;
-      triangle.indices[2] = backNeighbor->vertexIndex;
+    if (HAS(bottomNeighbor) && HAS(backNeighbor)) {
+      triangle.indices[0] = vertexIndices[i];
+      triangle.indices[1] = vertexIndices[bottomNeighbor];
+      triangle.indices[2] = vertexIndices[backNeighbor];
       mcMesh_addFace(mesh, &triangle);
     }
-    */
     /* LEFT+TOP and BOTTOM+RIGHT or LEFT+BOTTOM and TOP+RIGHT */
-    if (leftNeighbor && topNeighbor) {
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = leftNeighbor->vertexIndex;
-      triangle.indices[2] = topNeighbor->vertexIndex;
-      mcMesh_addFace(mesh, &triangle);
-    }
-    if (bottomNeighbor && rightNeighbor) {
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = bottomNeighbor->vertexIndex;
-      triangle.indices[2] = rightNeighbor->vertexIndex;
-      mcMesh_addFace(mesh, &triangle);
-    }
-    /*
-    if (leftNeighbor && bottomNeighbor) {
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = leftNeighbor->vertexIndex;
-      triangle.indices[2] = bottomNeighbor->vertexIndex;
+    if (HAS(leftNeighbor) && HAS(topNeighbor)) {
+      triangle.indices[0] = vertexIndices[i];
+      triangle.indices[1] = vertexIndices[leftNeighbor];
+      triangle.indices[2] = vertexIndices[topNeighbor];
       mcMesh_addFace(mesh, &triangle);
     }
-    if (topNeighbor && rightNeighbor) {
-      triangle.indices[0] = node->vertexIndex;
-      triangle.indices[1] = topNeighbor->vertexIndex;
-      triangle.indices[2] = rightNeighbor->vertexIndex;
+    if (HAS(bottomNeighbor) && HAS(rightNeighbor)) {
+      triangle.indices[0] = vertexIndices[i];
+      triangle.indices[1] = vertexIndices[bottomNeighbor];
+      triangle.indices[2] = vertexIndices[rightNeighbor];
       mcMesh_addFace(mesh, &triangle);
     }
-    */
+#undef HAS
   }
-  /* Free node buffers */
-  free(prevLine);
-  free(prevSlice);
   /* Destroy the surface net, freeing all memory */
   mcSurfaceNet_destroy(&surfaceNet);
   /* Destroy the triangle */
@@ -26,6 +26,7 @@
 #include <stdio.h>
 
 #include <mc/algorithms/common/cube.h>
+#include <mc/algorithms/common/sampleSlices.h>
 #include <mc/algorithms/simple/simple_tables.h>
 #include <mc/algorithms/transvoxel/edges.h>
 #include <mc/algorithms/transvoxel/transform.h>
@@ -198,8 +199,11 @@ void mcTransvoxel_isosurfaceFromField(
   float delta_z = fabs(max->z - min->z) / (float)(z_res - 1);
   mcFace triangle;
   mcFace_init(&triangle, 3);
+  mcSampleSlices slices;
+  mcSampleSlices_init(&slices, sf, args, x_res, y_res, z_res, min, max);
   // Iterate through the sample lattice
   for (int z = 0; z < z_res - 1; ++z) {
+    mcSampleSlices_advance(&slices);
     for (int y = 0; y < y_res - 1; ++y) {
       for (int x = 0; x < x_res - 1; ++x) {
         /* Determine the cell configuration index by iterating over the eight
@@ -210,12 +214,8 @@ void mcTransvoxel_isosurfaceFromField(
           unsigned int i;
           /* Determine this sample's relative position in the cell */
           mcCube_sampleRelativePosition(sampleIndex, pos);
-          /* TODO: Retrive the sample value from a buffer rather than computing
-           * it every time */
-          float sampleValue = sf(min->x + (float)(x + pos[0]) * delta_x,
-                                 min->y + (float)(y + pos[1]) * delta_y,
-                                 min->z + (float)(z + pos[2]) * delta_z,
-                                 args);
+          float sampleValue = mcSampleSlices_value(&slices,
+              x + pos[0], y + pos[1], pos[2]);
           /* Add the bit this sample contributes to the cell */
           cell |= (sampleValue >= 0.0f ? 0 : 1) << sampleIndex;
         }
@@ -255,12 +255,8 @@ void mcTransvoxel_isosurfaceFromField(
                 latticePos[i].x = (float)(abs[0]) * delta_x;
                 latticePos[i].y = (float)(abs[1]) * delta_y;
                 latticePos[i].z = (float)(abs[2]) * delta_z;
-                /* TODO: Retrieve this sample value from a buffer */
-                values[i] = sf(
-                    min->x + latticePos[i].x,
-                    min->y + latticePos[i].y,
-                    min->z + latticePos[i].z,
-                    args);
+                values[i] = mcSampleSlices_value(&slices,
+                    abs[0], abs[1], rel[2]);
               }
               /* Interpolate between the sample values at each vertex */
               float weight = fabs(values[0] / (values[0] - values[1]));
@@ -297,5 +293,6 @@ void mcTransvoxel_isosurfaceFromField(
       }
     }
   }
+  mcSampleSlices_destroy(&slices);
   mcFace_destroy(&triangle);
 }
@@ -21,6 +21,7 @@
  * IN THE SOFTWARE.
  */
 
+#include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -28,18 +29,56 @@
 
 #define MC_CONTOUR_INIT_SIZE_VERTICES 16
 #define MC_CONTOUR_INIT_SIZE_LINES 8
+#define MC_CONTOUR_INIT_SIZE_POLYLINES 4
 
 void mcContour_init(mcContour *self) {
+  mcContour_initWithFormat(self, MC_CONTOUR_LINES);
+}
+
+void mcContour_initWithFormat(mcContour *self, mcContourFormat format) {
+  self->format = format;
   self->numVertices = 0;
   self->numLines = 0;
   self->sizeVertices = MC_CONTOUR_INIT_SIZE_VERTICES;
   self->vertices = (mcVertex*)malloc(sizeof(mcVertex) * self->sizeVertices);
-  self->sizeLines = MC_CONTOUR_INIT_SIZE_LINES;
-  self->lines = (mcLine*)malloc(sizeof(mcLine) * self->sizeLines);
+  self->lines = NULL;
+  self->sizeLines = 0;
+  self->polylineOffsets = NULL;
+  self->polylineIndices = NULL;
+  self->numPolylines = 0;
+  self->numPolylineIndices = 0;
+  self->sizePolylineOffsets = 0;
+  self->sizePolylineIndices = 0;
+  self->links = NULL;
+  self->sizeLinks = 0;
+  switch (format) {
+    case MC_CONTOUR_LINES:
+      self->sizeLines = MC_CONTOUR_INIT_SIZE_LINES;
+      self->lines = (mcLine*)malloc(sizeof(mcLine) * self->sizeLines);
+      break;
+    case MC_CONTOUR_POLYLINES:
+      /* Polylines are chained through per-vertex links while the contour is
+       * being extracted, so we do not need to store the lines themselves */
+      self->sizeLinks = 2 * self->sizeVertices;
+      self->links = (int*)malloc(sizeof(int) * self->sizeLinks);
+      self->sizePolylineOffsets = MC_CONTOUR_INIT_SIZE_POLYLINES + 1;
+      self->polylineOffsets =
+        (int*)malloc(sizeof(int) * self->sizePolylineOffsets);
+      self->polylineOffsets[0] = 0;
+      self->sizePolylineIndices = MC_CONTOUR_INIT_SIZE_VERTICES;
+      self->polylineIndices =
+        (int*)malloc(sizeof(int) * self->sizePolylineIndices);
+      break;
+    default:
+      assert(0);
+  }
 }
 
 void mcContour_destroy(mcContour *self) {
   /* Free the contour data structures */
+  free(self->links);
+  free(self->polylineIndices);
+  free(self->polylineOffsets);
   free(self->lines);
   free(self->vertices);
 }
@@ -64,17 +103,56 @@ void mcContour_growLines(mcContour *self) {
   self->sizeLines *= 2;
 }
 
+void mcContour_growIndices(int **indices, int *size) {
+  /* Double the size of the given index buffer */
+  int *newIndices = (int*)malloc(sizeof(int) * *size * 2);
+  memcpy(newIndices, *indices, sizeof(int) * *size);
+  free(*indices);
+  *indices = newIndices;
+  *size *= 2;
+}
+
 int mcContour_addVertex(mcContour *self, const mcVertex *vertex) {
   /* Make sure we have enough memory allocated for this vertex */
   if (self->numVertices >= self->sizeVertices) {
     mcContour_growVertices(self);
   }
+  if (self->format == MC_CONTOUR_POLYLINES) {
+    /* Vertices cannot be added once the polylines have been assembled */
+    assert(self->links != NULL);
+    /* New vertices are not linked to any other vertices */
+    if (2 * self->numVertices >= self->sizeLinks) {
+      mcContour_growIndices(&self->links, &self->sizeLinks);
+    }
+    self->links[2 * self->numVertices] = -1;
+    self->links[2 * self->numVertices + 1] = -1;
+  }
   /* Add the vertex and increment the vertex index */
   self->vertices[self->numVertices++] = *vertex;
   return self->numVertices - 1;
 }
 
+int mcContour_freeLinkSlot(mcContour *self, int vertex) {
+  if (self->links[2 * vertex] == -1)
+    return 2 * vertex;
+  if (self->links[2 * vertex + 1] == -1)
+    return 2 * vertex + 1;
+  /* More than two segments meet at this vertex, so it cannot be part of a
+   * single polyline. We split the polylines here by duplicating the vertex. */
+  mcVertex copy = self->vertices[vertex];
+  return 2 * mcContour_addVertex(self, &copy);
+}
+
 void mcContour_addLine(mcContour *self, const mcLine *line) {
+  if (self->format == MC_CONTOUR_POLYLINES) {
+    assert(self->links != NULL);
+    /* Link the two vertices of this line together */
+    int a = mcContour_freeLinkSlot(self, line->a);
+    int b = mcContour_freeLinkSlot(self, line->b);
+    self->links[a] = b / 2;
+    self->links[b] = a / 2;
+    return;
+  }
   /* Make sure that we have enough memory allocated for this line */
   if (self->numLines >= self->sizeLines) {
     mcContour_growLines(self);
@@ -82,3 +160,63 @@ void mcContour_addLine(mcContour *self, const mcLine *line) {
   /* Add the line and increment the lines index */
   self->lines[self->numLines++] = *line;
 }
+
+void mcContour_addPolylineIndex(mcContour *self, int index) {
+  if (self->numPolylineIndices >= self->sizePolylineIndices) {
+    mcContour_growIndices(&self->polylineIndices, &self->sizePolylineIndices);
+  }
+  self->polylineIndices[self->numPolylineIndices++] = index;
+}
+
+void mcContour_walkPolyline(mcContour *self, int start, char *visited) {
+  int prev = -1, current = start;
+  while (1) {
+    visited[current] = 1;
+    mcContour_addPolylineIndex(self, current);
+    /* Follow the link that does not lead back to where we came from */
+    int next = self->links[2 * current];
+    if (next == prev)
+      next = self->links[2 * current + 1];
+    if (next == -1)
+      break;  /* Reached the end of an open polyline */
+    if (next == start) {
+      /* Close the loop by repeating the first vertex */
+      mcContour_addPolylineIndex(self, start);
+      break;
+    }
+    prev = current;
+    current = next;
+  }
+  /* Terminate this polyline in the offsets array */
+  if (self->numPolylines + 1 >= self->sizePolylineOffsets) {
+    mcContour_growIndices(&self->polylineOffsets, &self->sizePolylineOffsets);
+  }
+  self->polylineOffsets[++self->numPolylines] = self->numPolylineIndices;
+}
+
+void mcContour_assemblePolylines(mcContour *self) {
+  assert(self->format == MC_CONTOUR_POLYLINES);
+  assert(self->links != NULL);
+  self->numPolylines = 0;
+  self->numPolylineIndices = 0;
+  char *visited = (char*)calloc(self->numVertices, sizeof(char));
+  /* Open polylines start and end at vertices with only one neighbor */
+  for (int i = 0; i < self->numVertices; ++i) {
+    if (visited[i] || self->links[2 * i] == -1)
+      continue;
+    if (self->links[2 * i + 1] == -1)
+      mcContour_walkPolyline(self, i, visited);
+  }
+  /* All remaining linked vertices belong to closed loops */
+  for (int i = 0; i < self->numVertices; ++i) {
+    if (visited[i] || self->links[2 * i] == -1)
+      continue;
+    mcContour_walkPolyline(self, i, visited);
+  }
+  free(visited);
+  /* The links are only needed for chaining, so release them rather than
+   * keeping them alongside the polyline arrays */
+  free(self->links);
+  self->links = NULL;
+  self->sizeLinks = 0;
+}
@@ -0,0 +1,649 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mc/decimation.h>
+
+/* Relative weight of the planes that hold unlocked boundary edges in place */
+#define MC_DECIMATION_BOUNDARY_WEIGHT 10.0
+/* Collapses that turn a triangle's normal by more than about 80 degrees are
+ * rejected */
+#define MC_DECIMATION_MIN_NORMAL_COSINE 0.2f
+
+#define MC_DECIMATION_BOUNDARY (1 << 0)
+#define MC_DECIMATION_LOCKED (1 << 1)
+#define MC_DECIMATION_REMOVED (1 << 2)
+
+/**
+ * A quadric error metric, storing the symmetric 4x4 matrix sum of p p^T for
+ * each plane p = (a, b, c, d) as its upper triangle aa, ab, ac, ad, bb, bc,
+ * bd, cc, cd, dd.
+ */
+typedef struct mcDecimationQuadric {
+  double q[10];
+} mcDecimationQuadric;
+
+/**
+ * A candidate edge collapse that merges vertex \p from into vertex \p to and
+ * moves \p to to \p pos. The collapse is stale if the version of either
+ * vertex has changed since the collapse was evaluated.
+ */
+typedef struct mcDecimationCollapse {
+  float cost;
+  unsigned int from, to;
+  unsigned int fromVersion, toVersion;
+  mcVec3 pos;
+} mcDecimationCollapse;
+
+/**
+ * The working state of the decimation, kept entirely in flat arrays. Each
+ * triangle corner c (vertex indices[c] of triangle c / 3) is linked into a
+ * list of the corners of its vertex through next[c]. When an edge is
+ * collapsed, the corner list of the removed vertex is spliced onto the list
+ * of the kept vertex; corners of removed triangles are skipped lazily.
+ */
+typedef struct mcDecimationMesh {
+  mcVec3 *positions, *normals;
+  mcDecimationQuadric *quadrics;
+  unsigned int *versions, *marks;
+  unsigned char *flags;
+  int *heads;
+  unsigned int numVertices, mark;
+  unsigned int *indices;
+  int *next;
+  unsigned char *removed;
+  unsigned int numTriangles, numLiveTriangles;
+  mcDecimationCollapse *heap;
+  unsigned int heapSize, heapCapacity;
+} mcDecimationMesh;
+
+typedef struct mcDecimationEdge {
+  uint64_t key;
+  unsigned int triangle;
+} mcDecimationEdge;
+
+void mcDecimationParams_default(mcDecimationParams *params) {
+  params->targetNumFaces = 0;
+  params->maxError = 1.0e-6f;
+  params->lockBoundary = 1;
+}
+
+void mcDecimation_addPlane(mcDecimationQuadric *quadric,
+    double a, double b, double c, double d, double weight)
+{
+  double *q = quadric->q;
+  q[0] += weight * a * a;
+  q[1] += weight * a * b;
+  q[2] += weight * a * c;
+  q[3] += weight * a * d;
+  q[4] += weight * b * b;
+  q[5] += weight * b * c;
+  q[6] += weight * b * d;
+  q[7] += weight * c * c;
+  q[8] += weight * c * d;
+  q[9] += weight * d * d;
+}
+
+double mcDecimation_quadricError(const mcDecimationQuadric *quadric,
+    const mcVec3 *pos)
+{
+  const double *q = quadric->q;
+  double x = pos->x, y = pos->y, z = pos->z;
+  double error = q[0] * x * x + q[4] * y * y + q[7] * z * z
+    + 2.0 * (q[1] * x * y + q[2] * x * z + q[5] * y * z)
+    + 2.0 * (q[3] * x + q[6] * y + q[8] * z)
+    + q[9];
+  return error > 0.0 ? error : 0.0;
+}
+
+/**
+ * Finds the position minimizing the given quadric. Returns zero if the
+ * quadric does not determine a unique position, such as for a flat surface.
+ */
+int mcDecimation_optimalPosition(const mcDecimationQuadric *quadric,
+    mcVec3 *pos)
+{
+  const double *q = quadric->q;
+  /* Cofactors of the symmetric 3x3 system */
+  double c00 = q[4] * q[7] - q[5] * q[5];
+  double c01 = q[2] * q[5] - q[1] * q[7];
+  double c02 = q[1] * q[5] - q[2] * q[4];
+  double c11 = q[0] * q[7] - q[2] * q[2];
+  double c12 = q[1] * q[2] - q[0] * q[5];
+  double c22 = q[0] * q[4] - q[1] * q[1];
+  double det = q[0] * c00 + q[1] * c01 + q[2] * c02;
+  double trace = (q[0] + q[4] + q[7]) / 3.0;
+  if (fabs(det) <= 1.0e-3 * trace * trace * trace || det == 0.0)
+    return 0;
+  pos->x = -(c00 * q[3] + c01 * q[6] + c02 * q[8]) / det;
+  pos->y = -(c01 * q[3] + c11 * q[6] + c12 * q[8]) / det;
+  pos->z = -(c02 * q[3] + c12 * q[6] + c22 * q[8]) / det;
+  return 1;
+}
+
+void mcDecimation_push(mcDecimationMesh *self,
+    const mcDecimationCollapse *collapse)
+{
+  if (self->heapSize >= self->heapCapacity) {
+    /* Double the size of the heap */
+    mcDecimationCollapse *newHeap = (mcDecimationCollapse*)malloc(
+        sizeof(mcDecimationCollapse) * self->heapCapacity * 2);
+    memcpy(newHeap, self->heap,
+        sizeof(mcDecimationCollapse) * self->heapSize);
+    free(self->heap);
+    self->heap = newHeap;
+    self->heapCapacity *= 2;
+  }
+  /* Sift the new collapse up */
+  unsigned int i = self->heapSize++;
+  while (i > 0) {
+    unsigned int parent = (i - 1) / 2;
+    if (self->heap[parent].cost <= collapse->cost)
+      break;
+    self->heap[i] = self->heap[parent];
+    i = parent;
+  }
+  self->heap[i] = *collapse;
+}
+
+void mcDecimation_pop(mcDecimationMesh *self, mcDecimationCollapse *collapse)
+{
+  assert(self->heapSize > 0);
+  *collapse = self->heap[0];
+  mcDecimationCollapse last = self->heap[--self->heapSize];
+  /* Sift the last collapse down from the top */
+  unsigned int i = 0;
+  for (;;) {
+    unsigned int child = 2 * i + 1;
+    if (child >= self->heapSize)
+      break;
+    if (child + 1 < self->heapSize
+        && self->heap[child + 1].cost < self->heap[child].cost)
+      child += 1;
+    if (last.cost <= self->heap[child].cost)
+      break;
+    self->heap[i] = self->heap[child];
+    i = child;
+  }
+  if (self->heapSize > 0)
+    self->heap[i] = last;
+}
+
+/**
+ * Evaluates the cost of collapsing the edge between vertices \p a and \p b
+ * and pushes the collapse onto the heap, unless both vertices are locked.
+ */
+void mcDecimation_pushEdge(mcDecimationMesh *self,
+    unsigned int a, unsigned int b)
+{
+  mcDecimationCollapse collapse;
+  mcDecimationQuadric quadric;
+  int lockedA = self->flags[a] & MC_DECIMATION_LOCKED;
+  int lockedB = self->flags[b] & MC_DECIMATION_LOCKED;
+  if (lockedA && lockedB)
+    return;
+  /* Keep the locked vertex, or else the boundary vertex */
+  if (lockedA || (!lockedB && (self->flags[a] & MC_DECIMATION_BOUNDARY))) {
+    collapse.to = a;
+    collapse.from = b;
+  } else {
+    collapse.to = b;
+    collapse.from = a;
+  }
+  for (int i = 0; i < 10; ++i) {
+    quadric.q[i] = self->quadrics[a].q[i] + self->quadrics[b].q[i];
+  }
+  if (lockedA || lockedB) {
+    collapse.pos = self->positions[collapse.to];
+  } else {
+    /* Try the optimal position, falling back on the best of the endpoints
+     * and the midpoint of the edge */
+    const mcVec3 *pa = &self->positions[a], *pb = &self->positions[b];
+    mcVec3 candidates[3], edge, offset;
+    double best = DBL_MAX;
+    mcVec3_subtract(pb, pa, &edge);
+    candidates[0] = self->positions[collapse.to];
+    candidates[1] = self->positions[collapse.from];
+    candidates[2] = mcVec3_lerp(pa, pb, 0.5f);
+    if (mcDecimation_optimalPosition(&quadric, &collapse.pos)) {
+      mcVec3_subtract(&collapse.pos, &candidates[2], &offset);
+      /* Distrust solutions far from the edge */
+      if (mcVec3_dot(&offset, &offset) <= mcVec3_dot(&edge, &edge))
+        best = mcDecimation_quadricError(&quadric, &collapse.pos);
+    }
+    for (int i = 0; i < 3; ++i) {
+      double error = mcDecimation_quadricError(&quadric, &candidates[i]);
+      if (error < best) {
+        best = error;
+        collapse.pos = candidates[i];
+      }
+    }
+  }
+  collapse.cost = (float)mcDecimation_quadricError(&quadric, &collapse.pos);
+  collapse.fromVersion = self->versions[collapse.from];
+  collapse.toVersion = self->versions[collapse.to];
+  mcDecimation_push(self, &collapse);
+}
+
+/**
+ * Returns the normal of the given triangle (scaled by twice its area), with
+ * vertex \p moved optionally replaced by the position \p pos.
+ */
+mcVec3 mcDecimation_triangleNormal(const mcDecimationMesh *self,
+    unsigned int triangle, unsigned int moved, const mcVec3 *pos)
+{
+  mcVec3 p[3], u, v, normal;
+  for (int i = 0; i < 3; ++i) {
+    unsigned int vertex = self->indices[triangle * 3 + i];
+    p[i] = (pos != NULL && vertex == moved) ? *pos : self->positions[vertex];
+  }
+  mcVec3_subtract(&p[1], &p[0], &u);
+  mcVec3_subtract(&p[2], &p[0], &v);
+  mcVec3_cross(&u, &v, &normal);
+  return normal;
+}
+
+/**
+ * Returns nonzero if the triangle of corner \p c contains vertex \p vertex.
+ */
+static inline int mcDecimation_triangleHasVertex(const mcDecimationMesh *self,
+    int c, unsigned int vertex)
+{
+  const unsigned int *t = &self->indices[(c / 3) * 3];
+  return t[0] == vertex || t[1] == vertex || t[2] == vertex;
+}
+
+/**
+ * Returns nonzero if the given triangles around \p moved keep their
+ * orientation when \p moved is placed at \p pos. Triangles that also contain
+ * \p other are removed by the collapse and are not checked.
+ */
+int mcDecimation_keepsOrientation(const mcDecimationMesh *self,
+    unsigned int moved, unsigned int other, const mcVec3 *pos)
+{
+  for (int c = self->heads[moved]; c != -1; c = self->next[c]) {
+    if (self->removed[c / 3] || mcDecimation_triangleHasVertex(self, c, other))
+      continue;
+    mcVec3 before = mcDecimation_triangleNormal(self, c / 3, moved, NULL);
+    mcVec3 after = mcDecimation_triangleNormal(self, c / 3, moved, pos);
+    float lengths = mcVec3_length(&before) * mcVec3_length(&after);
+    if (lengths == 0.0f || mcVec3_dot(&before, &after)
+        < MC_DECIMATION_MIN_NORMAL_COSINE * lengths)
+      return 0;
+  }
+  return 1;
+}
+
+/**
+ * Returns nonzero if the given collapse keeps the mesh manifold and does not
+ * fold any of the triangles around the collapsed edge.
+ */
+int mcDecimation_isCollapseValid(mcDecimationMesh *self,
+    const mcDecimationCollapse *collapse)
+{
+  unsigned int from = collapse->from, to = collapse->to;
+  unsigned int numShared = 0, numCommon = 0;
+  self->mark += 2;
+  /* Mark the neighbors of the kept vertex and count the triangles that share
+   * the edge */
+  for (int c = self->heads[to]; c != -1; c = self->next[c]) {
+    if (self->removed[c / 3])
+      continue;
+    for (int i = 0; i < 3; ++i)
+      self->marks[self->indices[(c / 3) * 3 + i]] = self->mark;
+    if (mcDecimation_triangleHasVertex(self, c, from))
+      numShared += 1;
+  }
+  if (numShared == 0 || numShared > 2)
+    return 0;
+  /* The link condition: the two vertices may only share the neighbors
+   * opposite the collapsed edge */
+  for (int c = self->heads[from]; c != -1; c = self->next[c]) {
+    if (self->removed[c / 3])
+      continue;
+    for (int i = 0; i < 3; ++i) {
+      unsigned int vertex = self->indices[(c / 3) * 3 + i];
+      if (vertex == from || vertex == to || self->marks[vertex] != self->mark)
+        continue;
+      self->marks[vertex] = self->mark + 1;  /* Count each neighbor once */
+      numCommon += 1;
+    }
+  }
+  if (numCommon != numShared)
+    return 0;
+  /* Joining two boundary vertices through the interior would pinch the
+   * surface */
+  if ((self->flags[from] & MC_DECIMATION_BOUNDARY)
+      && (self->flags[to] & MC_DECIMATION_BOUNDARY) && numShared != 1)
+    return 0;
+  return mcDecimation_keepsOrientation(self, from, to, &collapse->pos)
+    && mcDecimation_keepsOrientation(self, to, from, &collapse->pos);
+}
+
+void mcDecimation_applyCollapse(mcDecimationMesh *self,
+    const mcDecimationCollapse *collapse)
+{
+  unsigned int from = collapse->from, to = collapse->to;
+  int last = -1;
+  /* Remove the triangles on the edge and move the remaining corners of the
+   * removed vertex to the kept vertex */
+  for (int c = self->heads[from]; c != -1; c = self->next[c]) {
+    last = c;
+    if (self->removed[c / 3])
+      continue;
+    if (mcDecimation_triangleHasVertex(self, c, to)) {
+      self->removed[c / 3] = 1;
+      self->numLiveTriangles -= 1;
+    } else {
+      self->indices[c] = to;
+    }
+  }
+  if (last != -1) {
+    self->next[last] = self->heads[to];
+    self->heads[to] = self->heads[from];
+    self->heads[from] = -1;
+  }
+  for (int i = 0; i < 10; ++i)
+    self->quadrics[to].q[i] += self->quadrics[from].q[i];
+  self->positions[to] = collapse->pos;
+  mcVec3_add(&self->normals[to], &self->normals[from], &self->normals[to]);
+  if (mcVec3_length(&self->normals[to]) > 0.0f)
+    mcVec3_normalize(&self->normals[to], &self->normals[to]);
+  self->flags[to] |= self->flags[from] & MC_DECIMATION_BOUNDARY;
+  self->flags[from] |= MC_DECIMATION_REMOVED;
+  self->versions[from] += 1;
+  self->versions[to] += 1;
+  /* Re-evaluate the edges around the kept vertex */
+  self->mark += 2;
+  self->marks[to] = self->mark;
+  for (int c = self->heads[to]; c != -1; c = self->next[c]) {
+    if (self->removed[c / 3])
+      continue;
+    for (int i = 0; i < 3; ++i) {
+      unsigned int vertex = self->indices[(c / 3) * 3 + i];
+      if (self->marks[vertex] == self->mark)
+        continue;
+      self->marks[vertex] = self->mark;
+      mcDecimation_pushEdge(self, to, vertex);
+    }
+  }
+}
+
+static inline uint32_t mcDecimation_hashPosition(const mcVec3 *pos) {
+  uint32_t bits[3], hash = 2166136261u;
+  memcpy(bits, &pos->x, sizeof(uint32_t));
+  memcpy(bits + 1, &pos->y, sizeof(uint32_t));
+  memcpy(bits + 2, &pos->z, sizeof(uint32_t));
+  for (int i = 0; i < 3; ++i)
+    hash = (hash ^ bits[i]) * 16777619u;
+  return hash;
+}
+
+/**
+ * Merges the vertices of the input mesh with identical positions and stores
+ * the index of the merged vertex for each input vertex in \p remap.
+ */
+void mcDecimation_weldVertices(mcDecimationMesh *self, const mcMesh *mesh,
+    unsigned int *remap)
+{
+  unsigned int tableSize = 1;
+  while (tableSize < mesh->numVertices * 2)
+    tableSize *= 2;
+  int *table = (int*)malloc(sizeof(int) * tableSize);
+  for (unsigned int i = 0; i < tableSize; ++i)
+    table[i] = -1;
+  self->numVertices = 0;
+  for (unsigned int i = 0; i < mesh->numVertices; ++i) {
+    const mcVertex *vertex = &mesh->vertices[i];
+    uint32_t slot = mcDecimation_hashPosition(&vertex->pos) & (tableSize - 1);
+    /* Linear probing */
+    while (table[slot] != -1) {
+      const mcVec3 *other = &self->positions[table[slot]];
+      if (other->x == vertex->pos.x && other->y == vertex->pos.y
+          && other->z == vertex->pos.z)
+        break;
+      slot = (slot + 1) & (tableSize - 1);
+    }
+    if (table[slot] == -1) {
+      table[slot] = self->numVertices;
+      self->positions[self->numVertices] = vertex->pos;
+      self->normals[self->numVertices].x = 0.0f;
+      self->normals[self->numVertices].y = 0.0f;
+      self->normals[self->numVertices].z = 0.0f;
+      self->numVertices += 1;
+    }
+    remap[i] = table[slot];
+    mcVec3_add(&self->normals[table[slot]], &vertex->norm,
+        &self->normals[table[slot]]);
+  }
+  for (unsigned int i = 0; i < self->numVertices; ++i) {
+    if (mcVec3_length(&self->normals[i]) > 0.0f)
+      mcVec3_normalize(&self->normals[i], &self->normals[i]);
+  }
+  free(table);
+}
+
+int mcDecimation_compareEdges(const void *a, const void *b) {
+  uint64_t keyA = ((const mcDecimationEdge*)a)->key;
+  uint64_t keyB = ((const mcDecimationEdge*)b)->key;
+  return keyA < keyB ? -1 : keyA > keyB;
+}
+
+/**
+ * Finds the boundary and non-manifold edges of the mesh, adds the boundary
+ * constraint planes to the quadrics of unlocked boundary vertices, and pushes
+ * a collapse for every edge onto the heap.
+ */
+void mcDecimation_initEdges(mcDecimationMesh *self,
+    const mcDecimationParams *params)
+{
+  unsigned int numEdges = self->numTriangles * 3;
+  mcDecimationEdge *edges =
+    (mcDecimationEdge*)malloc(sizeof(mcDecimationEdge) * (numEdges + 1));
+  for (unsigned int c = 0; c < numEdges; ++c) {
+    unsigned int a = self->indices[c];
+    unsigned int b = self->indices[(c / 3) * 3 + (c + 1) % 3];
+    uint64_t lo = a < b ? a : b, hi = a < b ? b : a;
+    edges[c].key = (lo << 32) | hi;
+    edges[c].triangle = c / 3;
+  }
+  qsort(edges, numEdges, sizeof(mcDecimationEdge), mcDecimation_compareEdges);
+  /* Classify each edge by the number of triangles that share it */
+  for (unsigned int i = 0, count; i < numEdges; i += count) {
+    unsigned int a = (unsigned int)(edges[i].key >> 32);
+    unsigned int b = (unsigned int)(edges[i].key & 0xffffffffu);
+    for (count = 1; i + count < numEdges
+        && edges[i + count].key == edges[i].key; ++count);
+    if (count > 2) {
+      /* Leave non-manifold edges alone */
+      self->flags[a] |= MC_DECIMATION_LOCKED;
+      self->flags[b] |= MC_DECIMATION_LOCKED;
+    } else if (count == 1) {
+      self->flags[a] |= MC_DECIMATION_BOUNDARY;
+      self->flags[b] |= MC_DECIMATION_BOUNDARY;
+      if (params->lockBoundary) {
+        self->flags[a] |= MC_DECIMATION_LOCKED;
+        self->flags[b] |= MC_DECIMATION_LOCKED;
+        continue;
+      }
+      /* Hold the boundary in place with a plane through the edge,
+       * perpendicular to its triangle */
+      mcVec3 normal = mcDecimation_triangleNormal(
+          self, edges[i].triangle, 0, NULL);
+      mcVec3 edge, plane;
+      mcVec3_subtract(&self->positions[b], &self->positions[a], &edge);
+      mcVec3_cross(&edge, &normal, &plane);
+      float length = mcVec3_length(&plane);
+      if (length == 0.0f)
+        continue;
+      mcVec3_scalarProduct(1.0f / length, &plane, &plane);
+      double d = -mcVec3_dot(&plane, &self->positions[a]);
+      mcDecimation_addPlane(&self->quadrics[a],
+          plane.x, plane.y, plane.z, d, MC_DECIMATION_BOUNDARY_WEIGHT);
+      mcDecimation_addPlane(&self->quadrics[b],
+          plane.x, plane.y, plane.z, d, MC_DECIMATION_BOUNDARY_WEIGHT);
+    }
+  }
+  for (unsigned int i = 0; i < numEdges; ++i) {
+    if (i > 0 && edges[i].key == edges[i - 1].key)
+      continue;
+    mcDecimation_pushEdge(self,
+        (unsigned int)(edges[i].key >> 32),
+        (unsigned int)(edges[i].key & 0xffffffffu));
+  }
+  free(edges);
+}
+
+void mcDecimation_decimateMesh(
+    const mcMesh *mesh,
+    const mcDecimationParams *params,
+    mcMesh *output)
+{
+  mcDecimationParams defaultParams;
+  if (params == NULL) {
+    mcDecimationParams_default(&defaultParams);
+    params = &defaultParams;
+  }
+  mcDecimationMesh self;
+  unsigned int numTriangles = 0;
+  for (unsigned int i = 0; i < mesh->numFaces; ++i) {
+    if (mesh->faces[i].numIndices >= 3)
+      numTriangles += mesh->faces[i].numIndices - 2;
+  }
+  unsigned int numVertices = mesh->numVertices;
+  self.positions = (mcVec3*)malloc(sizeof(mcVec3) * (numVertices + 1));
+  self.normals = (mcVec3*)malloc(sizeof(mcVec3) * (numVertices + 1));
+  self.quadrics = (mcDecimationQuadric*)calloc(numVertices + 1,
+      sizeof(mcDecimationQuadric));
+  self.versions = (unsigned int*)calloc(numVertices + 1, sizeof(unsigned int));
+  self.marks = (unsigned int*)calloc(numVertices + 1, sizeof(unsigned int));
+  self.flags = (unsigned char*)calloc(numVertices + 1, sizeof(unsigned char));
+  self.heads = (int*)malloc(sizeof(int) * (numVertices + 1));
+  self.mark = 0;
+  self.indices = (unsigned int*)malloc(
+      sizeof(unsigned int) * (numTriangles * 3 + 1));
+  self.next = (int*)malloc(sizeof(int) * (numTriangles * 3 + 1));
+  self.removed = (unsigned char*)calloc(numTriangles + 1,
+      sizeof(unsigned char));
+  self.heapCapacity = 1024;
+  self.heapSize = 0;
+  self.heap = (mcDecimationCollapse*)malloc(
+      sizeof(mcDecimationCollapse) * self.heapCapacity);
+  unsigned int *remap = (unsigned int*)malloc(
+      sizeof(unsigned int) * (numVertices + 1));
+  mcDecimation_weldVertices(&self, mesh, remap);
+  /* Split faces into triangle fans, dropping triangles that became
+   * degenerate when their vertices were merged */
+  self.numTriangles = 0;
+  for (unsigned int i = 0; i < mesh->numFaces; ++i) {
+    const mcFace *face = &mesh->faces[i];
+    for (unsigned int j = 2; j < face->numIndices; ++j) {
+      unsigned int *t = &self.indices[self.numTriangles * 3];
+      t[0] = remap[face->indices[0]];
+      t[1] = remap[face->indices[j - 1]];
+      t[2] = remap[face->indices[j]];
+      if (t[0] == t[1] || t[1] == t[2] || t[2] == t[0])
+        continue;
+      self.numTriangles += 1;
+    }
+  }
+  self.numLiveTriangles = self.numTriangles;
+  /* Link the corners of each vertex and sum the plane quadrics of its
+   * triangles */
+  for (unsigned int v = 0; v < self.numVertices; ++v)
+    self.heads[v] = -1;
+  for (unsigned int t = 0; t < self.numTriangles; ++t) {
+    mcVec3 normal = mcDecimation_triangleNormal(&self, t, 0, NULL);
+    float length = mcVec3_length(&normal);
+    for (int i = 0; i < 3; ++i) {
+      unsigned int c = t * 3 + i;
+      self.next[c] = self.heads[self.indices[c]];
+      self.heads[self.indices[c]] = c;
+    }
+    if (length == 0.0f)
+      continue;
+    mcVec3_scalarProduct(1.0f / length, &normal, &normal);
+    double d = -mcVec3_dot(&normal, &self.positions[self.indices[t * 3]]);
+    for (int i = 0; i < 3; ++i) {
+      mcDecimation_addPlane(&self.quadrics[self.indices[t * 3 + i]],
+          normal.x, normal.y, normal.z, d, 1.0);
+    }
+  }
+  mcDecimation_initEdges(&self, params);
+  /* Collapse edges in order of increasing error */
+  while (self.heapSize > 0 && (params->targetNumFaces == 0
+        || self.numLiveTriangles > params->targetNumFaces))
+  {
+    mcDecimationCollapse collapse;
+    mcDecimation_pop(&self, &collapse);
+    if (collapse.cost > params->maxError)
+      break;
+    if (collapse.fromVersion != self.versions[collapse.from]
+        || collapse.toVersion != self.versions[collapse.to])
+      continue;  /* The collapse is stale */
+    if (!mcDecimation_isCollapseValid(&self, &collapse))
+      continue;
+    mcDecimation_applyCollapse(&self, &collapse);
+  }
+  /* Add the remaining vertices and triangles to the output mesh, reusing the
+   * remap array for the output vertex indices */
+  mcFace triangle;
+  mcFace_init(&triangle, 3);
+  for (unsigned int v = 0; v < self.numVertices; ++v)
+    remap[v] = UINT32_MAX;
+  for (unsigned int t = 0; t < self.numTriangles; ++t) {
+    if (self.removed[t])
+      continue;
+    for (int i = 0; i < 3; ++i) {
+      unsigned int v = self.indices[t * 3 + i];
+      if (remap[v] == UINT32_MAX) {
+        mcVertex vertex;
+        vertex.pos = self.positions[v];
+        vertex.norm = self.normals[v];
+        remap[v] = mcMesh_addVertex(output, &vertex);
+      }
+      triangle.indices[i] = remap[v];
+    }
+    mcMesh_addFace(output, &triangle);
+  }
+  mcFace_destroy(&triangle);
+  /* Free our resources */
+  free(remap);
+  free(self.positions);
+  free(self.normals);
+  free(self.quadrics);
+  free(self.versions);
+  free(self.marks);
+  free(self.flags);
+  free(self.heads);
+  free(self.indices);
+  free(self.next);
+  free(self.removed);
+  free(self.heap);
+}
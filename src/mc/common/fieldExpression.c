@@ -0,0 +1,1165 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mc/common/latticeBlocks.h>
+#include <mc/fieldExpression.h>
+
+/** Registers 0, 1 and 2 hold the coordinates of the points. */
+#define MC_FIELD_PROGRAM_NUM_COORDINATES 3
+
+/** The number of samples beyond a block over which it must be bounded away
+ * from the isovalue before mcFieldProgram_evaluateLattice() culls it. */
+#define MC_FIELD_PROGRAM_CULL_MARGIN 2.0f
+/** The relative width added to intervals before culling, which covers the
+ * rounding in computing them. */
+#define MC_FIELD_PROGRAM_INTERVAL_EPSILON 1.0e-5f
+/** The number of samples in blocks that are sampled without subdividing them
+ * further. */
+#define MC_FIELD_PROGRAM_LEAF_SIZE 512
+
+/* Unlike fminf() and fmaxf(), these compile to single vector instructions
+ * without -ffast-math */
+#define MC_FIELD_PROGRAM_MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MC_FIELD_PROGRAM_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+/**
+ * Doubles the size of the node array of the given expression.
+ */
+void mcFieldExpression_growNodes(
+    mcFieldExpression *self)
+{
+  mcFieldNode *newNodes =
+    (mcFieldNode*)malloc(sizeof(mcFieldNode) * self->sizeNodes * 2);
+  memcpy(newNodes, self->nodes, sizeof(mcFieldNode) * self->sizeNodes);
+  free(self->nodes);
+  self->nodes = newNodes;
+  self->sizeNodes *= 2;
+}
+
+/**
+ * Doubles the size of the parameter array of the given expression.
+ */
+void mcFieldExpression_growParams(
+    mcFieldExpression *self)
+{
+  float *newParams = (float*)malloc(sizeof(float) * self->sizeParams * 2);
+  memcpy(newParams, self->params, sizeof(float) * self->sizeParams);
+  free(self->params);
+  self->params = newParams;
+  self->sizeParams *= 2;
+}
+
+void mcFieldExpression_init(
+    mcFieldExpression *self)
+{
+  const unsigned int INIT_NUM_NODES = 16;
+  const unsigned int INIT_NUM_PARAMS = 64;
+
+  self->nodes = (mcFieldNode*)malloc(sizeof(mcFieldNode) * INIT_NUM_NODES);
+  self->numNodes = 0;
+  self->sizeNodes = INIT_NUM_NODES;
+  self->params = (float*)malloc(sizeof(float) * INIT_NUM_PARAMS);
+  self->numParams = 0;
+  self->sizeParams = INIT_NUM_PARAMS;
+}
+
+void mcFieldExpression_destroy(
+    mcFieldExpression *self)
+{
+  free(self->nodes);
+  free(self->params);
+}
+
+/**
+ * Adds a node with the given operation, children and parameters, and returns
+ * its index.
+ */
+int mcFieldExpression_addNode(
+    mcFieldExpression *self,
+    mcFieldOp op, int a, int b,
+    const float *params, unsigned int numParams)
+{
+  assert(a < (int)self->numNodes && b < (int)self->numNodes);
+  if (self->numNodes >= self->sizeNodes)
+    mcFieldExpression_growNodes(self);
+  while (self->numParams + numParams > self->sizeParams)
+    mcFieldExpression_growParams(self);
+  mcFieldNode *node = &self->nodes[self->numNodes];
+  node->op = op;
+  node->children[0] = a;
+  node->children[1] = b;
+  node->params = self->numParams;
+  if (numParams > 0)
+    memcpy(&self->params[self->numParams], params, sizeof(float) * numParams);
+  self->numParams += numParams;
+  return (int)self->numNodes++;
+}
+
+int mcFieldExpression_x(mcFieldExpression *self) {
+  return mcFieldExpression_addNode(self, MC_FIELD_X, -1, -1, NULL, 0);
+}
+
+int mcFieldExpression_y(mcFieldExpression *self) {
+  return mcFieldExpression_addNode(self, MC_FIELD_Y, -1, -1, NULL, 0);
+}
+
+int mcFieldExpression_z(mcFieldExpression *self) {
+  return mcFieldExpression_addNode(self, MC_FIELD_Z, -1, -1, NULL, 0);
+}
+
+int mcFieldExpression_constant(mcFieldExpression *self, float value) {
+  return mcFieldExpression_addNode(self, MC_FIELD_CONSTANT, -1, -1, &value, 1);
+}
+
+int mcFieldExpression_add(mcFieldExpression *self, int a, int b) {
+  return mcFieldExpression_addNode(self, MC_FIELD_ADD, a, b, NULL, 0);
+}
+
+int mcFieldExpression_subtract(mcFieldExpression *self, int a, int b) {
+  return mcFieldExpression_addNode(self, MC_FIELD_SUBTRACT, a, b, NULL, 0);
+}
+
+int mcFieldExpression_multiply(mcFieldExpression *self, int a, int b) {
+  return mcFieldExpression_addNode(self, MC_FIELD_MULTIPLY, a, b, NULL, 0);
+}
+
+int mcFieldExpression_min(mcFieldExpression *self, int a, int b) {
+  return mcFieldExpression_addNode(self, MC_FIELD_MIN, a, b, NULL, 0);
+}
+
+int mcFieldExpression_max(mcFieldExpression *self, int a, int b) {
+  return mcFieldExpression_addNode(self, MC_FIELD_MAX, a, b, NULL, 0);
+}
+
+int mcFieldExpression_negate(mcFieldExpression *self, int a) {
+  return mcFieldExpression_addNode(self, MC_FIELD_NEGATE, a, -1, NULL, 0);
+}
+
+int mcFieldExpression_abs(mcFieldExpression *self, int a) {
+  return mcFieldExpression_addNode(self, MC_FIELD_ABS, a, -1, NULL, 0);
+}
+
+int mcFieldExpression_sphere(mcFieldExpression *self,
+    const mcVec3 *center, float radius)
+{
+  float params[] = { center->x, center->y, center->z, radius };
+  return mcFieldExpression_addNode(self, MC_FIELD_SPHERE, -1, -1, params, 4);
+}
+
+int mcFieldExpression_box(mcFieldExpression *self,
+    const mcVec3 *center, const mcVec3 *halfExtents)
+{
+  float params[] = {
+    center->x, center->y, center->z,
+    halfExtents->x, halfExtents->y, halfExtents->z };
+  return mcFieldExpression_addNode(self, MC_FIELD_BOX, -1, -1, params, 6);
+}
+
+int mcFieldExpression_torus(mcFieldExpression *self,
+    const mcVec3 *center, float majorRadius, float minorRadius)
+{
+  float params[] = {
+    center->x, center->y, center->z, majorRadius, minorRadius };
+  return mcFieldExpression_addNode(self, MC_FIELD_TORUS, -1, -1, params, 5);
+}
+
+int mcFieldExpression_plane(mcFieldExpression *self,
+    const mcVec3 *normal, float distance)
+{
+  float length = mcVec3_length(normal);
+  assert(length > 0.0f);
+  float params[] = {
+    normal->x / length, normal->y / length, normal->z / length, distance };
+  return mcFieldExpression_addNode(self, MC_FIELD_PLANE, -1, -1, params, 4);
+}
+
+int mcFieldExpression_noise(mcFieldExpression *self,
+    float frequency, float amplitude, unsigned int seed)
+{
+  /* The seed is stored exactly as long as it fits in a float's mantissa */
+  float params[] = { frequency, amplitude, (float)(seed & 0xffffff) };
+  return mcFieldExpression_addNode(self, MC_FIELD_NOISE, -1, -1, params, 3);
+}
+
+int mcFieldExpression_union(mcFieldExpression *self, int a, int b) {
+  return mcFieldExpression_min(self, a, b);
+}
+
+int mcFieldExpression_intersection(mcFieldExpression *self, int a, int b) {
+  return mcFieldExpression_max(self, a, b);
+}
+
+int mcFieldExpression_difference(mcFieldExpression *self, int a, int b) {
+  return mcFieldExpression_max(self, a, mcFieldExpression_negate(self, b));
+}
+
+int mcFieldExpression_smoothUnion(mcFieldExpression *self,
+    int a, int b, float radius)
+{
+  assert(radius > 0.0f);
+  return mcFieldExpression_addNode(self, MC_FIELD_SMOOTH_MIN, a, b,
+      &radius, 1);
+}
+
+int mcFieldExpression_affine(mcFieldExpression *self,
+    int a, const float *matrix)
+{
+  return mcFieldExpression_addNode(self, MC_FIELD_AFFINE, a, -1, matrix, 12);
+}
+
+int mcFieldExpression_translate(mcFieldExpression *self,
+    int a, const mcVec3 *offset)
+{
+  float matrix[] = {
+    1.0f, 0.0f, 0.0f, -offset->x,
+    0.0f, 1.0f, 0.0f, -offset->y,
+    0.0f, 0.0f, 1.0f, -offset->z };
+  return mcFieldExpression_affine(self, a, matrix);
+}
+
+int mcFieldExpression_rotate(mcFieldExpression *self,
+    int a, const mcVec3 *axis, float angle)
+{
+  mcVec3 u;
+  mcVec3_normalize(axis, &u);
+  /* Rotating the shape by angle means rotating the points by -angle, whose
+   * matrix is the transpose of the rotation matrix */
+  float c = cosf(angle), s = sinf(angle), t = 1.0f - c;
+  float matrix[] = {
+    t * u.x * u.x + c, t * u.x * u.y + s * u.z, t * u.x * u.z - s * u.y, 0.0f,
+    t * u.x * u.y - s * u.z, t * u.y * u.y + c, t * u.y * u.z + s * u.x, 0.0f,
+    t * u.x * u.z + s * u.y, t * u.y * u.z - s * u.x, t * u.z * u.z + c, 0.0f };
+  return mcFieldExpression_affine(self, a, matrix);
+}
+
+int mcFieldExpression_scale(mcFieldExpression *self, int a, float factor) {
+  assert(factor != 0.0f);
+  float inverse = 1.0f / factor;
+  float matrix[] = {
+    inverse, 0.0f, 0.0f, 0.0f,
+    0.0f, inverse, 0.0f, 0.0f,
+    0.0f, 0.0f, inverse, 0.0f };
+  /* Scaling the coordinates scales distances by the inverse, so scale the
+   * distances back */
+  return mcFieldExpression_multiply(self,
+      mcFieldExpression_affine(self, a, matrix),
+      mcFieldExpression_constant(self, fabsf(factor)));
+}
+
+/**
+ * \internal
+ * The state of the compiler while it turns an expression into a program.
+ * \endinternal
+ */
+typedef struct mcFieldCompiler {
+  const mcFieldExpression *expression;
+  mcFieldProgram *program;
+  unsigned int sizeInstructions, sizeParams;
+  /** For each register, whether it holds a constant, and its value. */
+  int *isConstant;
+  float *constants;
+  unsigned int sizeRegisters;
+  /** The register holding the value of each node in each coordinate frame
+   * seen so far, as (node, frame, register) triples. */
+  unsigned int *memo;
+  unsigned int numMemo, sizeMemo;
+  /** The number of coordinate frames created by transforms so far. */
+  unsigned int numFrames;
+} mcFieldCompiler;
+
+/**
+ * Returns a new register, which is constant with the given value if
+ * isConstant is set.
+ */
+unsigned int mcFieldCompiler_addRegister(
+    mcFieldCompiler *self, int isConstant, float value)
+{
+  mcFieldProgram *program = self->program;
+  if (program->numRegisters >= self->sizeRegisters) {
+    int *newIsConstant =
+      (int*)malloc(sizeof(int) * self->sizeRegisters * 2);
+    float *newConstants =
+      (float*)malloc(sizeof(float) * self->sizeRegisters * 2);
+    memcpy(newIsConstant, self->isConstant, sizeof(int) * self->sizeRegisters);
+    memcpy(newConstants, self->constants, sizeof(float) * self->sizeRegisters);
+    free(self->isConstant);
+    free(self->constants);
+    self->isConstant = newIsConstant;
+    self->constants = newConstants;
+    self->sizeRegisters *= 2;
+  }
+  self->isConstant[program->numRegisters] = isConstant;
+  self->constants[program->numRegisters] = value;
+  return program->numRegisters++;
+}
+
+/**
+ * Appends an instruction with the given immediate parameters to the program,
+ * and returns its result register.
+ */
+unsigned int mcFieldCompiler_emit(
+    mcFieldCompiler *self,
+    mcFieldOp op, const unsigned int *src,
+    const float *params, unsigned int numParams)
+{
+  mcFieldProgram *program = self->program;
+  if (program->numInstructions >= self->sizeInstructions) {
+    mcFieldInstruction *newInstructions = (mcFieldInstruction*)malloc(
+        sizeof(mcFieldInstruction) * self->sizeInstructions * 2);
+    memcpy(newInstructions, program->instructions,
+        sizeof(mcFieldInstruction) * self->sizeInstructions);
+    free(program->instructions);
+    program->instructions = newInstructions;
+    self->sizeInstructions *= 2;
+  }
+  while (program->numParams + numParams > self->sizeParams) {
+    float *newParams = (float*)malloc(sizeof(float) * self->sizeParams * 2);
+    memcpy(newParams, program->params, sizeof(float) * self->sizeParams);
+    free(program->params);
+    program->params = newParams;
+    self->sizeParams *= 2;
+  }
+  mcFieldInstruction *instruction =
+    &program->instructions[program->numInstructions++];
+  instruction->op = op;
+  instruction->dest = mcFieldCompiler_addRegister(self,
+      op == MC_FIELD_CONSTANT, numParams > 0 ? params[0] : 0.0f);
+  for (int i = 0; i < 3; ++i)
+    instruction->src[i] = src != NULL ? src[i] : 0;
+  instruction->params = program->numParams;
+  memcpy(&program->params[program->numParams], params,
+      sizeof(float) * numParams);
+  program->numParams += numParams;
+  return instruction->dest;
+}
+
+/**
+ * Returns the register holding the given node in the given coordinate frame
+ * if it has already been compiled, or -1.
+ */
+int mcFieldCompiler_lookup(
+    const mcFieldCompiler *self, int node, unsigned int frame)
+{
+  for (unsigned int i = 0; i < self->numMemo; ++i) {
+    const unsigned int *entry = &self->memo[i * 3];
+    if (entry[0] == (unsigned int)node && entry[1] == frame)
+      return (int)entry[2];
+  }
+  return -1;
+}
+
+void mcFieldCompiler_remember(
+    mcFieldCompiler *self, int node, unsigned int frame, unsigned int reg)
+{
+  if (self->numMemo >= self->sizeMemo) {
+    unsigned int *newMemo =
+      (unsigned int*)malloc(sizeof(unsigned int) * 3 * self->sizeMemo * 2);
+    memcpy(newMemo, self->memo, sizeof(unsigned int) * 3 * self->sizeMemo);
+    free(self->memo);
+    self->memo = newMemo;
+    self->sizeMemo *= 2;
+  }
+  unsigned int *entry = &self->memo[self->numMemo++ * 3];
+  entry[0] = (unsigned int)node;
+  entry[1] = frame;
+  entry[2] = reg;
+}
+
+/**
+ * Returns the value of the given arithmetic operation on constants.
+ */
+float mcFieldCompiler_fold(mcFieldOp op, float a, float b, const float *params)
+{
+  switch (op) {
+    case MC_FIELD_ADD: return a + b;
+    case MC_FIELD_SUBTRACT: return a - b;
+    case MC_FIELD_MULTIPLY: return a * b;
+    case MC_FIELD_MIN: return fminf(a, b);
+    case MC_FIELD_MAX: return fmaxf(a, b);
+    case MC_FIELD_NEGATE: return -a;
+    case MC_FIELD_ABS: return fabsf(a);
+    case MC_FIELD_SMOOTH_MIN:
+      {
+        float k = params[0];
+        float h = fmaxf(k - fabsf(a - b), 0.0f) / k;
+        return fminf(a, b) - h * h * k * 0.25f;
+      }
+    default:
+      assert(0);
+  }
+  return 0.0f;
+}
+
+/**
+ * Compiles the given node in the coordinate frame whose x, y and z
+ * coordinates are held in the given registers, and returns the register
+ * holding its value.
+ */
+unsigned int mcFieldCompiler_compile(
+    mcFieldCompiler *self, int node,
+    unsigned int frame, const unsigned int *coordinates)
+{
+  int memoized = mcFieldCompiler_lookup(self, node, frame);
+  if (memoized != -1)
+    return (unsigned int)memoized;
+  const mcFieldNode *n = &self->expression->nodes[node];
+  const float *params = &self->expression->params[n->params];
+  unsigned int result;
+  switch (n->op) {
+    case MC_FIELD_X:
+    case MC_FIELD_Y:
+    case MC_FIELD_Z:
+      result = coordinates[n->op - MC_FIELD_X];
+      break;
+    case MC_FIELD_CONSTANT:
+      result = mcFieldCompiler_emit(self, MC_FIELD_CONSTANT, NULL, params, 1);
+      break;
+    case MC_FIELD_ADD:
+    case MC_FIELD_SUBTRACT:
+    case MC_FIELD_MULTIPLY:
+    case MC_FIELD_MIN:
+    case MC_FIELD_MAX:
+    case MC_FIELD_NEGATE:
+    case MC_FIELD_ABS:
+    case MC_FIELD_SMOOTH_MIN:
+      {
+        unsigned int src[3] = { 0, 0, 0 };
+        int constant = 1;
+        for (int i = 0; i < 2; ++i) {
+          if (n->children[i] == -1)
+            continue;
+          src[i] = mcFieldCompiler_compile(self, n->children[i],
+              frame, coordinates);
+          constant = constant && self->isConstant[src[i]];
+        }
+        unsigned int numParams = n->op == MC_FIELD_SMOOTH_MIN ? 1 : 0;
+        if (constant) {
+          /* Fold the operation into a constant */
+          float value = mcFieldCompiler_fold(n->op,
+              self->constants[src[0]], self->constants[src[1]], params);
+          result = mcFieldCompiler_emit(self, MC_FIELD_CONSTANT, NULL,
+              &value, 1);
+        } else {
+          result = mcFieldCompiler_emit(self, n->op, src, params, numParams);
+        }
+      }
+      break;
+    case MC_FIELD_SPHERE:
+      result = mcFieldCompiler_emit(self, n->op, coordinates, params, 4);
+      break;
+    case MC_FIELD_BOX:
+      result = mcFieldCompiler_emit(self, n->op, coordinates, params, 6);
+      break;
+    case MC_FIELD_TORUS:
+      result = mcFieldCompiler_emit(self, n->op, coordinates, params, 5);
+      break;
+    case MC_FIELD_PLANE:
+      result = mcFieldCompiler_emit(self, n->op, coordinates, params, 4);
+      break;
+    case MC_FIELD_NOISE:
+      result = mcFieldCompiler_emit(self, n->op, coordinates, params, 3);
+      break;
+    case MC_FIELD_AFFINE:
+      {
+        /* Compute the transformed coordinates, one row of the matrix at a
+         * time, and compile the child in their new coordinate frame */
+        unsigned int transformed[3];
+        for (int i = 0; i < 3; ++i) {
+          transformed[i] = mcFieldCompiler_emit(self, MC_FIELD_AFFINE,
+              coordinates, &params[i * 4], 4);
+        }
+        result = mcFieldCompiler_compile(self, n->children[0],
+            ++self->numFrames, transformed);
+      }
+      break;
+    default:
+      assert(0);
+      result = 0;
+  }
+  mcFieldCompiler_remember(self, node, frame, result);
+  return result;
+}
+
+/**
+ * Removes the instructions whose results are never used, such as the
+ * constants that were folded into other constants.
+ */
+void mcFieldProgram_removeDeadCode(
+    mcFieldProgram *self)
+{
+  int *live = (int*)malloc(sizeof(int) * self->numRegisters);
+  memset(live, 0, sizeof(int) * self->numRegisters);
+  live[self->result] = 1;
+  for (int i = (int)self->numInstructions - 1; i >= 0; --i) {
+    const mcFieldInstruction *instruction = &self->instructions[i];
+    if (!live[instruction->dest])
+      continue;
+    for (int j = 0; j < 3; ++j)
+      live[instruction->src[j]] = 1;
+  }
+  unsigned int numLive = 0;
+  for (unsigned int i = 0; i < self->numInstructions; ++i) {
+    if (live[self->instructions[i].dest])
+      self->instructions[numLive++] = self->instructions[i];
+  }
+  self->numInstructions = numLive;
+  free(live);
+}
+
+void mcFieldProgram_init(
+    mcFieldProgram *self,
+    const mcFieldExpression *expression,
+    int root)
+{
+  const unsigned int INIT_SIZE = 16;
+
+  assert(root >= 0 && root < (int)expression->numNodes);
+  self->instructions =
+    (mcFieldInstruction*)malloc(sizeof(mcFieldInstruction) * INIT_SIZE);
+  self->numInstructions = 0;
+  self->params = (float*)malloc(sizeof(float) * INIT_SIZE);
+  self->numParams = 0;
+  self->numRegisters = 0;
+  mcFieldCompiler compiler;
+  compiler.expression = expression;
+  compiler.program = self;
+  compiler.sizeInstructions = INIT_SIZE;
+  compiler.sizeParams = INIT_SIZE;
+  compiler.isConstant = (int*)malloc(sizeof(int) * INIT_SIZE);
+  compiler.constants = (float*)malloc(sizeof(float) * INIT_SIZE);
+  compiler.sizeRegisters = INIT_SIZE;
+  compiler.memo = (unsigned int*)malloc(sizeof(unsigned int) * 3 * INIT_SIZE);
+  compiler.numMemo = 0;
+  compiler.sizeMemo = INIT_SIZE;
+  compiler.numFrames = 0;
+  unsigned int coordinates[MC_FIELD_PROGRAM_NUM_COORDINATES];
+  for (int i = 0; i < MC_FIELD_PROGRAM_NUM_COORDINATES; ++i)
+    coordinates[i] = mcFieldCompiler_addRegister(&compiler, 0, 0.0f);
+  self->result = mcFieldCompiler_compile(&compiler, root, 0, coordinates);
+  mcFieldProgram_removeDeadCode(self);
+  free(compiler.isConstant);
+  free(compiler.constants);
+  free(compiler.memo);
+}
+
+void mcFieldProgram_destroy(
+    mcFieldProgram *self)
+{
+  free(self->instructions);
+  free(self->params);
+}
+
+/**
+ * Returns a pseudorandom value between -1 and 1 for the given noise lattice
+ * point.
+ */
+static inline float mcFieldProgram_hash(
+    int32_t x, int32_t y, int32_t z, uint32_t seed)
+{
+  uint32_t h = seed * 0x9e3779b9u;
+  h ^= (uint32_t)x * 0x85ebca6bu;
+  h ^= (uint32_t)y * 0xc2b2ae35u;
+  h ^= (uint32_t)z * 0x27d4eb2fu;
+  h ^= h >> 15;
+  h *= 0x2c1b3c6du;
+  h ^= h >> 12;
+  h *= 0x297a2d39u;
+  h ^= h >> 15;
+  return (float)(h >> 8) * (2.0f / 16777215.0f) - 1.0f;
+}
+
+/**
+ * Evaluates the program over a batch of points whose coordinates are already
+ * in registers 0, 1 and 2. Register r of point i is registers[r * stride + i].
+ */
+void mcFieldProgram_evaluateBatch(
+    const mcFieldProgram *self,
+    float *registers, unsigned int stride,
+    int count)
+{
+  for (unsigned int j = 0; j < self->numInstructions; ++j) {
+    const mcFieldInstruction *instruction = &self->instructions[j];
+    float *restrict dest = &registers[instruction->dest * stride];
+    const float *restrict a = &registers[instruction->src[0] * stride];
+    const float *restrict b = &registers[instruction->src[1] * stride];
+    const float *restrict c = &registers[instruction->src[2] * stride];
+    const float *p = &self->params[instruction->params];
+    switch (instruction->op) {
+      case MC_FIELD_CONSTANT:
+        for (int i = 0; i < count; ++i)
+          dest[i] = p[0];
+        break;
+      case MC_FIELD_ADD:
+#pragma omp simd
+        for (int i = 0; i < count; ++i)
+          dest[i] = a[i] + b[i];
+        break;
+      case MC_FIELD_SUBTRACT:
+#pragma omp simd
+        for (int i = 0; i < count; ++i)
+          dest[i] = a[i] - b[i];
+        break;
+      case MC_FIELD_MULTIPLY:
+#pragma omp simd
+        for (int i = 0; i < count; ++i)
+          dest[i] = a[i] * b[i];
+        break;
+      case MC_FIELD_MIN:
+#pragma omp simd
+        for (int i = 0; i < count; ++i)
+          dest[i] = MC_FIELD_PROGRAM_MIN(a[i], b[i]);
+        break;
+      case MC_FIELD_MAX:
+#pragma omp simd
+        for (int i = 0; i < count; ++i)
+          dest[i] = MC_FIELD_PROGRAM_MAX(a[i], b[i]);
+        break;
+      case MC_FIELD_NEGATE:
+#pragma omp simd
+        for (int i = 0; i < count; ++i)
+          dest[i] = -a[i];
+        break;
+      case MC_FIELD_ABS:
+#pragma omp simd
+        for (int i = 0; i < count; ++i)
+          dest[i] = fabsf(a[i]);
+        break;
+      case MC_FIELD_SMOOTH_MIN:
+        {
+          float k = p[0], scale = 0.25f / k;
+#pragma omp simd
+          for (int i = 0; i < count; ++i) {
+            float h = MC_FIELD_PROGRAM_MAX(k - fabsf(a[i] - b[i]), 0.0f);
+            dest[i] = MC_FIELD_PROGRAM_MIN(a[i], b[i]) - h * h * scale;
+          }
+        }
+        break;
+      case MC_FIELD_SPHERE:
+#pragma omp simd
+        for (int i = 0; i < count; ++i) {
+          float dx = a[i] - p[0], dy = b[i] - p[1], dz = c[i] - p[2];
+          dest[i] = sqrtf(dx * dx + dy * dy + dz * dz) - p[3];
+        }
+        break;
+      case MC_FIELD_BOX:
+#pragma omp simd
+        for (int i = 0; i < count; ++i) {
+          float qx = fabsf(a[i] - p[0]) - p[3];
+          float qy = fabsf(b[i] - p[1]) - p[4];
+          float qz = fabsf(c[i] - p[2]) - p[5];
+          float ox = MC_FIELD_PROGRAM_MAX(qx, 0.0f);
+          float oy = MC_FIELD_PROGRAM_MAX(qy, 0.0f);
+          float oz = MC_FIELD_PROGRAM_MAX(qz, 0.0f);
+          float inside = MC_FIELD_PROGRAM_MAX(qx, MC_FIELD_PROGRAM_MAX(qy, qz));
+          dest[i] = sqrtf(ox * ox + oy * oy + oz * oz)
+            + MC_FIELD_PROGRAM_MIN(inside, 0.0f);
+        }
+        break;
+      case MC_FIELD_TORUS:
+#pragma omp simd
+        for (int i = 0; i < count; ++i) {
+          float dx = a[i] - p[0], dy = b[i] - p[1], dz = c[i] - p[2];
+          float qx = sqrtf(dx * dx + dy * dy) - p[3];
+          dest[i] = sqrtf(qx * qx + dz * dz) - p[4];
+        }
+        break;
+      case MC_FIELD_PLANE:
+#pragma omp simd
+        for (int i = 0; i < count; ++i)
+          dest[i] = a[i] * p[0] + b[i] * p[1] + c[i] * p[2] - p[3];
+        break;
+      case MC_FIELD_NOISE:
+        {
+          uint32_t seed = (uint32_t)p[2];
+#pragma omp simd
+          for (int i = 0; i < count; ++i) {
+            float x = a[i] * p[0], y = b[i] * p[0], z = c[i] * p[0];
+            float fx = floorf(x), fy = floorf(y), fz = floorf(z);
+            int32_t ix = (int32_t)fx, iy = (int32_t)fy, iz = (int32_t)fz;
+            /* Smoothstep between the lattice values */
+            float u = x - fx, v = y - fy, w = z - fz;
+            u = u * u * (3.0f - 2.0f * u);
+            v = v * v * (3.0f - 2.0f * v);
+            w = w * w * (3.0f - 2.0f * w);
+            float n00 = mcFieldProgram_hash(ix, iy, iz, seed)
+              + u * (mcFieldProgram_hash(ix + 1, iy, iz, seed)
+                  - mcFieldProgram_hash(ix, iy, iz, seed));
+            float n10 = mcFieldProgram_hash(ix, iy + 1, iz, seed)
+              + u * (mcFieldProgram_hash(ix + 1, iy + 1, iz, seed)
+                  - mcFieldProgram_hash(ix, iy + 1, iz, seed));
+            float n01 = mcFieldProgram_hash(ix, iy, iz + 1, seed)
+              + u * (mcFieldProgram_hash(ix + 1, iy, iz + 1, seed)
+                  - mcFieldProgram_hash(ix, iy, iz + 1, seed));
+            float n11 = mcFieldProgram_hash(ix, iy + 1, iz + 1, seed)
+              + u * (mcFieldProgram_hash(ix + 1, iy + 1, iz + 1, seed)
+                  - mcFieldProgram_hash(ix, iy + 1, iz + 1, seed));
+            float n0 = n00 + v * (n10 - n00);
+            float n1 = n01 + v * (n11 - n01);
+            dest[i] = p[1] * (n0 + w * (n1 - n0));
+          }
+        }
+        break;
+      case MC_FIELD_AFFINE:
+#pragma omp simd
+        for (int i = 0; i < count; ++i)
+          dest[i] = a[i] * p[0] + b[i] * p[1] + c[i] * p[2] + p[3];
+        break;
+      default:
+        assert(0);
+    }
+  }
+}
+
+void mcFieldProgram_evaluate(
+    const mcFieldProgram *self,
+    const float *x, const float *y, const float *z,
+    unsigned int count,
+    float *values)
+{
+  const unsigned int stride = MC_FIELD_PROGRAM_BATCH_SIZE;
+  float *registers =
+    (float*)malloc(sizeof(float) * self->numRegisters * stride);
+  for (unsigned int start = 0; start < count; start += stride) {
+    int n = count - start < stride ? (int)(count - start) : (int)stride;
+    memcpy(&registers[0 * stride], &x[start], sizeof(float) * n);
+    memcpy(&registers[1 * stride], &y[start], sizeof(float) * n);
+    memcpy(&registers[2 * stride], &z[start], sizeof(float) * n);
+    mcFieldProgram_evaluateBatch(self, registers, stride, n);
+    memcpy(&values[start], &registers[self->result * stride],
+        sizeof(float) * n);
+  }
+  free(registers);
+}
+
+/**
+ * Evaluates the program along part of a row, at x = x0 + i * dx for i from
+ * first to first + count - 1, using the given scratch registers.
+ */
+void mcFieldProgram_evaluatePartialRow(
+    const mcFieldProgram *self,
+    float *registers,
+    float x0, float dx, unsigned int first, float y, float z,
+    unsigned int count,
+    float *values)
+{
+  const unsigned int stride = MC_FIELD_PROGRAM_BATCH_SIZE;
+  for (unsigned int start = 0; start < count; start += stride) {
+    int n = count - start < stride ? (int)(count - start) : (int)stride;
+    for (int i = 0; i < n; ++i) {
+      registers[0 * stride + i] = x0 + (float)(first + start + i) * dx;
+      registers[1 * stride + i] = y;
+      registers[2 * stride + i] = z;
+    }
+    mcFieldProgram_evaluateBatch(self, registers, stride, n);
+    memcpy(&values[start], &registers[self->result * stride],
+        sizeof(float) * n);
+  }
+}
+
+void mcFieldProgram_evaluateRow(
+    const mcFieldProgram *self,
+    float x0, float dx, float y, float z,
+    unsigned int count,
+    float *values)
+{
+  float *registers = (float*)malloc(
+      sizeof(float) * self->numRegisters * MC_FIELD_PROGRAM_BATCH_SIZE);
+  mcFieldProgram_evaluatePartialRow(self, registers,
+      x0, dx, 0, y, z, count, values);
+  free(registers);
+}
+
+float mcFieldProgram_scalarField(
+    float x, float y, float z,
+    const void *args)
+{
+  const mcFieldProgram *self = (const mcFieldProgram*)args;
+  /* A single point needs only one value per register */
+  float registers[self->numRegisters];
+  registers[0] = x;
+  registers[1] = y;
+  registers[2] = z;
+  mcFieldProgram_evaluateBatch(self, registers, 1, 1);
+  return registers[self->result];
+}
+
+/**
+ * Computes the interval of values of each instruction over the box whose
+ * coordinate intervals are already in registers 0, 1 and 2.
+ */
+void mcFieldProgram_evaluateIntervals(
+    const mcFieldProgram *self,
+    float *lower, float *upper)
+{
+  for (unsigned int j = 0; j < self->numInstructions; ++j) {
+    const mcFieldInstruction *instruction = &self->instructions[j];
+    const float *p = &self->params[instruction->params];
+    unsigned int a = instruction->src[0], b = instruction->src[1];
+    float lo, hi;
+    switch (instruction->op) {
+      case MC_FIELD_CONSTANT:
+        lo = hi = p[0];
+        break;
+      case MC_FIELD_ADD:
+        lo = lower[a] + lower[b];
+        hi = upper[a] + upper[b];
+        break;
+      case MC_FIELD_SUBTRACT:
+        lo = lower[a] - upper[b];
+        hi = upper[a] - lower[b];
+        break;
+      case MC_FIELD_MULTIPLY:
+        {
+          float products[] = {
+            lower[a] * lower[b], lower[a] * upper[b],
+            upper[a] * lower[b], upper[a] * upper[b] };
+          lo = hi = products[0];
+          for (int i = 1; i < 4; ++i) {
+            lo = fminf(lo, products[i]);
+            hi = fmaxf(hi, products[i]);
+          }
+        }
+        break;
+      case MC_FIELD_MIN:
+        lo = fminf(lower[a], lower[b]);
+        hi = fminf(upper[a], upper[b]);
+        break;
+      case MC_FIELD_MAX:
+        lo = fmaxf(lower[a], lower[b]);
+        hi = fmaxf(upper[a], upper[b]);
+        break;
+      case MC_FIELD_NEGATE:
+        lo = -upper[a];
+        hi = -lower[a];
+        break;
+      case MC_FIELD_ABS:
+        if (lower[a] >= 0.0f) {
+          lo = lower[a];
+          hi = upper[a];
+        } else if (upper[a] <= 0.0f) {
+          lo = -upper[a];
+          hi = -lower[a];
+        } else {
+          lo = 0.0f;
+          hi = fmaxf(-lower[a], upper[a]);
+        }
+        break;
+      case MC_FIELD_SMOOTH_MIN:
+        /* The blend lowers the minimum by at most a quarter of the radius */
+        lo = fminf(lower[a], lower[b]) - p[0] * 0.25f;
+        hi = fminf(upper[a], upper[b]);
+        break;
+      case MC_FIELD_SPHERE:
+        {
+          float nearest = 0.0f, farthest = 0.0f;
+          for (int i = 0; i < 3; ++i) {
+            unsigned int r = instruction->src[i];
+            float d = fmaxf(fmaxf(lower[r] - p[i], p[i] - upper[r]), 0.0f);
+            float e = fmaxf(fabsf(lower[r] - p[i]), fabsf(upper[r] - p[i]));
+            nearest += d * d;
+            farthest += e * e;
+          }
+          lo = sqrtf(nearest) - p[3];
+          hi = sqrtf(farthest) - p[3];
+        }
+        break;
+      case MC_FIELD_BOX:
+      case MC_FIELD_TORUS:
+        {
+          /* Signed distance functions change no faster than the distance
+           * from the center of the box */
+          float center[3], halfDiagonal = 0.0f;
+          for (int i = 0; i < 3; ++i) {
+            unsigned int r = instruction->src[i];
+            float half = (upper[r] - lower[r]) * 0.5f;
+            center[i] = lower[r] + half;
+            halfDiagonal += half * half;
+          }
+          halfDiagonal = sqrtf(halfDiagonal);
+          float registers[] = { center[0], center[1], center[2], 0.0f };
+          mcFieldInstruction single = *instruction;
+          single.src[0] = 0;
+          single.src[1] = 1;
+          single.src[2] = 2;
+          single.dest = 3;
+          mcFieldProgram centerProgram = *self;
+          centerProgram.instructions = &single;
+          centerProgram.numInstructions = 1;
+          mcFieldProgram_evaluateBatch(&centerProgram, registers, 1, 1);
+          lo = registers[3] - halfDiagonal;
+          hi = registers[3] + halfDiagonal;
+        }
+        break;
+      case MC_FIELD_PLANE:
+      case MC_FIELD_AFFINE:
+        {
+          /* Both are linear in the coordinates */
+          float offset = instruction->op == MC_FIELD_PLANE ? -p[3] : p[3];
+          lo = hi = offset;
+          for (int i = 0; i < 3; ++i) {
+            unsigned int r = instruction->src[i];
+            lo += fminf(p[i] * lower[r], p[i] * upper[r]);
+            hi += fmaxf(p[i] * lower[r], p[i] * upper[r]);
+          }
+        }
+        break;
+      case MC_FIELD_NOISE:
+        lo = -fabsf(p[1]);
+        hi = fabsf(p[1]);
+        break;
+      default:
+        assert(0);
+        lo = -INFINITY;
+        hi = INFINITY;
+    }
+    lower[instruction->dest] = lo;
+    upper[instruction->dest] = hi;
+  }
+}
+
+void mcFieldProgram_evaluateInterval(
+    const mcFieldProgram *self,
+    const mcVec3 *min, const mcVec3 *max,
+    float *lower, float *upper)
+{
+  float *intervals = (float*)malloc(sizeof(float) * self->numRegisters * 2);
+  float *lo = intervals, *hi = &intervals[self->numRegisters];
+  lo[0] = fminf(min->x, max->x); hi[0] = fmaxf(min->x, max->x);
+  lo[1] = fminf(min->y, max->y); hi[1] = fmaxf(min->y, max->y);
+  lo[2] = fminf(min->z, max->z); hi[2] = fmaxf(min->z, max->z);
+  mcFieldProgram_evaluateIntervals(self, lo, hi);
+  *lower = lo[self->result];
+  *upper = hi[self->result];
+  free(intervals);
+}
+
+/**
+ * Initializes a copy of the given program without the CSG branches that
+ * cannot affect its value within the intervals computed by
+ * mcFieldProgram_evaluateIntervals(). Minimums and maximums whose operands do
+ * not overlap become their winning operand, and whatever only fed the losing
+ * operand is removed. The copy uses the same registers as the original.
+ */
+void mcFieldProgram_initPruned(
+    mcFieldProgram *self,
+    const mcFieldProgram *program,
+    const float *lower, const float *upper)
+{
+  self->instructions = (mcFieldInstruction*)malloc(
+      sizeof(mcFieldInstruction) * (program->numInstructions + 1));
+  self->numInstructions = 0;
+  self->params = (float*)malloc(sizeof(float) * (program->numParams + 1));
+  memcpy(self->params, program->params, sizeof(float) * program->numParams);
+  self->numParams = program->numParams;
+  self->numRegisters = program->numRegisters;
+  /* Registers replaced by one of their operands */
+  unsigned int *alias =
+    (unsigned int*)malloc(sizeof(unsigned int) * program->numRegisters);
+  for (unsigned int i = 0; i < program->numRegisters; ++i)
+    alias[i] = i;
+  for (unsigned int j = 0; j < program->numInstructions; ++j) {
+    mcFieldInstruction instruction = program->instructions[j];
+    for (int i = 0; i < 3; ++i)
+      instruction.src[i] = alias[instruction.src[i]];
+    unsigned int a = instruction.src[0], b = instruction.src[1];
+    float radius = 0.0f;
+    switch (instruction.op) {
+      case MC_FIELD_SMOOTH_MIN:
+        /* Operands further apart than the radius are not blended */
+        radius = self->params[instruction.params];
+        /* Fall through */
+      case MC_FIELD_MIN:
+        if (upper[a] + radius <= lower[b]) {
+          alias[instruction.dest] = a;
+          continue;
+        }
+        if (upper[b] + radius <= lower[a]) {
+          alias[instruction.dest] = b;
+          continue;
+        }
+        break;
+      case MC_FIELD_MAX:
+        if (lower[a] >= upper[b]) {
+          alias[instruction.dest] = a;
+          continue;
+        }
+        if (lower[b] >= upper[a]) {
+          alias[instruction.dest] = b;
+          continue;
+        }
+        break;
+      default:
+        break;
+    }
+    self->instructions[self->numInstructions++] = instruction;
+  }
+  self->result = alias[program->result];
+  free(alias);
+  mcFieldProgram_removeDeadCode(self);
+}
+
+/**
+ * \internal
+ * A program narrowed to a block of the lattice sampled by
+ * mcFieldProgram_evaluateLattice().
+ * \endinternal
+ */
+typedef struct mcFieldBlock {
+  const mcFieldProgram *program;
+  /** The program pruned to the block, if this block owns one. */
+  mcFieldProgram pruned;
+  /** Scratch registers for evaluating rows. */
+  float *registers;
+} mcFieldBlock;
+
+/**
+ * Bounds the program over a block with interval arithmetic, and prunes it to
+ * the instructions that matter within the block.
+ */
+int mcFieldProgram_boundBlock(
+    const void *args,
+    const mcLatticeBlocks *lattice,
+    const unsigned int *start, const unsigned int *end,
+    float *value,
+    void **narrowed)
+{
+  const mcFieldBlock *block = (const mcFieldBlock*)args;
+  const mcFieldProgram *self = block->program;
+  const float *min = &lattice->min.x, *delta = &lattice->delta.x;
+  float *intervals = (float*)malloc(sizeof(float) * self->numRegisters * 2);
+  float *lower = intervals, *upper = &intervals[self->numRegisters];
+  for (int i = 0; i < 3; ++i) {
+    /* Bound the field a few samples beyond the block. The cubes touching the
+     * block and the samples around them used to estimate normals must not
+     * contain the isosurface if the block is culled. */
+    float first = min[i]
+      + ((float)start[i] - MC_FIELD_PROGRAM_CULL_MARGIN) * delta[i];
+    float last = min[i]
+      + ((float)end[i] - 1.0f + MC_FIELD_PROGRAM_CULL_MARGIN) * delta[i];
+    lower[i] = fminf(first, last);
+    upper[i] = fmaxf(first, last);
+  }
+  mcFieldProgram_evaluateIntervals(self, lower, upper);
+  float lo = lower[self->result], hi = upper[self->result];
+  /* Leave some room for rounding in the bounds */
+  float epsilon = MC_FIELD_PROGRAM_INTERVAL_EPSILON * (fabsf(lo) + fabsf(hi));
+  if (lo - epsilon > 0.0f || hi + epsilon < 0.0f) {
+    /* Any value on the right side of the isosurface will do */
+    *value = lo > 0.0f ? lo : hi;
+    free(intervals);
+    return 1;
+  }
+  mcFieldBlock *child = (mcFieldBlock*)malloc(sizeof(mcFieldBlock));
+  mcFieldProgram_initPruned(&child->pruned, self, lower, upper);
+  child->program = &child->pruned;
+  child->registers = block->registers;
+  free(intervals);
+  *narrowed = child;
+  return 0;
+}
+
+/**
+ * Evaluates every row of a block with the program pruned to it.
+ */
+void mcFieldProgram_sampleBlock(
+    const void *args,
+    const mcLatticeBlocks *lattice,
+    const unsigned int *start, const unsigned int *end)
+{
+  const mcFieldBlock *block = (const mcFieldBlock*)args;
+  const float *min = &lattice->min.x, *delta = &lattice->delta.x;
+  for (unsigned int z = start[2]; z < end[2]; ++z) {
+    for (unsigned int y = start[1]; y < end[1]; ++y) {
+      mcFieldProgram_evaluatePartialRow(block->program, block->registers,
+          min[0], delta[0], start[0],
+          min[1] + (float)y * delta[1],
+          min[2] + (float)z * delta[2],
+          end[0] - start[0],
+          mcLatticeBlocks_sample(lattice, start[0], y, z));
+    }
+  }
+}
+
+void mcFieldProgram_releaseBlock(void *narrowed) {
+  mcFieldBlock *block = (mcFieldBlock*)narrowed;
+  mcFieldProgram_destroy(&block->pruned);
+  free(block);
+}
+
+/**
+ * The lattice sampler of the descriptor made by mcFieldProgram_descriptor().
+ */
+void mcFieldProgram_sampleLattice(
+    const void *args,
+    const mcVec3 *min, const mcVec3 *delta,
+    const unsigned int *start, const unsigned int *res,
+    void **scratch,
+    float *samples)
+{
+  const mcFieldProgram *self = (const mcFieldProgram*)args;
+  (void)scratch;
+  mcLatticeBlocks lattice;
+  lattice.min = *min;
+  lattice.delta = *delta;
+  for (int i = 0; i < 3; ++i) {
+    lattice.start[i] = start[i];
+    lattice.res[i] = res[i];
+  }
+  lattice.samples = samples;
+  lattice.leafSize = MC_FIELD_PROGRAM_LEAF_SIZE;
+  lattice.bound = mcFieldProgram_boundBlock;
+  lattice.sample = mcFieldProgram_sampleBlock;
+  lattice.release = mcFieldProgram_releaseBlock;
+  mcFieldBlock root;
+  root.program = self;
+  root.registers = (float*)malloc(
+      sizeof(float) * self->numRegisters * MC_FIELD_PROGRAM_BATCH_SIZE);
+  mcLatticeBlocks_evaluate(&lattice, &root);
+  free(root.registers);
+}
+
+void mcFieldProgram_evaluateLattice(
+    const mcFieldProgram *self,
+    const mcVec3 *min, const mcVec3 *delta,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    float *samples)
+{
+  const unsigned int start[3] = { 0, 0, 0 };
+  const unsigned int res[3] = { x_res, y_res, z_res };
+  mcFieldProgram_sampleLattice(self, min, delta, start, res, NULL, samples);
+}
+
+void mcFieldProgram_descriptor(
+    const mcFieldProgram *self,
+    mcScalarFieldDescriptor *descriptor)
+{
+  descriptor->sf = mcFieldProgram_scalarField;
+  descriptor->args = self;
+  descriptor->sampleLattice = mcFieldProgram_sampleLattice;
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <mc/heightField.h>
+
+/** The number of samples beyond a lattice along the vertical axis that must
+ * also lie outside the range of heights before mcHeightField_cullLattice()
+ * skips it. */
+#define MC_HEIGHT_FIELD_CULL_MARGIN 2.0f
+
+void mcHeightField_init(
+    mcHeightField *self,
+    mcHeightFunction height,
+    const void *args,
+    int axis,
+    float minHeight, float maxHeight)
+{
+  assert(axis >= 0 && axis < 3);
+  assert(minHeight <= maxHeight);
+  self->height = height;
+  self->args = args;
+  self->axis = axis;
+  self->minHeight = minHeight;
+  self->maxHeight = maxHeight;
+}
+
+/**
+ * Finds the two horizontal axes of the given height field, in increasing
+ * order.
+ */
+void mcHeightField_horizontalAxes(const mcHeightField *self, int *u, int *v)
+{
+  *u = self->axis == 0 ? 1 : 0;
+  *v = self->axis == 2 ? 1 : 2;
+}
+
+float mcHeightField_scalarField(
+    float x, float y, float z,
+    const void *args)
+{
+  const mcHeightField *self = (const mcHeightField*)args;
+  float pos[3] = { x, y, z };
+  int u, v;
+  mcHeightField_horizontalAxes(self, &u, &v);
+  return pos[self->axis] - self->height(pos[u], pos[v], self->args);
+}
+
+/**
+ * Evaluates the height of each column of the given block of a lattice along
+ * the vertical axis. The heights are stored with the lower of the two
+ * horizontal axes varying fastest.
+ */
+void mcHeightField_evaluateColumns(
+    const mcHeightField *self,
+    const mcVec3 *min, const mcVec3 *delta,
+    const unsigned int *start, const unsigned int *res,
+    float *heights)
+{
+  const float *origin = &min->x, *step = &delta->x;
+  int u, v;
+  mcHeightField_horizontalAxes(self, &u, &v);
+  for (unsigned int j = 0; j < res[v]; ++j) {
+    float pos_v = origin[v] + (float)(start[v] + j) * step[v];
+    for (unsigned int i = 0; i < res[u]; ++i) {
+      heights[j * res[u] + i] = self->height(
+          origin[u] + (float)(start[u] + i) * step[u], pos_v, self->args);
+    }
+  }
+}
+
+/**
+ * Fills the samples of the given block of a lattice from the heights of its
+ * columns, as computed by mcHeightField_evaluateColumns(). The samples are
+ * exactly the values of mcHeightField_scalarField().
+ */
+void mcHeightField_fillLattice(
+    const mcHeightField *self,
+    const mcVec3 *min, const mcVec3 *delta,
+    const unsigned int *start, const unsigned int *res,
+    const float *heights,
+    float *samples)
+{
+  int axis = self->axis, u, v;
+  mcHeightField_horizontalAxes(self, &u, &v);
+  unsigned int index[3];
+  for (index[2] = 0; index[2] < res[2]; ++index[2]) {
+    for (index[1] = 0; index[1] < res[1]; ++index[1]) {
+      float *row = &samples[((size_t)index[2] * res[1] + index[1]) * res[0]];
+      for (index[0] = 0; index[0] < res[0]; ++index[0]) {
+        float pos = (&min->x)[axis]
+          + (float)(start[axis] + index[axis]) * (&delta->x)[axis];
+        row[index[0]] = pos - heights[index[v] * res[u] + index[u]];
+      }
+    }
+  }
+}
+
+/**
+ * Fills the samples of the given block of a lattice without evaluating the
+ * height function if the block, grown by a couple of samples along the
+ * vertical axis, lies entirely outside the range of heights. These samples
+ * only keep their sign. Otherwise leaves the samples untouched.
+ *
+ * \return Nonzero if the samples were filled.
+ */
+int mcHeightField_cullLattice(
+    const mcHeightField *self,
+    const mcVec3 *min, const mcVec3 *delta,
+    const unsigned int *start, const unsigned int *res,
+    float *samples)
+{
+  const float *origin = &min->x, *step = &delta->x;
+  int axis = self->axis;
+  /* Find the range of the grown block along the vertical axis */
+  float first = origin[axis]
+    + ((float)start[axis] - MC_HEIGHT_FIELD_CULL_MARGIN) * step[axis];
+  float last = origin[axis]
+    + ((float)(start[axis] + res[axis] - 1) + MC_HEIGHT_FIELD_CULL_MARGIN)
+    * step[axis];
+  float lower = first < last ? first : last;
+  float upper = first < last ? last : first;
+  float height;
+  if (lower > self->maxHeight)
+    height = self->maxHeight;  /* Entirely above the surface */
+  else if (upper < self->minHeight)
+    height = self->minHeight;  /* Entirely below the surface */
+  else
+    return 0;
+  /* Every column of the block has the same samples */
+  unsigned int index[3];
+  for (index[2] = 0; index[2] < res[2]; ++index[2]) {
+    for (index[1] = 0; index[1] < res[1]; ++index[1]) {
+      float *row = &samples[((size_t)index[2] * res[1] + index[1]) * res[0]];
+      for (index[0] = 0; index[0] < res[0]; ++index[0]) {
+        row[index[0]] = origin[axis]
+          + (float)(start[axis] + index[axis]) * step[axis] - height;
+      }
+    }
+  }
+  return 1;
+}
+
+/**
+ * The lattice sampler of the descriptor made by mcHeightField_descriptor().
+ * When the vertical axis is the z-axis, blocks sampled with the same scratch
+ * memory cross the same columns, so their heights are evaluated once and kept
+ * in the scratch memory.
+ */
+void mcHeightField_sampleLattice(
+    const void *args,
+    const mcVec3 *min, const mcVec3 *delta,
+    const unsigned int *start, const unsigned int *res,
+    void **scratch,
+    float *samples)
+{
+  const mcHeightField *self = (const mcHeightField*)args;
+  if (mcHeightField_cullLattice(self, min, delta, start, res, samples))
+    return;
+  int u, v;
+  mcHeightField_horizontalAxes(self, &u, &v);
+  if (self->axis == 2 && scratch != NULL) {
+    if (*scratch == NULL) {
+      *scratch = malloc(sizeof(float) * res[u] * res[v]);
+      mcHeightField_evaluateColumns(self, min, delta, start, res,
+          (float*)*scratch);
+    }
+    mcHeightField_fillLattice(self, min, delta, start, res,
+        (const float*)*scratch, samples);
+    return;
+  }
+  float *heights = (float*)malloc(sizeof(float) * res[u] * res[v]);
+  mcHeightField_evaluateColumns(self, min, delta, start, res, heights);
+  mcHeightField_fillLattice(self, min, delta, start, res, heights, samples);
+  free(heights);
+}
+
+void mcHeightField_evaluateLattice(
+    const mcHeightField *self,
+    const mcVec3 *min, const mcVec3 *delta,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    float *samples)
+{
+  const unsigned int start[3] = { 0, 0, 0 };
+  const unsigned int res[3] = { x_res, y_res, z_res };
+  mcHeightField_sampleLattice(self, min, delta, start, res, NULL, samples);
+}
+
+void mcHeightField_descriptor(
+    const mcHeightField *self,
+    mcScalarFieldDescriptor *descriptor)
+{
+  descriptor->sf = mcHeightField_scalarField;
+  descriptor->args = self;
+  descriptor->sampleLattice = mcHeightField_sampleLattice;
+}
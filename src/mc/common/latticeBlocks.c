@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include <mc/common/latticeBlocks.h>
+
+/**
+ * Samples the block of the lattice from start up to but not including end,
+ * skipping it if the bound callback proves it empty and splitting it in half
+ * along its longest axis while it is large.
+ */
+void mcLatticeBlocks_evaluateBlock(
+    const mcLatticeBlocks *self,
+    const void *args,
+    const unsigned int *start, const unsigned int *end)
+{
+  unsigned int numSamples = 1, longest = 0;
+  for (int i = 0; i < 3; ++i) {
+    numSamples *= end[i] - start[i];
+    if (end[i] - start[i] > end[longest] - start[longest])
+      longest = i;
+  }
+  float value;
+  void *narrowed = NULL;
+  if (self->bound(args, self, start, end, &value, &narrowed)) {
+    /* The isosurface does not pass near this block */
+    assert(narrowed == NULL);
+    for (unsigned int z = start[2]; z < end[2]; ++z) {
+      for (unsigned int y = start[1]; y < end[1]; ++y) {
+        float *row = mcLatticeBlocks_sample(self, start[0], y, z);
+        for (unsigned int x = 0; x < end[0] - start[0]; ++x)
+          row[x] = value;
+      }
+    }
+    return;
+  }
+  const void *blockArgs = narrowed != NULL ? narrowed : args;
+  if (numSamples <= self->leafSize || end[longest] - start[longest] == 1) {
+    self->sample(blockArgs, self, start, end);
+  } else {
+    /* Split the block in half along its longest axis */
+    unsigned int middle[3] = { end[0], end[1], end[2] };
+    middle[longest] = start[longest] + (end[longest] - start[longest]) / 2;
+    mcLatticeBlocks_evaluateBlock(self, blockArgs, start, middle);
+    memcpy(middle, start, sizeof(middle));
+    middle[longest] = start[longest] + (end[longest] - start[longest]) / 2;
+    mcLatticeBlocks_evaluateBlock(self, blockArgs, middle, end);
+  }
+  if (narrowed != NULL)
+    self->release(narrowed);
+}
+
+void mcLatticeBlocks_evaluate(
+    const mcLatticeBlocks *self,
+    const void *args)
+{
+  unsigned int end[3];
+  for (int i = 0; i < 3; ++i)
+    end[i] = self->start[i] + self->res[i];
+  mcLatticeBlocks_evaluateBlock(self, args, self->start, end);
+}
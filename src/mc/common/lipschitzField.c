@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+
+#include <mc/common/latticeBlocks.h>
+#include <mc/lipschitzField.h>
+
+/** The number of samples beyond a block that must also be proven empty before
+ * mcLipschitzField_evaluateLattice() skips it. */
+#define MC_LIPSCHITZ_FIELD_CULL_MARGIN 2.0f
+/** The relative slack added to the bound before skipping a block, which
+ * covers the rounding in computing it. */
+#define MC_LIPSCHITZ_FIELD_EPSILON 1.0e-5f
+/** The number of samples in blocks that are sampled without subdividing them
+ * further. */
+#define MC_LIPSCHITZ_FIELD_LEAF_SIZE 16
+
+void mcLipschitzField_init(
+    mcLipschitzField *self,
+    mcScalarFieldWithArgs sf,
+    const void *args,
+    float lipschitz)
+{
+  assert(lipschitz > 0.0f);
+  self->sf = sf;
+  self->args = args;
+  self->lipschitz = lipschitz;
+}
+
+float mcLipschitzField_scalarField(
+    float x, float y, float z,
+    const void *args)
+{
+  const mcLipschitzField *self = (const mcLipschitzField*)args;
+  return self->sf(x, y, z, self->args);
+}
+
+/**
+ * Bounds the field over a block by its value at the center of the block.
+ * Blocks small enough to be sampled directly are not bounded, since they cost
+ * little more to sample than to test.
+ */
+int mcLipschitzField_boundBlock(
+    const void *args,
+    const mcLatticeBlocks *lattice,
+    const unsigned int *start, const unsigned int *end,
+    float *value,
+    void **narrowed)
+{
+  const mcLipschitzField *self = (const mcLipschitzField*)args;
+  const float *min = &lattice->min.x, *delta = &lattice->delta.x;
+  (void)narrowed;
+  unsigned int numSamples = 1;
+  float center[3], halfDiagonal = 0.0f;
+  for (int i = 0; i < 3; ++i) {
+    float halfWidth = (float)(end[i] - 1 - start[i]) * 0.5f;
+    center[i] = min[i] + ((float)start[i] + halfWidth) * delta[i];
+    float half = (halfWidth + MC_LIPSCHITZ_FIELD_CULL_MARGIN) * delta[i];
+    halfDiagonal += half * half;
+    numSamples *= end[i] - start[i];
+  }
+  if (numSamples <= lattice->leafSize)
+    return 0;
+  *value = self->sf(center[0], center[1], center[2], self->args);
+  float bound = self->lipschitz * sqrtf(halfDiagonal)
+    * (1.0f + MC_LIPSCHITZ_FIELD_EPSILON);
+  return fabsf(*value) > bound;
+}
+
+/**
+ * Samples every point of a block that the isosurface may pass near.
+ */
+void mcLipschitzField_sampleBlock(
+    const void *args,
+    const mcLatticeBlocks *lattice,
+    const unsigned int *start, const unsigned int *end)
+{
+  const mcLipschitzField *self = (const mcLipschitzField*)args;
+  const float *min = &lattice->min.x, *delta = &lattice->delta.x;
+  for (unsigned int z = start[2]; z < end[2]; ++z) {
+    float pos_z = min[2] + (float)z * delta[2];
+    for (unsigned int y = start[1]; y < end[1]; ++y) {
+      float pos_y = min[1] + (float)y * delta[1];
+      float *row = mcLatticeBlocks_sample(lattice, start[0], y, z);
+      for (unsigned int x = start[0]; x < end[0]; ++x) {
+        row[x - start[0]] = self->sf(min[0] + (float)x * delta[0],
+            pos_y, pos_z, self->args);
+      }
+    }
+  }
+}
+
+/**
+ * The lattice sampler of the descriptor made by mcLipschitzField_descriptor().
+ */
+void mcLipschitzField_sampleLattice(
+    const void *args,
+    const mcVec3 *min, const mcVec3 *delta,
+    const unsigned int *start, const unsigned int *res,
+    void **scratch,
+    float *samples)
+{
+  (void)scratch;
+  mcLatticeBlocks lattice;
+  lattice.min = *min;
+  lattice.delta = *delta;
+  for (int i = 0; i < 3; ++i) {
+    lattice.start[i] = start[i];
+    lattice.res[i] = res[i];
+  }
+  lattice.samples = samples;
+  lattice.leafSize = MC_LIPSCHITZ_FIELD_LEAF_SIZE;
+  lattice.bound = mcLipschitzField_boundBlock;
+  lattice.sample = mcLipschitzField_sampleBlock;
+  lattice.release = NULL;
+  mcLatticeBlocks_evaluate(&lattice, args);
+}
+
+void mcLipschitzField_evaluateLattice(
+    const mcLipschitzField *self,
+    const mcVec3 *min, const mcVec3 *delta,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    float *samples)
+{
+  const unsigned int start[3] = { 0, 0, 0 };
+  const unsigned int res[3] = { x_res, y_res, z_res };
+  mcLipschitzField_sampleLattice(self, min, delta, start, res, NULL, samples);
+}
+
+void mcLipschitzField_descriptor(
+    const mcLipschitzField *self,
+    mcScalarFieldDescriptor *descriptor)
+{
+  descriptor->sf = mcLipschitzField_scalarField;
+  descriptor->args = self;
+  descriptor->sampleLattice = mcLipschitzField_sampleLattice;
+}
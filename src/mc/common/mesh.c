@@ -93,6 +93,26 @@ void mcMesh_destroy(
   free(self->vertices);
 }
 
+void mcMesh_copy(
+    mcMesh *self,
+    const mcMesh *other)
+{
+  /* Allocate just enough memory for the vertices and faces being copied */
+  self->sizeVertices = other->numVertices > 0 ? other->numVertices : 1;
+  self->vertices = (mcVertex*)malloc(sizeof(mcVertex) * self->sizeVertices);
+  memcpy(self->vertices, other->vertices,
+      sizeof(mcVertex) * other->numVertices);
+  self->numVertices = other->numVertices;
+  self->sizeFaces = other->numFaces > 0 ? other->numFaces : 1;
+  self->faces = (mcFace*)malloc(sizeof(mcFace) * self->sizeFaces);
+  for (unsigned int i = 0; i < other->numFaces; ++i) {
+    mcFace_copy(&self->faces[i], &other->faces[i]);
+  }
+  self->numFaces = other->numFaces;
+  self->numIndices = other->numIndices;
+  self->isTriangleMesh = other->isTriangleMesh;
+}
+
 void mcMesh_growVertices(
     mcMesh *self)
 {
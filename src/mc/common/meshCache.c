@@ -0,0 +1,302 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mc/meshCache.h>
+
+#define MC_MESH_CACHE_INIT_NUM_BUCKETS 64
+
+struct mcMeshCacheEntry {
+  mcMeshCacheKey key;
+  uint64_t hash;
+  mcMesh mesh;
+  size_t size;
+  /** The next entry in the same hash table bucket. */
+  mcMeshCacheEntry *chain;
+  /** The neighboring entries in the least recently used list. */
+  mcMeshCacheEntry *prev, *next;
+};
+
+uint64_t mcMeshCache_hashBytes(
+    const void *bytes,
+    size_t size,
+    uint64_t hash)
+{
+  const unsigned char *data = (const unsigned char*)bytes;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+/**
+ * Hashes each member of the key separately, so that padding bytes are never
+ * read.
+ */
+uint64_t mcMeshCache_hashKey(
+    const mcMeshCacheKey *key)
+{
+  uint64_t hash = MC_MESH_CACHE_HASH_INIT;
+  hash = mcMeshCache_hashBytes(&key->sf, sizeof(key->sf), hash);
+  hash = mcMeshCache_hashBytes(&key->args, sizeof(key->args), hash);
+  hash = mcMeshCache_hashBytes(&key->fieldVersion,
+      sizeof(key->fieldVersion), hash);
+  hash = mcMeshCache_hashBytes(&key->algorithm, sizeof(key->algorithm), hash);
+  hash = mcMeshCache_hashBytes(&key->paramsHash,
+      sizeof(key->paramsHash), hash);
+  hash = mcMeshCache_hashBytes(key->res, sizeof(key->res), hash);
+  hash = mcMeshCache_hashBytes(&key->min, sizeof(key->min), hash);
+  hash = mcMeshCache_hashBytes(&key->max, sizeof(key->max), hash);
+  return hash;
+}
+
+int mcMeshCache_keysEqual(
+    const mcMeshCacheKey *a,
+    const mcMeshCacheKey *b)
+{
+  return a->sf == b->sf
+    && a->args == b->args
+    && a->fieldVersion == b->fieldVersion
+    && a->algorithm == b->algorithm
+    && a->paramsHash == b->paramsHash
+    && a->res[0] == b->res[0]
+    && a->res[1] == b->res[1]
+    && a->res[2] == b->res[2]
+    && memcmp(&a->min, &b->min, sizeof(a->min)) == 0
+    && memcmp(&a->max, &b->max, sizeof(a->max)) == 0;
+}
+
+size_t mcMeshCache_meshSize(
+    const mcMesh *mesh)
+{
+  return sizeof(mcVertex) * mesh->numVertices
+    + sizeof(mcFace) * mesh->numFaces
+    + sizeof(unsigned int) * mesh->numIndices;
+}
+
+void mcMeshCache_init(
+    mcMeshCache *self,
+    size_t budget)
+{
+  pthread_mutex_init(&self->mutex, NULL);
+  self->numBuckets = MC_MESH_CACHE_INIT_NUM_BUCKETS;
+  self->buckets = (mcMeshCacheEntry**)malloc(
+      sizeof(mcMeshCacheEntry*) * self->numBuckets);
+  memset(self->buckets, 0, sizeof(mcMeshCacheEntry*) * self->numBuckets);
+  self->numEntries = 0;
+  self->head = NULL;
+  self->tail = NULL;
+  self->budget = budget;
+  self->size = 0;
+  self->hits = 0;
+  self->misses = 0;
+}
+
+/**
+ * Removes all entries without locking the mutex.
+ */
+void mcMeshCache_removeAll(
+    mcMeshCache *self)
+{
+  mcMeshCacheEntry *entry = self->head;
+  while (entry != NULL) {
+    mcMeshCacheEntry *next = entry->next;
+    mcMesh_destroy(&entry->mesh);
+    free(entry);
+    entry = next;
+  }
+  memset(self->buckets, 0, sizeof(mcMeshCacheEntry*) * self->numBuckets);
+  self->numEntries = 0;
+  self->head = NULL;
+  self->tail = NULL;
+  self->size = 0;
+}
+
+void mcMeshCache_destroy(
+    mcMeshCache *self)
+{
+  mcMeshCache_removeAll(self);
+  free(self->buckets);
+  pthread_mutex_destroy(&self->mutex);
+}
+
+void mcMeshCache_clear(
+    mcMeshCache *self)
+{
+  pthread_mutex_lock(&self->mutex);
+  mcMeshCache_removeAll(self);
+  pthread_mutex_unlock(&self->mutex);
+}
+
+/**
+ * Unlinks the given entry from the least recently used list.
+ */
+void mcMeshCache_unlink(
+    mcMeshCache *self,
+    mcMeshCacheEntry *entry)
+{
+  if (entry->prev != NULL)
+    entry->prev->next = entry->next;
+  else
+    self->head = entry->next;
+  if (entry->next != NULL)
+    entry->next->prev = entry->prev;
+  else
+    self->tail = entry->prev;
+}
+
+/**
+ * Links the given entry at the front of the least recently used list.
+ */
+void mcMeshCache_pushFront(
+    mcMeshCache *self,
+    mcMeshCacheEntry *entry)
+{
+  entry->prev = NULL;
+  entry->next = self->head;
+  if (self->head != NULL)
+    self->head->prev = entry;
+  else
+    self->tail = entry;
+  self->head = entry;
+}
+
+mcMeshCacheEntry *mcMeshCache_find(
+    mcMeshCache *self,
+    const mcMeshCacheKey *key,
+    uint64_t hash)
+{
+  mcMeshCacheEntry *entry = self->buckets[hash & (self->numBuckets - 1)];
+  while (entry != NULL) {
+    if (entry->hash == hash && mcMeshCache_keysEqual(&entry->key, key))
+      return entry;
+    entry = entry->chain;
+  }
+  return NULL;
+}
+
+/**
+ * Removes the least recently used entry.
+ */
+void mcMeshCache_evict(
+    mcMeshCache *self)
+{
+  mcMeshCacheEntry *entry = self->tail;
+  assert(entry != NULL);
+  /* Remove the entry from its bucket */
+  mcMeshCacheEntry **link =
+    &self->buckets[entry->hash & (self->numBuckets - 1)];
+  while (*link != entry)
+    link = &(*link)->chain;
+  *link = entry->chain;
+  mcMeshCache_unlink(self, entry);
+  self->size -= entry->size;
+  self->numEntries -= 1;
+  mcMesh_destroy(&entry->mesh);
+  free(entry);
+}
+
+/**
+ * Doubles the number of hash table buckets.
+ */
+void mcMeshCache_growBuckets(
+    mcMeshCache *self)
+{
+  unsigned int numBuckets = self->numBuckets * 2;
+  mcMeshCacheEntry **buckets = (mcMeshCacheEntry**)malloc(
+      sizeof(mcMeshCacheEntry*) * numBuckets);
+  memset(buckets, 0, sizeof(mcMeshCacheEntry*) * numBuckets);
+  for (mcMeshCacheEntry *entry = self->head; entry != NULL;
+      entry = entry->next)
+  {
+    mcMeshCacheEntry **bucket = &buckets[entry->hash & (numBuckets - 1)];
+    entry->chain = *bucket;
+    *bucket = entry;
+  }
+  free(self->buckets);
+  self->buckets = buckets;
+  self->numBuckets = numBuckets;
+}
+
+int mcMeshCache_lookup(
+    mcMeshCache *self,
+    const mcMeshCacheKey *key,
+    mcMesh *mesh)
+{
+  uint64_t hash = mcMeshCache_hashKey(key);
+  pthread_mutex_lock(&self->mutex);
+  mcMeshCacheEntry *entry = mcMeshCache_find(self, key, hash);
+  if (entry != NULL) {
+    /* NOTE: The mesh is copied while holding the lock, since another thread
+     * could evict the entry as soon as we release it */
+    mcMeshCache_unlink(self, entry);
+    mcMeshCache_pushFront(self, entry);
+    mcMesh_copy(mesh, &entry->mesh);
+    self->hits += 1;
+  } else {
+    self->misses += 1;
+  }
+  pthread_mutex_unlock(&self->mutex);
+  return entry != NULL;
+}
+
+void mcMeshCache_insert(
+    mcMeshCache *self,
+    const mcMeshCacheKey *key,
+    const mcMesh *mesh)
+{
+  size_t size = mcMeshCache_meshSize(mesh);
+  if (size > self->budget)
+    return;
+  /* Copy the mesh before taking the lock */
+  uint64_t hash = mcMeshCache_hashKey(key);
+  mcMeshCacheEntry *entry =
+    (mcMeshCacheEntry*)malloc(sizeof(mcMeshCacheEntry));
+  entry->key = *key;
+  entry->hash = hash;
+  mcMesh_copy(&entry->mesh, mesh);
+  entry->size = size;
+  pthread_mutex_lock(&self->mutex);
+  if (mcMeshCache_find(self, key, hash) != NULL) {
+    /* Another thread extracted the same mesh first */
+    pthread_mutex_unlock(&self->mutex);
+    mcMesh_destroy(&entry->mesh);
+    free(entry);
+    return;
+  }
+  while (self->size + size > self->budget)
+    mcMeshCache_evict(self);
+  if (self->numEntries >= self->numBuckets)
+    mcMeshCache_growBuckets(self);
+  mcMeshCacheEntry **bucket = &self->buckets[hash & (self->numBuckets - 1)];
+  entry->chain = *bucket;
+  *bucket = entry;
+  mcMeshCache_pushFront(self, entry);
+  self->size += size;
+  self->numEntries += 1;
+  pthread_mutex_unlock(&self->mutex);
+}
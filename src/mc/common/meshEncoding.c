@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mc/meshEncoding.h>
+
+/* NOTE: The encoding is little-endian, and values are copied to and from the
+ * buffer in native byte order, so big-endian hosts are not supported. */
+
+#define MC_MESH_ENCODING_POSITION_MAX 65535.0f
+#define MC_MESH_ENCODING_NORMAL_MAX 32767.0f
+
+static inline uint32_t mcMeshEncoding_align(uint32_t offset) {
+  return (offset + 3u) & ~3u;
+}
+
+static inline float mcMeshEncoding_sign(float value) {
+  return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+/**
+ * Projects the given normal onto the octahedron |x| + |y| + |z| = 1 and
+ * unfolds the lower half of the octahedron onto the corners of the square,
+ * giving two coordinates in [-1, 1].
+ */
+static inline void mcMeshEncoding_encodeNormal(const mcVec3 *normal,
+    int16_t *encoded)
+{
+  float length = fabsf(normal->x) + fabsf(normal->y) + fabsf(normal->z);
+  float u = 0.0f, v = 0.0f;
+  if (length > 0.0f) {
+    u = normal->x / length;
+    v = normal->y / length;
+    if (normal->z < 0.0f) {
+      float foldedU = (1.0f - fabsf(v)) * mcMeshEncoding_sign(u);
+      float foldedV = (1.0f - fabsf(u)) * mcMeshEncoding_sign(v);
+      u = foldedU;
+      v = foldedV;
+    }
+  }
+  encoded[0] = (int16_t)lrintf(u * MC_MESH_ENCODING_NORMAL_MAX);
+  encoded[1] = (int16_t)lrintf(v * MC_MESH_ENCODING_NORMAL_MAX);
+}
+
+static inline void mcMeshEncoding_decodeNormal(const int16_t *encoded,
+    float *normal)
+{
+  float u = (float)encoded[0] * (1.0f / MC_MESH_ENCODING_NORMAL_MAX);
+  float v = (float)encoded[1] * (1.0f / MC_MESH_ENCODING_NORMAL_MAX);
+  float z = 1.0f - fabsf(u) - fabsf(v);
+  if (z < 0.0f) {
+    /* Fold the corners of the square back onto the lower half */
+    float unfoldedU = (1.0f - fabsf(v)) * mcMeshEncoding_sign(u);
+    float unfoldedV = (1.0f - fabsf(u)) * mcMeshEncoding_sign(v);
+    u = unfoldedU;
+    v = unfoldedV;
+  }
+  float length = sqrtf(u * u + v * v + z * z);
+  normal[0] = u / length;
+  normal[1] = v / length;
+  normal[2] = z / length;
+}
+
+size_t mcMeshEncoding_encodedSizeBound(
+    const mcMesh *mesh)
+{
+  /* Each index delta takes at most five bytes */
+  return sizeof(mcEncodedMeshHeader)
+    + mcMeshEncoding_align(6 * mesh->numVertices)
+    + 4 * mesh->numVertices
+    + mcMeshEncoding_align(mesh->numFaces)
+    + 5 * (size_t)mesh->numIndices;
+}
+
+size_t mcMeshEncoding_encode(
+    const mcMesh *mesh,
+    void *buffer,
+    size_t bufferSize)
+{
+  unsigned char *bytes = (unsigned char*)buffer;
+  mcEncodedMeshHeader header;
+  assert(bufferSize >= mcMeshEncoding_encodedSizeBound(mesh));
+  header.magic = MC_ENCODED_MESH_MAGIC;
+  header.numVertices = mesh->numVertices;
+  header.numFaces = mesh->numFaces;
+  header.numIndices = mesh->numIndices;
+  header.isTriangleMesh = mesh->isTriangleMesh ? 1 : 0;
+  header.positionsOffset = sizeof(mcEncodedMeshHeader);
+  header.normalsOffset = mcMeshEncoding_align(
+      header.positionsOffset + 6 * mesh->numVertices);
+  header.facesOffset = header.normalsOffset + 4 * mesh->numVertices;
+  /* Quantize positions within the bounding box of the mesh */
+  float max[3];
+  for (int i = 0; i < 3; ++i) {
+    header.min[i] = mesh->numVertices > 0 ? FLT_MAX : 0.0f;
+    max[i] = mesh->numVertices > 0 ? -FLT_MAX : 0.0f;
+  }
+  for (unsigned int i = 0; i < mesh->numVertices; ++i) {
+    const float pos[3] = { mesh->vertices[i].pos.x,
+      mesh->vertices[i].pos.y, mesh->vertices[i].pos.z };
+    for (int j = 0; j < 3; ++j) {
+      header.min[j] = fminf(header.min[j], pos[j]);
+      max[j] = fmaxf(max[j], pos[j]);
+    }
+  }
+  for (int i = 0; i < 3; ++i)
+    header.scale[i] = (max[i] - header.min[i]) / MC_MESH_ENCODING_POSITION_MAX;
+  for (unsigned int i = 0; i < mesh->numVertices; ++i) {
+    const float pos[3] = { mesh->vertices[i].pos.x,
+      mesh->vertices[i].pos.y, mesh->vertices[i].pos.z };
+    uint16_t quantized[3];
+    int16_t normal[2];
+    for (int j = 0; j < 3; ++j) {
+      float q = header.scale[j] > 0.0f
+        ? (pos[j] - header.min[j]) / header.scale[j] : 0.0f;
+      q = fminf(fmaxf(q, 0.0f), MC_MESH_ENCODING_POSITION_MAX);
+      quantized[j] = (uint16_t)lrintf(q);
+    }
+    memcpy(bytes + header.positionsOffset + 6 * i, quantized,
+        sizeof(quantized));
+    mcMeshEncoding_encodeNormal(&mesh->vertices[i].norm, normal);
+    memcpy(bytes + header.normalsOffset + 4 * i, normal, sizeof(normal));
+  }
+  /* Store the face sizes, unless they are all three */
+  uint32_t offset = header.facesOffset;
+  if (!header.isTriangleMesh) {
+    for (unsigned int i = 0; i < mesh->numFaces; ++i) {
+      assert(mesh->faces[i].numIndices <= 255);
+      bytes[offset++] = (unsigned char)mesh->faces[i].numIndices;
+    }
+    offset = mcMeshEncoding_align(offset);
+  }
+  /* Store each index as a variable length zig-zag encoded delta */
+  int64_t previous = 0;
+  for (unsigned int i = 0; i < mesh->numFaces; ++i) {
+    const mcFace *face = &mesh->faces[i];
+    for (unsigned int j = 0; j < face->numIndices; ++j) {
+      int64_t delta = (int64_t)face->indices[j] - previous;
+      uint64_t zigzag = delta >= 0 ? (uint64_t)delta << 1
+        : ((uint64_t)(-delta) << 1) - 1;
+      previous = face->indices[j];
+      do {
+        unsigned char byte = zigzag & 0x7f;
+        zigzag >>= 7;
+        bytes[offset++] = byte | (zigzag ? 0x80 : 0x00);
+      } while (zigzag);
+    }
+  }
+  header.size = offset;
+  memcpy(bytes, &header, sizeof(header));
+  return offset;
+}
+
+const mcEncodedMeshHeader *mcMeshEncoding_header(
+    const void *buffer,
+    size_t size)
+{
+  const mcEncodedMeshHeader *header = (const mcEncodedMeshHeader*)buffer;
+  /* The fixed size sections are read in place, so they must be aligned */
+  assert(((uintptr_t)buffer & 3) == 0);
+  if (size < sizeof(mcEncodedMeshHeader)
+      || header->magic != MC_ENCODED_MESH_MAGIC
+      || header->size > size)
+    return NULL;
+  if (header->positionsOffset < sizeof(mcEncodedMeshHeader)
+      || (header->positionsOffset & 3) || (header->normalsOffset & 3)
+      || header->normalsOffset < header->positionsOffset
+      || (header->normalsOffset - header->positionsOffset) / 6
+        < header->numVertices
+      || header->facesOffset < header->normalsOffset
+      || (header->facesOffset - header->normalsOffset) / 4
+        < header->numVertices
+      || header->facesOffset > header->size)
+    return NULL;
+  if (header->isTriangleMesh
+      && (uint64_t)header->numFaces * 3 != header->numIndices)
+    return NULL;
+  return header;
+}
+
+int mcMeshEncoding_decodeArrays(
+    const void *buffer,
+    float *positions,
+    float *normals,
+    unsigned int *indices,
+    unsigned char *faceSizes)
+{
+  const mcEncodedMeshHeader *header = (const mcEncodedMeshHeader*)buffer;
+  const unsigned char *bytes = (const unsigned char*)buffer;
+  unsigned int numVertices = header->numVertices;
+  if (positions) {
+    const uint16_t *quantized =
+      (const uint16_t*)(bytes + header->positionsOffset);
+    const float min[3] = { header->min[0], header->min[1], header->min[2] };
+    const float scale[3] = {
+      header->scale[0], header->scale[1], header->scale[2] };
+    /* A simple loop over contiguous arrays that compilers vectorize */
+    for (unsigned int i = 0; i < numVertices; ++i) {
+      positions[i * 3] = min[0] + (float)quantized[i * 3] * scale[0];
+      positions[i * 3 + 1] = min[1] + (float)quantized[i * 3 + 1] * scale[1];
+      positions[i * 3 + 2] = min[2] + (float)quantized[i * 3 + 2] * scale[2];
+    }
+  }
+  if (normals) {
+    const int16_t *encoded = (const int16_t*)(bytes + header->normalsOffset);
+    for (unsigned int i = 0; i < numVertices; ++i)
+      mcMeshEncoding_decodeNormal(&encoded[i * 2], &normals[i * 3]);
+  }
+  /* Decode the faces */
+  uint32_t offset = header->facesOffset;
+  if (!header->isTriangleMesh) {
+    uint64_t numIndices = 0;
+    if (offset + (uint64_t)header->numFaces > header->size)
+      return 0;
+    for (unsigned int i = 0; i < header->numFaces; ++i) {
+      numIndices += bytes[offset + i];
+      if (faceSizes)
+        faceSizes[i] = bytes[offset + i];
+    }
+    if (numIndices != header->numIndices)
+      return 0;
+    offset = mcMeshEncoding_align(offset + header->numFaces);
+  } else if (faceSizes) {
+    memset(faceSizes, 3, header->numFaces);
+  }
+  if (!indices)
+    return 1;
+  int64_t previous = 0;
+  for (unsigned int i = 0; i < header->numIndices; ++i) {
+    uint64_t zigzag = 0;
+    int shift = 0;
+    unsigned char byte;
+    do {
+      if (offset >= header->size || shift > 35)
+        return 0;
+      byte = bytes[offset++];
+      zigzag |= (uint64_t)(byte & 0x7f) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+    int64_t delta = (zigzag & 1) ? -(int64_t)((zigzag + 1) >> 1)
+      : (int64_t)(zigzag >> 1);
+    previous += delta;
+    if (previous < 0 || previous >= numVertices)
+      return 0;
+    indices[i] = (unsigned int)previous;
+  }
+  return 1;
+}
+
+int mcMeshEncoding_decode(
+    const void *buffer,
+    size_t size,
+    mcMesh *mesh)
+{
+  const mcEncodedMeshHeader *header = mcMeshEncoding_header(buffer, size);
+  if (header == NULL)
+    return 0;
+  unsigned int numVertices = header->numVertices;
+  unsigned int numFaces = header->numFaces;
+  float *positions = (float*)malloc(sizeof(float) * 3 * (numVertices + 1));
+  float *normals = (float*)malloc(sizeof(float) * 3 * (numVertices + 1));
+  unsigned int *indices = (unsigned int*)malloc(
+      sizeof(unsigned int) * (header->numIndices + 1));
+  unsigned char *faceSizes = (unsigned char*)malloc(numFaces + 1);
+  int result = mcMeshEncoding_decodeArrays(buffer, positions, normals,
+      indices, faceSizes);
+  if (result) {
+    /* Add the vertices and faces, offsetting the indices by the vertices
+     * already in the mesh */
+    unsigned int firstVertex = mesh->numVertices;
+    for (unsigned int i = 0; i < numVertices; ++i) {
+      mcVertex vertex;
+      vertex.pos.x = positions[i * 3];
+      vertex.pos.y = positions[i * 3 + 1];
+      vertex.pos.z = positions[i * 3 + 2];
+      vertex.norm.x = normals[i * 3];
+      vertex.norm.y = normals[i * 3 + 1];
+      vertex.norm.z = normals[i * 3 + 2];
+      mcMesh_addVertex(mesh, &vertex);
+    }
+    while (mesh->sizeFaces < mesh->numFaces + numFaces)
+      mcMesh_growFaces(mesh);
+    const unsigned int *faceIndices = indices;
+    for (unsigned int i = 0; i < numFaces; ++i) {
+      mcFace *face = &mesh->faces[mesh->numFaces + i];
+      mcFace_init(face, faceSizes[i]);
+      for (unsigned int j = 0; j < faceSizes[i]; ++j)
+        face->indices[j] = firstVertex + faceIndices[j];
+      faceIndices += faceSizes[i];
+    }
+    mesh->numFaces += numFaces;
+    mesh->numIndices += header->numIndices;
+    if (!header->isTriangleMesh)
+      mesh->isTriangleMesh = 0;
+  }
+  free(positions);
+  free(normals);
+  free(indices);
+  free(faceSizes);
+  return result;
+}
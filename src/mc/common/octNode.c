@@ -24,3 +24,4 @@
 #include <mc/common/octNode.h>
 
 MC_DEFINE_Z_ORDER_NODE(Oct, 3)
+MC_DEFINE_LINEAR_Z_ORDER_TREE(Oct, 3)
@@ -24,3 +24,4 @@
 #include <mc/common/quadNode.h>
 
 MC_DEFINE_Z_ORDER_NODE(Quad, 2)
+MC_DEFINE_LINEAR_Z_ORDER_TREE(Quad, 2)
@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mc/sampleGrid.h>
+
+/** Lattice coordinates this close to a lattice point are snapped to it, so
+ * that positions computed by algorithms with slightly different floating point
+ * arithmetic still read the stored samples exactly. */
+#define MC_SAMPLE_GRID_SNAP_EPSILON 1.0e-4f
+
+/**
+ * Allocates the samples of a sample grid with the given resolution and
+ * bounds, without sampling anything yet.
+ */
+void mcSampleGrid_initLattice(
+    mcSampleGrid *self,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max)
+{
+  assert(x_res >= 2 && y_res >= 2 && z_res >= 2);
+  self->samples =
+    (float*)malloc(sizeof(float) * x_res * y_res * z_res);
+  self->size[0] = self->res[0] = x_res;
+  self->size[1] = self->res[1] = y_res;
+  self->size[2] = self->res[2] = z_res;
+  self->stride = 1;
+  self->min = *min;
+  self->max = *max;
+  self->delta.x = (max->x - min->x) / (float)(x_res - 1);
+  self->delta.y = (max->y - min->y) / (float)(y_res - 1);
+  self->delta.z = (max->z - min->z) / (float)(z_res - 1);
+  self->ownsSamples = 1;
+}
+
+void mcSampleGrid_init(
+    mcSampleGrid *self,
+    mcScalarFieldWithArgs sf,
+    const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max)
+{
+  mcSampleGrid_initLattice(self, x_res, y_res, z_res, min, max);
+  mcScalarFieldDescriptor field;
+  mcScalarFieldDescriptor_initFromField(&field, sf, args);
+  if (field.sampleLattice != NULL) {
+    /* Let the lattice sampler see the whole lattice at once */
+    const unsigned int start[3] = { 0, 0, 0 };
+    void *scratch = NULL;
+    mcScalarFieldDescriptor_sampleLattice(&field, min, &self->delta,
+        start, self->res, &scratch, self->samples);
+    free(scratch);
+    return;
+  }
+  /* Sample the lattice one xy-slice per iteration */
+#pragma omp parallel for schedule(static)
+  for (int z = 0; z < (int)z_res; ++z) {
+    float *slice = &self->samples[(size_t)z * x_res * y_res];
+    float pos_z = min->z + (float)z * self->delta.z;
+    for (unsigned int y = 0; y < y_res; ++y) {
+      float pos_y = min->y + (float)y * self->delta.y;
+      for (unsigned int x = 0; x < x_res; ++x) {
+        slice[y * x_res + x] =
+          sf(min->x + (float)x * self->delta.x, pos_y, pos_z, args);
+      }
+    }
+  }
+}
+
+/**
+ * Finds the coarse cells along one axis that contain the given lattice index.
+ * Indices on the boundary between two cells are contained by both.
+ */
+void mcSampleGrid_coarseCells(
+    unsigned int index, unsigned int step, unsigned int numCells,
+    unsigned int *first, unsigned int *last)
+{
+  *last = index / step < numCells ? index / step : numCells - 1;
+  *first = index % step == 0 && index > 0 ? index / step - 1 : *last;
+  if (*first > *last)
+    *first = *last;
+}
+
+void mcSampleGrid_initCoarseToFine(
+    mcSampleGrid *self,
+    mcScalarFieldWithArgs sf,
+    const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max,
+    unsigned int step, unsigned int dilation)
+{
+  assert(step >= 1);
+  mcSampleGrid_initLattice(self, x_res, y_res, z_res, min, max);
+  const unsigned int *res = self->res;
+  const float *lo = &min->x, *delta = &self->delta.x;
+  unsigned int numCells[3], *firstCell[3], *lastCell[3];
+  for (int i = 0; i < 3; ++i) {
+    numCells[i] = (res[i] - 1 + step - 1) / step;
+    firstCell[i] = (unsigned int*)malloc(sizeof(unsigned int) * res[i] * 2);
+    lastCell[i] = &firstCell[i][res[i]];
+    for (unsigned int j = 0; j < res[i]; ++j) {
+      mcSampleGrid_coarseCells(j, step, numCells[i],
+          &firstCell[i][j], &lastCell[i][j]);
+    }
+  }
+#define MC_SAMPLE_GRID_INDEX(x, y, z) \
+  (((size_t)(z) * res[1] + (y)) * res[0] + (x))
+#define MC_SAMPLE_GRID_COARSE(i, axis) \
+  ((i) * step < res[axis] - 1 ? (i) * step : res[axis] - 1)
+  /* Sample the coarse lattice, whose points are also points of the fine
+   * lattice */
+#pragma omp parallel for schedule(static)
+  for (int k = 0; k <= (int)numCells[2]; ++k) {
+    unsigned int z = MC_SAMPLE_GRID_COARSE((unsigned int)k, 2);
+    for (unsigned int j = 0; j <= numCells[1]; ++j) {
+      unsigned int y = MC_SAMPLE_GRID_COARSE(j, 1);
+      for (unsigned int i = 0; i <= numCells[0]; ++i) {
+        unsigned int x = MC_SAMPLE_GRID_COARSE(i, 0);
+        self->samples[MC_SAMPLE_GRID_INDEX(x, y, z)] = sf(
+            lo[0] + (float)x * delta[0],
+            lo[1] + (float)y * delta[1],
+            lo[2] + (float)z * delta[2],
+            args);
+      }
+    }
+  }
+  /* Refine the coarse cells whose corners change sign, along with their
+   * neighbors out to the dilation */
+  size_t totalCells = (size_t)numCells[0] * numCells[1] * numCells[2];
+  unsigned char *refine = (unsigned char*)malloc(totalCells);
+  memset(refine, 0, totalCells);
+  for (unsigned int k = 0; k < numCells[2]; ++k) {
+    for (unsigned int j = 0; j < numCells[1]; ++j) {
+      for (unsigned int i = 0; i < numCells[0]; ++i) {
+        int numInside = 0;
+        for (int n = 0; n < 8; ++n) {
+          unsigned int x = MC_SAMPLE_GRID_COARSE(i + (n & 1), 0);
+          unsigned int y = MC_SAMPLE_GRID_COARSE(j + ((n >> 1) & 1), 1);
+          unsigned int z = MC_SAMPLE_GRID_COARSE(k + (n >> 2), 2);
+          if (self->samples[MC_SAMPLE_GRID_INDEX(x, y, z)] < 0.0f)
+            ++numInside;
+        }
+        if (numInside == 0 || numInside == 8)
+          continue;
+        unsigned int first[3] = { i, j, k }, last[3] = { i, j, k };
+        for (int a = 0; a < 3; ++a) {
+          first[a] = first[a] > dilation ? first[a] - dilation : 0;
+          last[a] = last[a] + dilation < numCells[a] - 1
+            ? last[a] + dilation : numCells[a] - 1;
+        }
+        for (unsigned int c = first[2]; c <= last[2]; ++c) {
+          for (unsigned int b = first[1]; b <= last[1]; ++b) {
+            for (unsigned int a = first[0]; a <= last[0]; ++a)
+              refine[((size_t)c * numCells[1] + b) * numCells[0] + a] = 1;
+          }
+        }
+      }
+    }
+  }
+  /* Sample the fine lattice in the refined cells, and interpolate it
+   * trilinearly from the coarse lattice everywhere else */
+#pragma omp parallel for schedule(dynamic)
+  for (int z = 0; z < (int)res[2]; ++z) {
+    for (unsigned int y = 0; y < res[1]; ++y) {
+      for (unsigned int x = 0; x < res[0]; ++x) {
+        unsigned int pos[3] = { x, y, (unsigned int)z };
+        int isCoarse = 1, isRefined = 0;
+        for (int a = 0; a < 3; ++a) {
+          if (pos[a] % step != 0 && pos[a] != res[a] - 1)
+            isCoarse = 0;
+        }
+        if (isCoarse)
+          continue;
+        for (unsigned int c = firstCell[2][z]; c <= lastCell[2][z]; ++c) {
+          for (unsigned int b = firstCell[1][y]; b <= lastCell[1][y]; ++b) {
+            for (unsigned int a = firstCell[0][x]; a <= lastCell[0][x]; ++a) {
+              if (refine[((size_t)c * numCells[1] + b) * numCells[0] + a])
+                isRefined = 1;
+            }
+          }
+        }
+        float *sample = &self->samples[MC_SAMPLE_GRID_INDEX(x, y, z)];
+        if (isRefined) {
+          *sample = sf(
+              lo[0] + (float)x * delta[0],
+              lo[1] + (float)y * delta[1],
+              lo[2] + (float)z * delta[2],
+              args);
+          continue;
+        }
+        unsigned int corner[3][2];
+        float t[3];
+        for (int a = 0; a < 3; ++a) {
+          unsigned int cell = lastCell[a][pos[a]];
+          corner[a][0] = MC_SAMPLE_GRID_COARSE(cell, a);
+          corner[a][1] = MC_SAMPLE_GRID_COARSE(cell + 1, a);
+          t[a] = (float)(pos[a] - corner[a][0])
+            / (float)(corner[a][1] - corner[a][0]);
+        }
+        float c[4];
+        for (int n = 0; n < 4; ++n) {
+          float v0 = self->samples[MC_SAMPLE_GRID_INDEX(
+              corner[0][0], corner[1][n & 1], corner[2][n >> 1])];
+          float v1 = self->samples[MC_SAMPLE_GRID_INDEX(
+              corner[0][1], corner[1][n & 1], corner[2][n >> 1])];
+          c[n] = v0 + (v1 - v0) * t[0];
+        }
+        float c0 = c[0] + (c[1] - c[0]) * t[1];
+        float c1 = c[2] + (c[3] - c[2]) * t[1];
+        *sample = c0 + (c1 - c0) * t[2];
+      }
+    }
+  }
+#undef MC_SAMPLE_GRID_INDEX
+#undef MC_SAMPLE_GRID_COARSE
+  free(refine);
+  for (int i = 0; i < 3; ++i)
+    free(firstCell[i]);
+}
+
+void mcSampleGrid_initHalfResolution(
+    mcSampleGrid *self,
+    const mcSampleGrid *other)
+{
+  *self = *other;
+  self->stride = other->stride * 2;
+  for (int i = 0; i < 3; ++i) {
+    assert(other->res[i] >= 2);
+    self->res[i] = (other->res[i] - 1) / 2 + 1;
+  }
+  self->delta.x = other->delta.x * 2.0f;
+  self->delta.y = other->delta.y * 2.0f;
+  self->delta.z = other->delta.z * 2.0f;
+  self->max.x = self->min.x + self->delta.x * (float)(self->res[0] - 1);
+  self->max.y = self->min.y + self->delta.y * (float)(self->res[1] - 1);
+  self->max.z = self->min.z + self->delta.z * (float)(self->res[2] - 1);
+  self->ownsSamples = 0;
+}
+
+void mcSampleGrid_destroy(
+    mcSampleGrid *self)
+{
+  if (self->ownsSamples)
+    free(self->samples);
+}
+
+/**
+ * Converts a position along one axis to the index of the lower lattice point
+ * of the surrounding cell and the fraction of the way to the upper point.
+ */
+void mcSampleGrid_latticeCoordinate(
+    float pos, float min, float delta, unsigned int res,
+    unsigned int *index, float *t)
+{
+  float coord = delta != 0.0f ? (pos - min) / delta : 0.0f;
+  float nearest = floorf(coord + 0.5f);
+  if (fabsf(coord - nearest) < MC_SAMPLE_GRID_SNAP_EPSILON)
+    coord = nearest;
+  coord = fminf(fmaxf(coord, 0.0f), (float)(res - 1));
+  *index = (unsigned int)coord;
+  *t = coord - (float)*index;
+}
+
+float mcSampleGrid_scalarField(
+    float x, float y, float z,
+    const void *args)
+{
+  const mcSampleGrid *self = (const mcSampleGrid*)args;
+  unsigned int i, j, k;
+  float tx, ty, tz;
+  mcSampleGrid_latticeCoordinate(x, self->min.x, self->delta.x, self->res[0],
+      &i, &tx);
+  mcSampleGrid_latticeCoordinate(y, self->min.y, self->delta.y, self->res[1],
+      &j, &ty);
+  mcSampleGrid_latticeCoordinate(z, self->min.z, self->delta.z, self->res[2],
+      &k, &tz);
+  /* Return lattice samples exactly rather than interpolating */
+  if (tx == 0.0f && ty == 0.0f && tz == 0.0f)
+    return mcSampleGrid_sample(self, i, j, k);
+  /* The upper lattice point is only read when it has some weight, since
+   * positions on the maximum faces of the grid have no upper point */
+  unsigned int ix[2] = { i, tx != 0.0f ? i + 1 : i };
+  unsigned int jy[2] = { j, ty != 0.0f ? j + 1 : j };
+  unsigned int kz[2] = { k, tz != 0.0f ? k + 1 : k };
+  float c[4];
+  for (int n = 0; n < 4; ++n) {
+    float a = mcSampleGrid_sample(self, ix[0], jy[n & 1], kz[n >> 1]);
+    float b = mcSampleGrid_sample(self, ix[1], jy[n & 1], kz[n >> 1]);
+    c[n] = a + (b - a) * tx;
+  }
+  float c0 = c[0] + (c[1] - c[0]) * ty;
+  float c1 = c[2] + (c[3] - c[2]) * ty;
+  return c0 + (c1 - c0) * tz;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stddef.h>
+
+#include <mc/scalarField.h>
+
+void mcScalarFieldDescriptor_init(
+    mcScalarFieldDescriptor *self,
+    mcScalarFieldWithArgs sf,
+    const void *args)
+{
+  self->sf = sf;
+  self->args = args;
+  self->sampleLattice = NULL;
+}
+
+void mcScalarFieldDescriptor_initFromField(
+    mcScalarFieldDescriptor *self,
+    mcScalarFieldWithArgs sf,
+    const void *args)
+{
+  if (sf == mcScalarFieldDescriptor_scalarField) {
+    *self = *(const mcScalarFieldDescriptor*)args;
+    return;
+  }
+  mcScalarFieldDescriptor_init(self, sf, args);
+}
+
+float mcScalarFieldDescriptor_scalarField(
+    float x, float y, float z,
+    const void *args)
+{
+  const mcScalarFieldDescriptor *self = (const mcScalarFieldDescriptor*)args;
+  return self->sf(x, y, z, self->args);
+}
+
+void mcScalarFieldDescriptor_sampleLattice(
+    const mcScalarFieldDescriptor *self,
+    const mcVec3 *min, const mcVec3 *delta,
+    const unsigned int *start, const unsigned int *res,
+    void **scratch,
+    float *samples)
+{
+  if (self->sampleLattice != NULL) {
+    self->sampleLattice(self->args, min, delta, start, res, scratch, samples);
+    return;
+  }
+  for (unsigned int k = 0; k < res[2]; ++k) {
+    float pos_z = min->z + (float)(start[2] + k) * delta->z;
+    for (unsigned int j = 0; j < res[1]; ++j) {
+      float pos_y = min->y + (float)(start[1] + j) * delta->y;
+      float *row = &samples[((size_t)k * res[1] + j) * res[0]];
+      for (unsigned int i = 0; i < res[0]; ++i) {
+        row[i] = self->sf(min->x + (float)(start[0] + i) * delta->x,
+            pos_y, pos_z, self->args);
+      }
+    }
+  }
+}
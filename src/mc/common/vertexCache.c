@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mc/vertexCache.h>
+
+/* Scoring constants from Forsyth's "Linear-Speed Vertex Cache Optimisation" */
+#define MC_VERTEX_CACHE_DECAY_POWER 1.5f
+#define MC_VERTEX_CACHE_LAST_TRIANGLE_SCORE 0.75f
+#define MC_VERTEX_CACHE_VALENCE_BOOST_SCALE 2.0f
+#define MC_VERTEX_CACHE_VALENCE_BOOST_POWER 0.5f
+
+/* Valences at or above this size share the last entry of the valence score
+ * table */
+#define MC_VERTEX_CACHE_MAX_VALENCE 32
+
+/**
+ * Precomputed vertex score components, so that rescoring vertices as the
+ * simulated cache changes involves no calls to powf().
+ */
+typedef struct mcVertexCacheScores {
+  /** The score for each position in the cache, or -1 for positions outside
+   * of the cache. */
+  float *cachePosition;
+  /** The score for each number of remaining triangles. */
+  float valence[MC_VERTEX_CACHE_MAX_VALENCE];
+} mcVertexCacheScores;
+
+/**
+ * Fills in the score tables for a cache of the given size. Vertices used by
+ * the most recent triangle are scored slightly lower than those just behind
+ * them, so that the next triangle does not simply turn back on the previous
+ * one, and vertices with few remaining triangles are boosted so that they are
+ * finished off rather than left behind.
+ */
+void mcVertexCacheScores_init(mcVertexCacheScores *self,
+    unsigned int cacheSize)
+{
+  self->cachePosition = (float*)malloc(sizeof(float) * cacheSize);
+  for (unsigned int i = 0; i < cacheSize; ++i) {
+    if (i < 3) {
+      self->cachePosition[i] = MC_VERTEX_CACHE_LAST_TRIANGLE_SCORE;
+    } else {
+      float scale = 1.0f / (float)(cacheSize - 3);
+      self->cachePosition[i] = powf(1.0f - (float)(i - 3) * scale,
+          MC_VERTEX_CACHE_DECAY_POWER);
+    }
+  }
+  self->valence[0] = 0.0f;
+  for (unsigned int i = 1; i < MC_VERTEX_CACHE_MAX_VALENCE; ++i) {
+    self->valence[i] = MC_VERTEX_CACHE_VALENCE_BOOST_SCALE
+      * powf((float)i, -MC_VERTEX_CACHE_VALENCE_BOOST_POWER);
+  }
+}
+
+void mcVertexCacheScores_destroy(mcVertexCacheScores *self) {
+  free(self->cachePosition);
+}
+
+/**
+ * Scores a vertex by its position in the simulated cache and by the number of
+ * triangles that still use it.
+ */
+static inline float mcVertexCache_vertexScore(
+    const mcVertexCacheScores *scores,
+    int cachePosition, unsigned int numTriangles)
+{
+  if (numTriangles == 0)
+    return -1.0f;  /* This vertex is no longer used */
+  float score = cachePosition >= 0 ? scores->cachePosition[cachePosition]
+    : 0.0f;
+  if (numTriangles >= MC_VERTEX_CACHE_MAX_VALENCE)
+    numTriangles = MC_VERTEX_CACHE_MAX_VALENCE - 1;
+  return score + scores->valence[numTriangles];
+}
+
+void mcVertexCache_optimizeTriangles(
+    unsigned int *indices,
+    unsigned int numTriangles,
+    unsigned int numVertices,
+    unsigned int cacheSize)
+{
+  assert(cacheSize > 3);
+  if (numTriangles == 0)
+    return;
+  /* List the triangles of each vertex in a compressed sparse row layout. The
+   * first numActive[v] entries in each row are the triangles of v that have
+   * not yet been emitted. */
+  unsigned int *offsets = (unsigned int*)calloc(numVertices + 1,
+      sizeof(unsigned int));
+  unsigned int *numActive = (unsigned int*)calloc(numVertices,
+      sizeof(unsigned int));
+  unsigned int *vertexTriangles = (unsigned int*)malloc(
+      sizeof(unsigned int) * numTriangles * 3);
+  for (unsigned int i = 0; i < numTriangles * 3; ++i) {
+    assert(indices[i] < numVertices);
+    offsets[indices[i] + 1] += 1;
+  }
+  for (unsigned int v = 0; v < numVertices; ++v)
+    offsets[v + 1] += offsets[v];
+  for (unsigned int i = 0; i < numTriangles * 3; ++i) {
+    unsigned int v = indices[i];
+    vertexTriangles[offsets[v] + numActive[v]++] = i / 3;
+  }
+  /* Score every vertex and triangle */
+  int *cachePositions = (int*)malloc(sizeof(int) * numVertices);
+  float *vertexScores = (float*)malloc(sizeof(float) * numVertices);
+  float *triangleScores = (float*)malloc(sizeof(float) * numTriangles);
+  unsigned char *emitted = (unsigned char*)calloc(numTriangles,
+      sizeof(unsigned char));
+  mcVertexCacheScores scores;
+  mcVertexCacheScores_init(&scores, cacheSize);
+  for (unsigned int v = 0; v < numVertices; ++v) {
+    cachePositions[v] = -1;
+    vertexScores[v] = mcVertexCache_vertexScore(&scores, -1, numActive[v]);
+  }
+  for (unsigned int t = 0; t < numTriangles; ++t) {
+    triangleScores[t] = vertexScores[indices[t * 3]]
+      + vertexScores[indices[t * 3 + 1]]
+      + vertexScores[indices[t * 3 + 2]];
+  }
+  /* The simulated cache has room for the three vertices of the triangle
+   * being added before the oldest vertices are pushed out */
+  unsigned int *cache = (unsigned int*)malloc(
+      sizeof(unsigned int) * (cacheSize + 3));
+  unsigned int *newCache = (unsigned int*)malloc(
+      sizeof(unsigned int) * (cacheSize + 3));
+  unsigned int cacheCount = 0;
+  unsigned int *output = (unsigned int*)malloc(
+      sizeof(unsigned int) * numTriangles * 3);
+  unsigned int cursor = 0;
+  int best = -1;
+  for (unsigned int n = 0; n < numTriangles; ++n) {
+    if (best == -1) {
+      /* None of the cached vertices have triangles left, so start over at
+       * the next triangle in the original order */
+      while (emitted[cursor])
+        ++cursor;
+      best = cursor;
+    }
+    const unsigned int *triangle = &indices[best * 3];
+    memcpy(&output[n * 3], triangle, sizeof(unsigned int) * 3);
+    emitted[best] = 1;
+    /* Remove the triangle from the active triangles of its vertices */
+    for (int i = 0; i < 3; ++i) {
+      unsigned int v = triangle[i];
+      unsigned int *row = &vertexTriangles[offsets[v]];
+      for (unsigned int j = 0; j < numActive[v]; ++j) {
+        if (row[j] == (unsigned int)best) {
+          row[j] = row[--numActive[v]];
+          break;
+        }
+      }
+    }
+    /* Move the triangle's vertices to the front of the cache */
+    unsigned int newCount = 0;
+    for (int i = 0; i < 3; ++i)
+      newCache[newCount++] = triangle[i];
+    for (unsigned int i = 0; i < cacheCount; ++i) {
+      unsigned int v = cache[i];
+      if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+        newCache[newCount++] = v;
+    }
+    /* Rescore the vertices in the cache, including those just pushed out */
+    for (unsigned int i = 0; i < newCount; ++i) {
+      unsigned int v = newCache[i];
+      cachePositions[v] = i < cacheSize ? (int)i : -1;
+      vertexScores[v] = mcVertexCache_vertexScore(&scores,
+          cachePositions[v], numActive[v]);
+    }
+    /* Rescore their triangles and pick the best as the next triangle */
+    float bestScore = -1.0f;
+    best = -1;
+    for (unsigned int i = 0; i < newCount; ++i) {
+      unsigned int v = newCache[i];
+      const unsigned int *row = &vertexTriangles[offsets[v]];
+      for (unsigned int j = 0; j < numActive[v]; ++j) {
+        unsigned int t = row[j];
+        triangleScores[t] = vertexScores[indices[t * 3]]
+          + vertexScores[indices[t * 3 + 1]]
+          + vertexScores[indices[t * 3 + 2]];
+        if (triangleScores[t] > bestScore) {
+          bestScore = triangleScores[t];
+          best = t;
+        }
+      }
+    }
+    /* Swap in the new cache, dropping the vertices pushed out */
+    unsigned int *temp = cache;
+    cache = newCache;
+    newCache = temp;
+    cacheCount = newCount < cacheSize ? newCount : cacheSize;
+  }
+  memcpy(indices, output, sizeof(unsigned int) * numTriangles * 3);
+  /* Free our resources */
+  mcVertexCacheScores_destroy(&scores);
+  free(offsets);
+  free(numActive);
+  free(vertexTriangles);
+  free(cachePositions);
+  free(vertexScores);
+  free(triangleScores);
+  free(emitted);
+  free(cache);
+  free(newCache);
+  free(output);
+}
+
+unsigned int mcVertexCache_optimizeVertexFetch(
+    unsigned int *indices,
+    unsigned int numIndices,
+    unsigned int numVertices,
+    unsigned int *remap)
+{
+  unsigned int count = 0;
+  for (unsigned int v = 0; v < numVertices; ++v)
+    remap[v] = UINT_MAX;
+  for (unsigned int i = 0; i < numIndices; ++i) {
+    assert(indices[i] < numVertices);
+    if (remap[indices[i]] == UINT_MAX)
+      remap[indices[i]] = count++;
+    indices[i] = remap[indices[i]];
+  }
+  return count;
+}
+
+float mcVertexCache_averageCacheMissRatio(
+    const unsigned int *indices,
+    unsigned int numTriangles,
+    unsigned int cacheSize)
+{
+  if (numTriangles == 0)
+    return 0.0f;
+  /* A ring buffer of the cached vertices */
+  unsigned int *cache = (unsigned int*)malloc(
+      sizeof(unsigned int) * cacheSize);
+  unsigned int cacheCount = 0, head = 0, misses = 0;
+  for (unsigned int i = 0; i < numTriangles * 3; ++i) {
+    int hit = 0;
+    for (unsigned int j = 0; j < cacheCount; ++j) {
+      if (cache[j] == indices[i]) {
+        hit = 1;
+        break;
+      }
+    }
+    if (hit)
+      continue;
+    misses += 1;
+    /* Push the vertex, replacing the oldest vertex once the cache is full */
+    if (cacheCount < cacheSize) {
+      cache[cacheCount++] = indices[i];
+    } else {
+      cache[head] = indices[i];
+      head = (head + 1) % cacheSize;
+    }
+  }
+  free(cache);
+  return (float)misses / (float)numTriangles;
+}
+
+void mcVertexCache_optimizeMesh(
+    mcMesh *mesh,
+    unsigned int cacheSize)
+{
+  /* Gather the face indices into a flat array */
+  unsigned int *indices = (unsigned int*)malloc(
+      sizeof(unsigned int) * (mesh->numIndices + 1));
+  unsigned int numIndices = 0;
+  for (unsigned int i = 0; i < mesh->numFaces; ++i) {
+    const mcFace *face = &mesh->faces[i];
+    memcpy(&indices[numIndices], face->indices,
+        sizeof(unsigned int) * face->numIndices);
+    numIndices += face->numIndices;
+  }
+  assert(numIndices == mesh->numIndices);
+  if (mesh->isTriangleMesh) {
+    mcVertexCache_optimizeTriangles(indices, mesh->numFaces,
+        mesh->numVertices, cacheSize);
+  }
+  unsigned int *remap = (unsigned int*)malloc(
+      sizeof(unsigned int) * (mesh->numVertices + 1));
+  unsigned int numVertices = mcVertexCache_optimizeVertexFetch(
+      indices, numIndices, mesh->numVertices, remap);
+  /* Write the reordered indices back into the faces. Triangles may have been
+   * reordered, but every face still has three indices. */
+  numIndices = 0;
+  for (unsigned int i = 0; i < mesh->numFaces; ++i) {
+    mcFace *face = &mesh->faces[i];
+    memcpy(face->indices, &indices[numIndices],
+        sizeof(unsigned int) * face->numIndices);
+    numIndices += face->numIndices;
+  }
+  /* Move the vertices to their new positions */
+  mcVertex *vertices = (mcVertex*)malloc(
+      sizeof(mcVertex) * mesh->sizeVertices);
+  for (unsigned int v = 0; v < mesh->numVertices; ++v) {
+    if (remap[v] != UINT_MAX)
+      vertices[remap[v]] = mesh->vertices[v];
+  }
+  free(mesh->vertices);
+  mesh->vertices = vertices;
+  mesh->numVertices = numVertices;
+  free(remap);
+  free(indices);
+}
+
+float mcVertexCache_meshAverageCacheMissRatio(
+    const mcMesh *mesh,
+    unsigned int cacheSize)
+{
+  assert(mesh->isTriangleMesh);
+  unsigned int *indices = (unsigned int*)malloc(
+      sizeof(unsigned int) * (mesh->numIndices + 1));
+  for (unsigned int i = 0; i < mesh->numFaces; ++i) {
+    memcpy(&indices[i * 3], mesh->faces[i].indices,
+        sizeof(unsigned int) * 3);
+  }
+  float acmr = mcVertexCache_averageCacheMissRatio(indices, mesh->numFaces,
+      cacheSize);
+  free(indices);
+  return acmr;
+}
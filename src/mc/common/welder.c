@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mc/welder.h>
+
+static inline uint64_t mcWelder_hash(const int64_t *key) {
+  uint64_t hash = 14695981039346656037ull;
+  for (int i = 0; i < 3; ++i)
+    hash = (hash ^ (uint64_t)key[i]) * 1099511628211ull;
+  return hash ^ (hash >> 32);
+}
+
+/**
+ * Computes the quantized lattice key of the given position.
+ */
+static inline void mcWelder_key(const mcWelder *self, const mcVec3 *pos,
+    int64_t *key)
+{
+  key[0] = llround((double)pos->x / self->delta.x * MC_WELDER_SUBDIVISIONS);
+  key[1] = llround((double)pos->y / self->delta.y * MC_WELDER_SUBDIVISIONS);
+  key[2] = llround((double)pos->z / self->delta.z * MC_WELDER_SUBDIVISIONS);
+}
+
+/**
+ * Returns how far apart two vertices near the given coordinate may lie along
+ * an axis with the given lattice spacing and still be welded.
+ */
+static inline float mcWelder_tolerance(float delta, float coordinate) {
+  return MC_WELDER_TOLERANCE * delta + 8.0f * FLT_EPSILON * fabsf(coordinate);
+}
+
+/**
+ * Returns the first empty hash table slot at or after the slot for the given
+ * hash. The table may hold several vertices with the same key, since
+ * distinct vertices that lie very close together can share a key.
+ */
+unsigned int mcWelder_findEmptySlot(const mcWelder *self, uint64_t hash) {
+  unsigned int slot = (unsigned int)(hash & (self->tableSize - 1));
+  /* Linear probing */
+  while (self->indices[slot] != -1)
+    slot = (slot + 1) & (self->tableSize - 1);
+  return slot;
+}
+
+/**
+ * Doubles the size of the hash table and re-inserts its entries.
+ */
+void mcWelder_growTable(mcWelder *self) {
+  int64_t *oldKeys = self->keys;
+  int *oldIndices = self->indices;
+  unsigned int oldSize = self->tableSize;
+  self->tableSize *= 2;
+  self->keys = (int64_t*)malloc(sizeof(int64_t) * 3 * self->tableSize);
+  self->indices = (int*)malloc(sizeof(int) * self->tableSize);
+  for (unsigned int i = 0; i < self->tableSize; ++i)
+    self->indices[i] = -1;
+  for (unsigned int i = 0; i < oldSize; ++i) {
+    if (oldIndices[i] == -1)
+      continue;
+    const int64_t *key = &oldKeys[i * 3];
+    unsigned int slot = mcWelder_findEmptySlot(self, mcWelder_hash(key));
+    memcpy(&self->keys[slot * 3], key, sizeof(int64_t) * 3);
+    self->indices[slot] = oldIndices[i];
+  }
+  free(oldKeys);
+  free(oldIndices);
+}
+
+/**
+ * Adds an entry for the given key and merged vertex index to the hash table.
+ */
+void mcWelder_addEntry(mcWelder *self, const int64_t *key, uint64_t hash,
+    int index)
+{
+  unsigned int slot = mcWelder_findEmptySlot(self, hash);
+  memcpy(&self->keys[slot * 3], key, sizeof(int64_t) * 3);
+  self->indices[slot] = index;
+  self->numEntries += 1;
+  /* Keep the table at most half full */
+  if (self->numEntries * 2 > self->tableSize)
+    mcWelder_growTable(self);
+}
+
+/**
+ * Returns the merged vertex index for the given key, adding the given vertex
+ * to the merged mesh if no earlier mesh had the same vertex.
+ * Merged vertices from firstIndex onward come from the mesh being added, and
+ * are never merged with the given vertex. Of the earlier vertices that share
+ * the key and lie within MC_WELDER_TOLERANCE, the closest one is merged.
+ */
+unsigned int mcWelder_insert(mcWelder *self, const int64_t *key,
+    uint64_t hash, const mcVertex *vertex, int firstIndex)
+{
+  int best = -1;
+  float bestDistance = 0.0f;
+  unsigned int slot = (unsigned int)(hash & (self->tableSize - 1));
+  while (self->indices[slot] != -1) {
+    const int64_t *other = &self->keys[slot * 3];
+    int index = self->indices[slot];
+    if (index < firstIndex
+        && other[0] == key[0] && other[1] == key[1] && other[2] == key[2])
+    {
+      mcVec3 d;
+      mcVec3_subtract(&self->mesh->vertices[index].pos, &vertex->pos, &d);
+      float distance = mcVec3_dot(&d, &d);
+      int close =
+        fabs(d.x) <= mcWelder_tolerance(self->delta.x, vertex->pos.x)
+        && fabs(d.y) <= mcWelder_tolerance(self->delta.y, vertex->pos.y)
+        && fabs(d.z) <= mcWelder_tolerance(self->delta.z, vertex->pos.z);
+      if (close && (best == -1 || distance < bestDistance)) {
+        best = index;
+        bestDistance = distance;
+      }
+    }
+    slot = (slot + 1) & (self->tableSize - 1);
+  }
+  if (best != -1)
+    return (unsigned int)best;
+  /* No earlier mesh has this vertex. Any vertex of the same mesh with this
+   * key is a distinct vertex that happens to lie very close by, such as on
+   * another lattice edge near the same sample, since the algorithm that built
+   * the mesh already shared its vertices. */
+  unsigned int index = mcMesh_addVertex(self->mesh, vertex);
+  mcWelder_addEntry(self, key, hash, (int)index);
+  return index;
+}
+
+void mcWelder_init(
+    mcWelder *self,
+    mcMesh *mesh,
+    const mcVec3 *delta)
+{
+  const unsigned int INIT_TABLE_SIZE = 1024;
+
+  self->mesh = mesh;
+  self->delta = *delta;
+  self->tableSize = INIT_TABLE_SIZE;
+  self->numEntries = 0;
+  self->keys = (int64_t*)malloc(sizeof(int64_t) * 3 * self->tableSize);
+  self->indices = (int*)malloc(sizeof(int) * self->tableSize);
+  for (unsigned int i = 0; i < self->tableSize; ++i)
+    self->indices[i] = -1;
+  /* Enter the vertices already in the merged mesh */
+  for (unsigned int i = 0; i < mesh->numVertices; ++i) {
+    int64_t key[3];
+    mcWelder_key(self, &mesh->vertices[i].pos, key);
+    mcWelder_addEntry(self, key, mcWelder_hash(key), (int)i);
+  }
+}
+
+void mcWelder_destroy(
+    mcWelder *self)
+{
+  free(self->keys);
+  free(self->indices);
+}
+
+void mcWelder_addMesh(
+    mcWelder *self,
+    const mcMesh *mesh,
+    const mcVec3 *offset)
+{
+  int numVertices = (int)mesh->numVertices;
+  int numFaces = (int)mesh->numFaces;
+  mcVertex *vertices = (mcVertex*)malloc(
+      sizeof(mcVertex) * (numVertices + 1));
+  int64_t *keys = (int64_t*)malloc(sizeof(int64_t) * 3 * (numVertices + 1));
+  uint64_t *hashes = (uint64_t*)malloc(sizeof(uint64_t) * (numVertices + 1));
+  unsigned int *remap = (unsigned int*)malloc(
+      sizeof(unsigned int) * (numVertices + 1));
+  /* Move the vertices into the merged mesh space and compute their keys */
+#pragma omp parallel for schedule(static)
+  for (int i = 0; i < numVertices; ++i) {
+    vertices[i] = mesh->vertices[i];
+    mcVec3_add(&vertices[i].pos, offset, &vertices[i].pos);
+    mcWelder_key(self, &vertices[i].pos, &keys[i * 3]);
+    hashes[i] = mcWelder_hash(&keys[i * 3]);
+  }
+  /* Look up or insert each vertex. This must be done in order so that the
+   * merged mesh does not depend on the number of threads. */
+  int firstIndex = (int)self->mesh->numVertices;
+  for (int i = 0; i < numVertices; ++i) {
+    remap[i] = mcWelder_insert(self, &keys[i * 3], hashes[i], &vertices[i],
+        firstIndex);
+  }
+  /* Make room for the new faces and copy them with their indices remapped */
+  mcMesh *merged = self->mesh;
+  while (merged->sizeFaces < merged->numFaces + numFaces)
+    mcMesh_growFaces(merged);
+  mcFace *faces = &merged->faces[merged->numFaces];
+#pragma omp parallel for schedule(static)
+  for (int i = 0; i < numFaces; ++i) {
+    const mcFace *face = &mesh->faces[i];
+    mcFace_init(&faces[i], face->numIndices);
+    for (unsigned int j = 0; j < face->numIndices; ++j)
+      faces[i].indices[j] = remap[face->indices[j]];
+  }
+  merged->numFaces += numFaces;
+  merged->numIndices += mesh->numIndices;
+  if (!mesh->isTriangleMesh)
+    merged->isTriangleMesh = 0;
+  /* Free our resources */
+  free(vertices);
+  free(keys);
+  free(hashes);
+  free(remap);
+}
+
+void mcWelder_weldMeshes(
+    const mcMesh *const *meshes,
+    const mcVec3 *offsets,
+    unsigned int numMeshes,
+    const mcVec3 *delta,
+    mcMesh *output)
+{
+  mcWelder welder;
+  mcWelder_init(&welder, output, delta);
+  for (unsigned int i = 0; i < numMeshes; ++i) {
+    mcWelder_addMesh(&welder, meshes[i], &offsets[i]);
+  }
+  mcWelder_destroy(&welder);
+}
@@ -25,6 +25,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <mc/algorithms/adaptiveMarchingSquares.h>
 #include <mc/algorithms/coloredMarchingSquares.h>
 #include <mc/algorithms/marchingSquares.h>
 #include <mc/contourBuilder.h>
@@ -33,6 +34,7 @@ struct mcContourBuilderInternal {
   mcContour *contours;
   int contoursSize;
   int numContours;
+  mcContourFormat format;
 };
 
 void mcContourBuilder_init(mcContourBuilder *self) {
@@ -45,6 +47,7 @@ void mcContourBuilder_init(mcContourBuilder *self) {
     (mcContour*)malloc(sizeof(mcContour) * INIT_NUM_CONTOURS);
   self->internal->contoursSize = INIT_NUM_CONTOURS;
   self->internal->numContours = 0;
+  self->internal->format = MC_CONTOUR_LINES;
 }
 
 void mcContourBuilder_destroy(mcContourBuilder *self) {
@@ -72,6 +75,13 @@ void mcContourBuilder_growContours(mcContourBuilder *self) {
   assert(self->internal->numContours < self->internal->contoursSize);
 }
 
+void mcContourBuilder_setFormat(
+    mcContourBuilder *self,
+    mcContourFormat format)
+{
+  self->internal->format = format;
+}
+
 const mcContour *mcContourBuilder_contourFromFieldWithArgs(
     mcContourBuilder *self,
     mcScalarFieldWithArgs sf,
@@ -79,13 +89,31 @@ const mcContour *mcContourBuilder_contourFromFieldWithArgs(
     mcAlgorithmFlag algorithm,
     unsigned int x_res, unsigned int y_res,
     const mcVec2 *min, const mcVec2 *max)
+{
+  return mcContourBuilder_contourFromFieldWithParams(
+      self,
+      sf, args,
+      algorithm,
+      NULL,  /* Use the default parameters */
+      x_res, y_res,
+      min, max);
+}
+
+const mcContour *mcContourBuilder_contourFromFieldWithParams(
+    mcContourBuilder *self,
+    mcScalarFieldWithArgs sf,
+    const void *args,
+    mcAlgorithmFlag algorithm,
+    mcAlgorithmParams params,
+    unsigned int x_res, unsigned int y_res,
+    const mcVec2 *min, const mcVec2 *max)
 {
   /* Make sure we have enough memory to store this contour */
   if (self->internal->numContours >= self->internal->contoursSize) {
     mcContourBuilder_growContours(self);
   }
   mcContour *contour = &self->internal->contours[self->internal->numContours++];
-  mcContour_init(contour);
+  mcContour_initWithFormat(contour, self->internal->format);
   /* Extract the contour using the given algorithm */
   switch (algorithm) {
     case MC_MARCHING_SQUARES:
@@ -95,9 +123,19 @@ const mcContour *mcContourBuilder_contourFromFieldWithArgs(
           min, max,
           contour);
       break;
+    case MC_ADAPTIVE_MARCHING_SQUARES:
+      mcAdaptiveMarchingSquares_contourFromField(
+          sf, args,
+          x_res, y_res,
+          min, max,
+          (const mcAdaptiveMarchingSquaresParams*)params,
+          contour);
+      break;
     default:
       assert(0);
   }
+  if (contour->format == MC_CONTOUR_POLYLINES)
+    mcContour_assemblePolylines(contour);
   return contour;
 }
 
@@ -114,7 +152,9 @@ const mcContour *mcContourBuilder_contourFromColoredFieldWithArgs(
     mcContourBuilder_growContours(self);
   }
   mcContour *contour = &self->internal->contours[self->internal->numContours++];
-  mcContour_init(contour);
+  /* Colored marching squares emits unshared vertices, which cannot be
+   * chained into polylines, so its contours are always built as lines */
+  mcContour_initWithFormat(contour, MC_CONTOUR_LINES);
   /* Extract the contour using the given algorithm */
   switch (algorithm) {
     case MC_COLORED_MARCHING_SQUARES:
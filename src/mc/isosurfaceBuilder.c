@@ -25,15 +25,19 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <mc/algorithms/adaptiveDualContouring.h>
 #include <mc/algorithms/cuberille.h>
+#include <mc/algorithms/cubes33.h>
 #include <mc/algorithms/dualMarchingCubes.h>
 #include <mc/algorithms/elasticSurfaceNet.h>
 #include <mc/algorithms/nielsonDual.h>
 #include <mc/algorithms/patch.h>
 #include <mc/algorithms/simple.h>
+#include <mc/algorithms/snapmc.h>
 #include <mc/algorithms/transvoxel.h>
 #include <mc/isosurfaceBuilder.h>
 #include <mc/mesh.h>
+#include <mc/policy.h>
 
 /**
  * \internal
@@ -51,6 +55,9 @@ struct mcIsosurfaceBuilderInternal {
   unsigned int meshesSize;
   /** The number of meshes that this isosurface builder currently holds. */
   unsigned int numMeshes;
+  /** An optional cache of previously extracted meshes, which may be shared
+   * with other isosurface builders. */
+  mcMeshCache *meshCache;
 };
 
 void mcIsosurfaceBuilder_init(
@@ -65,6 +72,7 @@ void mcIsosurfaceBuilder_init(
     (mcMesh*)malloc(sizeof(mcMesh) * INIT_NUM_MESHES);
   self->internal->meshesSize = INIT_NUM_MESHES;
   self->internal->numMeshes = 0;
+  self->internal->meshCache = NULL;
 }
 
 void mcIsosurfaceBuilder_destroy(
@@ -98,6 +106,20 @@ void mcIsosurfaceBuilder_growMeshes(
   assert(self->internal->numMeshes < self->internal->meshesSize);
 }
 
+/**
+ * Initializes a new mesh in the internal list of meshes and returns it.
+ */
+mcMesh *mcIsosurfaceBuilder_addMesh(
+    mcIsosurfaceBuilder *self)
+{
+  if (self->internal->numMeshes >= self->internal->meshesSize) {
+    mcIsosurfaceBuilder_growMeshes(self);
+  }
+  mcMesh *mesh = &self->internal->meshes[self->internal->numMeshes++];
+  mcMesh_init(mesh);
+  return mesh;
+}
+
 /**
  * This method allows us to pass an mcScalarField (without arguments) as an
  * mcScalarFieldWithArgs.
@@ -131,27 +153,43 @@ const mcMesh *mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
     mcAlgorithmFlag algorithm,
     unsigned int x_res, unsigned int y_res, unsigned int z_res,
     const mcVec3 *min, const mcVec3 *max)
+{
+  return mcIsosurfaceBuilder_isosurfaceFromFieldWithParams(
+      self,
+      sf, args,
+      algorithm,
+      NULL,  /* Use the default parameters */
+      x_res, y_res, z_res,
+      min, max);
+}
+
+const mcMesh *mcIsosurfaceBuilder_isosurfaceFromFieldWithParams(
+    mcIsosurfaceBuilder *self,
+    mcScalarFieldWithArgs sf,
+    const void *args,
+    mcAlgorithmFlag algorithm,
+    mcAlgorithmParams params,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max)
 {
   /* Initialize a mesh */
-  if (self->internal->numMeshes >= self->internal->meshesSize) {
-    mcIsosurfaceBuilder_growMeshes(self);
-  }
-  mcMesh *mesh = &self->internal->meshes[self->internal->numMeshes++];
-  mcMesh_init(mesh);
-  /* TODO: Determine the isosurface generation algorithm to use */
+  mcMesh *mesh = mcIsosurfaceBuilder_addMesh(self);
   switch (algorithm) {
-    case MC_CPU_PERFORMANCE_ALGORITHM:
-      /* TODO */
-      assert(0);
-      break;
     case MC_DEFAULT_ALGORITHM:
+    case MC_CPU_PERFORMANCE_ALGORITHM:
     case MC_CPU_BALANCE_ALGORITHM:
-      /* TODO */
-      assert(0);
-      break;
     case MC_CPU_QUALITY_ALGORITHM:
-      /* TODO */
-      assert(0);
+    case MC_LOW_MEMORY_ALGORITHM:
+      {
+        /* Let the policy calibration choose a concrete algorithm */
+        mcPolicy policy;
+        mcPolicy_select(algorithm, x_res, y_res, z_res, &policy);
+        mcPolicy_isosurfaceFromField(&policy,
+            sf, args,
+            x_res, y_res, z_res,
+            min, max,
+            mesh);
+      }
       break;
     case MC_GPGPU_PERFORMANCE_ALGORITHM:
       /* TODO */
@@ -165,10 +203,6 @@ const mcMesh *mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
       /* TODO */
       assert(0);
       break;
-    case MC_LOW_MEMORY_ALGORITHM:
-      /* TODO */
-      assert(0);
-      break;
     case MC_MIDPOINT_MARCHING_CUBES:
       /* TODO */
       assert(0);
@@ -193,6 +227,7 @@ const mcMesh *mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
           sf, args,
           x_res, y_res, z_res,
           min, max,
+          (const mcElasticSurfaceNetParams*)params,
           mesh);
       break;
     case MC_CUBERILLE:
@@ -200,10 +235,16 @@ const mcMesh *mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
           sf, args,
           x_res, y_res, z_res,
           min, max,
-          NULL,  /* TODO: Pass the params into this function */
+          (const mcCuberilleParams*)params,
           mesh);
       break;
     case MC_SNAP_MARCHING_CUBES:
+      mcSnapMC_isosurfaceFromField(
+          sf, args,
+          x_res, y_res, z_res,
+          min, max,
+          (const mcSnapMCParams*)params,
+          mesh);
       break;
     case MC_PATCH_MARCHING_CUBES:
       mcPatch_isosurfaceFromField(
@@ -226,12 +267,159 @@ const mcMesh *mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
           min, max,
           mesh);
       break;
+    case MC_MARCHING_CUBES_33:
+      mcCubes33_isosurfaceFromField(
+          sf, args,
+          x_res, y_res, z_res,
+          min, max,
+          mesh);
+      break;
+    case MC_ADAPTIVE_DUAL_CONTOURING:
+      mcAdaptiveDualContouring_isosurfaceFromField(
+          sf, args,
+          x_res, y_res, z_res,
+          min, max,
+          (const mcAdaptiveDualContouringParams*)params,
+          mesh);
+      break;
     default:
       assert(0);
   }
   return mesh;
 }
 
+const mcMesh *mcIsosurfaceBuilder_isosurfaceFromSampleGrid(
+    mcIsosurfaceBuilder *self,
+    const mcSampleGrid *grid,
+    mcAlgorithmFlag algorithm,
+    mcAlgorithmParams params)
+{
+  return mcIsosurfaceBuilder_isosurfaceFromFieldWithParams(
+      self,
+      mcSampleGrid_scalarField, grid,
+      algorithm,
+      params,
+      grid->res[0], grid->res[1], grid->res[2],
+      &grid->min, &grid->max);
+}
+
+void mcIsosurfaceBuilder_setMeshCache(
+    mcIsosurfaceBuilder *self,
+    mcMeshCache *cache)
+{
+  self->internal->meshCache = cache;
+}
+
+/**
+ * Returns the size of the parameter structure used by the given algorithm, or
+ * zero if the algorithm does not take parameters.
+ */
+size_t mcIsosurfaceBuilder_paramsSize(
+    mcAlgorithmFlag algorithm)
+{
+  switch (algorithm) {
+    case MC_ELASTIC_SURFACE_NETS:
+      return sizeof(mcElasticSurfaceNetParams);
+    case MC_CUBERILLE:
+      return sizeof(mcCuberilleParams);
+    case MC_ADAPTIVE_DUAL_CONTOURING:
+      return sizeof(mcAdaptiveDualContouringParams);
+    case MC_SNAP_MARCHING_CUBES:
+      return sizeof(mcSnapMCParams);
+    default:
+      return 0;
+  }
+}
+
+const mcMesh *mcIsosurfaceBuilder_isosurfaceFromFieldCached(
+    mcIsosurfaceBuilder *self,
+    mcScalarFieldWithArgs sf,
+    const void *args,
+    uint64_t fieldVersion,
+    mcAlgorithmFlag algorithm,
+    mcAlgorithmParams params,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max)
+{
+  mcMeshCache *cache = self->internal->meshCache;
+  if (cache == NULL) {
+    return mcIsosurfaceBuilder_isosurfaceFromFieldWithParams(
+        self,
+        sf, args,
+        algorithm,
+        params,
+        x_res, y_res, z_res,
+        min, max);
+  }
+  mcMeshCacheKey key;
+  memset(&key, 0, sizeof(key));
+  key.sf = sf;
+  key.args = args;
+  key.fieldVersion = fieldVersion;
+  key.algorithm = algorithm;
+  key.paramsHash = 0;
+  size_t paramsSize = mcIsosurfaceBuilder_paramsSize(algorithm);
+  if (params != NULL && paramsSize > 0) {
+    key.paramsHash = mcMeshCache_hashBytes(params, paramsSize,
+        MC_MESH_CACHE_HASH_INIT);
+  }
+  key.res[0] = x_res;
+  key.res[1] = y_res;
+  key.res[2] = z_res;
+  key.min = *min;
+  key.max = *max;
+  /* Copy the cached mesh into a new mesh if we can */
+  if (self->internal->numMeshes >= self->internal->meshesSize) {
+    mcIsosurfaceBuilder_growMeshes(self);
+  }
+  mcMesh *mesh = &self->internal->meshes[self->internal->numMeshes];
+  if (mcMeshCache_lookup(cache, &key, mesh)) {
+    self->internal->numMeshes += 1;
+    return mesh;
+  }
+  /* Extract the mesh and remember it */
+  const mcMesh *result = mcIsosurfaceBuilder_isosurfaceFromFieldWithParams(
+      self,
+      sf, args,
+      algorithm,
+      params,
+      x_res, y_res, z_res,
+      min, max);
+  mcMeshCache_insert(cache, &key, result);
+  return result;
+}
+
+const mcMesh *mcIsosurfaceBuilder_decimateMesh(
+    mcIsosurfaceBuilder *self,
+    const mcMesh *mesh,
+    const mcDecimationParams *params)
+{
+  /* NOTE: Adding a mesh can move the meshes we already hold, so the input
+   * mesh must be decimated into temporary storage first */
+  mcMesh decimated;
+  mcMesh_init(&decimated);
+  mcDecimation_decimateMesh(mesh, params, &decimated);
+  mcMesh *result = mcIsosurfaceBuilder_addMesh(self);
+  mcMesh_destroy(result);
+  *result = decimated;
+  return result;
+}
+
+void mcIsosurfaceBuilder_optimizeVertexCache(
+    mcIsosurfaceBuilder *self,
+    const mcMesh *mesh)
+{
+  /* Find our own non-const copy of the mesh */
+  for (unsigned int i = 0; i < self->internal->numMeshes; ++i) {
+    if (&self->internal->meshes[i] == mesh) {
+      mcVertexCache_optimizeMesh(&self->internal->meshes[i],
+          MC_VERTEX_CACHE_DEFAULT_SIZE);
+      return;
+    }
+  }
+  assert(0);  /* The mesh does not belong to this isosurface builder */
+}
+
 const mcMesh *mcIsosurfaceBuilder_isosurfaceFromLattice(
     mcIsosurfaceBuilder *self,
     mcScalarLattice sl,
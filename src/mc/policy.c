@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <mc/algorithms/cubes33.h>
+#include <mc/algorithms/simple.h>
+#include <mc/policy.h>
+#include <mc/welder.h>
+
+/** The lattice resolution used to time each candidate algorithm. */
+#define MC_POLICY_KERNEL_RES 48
+/** The lattice resolution used to time each block size. */
+#define MC_POLICY_BLOCK_RES 64
+/** How many times slower than the fastest algorithm Marching Cubes 33 may be
+ * for MC_CPU_BALANCE_ALGORITHM to still choose it. */
+#define MC_POLICY_BALANCE_SLOWDOWN 1.5f
+
+/**
+ * \internal
+ * The whole lattice that the blocks are split from.
+ * \endinternal
+ */
+typedef struct mcPolicyLattice {
+  mcScalarFieldDescriptor field;
+  mcVec3 min, delta;
+} mcPolicyLattice;
+
+/**
+ * \internal
+ * The scalar field seen by the algorithm extracting a block. It snaps each
+ * position to the nearest point of the whole lattice, so that every block
+ * samples exactly the positions the unsplit lattice would.
+ * \endinternal
+ */
+typedef struct mcPolicyBlockField {
+  const mcPolicyLattice *lattice;
+  /** The lattice coordinates of the first sample of the block. */
+  unsigned int start[3];
+} mcPolicyBlockField;
+
+static mcPolicyCalibration mcPolicy_calibrationResult;
+static pthread_once_t mcPolicy_calibrationOnce = PTHREAD_ONCE_INIT;
+
+float mcPolicy_blockField(float x, float y, float z, const void *args) {
+  const mcPolicyLattice *lattice = ((const mcPolicyBlockField*)args)->lattice;
+  float i = floorf((x - lattice->min.x) / lattice->delta.x + 0.5f);
+  float j = floorf((y - lattice->min.y) / lattice->delta.y + 0.5f);
+  float k = floorf((z - lattice->min.z) / lattice->delta.z + 0.5f);
+  return lattice->field.sf(
+      lattice->min.x + i * lattice->delta.x,
+      lattice->min.y + j * lattice->delta.y,
+      lattice->min.z + k * lattice->delta.z,
+      lattice->field.args);
+}
+
+/**
+ * Samples part of a block with the lattice sampler of the whole lattice. The
+ * block's own lattice is a sub-lattice of the whole lattice, so its samples
+ * are found from their coordinates in the whole lattice rather than from the
+ * block's \p min and \p delta.
+ */
+void mcPolicy_sampleBlockLattice(const void *args,
+    const mcVec3 *min, const mcVec3 *delta,
+    const unsigned int *start, const unsigned int *res,
+    void **scratch, float *samples)
+{
+  (void)min;
+  (void)delta;
+  const mcPolicyBlockField *block = (const mcPolicyBlockField*)args;
+  const mcPolicyLattice *lattice = block->lattice;
+  unsigned int latticeStart[3];
+  for (int i = 0; i < 3; ++i)
+    latticeStart[i] = block->start[i] + start[i];
+  lattice->field.sampleLattice(lattice->field.args,
+      &lattice->min, &lattice->delta,
+      latticeStart, res, scratch, samples);
+}
+
+/**
+ * A bumpy sphere, which gives the calibration a mix of empty cubes, simple
+ * cubes and the occasional ambiguous cube like a typical isosurface.
+ */
+float mcPolicy_calibrationField(float x, float y, float z, const void *args) {
+  (void)args;
+  return sqrtf(x * x + y * y + z * z) - 0.7f
+    + 0.1f * sinf(9.0f * x) * sinf(9.0f * y) * sinf(9.0f * z);
+}
+
+double mcPolicy_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + 1.0e-9 * (double)ts.tv_nsec;
+}
+
+/**
+ * Extracts an isosurface with one of the candidate algorithms, all of which
+ * take their default parameters.
+ */
+void mcPolicy_extract(
+    mcAlgorithmFlag algorithm,
+    mcScalarFieldWithArgs sf,
+    const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max,
+    mcMesh *mesh)
+{
+  switch (algorithm) {
+    case MC_SIMPLE_MARCHING_CUBES:
+      mcSimple_isosurfaceFromField(
+          sf, args, x_res, y_res, z_res, min, max, mesh);
+      break;
+    case MC_MARCHING_CUBES_33:
+      mcCubes33_isosurfaceFromField(
+          sf, args, x_res, y_res, z_res, min, max, mesh);
+      break;
+    default:
+      assert(0);
+  }
+}
+
+/**
+ * Returns the time in seconds per cube taken to extract the calibration field
+ * at the given resolution with the given policy, taking the best of two runs.
+ */
+float mcPolicy_timePolicy(const mcPolicy *policy, unsigned int res) {
+  mcVec3 min = { -1.0f, -1.0f, -1.0f }, max = { 1.0f, 1.0f, 1.0f };
+  double best = -1.0;
+  for (int run = 0; run < 2; ++run) {
+    mcMesh mesh;
+    mcMesh_init(&mesh);
+    double start = mcPolicy_time();
+    mcPolicy_isosurfaceFromField(policy,
+        mcPolicy_calibrationField, NULL,
+        res, res, res,
+        &min, &max,
+        &mesh);
+    double elapsed = mcPolicy_time() - start;
+    mcMesh_destroy(&mesh);
+    if (best < 0.0 || elapsed < best)
+      best = elapsed;
+  }
+  return (float)(best / ((double)(res - 1) * (res - 1) * (res - 1)));
+}
+
+void mcPolicy_calibrate() {
+  mcPolicyCalibration *self = &mcPolicy_calibrationResult;
+  self->candidates[0] = MC_SIMPLE_MARCHING_CUBES;
+  self->candidates[1] = MC_MARCHING_CUBES_33;
+  self->blockSizes[0] = 16;
+  self->blockSizes[1] = 32;
+#ifdef _OPENMP
+  self->maxThreads = omp_get_max_threads();
+#else
+  self->maxThreads = 1;
+#endif
+  /* Time each algorithm on its own */
+  int fastest = 0;
+  for (int i = 0; i < MC_POLICY_NUM_CANDIDATES; ++i) {
+    mcPolicy policy = { self->candidates[i], 1, 0 };
+    self->cubeCost[i] = mcPolicy_timePolicy(&policy, MC_POLICY_KERNEL_RES);
+    if (self->cubeCost[i] < self->cubeCost[fastest])
+      fastest = i;
+  }
+  /* Time the fastest algorithm over blocks of each size.
+   * Blocks pay for welding and for sampling their shared faces twice, which
+   * only more threads can make up for. */
+  for (int i = 0; i < MC_POLICY_NUM_BLOCK_SIZES; ++i) {
+    mcPolicy policy = {
+      self->candidates[fastest], self->maxThreads, self->blockSizes[i] };
+    self->blockCost[i] = self->maxThreads > 1
+      ? mcPolicy_timePolicy(&policy, MC_POLICY_BLOCK_RES) : 0.0f;
+  }
+}
+
+const mcPolicyCalibration *mcPolicy_calibration() {
+  pthread_once(&mcPolicy_calibrationOnce, mcPolicy_calibrate);
+  return &mcPolicy_calibrationResult;
+}
+
+void mcPolicy_select(
+    mcAlgorithmFlag policy,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    mcPolicy *result)
+{
+  const mcPolicyCalibration *calibration = mcPolicy_calibration();
+  int fastest = 0, cubes33 = 0;
+  for (int i = 0; i < MC_POLICY_NUM_CANDIDATES; ++i) {
+    if (calibration->cubeCost[i] < calibration->cubeCost[fastest])
+      fastest = i;
+    if (calibration->candidates[i] == MC_MARCHING_CUBES_33)
+      cubes33 = i;
+  }
+  int chosen = fastest;
+  switch (policy) {
+    case MC_CPU_PERFORMANCE_ALGORITHM:
+    case MC_LOW_MEMORY_ALGORITHM:
+      break;
+    case MC_DEFAULT_ALGORITHM:
+    case MC_CPU_BALANCE_ALGORITHM:
+      if (calibration->cubeCost[cubes33]
+          <= MC_POLICY_BALANCE_SLOWDOWN * calibration->cubeCost[fastest])
+        chosen = cubes33;
+      break;
+    case MC_CPU_QUALITY_ALGORITHM:
+      chosen = cubes33;
+      break;
+    default:
+      assert(0);
+  }
+  result->algorithm = calibration->candidates[chosen];
+  result->numThreads = 1;
+  result->blockSize = 0;
+  /* Only the explicit CPU policies extract blocks in parallel, since that
+   * calls the scalar field from several threads at once */
+  if (policy == MC_DEFAULT_ALGORITHM || policy == MC_LOW_MEMORY_ALGORITHM
+      || calibration->maxThreads < 2)
+    return;
+  /* Split the lattice into blocks if that was faster than extracting it whole
+   * during calibration, and if there are enough blocks to keep every thread
+   * busy */
+  int best = 0;
+  for (int i = 1; i < MC_POLICY_NUM_BLOCK_SIZES; ++i) {
+    if (calibration->blockCost[i] < calibration->blockCost[best])
+      best = i;
+  }
+  if (calibration->blockCost[best] >= calibration->cubeCost[chosen])
+    return;
+  unsigned int blockSize = calibration->blockSizes[best];
+  unsigned int numBlocks =
+    ((x_res - 1 + blockSize - 1) / blockSize)
+    * ((y_res - 1 + blockSize - 1) / blockSize)
+    * ((z_res - 1 + blockSize - 1) / blockSize);
+  if (numBlocks < calibration->maxThreads)
+    return;
+  result->numThreads = calibration->maxThreads;
+  result->blockSize = blockSize;
+}
+
+void mcPolicy_isosurfaceFromField(
+    const mcPolicy *policy,
+    mcScalarFieldWithArgs sf,
+    const void *args,
+    unsigned int x_res, unsigned int y_res, unsigned int z_res,
+    const mcVec3 *min, const mcVec3 *max,
+    mcMesh *mesh)
+{
+  if (policy->blockSize == 0) {
+    mcPolicy_extract(policy->algorithm,
+        sf, args,
+        x_res, y_res, z_res,
+        min, max,
+        mesh);
+    return;
+  }
+  /* Neighboring blocks share the samples on the faces between them */
+  mcPolicyLattice lattice;
+  mcScalarFieldDescriptor_initFromField(&lattice.field, sf, args);
+  lattice.min = *min;
+  lattice.delta.x = fabs(max->x - min->x) / (float)(x_res - 1);
+  lattice.delta.y = fabs(max->y - min->y) / (float)(y_res - 1);
+  lattice.delta.z = fabs(max->z - min->z) / (float)(z_res - 1);
+  unsigned int res[3] = { x_res, y_res, z_res };
+  unsigned int numBlocks[3];
+  for (int i = 0; i < 3; ++i)
+    numBlocks[i] = (res[i] - 1 + policy->blockSize - 1) / policy->blockSize;
+  int totalBlocks = numBlocks[0] * numBlocks[1] * numBlocks[2];
+  mcMesh *blockMeshes = (mcMesh*)malloc(sizeof(mcMesh) * totalBlocks);
+  const mcMesh **meshes =
+    (const mcMesh**)malloc(sizeof(mcMesh*) * totalBlocks);
+  mcVec3 *offsets = (mcVec3*)malloc(sizeof(mcVec3) * totalBlocks);
+#pragma omp parallel for schedule(dynamic) num_threads(policy->numThreads)
+  for (int block = 0; block < totalBlocks; ++block) {
+    unsigned int start[3], blockRes[3];
+    start[0] = (block % numBlocks[0]) * policy->blockSize;
+    start[1] = (block / numBlocks[0] % numBlocks[1]) * policy->blockSize;
+    start[2] = (block / numBlocks[0] / numBlocks[1]) * policy->blockSize;
+    for (int i = 0; i < 3; ++i) {
+      blockRes[i] = policy->blockSize + 1;
+      if (start[i] + blockRes[i] > res[i])
+        blockRes[i] = res[i] - start[i];
+    }
+    offsets[block].x = (float)start[0] * lattice.delta.x;
+    offsets[block].y = (float)start[1] * lattice.delta.y;
+    offsets[block].z = (float)start[2] * lattice.delta.z;
+    mcVec3 blockMin, blockMax;
+    mcVec3_add(min, &offsets[block], &blockMin);
+    blockMax.x = blockMin.x + (float)(blockRes[0] - 1) * lattice.delta.x;
+    blockMax.y = blockMin.y + (float)(blockRes[1] - 1) * lattice.delta.y;
+    blockMax.z = blockMin.z + (float)(blockRes[2] - 1) * lattice.delta.z;
+    /* Forward the lattice sampler of the field to the block, if it has one */
+    mcPolicyBlockField blockField;
+    blockField.lattice = &lattice;
+    for (int i = 0; i < 3; ++i)
+      blockField.start[i] = start[i];
+    mcScalarFieldDescriptor blockDescriptor;
+    mcScalarFieldDescriptor_init(&blockDescriptor,
+        mcPolicy_blockField, &blockField);
+    if (lattice.field.sampleLattice != NULL)
+      blockDescriptor.sampleLattice = mcPolicy_sampleBlockLattice;
+    mcMesh_init(&blockMeshes[block]);
+    mcPolicy_extract(policy->algorithm,
+        mcScalarFieldDescriptor_scalarField, &blockDescriptor,
+        blockRes[0], blockRes[1], blockRes[2],
+        &blockMin, &blockMax,
+        &blockMeshes[block]);
+    meshes[block] = &blockMeshes[block];
+  }
+  /* Weld the blocks in order, so that the mesh does not depend on which
+   * thread finished first */
+  mcWelder_weldMeshes(meshes, offsets, totalBlocks, &lattice.delta, mesh);
+  /* Free our resources */
+  for (int block = 0; block < totalBlocks; ++block)
+    mcMesh_destroy(&blockMeshes[block]);
+  free(blockMeshes);
+  free(meshes);
+  free(offsets);
+}
@@ -39,6 +39,10 @@ namespace mc {
     mcContourBuilder_destroy(&m_internal);
   }
 
+  void ContourBuilder::setFormat(mcContourFormat format) {
+    mcContourBuilder_setFormat(&m_internal, format);
+  }
+
   float wrapScalarField(float x, float y, float z, ScalarField *sf) {
     return (*sf)(x, y, z);
   }
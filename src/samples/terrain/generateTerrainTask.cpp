@@ -37,10 +37,10 @@ namespace mc { namespace samples { namespace terrain {
   }
 
   void GenerateTerrainTask::run() {
-    // Generate terrain using the scalar field for this terrain object
-    auto sf = m_terrain->sf();
+    // Generate terrain using the height field for this terrain object
     auto mesh = std::shared_ptr<TerrainMesh>(
-        new TerrainMesh(sf, m_node->block(), m_node->lod()));
+        new TerrainMesh(
+          m_terrain->heightField(), m_node->block(), m_node->lod()));
     fprintf(stderr, "Generating mesh at block: (%d, %d, %d), lod: %d\n",
         m_node->block().x,
         m_node->block().y,
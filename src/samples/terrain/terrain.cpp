@@ -54,19 +54,23 @@ namespace mc { namespace samples { namespace terrain {
     return z - (cos(x / interval) * sin(y / interval)) * amplitude;
   }
 
-  float hills(float x, float y, float z) {
-    float interval = 800.0f;
-    float amplitude = 1000.0f;
+  /** The largest height of hillsHeight() above or below zero. */
+  const float HILLS_AMPLITUDE = 100.0f + 25.0f + 50.0f;
+
+  float hillsHeight(float x, float y, const void *args) {
 #define ADD_HILLS(interval,amplitude) \
     ((cos(x / interval) * sin(y / interval)) * amplitude)
 #define ADD_RANDOM_HILLS(interval,amplitude) \
     (( \
       cos(x / (interval + glm::simplex(glm::vec2(x, y)))) \
       * sin(y / (interval + 0.3f * glm::simplex(glm::vec2(x, y))))) * amplitude)
-    return z -
-      (ADD_HILLS(800.0f, 100.0f)
-       + ADD_HILLS(72.0f, 25.0f)
-       + ADD_HILLS(40.0f, 50.0f));
+    return ADD_HILLS(800.0f, 100.0f)
+      + ADD_HILLS(72.0f, 25.0f)
+      + ADD_HILLS(40.0f, 50.0f);
+  }
+
+  float hills(float x, float y, float z) {
+    return z - hillsHeight(x, y, nullptr);
   }
 
   Terrain::Terrain(std::shared_ptr<Camera> camera, int minimumLod)
@@ -80,6 +84,14 @@ namespace mc { namespace samples { namespace terrain {
     m_lastCameraBlock.y = INT_MAX;
     m_lastCameraBlock.z = INT_MAX;
 
+    // Describe the hills as a height field over the xy-plane
+    mcHeightField_init(&m_heightField,
+        hillsHeight,  // height
+        nullptr,  // args
+        2,  // axis
+        -HILLS_AMPLITUDE, HILLS_AMPLITUDE  // minHeight, maxHeight
+        );
+
     // Send debugging vertices to the GL
     m_generateCubeWireframe();
   }
@@ -29,6 +29,10 @@
 #include <mutex>
 #include <queue>
 
+extern "C" {
+#include <mc/heightField.h>
+}
+
 #include "../common/sceneObject.h"
 #include "../common/workerPool.h"
 #include "lodTree.h"
@@ -50,6 +54,7 @@ namespace mc { namespace samples {
         } WireframeVertex;
 
         ScalarField m_sf;
+        mcHeightField m_heightField;
 
         LodTree m_lodTree;
         int m_minimumLod;
@@ -144,6 +149,14 @@ namespace mc { namespace samples {
          */
         const ScalarField &sf() const { return m_sf; }
 
+        /**
+         * \return A reference to the height field describing the same surface
+         * as sf(), which lets libmc evaluate the terrain height once per
+         * column of each sample lattice and skip blocks that lie entirely
+         * above or below the terrain.
+         */
+        const mcHeightField &heightField() const { return m_heightField; }
+
         /**
          * This method returns the lowest level of detail that this terrain
          * object will generate. This value ultimately decides how far up the
@@ -52,15 +52,58 @@ namespace mc { namespace samples { namespace terrain {
           this->position().x,
           this->position().y,
           this->position().z),  // min
-        Vec3(
-          this->position().x + (float)BLOCK_SIZE * VOXEL_DELTA * (1 << lod),
-          this->position().y + (float)BLOCK_SIZE * VOXEL_DELTA * (1 << lod),
-          this->position().z + (float)BLOCK_SIZE * VOXEL_DELTA * (1 << lod)) // max
+        m_latticeMax(lod)  // max
         );
     m_empty = mesh->numVertices() == 0;
     this->setMesh(*mesh);
   }
 
+  TerrainMesh::TerrainMesh(
+      const mcHeightField &heightField,
+      const LodTree::Coordinates &block,
+      int lod)
+    : MeshObject(
+        glm::vec3(
+          (float)block.x * VOXEL_DELTA * (float)BLOCK_SIZE,
+          (float)block.y * VOXEL_DELTA * (float)BLOCK_SIZE,
+          (float)block.z * VOXEL_DELTA * (float)BLOCK_SIZE),  // position
+        glm::quat()  // orientation
+        )
+  {
+    // Pass a descriptor of the height field to libmc, rather than wrapping it
+    // in a scalar field functor, so that its lattice sampler evaluates the
+    // height once per column
+    Vec3 min(
+        this->position().x,
+        this->position().y,
+        this->position().z);
+    Vec3 max = m_latticeMax(lod);
+    mcScalarFieldDescriptor descriptor;
+    mcHeightField_descriptor(&heightField, &descriptor);
+    mcIsosurfaceBuilder ib;
+    mcIsosurfaceBuilder_init(&ib);
+    const mcMesh *mesh = mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
+        &ib,
+        mcScalarFieldDescriptor_scalarField,  // scalar field
+        &descriptor,  // args
+        MC_ORIGINAL_MARCHING_CUBES,  // algorithm
+        BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE,  // resolution
+        &min.to_mcVec3(),  // min
+        &max.to_mcVec3()  // max
+        );
+    m_empty = mesh->numVertices == 0;
+    this->setMesh(*mesh);
+    mcIsosurfaceBuilder_destroy(&ib);
+  }
+
+  Vec3 TerrainMesh::m_latticeMax(int lod) const {
+    float size = (float)BLOCK_SIZE * VOXEL_DELTA * (1 << lod);
+    return Vec3(
+        this->position().x + size,
+        this->position().y + size,
+        this->position().z + size);
+  }
+
   TerrainMesh::~TerrainMesh() {
   }
 } } }
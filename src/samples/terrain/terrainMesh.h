@@ -25,6 +25,11 @@
 #define MC_SAMPLES_TERRAIN_TERRAIN_MESH_H_
 
 #include <mcxx/scalarField.h>
+#include <mcxx/vector.h>
+
+extern "C" {
+#include <mc/heightField.h>
+}
 
 #include "../common/meshObject.h"
 #include "lodTree.h"
@@ -41,6 +46,13 @@ namespace mc { namespace samples { namespace terrain {
   class TerrainMesh : public MeshObject {
     private:
       bool m_empty;
+
+      /**
+       * \return The position of the last sample in the sample lattice of this
+       * terrain mesh at the given level of detail. The first sample is at the
+       * position of the mesh.
+       */
+      Vec3 m_latticeMax(int lod) const;
     public:
       /**
        * The number of samples along each axis in the sample lattice for each
@@ -76,6 +88,22 @@ namespace mc { namespace samples { namespace terrain {
           const LodTree::Coordinates &block,
           int lod);
 
+      /**
+       * Constructs a terrain mesh object representing the given height field
+       * at the given level of detail. The height field is evaluated once per
+       * column of the sample lattice, and blocks that lie entirely above or
+       * below the terrain are generated without evaluating it at all.
+       *
+       * \param heightField The height field that defines the terrain surface.
+       * \param block The coordinates of this terrain mesh in the voxel block
+       * octree.
+       * \param lod The level of detail of the terrain mesh.
+       */
+      TerrainMesh(
+          const mcHeightField &heightField,
+          const LodTree::Coordinates &block,
+          int lod);
+
       ~TerrainMesh();
 
       /**
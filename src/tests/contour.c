@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#include <assert.h>
+#include <stdlib.h>
+
+#include <mc/contourBuilder.h>
+
+float circle(float x, float y, float z, void *args) {
+  return x * x + y * y - 0.5f;
+}
+
+float halfPlane(float x, float y, float z, void *args) {
+  return x - 0.1f;
+}
+
+int test_mcContour_polylineLoop() {
+  mcContourBuilder cb;
+  mcVec2 min = { .x = -1.0f, .y = -1.0f }, max = { .x = 1.0f, .y = 1.0f };
+  mcContourBuilder_init(&cb);
+  mcContourBuilder_setFormat(&cb, MC_CONTOUR_POLYLINES);
+  const mcContour *contour = mcContourBuilder_contourFromFieldWithArgs(
+      &cb,
+      (mcScalarFieldWithArgs)circle, NULL,
+      MC_MARCHING_SQUARES,
+      16, 16,
+      &min, &max);
+  /* A circle yields a single closed loop through every vertex */
+  assert(contour->numLines == 0);
+  assert(contour->numPolylines == 1);
+  /* The chaining links are released once the polylines are assembled */
+  assert(contour->links == NULL);
+  assert(contour->polylineOffsets[0] == 0);
+  assert(contour->polylineOffsets[1] == contour->numVertices + 1);
+  assert(contour->polylineIndices[0]
+      == contour->polylineIndices[contour->numVertices]);
+  mcContourBuilder_destroy(&cb);
+
+  return EXIT_SUCCESS;
+}
+
+int test_mcContour_polylineOpen() {
+  mcContourBuilder cb;
+  mcVec2 min = { .x = -1.0f, .y = -1.0f }, max = { .x = 1.0f, .y = 1.0f };
+  mcContourBuilder_init(&cb);
+  /* Build the same contour with both formats */
+  const mcContour *lines = mcContourBuilder_contourFromFieldWithArgs(
+      &cb,
+      (mcScalarFieldWithArgs)halfPlane, NULL,
+      MC_MARCHING_SQUARES,
+      8, 8,
+      &min, &max);
+  mcContourBuilder_setFormat(&cb, MC_CONTOUR_POLYLINES);
+  const mcContour *polylines = mcContourBuilder_contourFromFieldWithArgs(
+      &cb,
+      (mcScalarFieldWithArgs)halfPlane, NULL,
+      MC_MARCHING_SQUARES,
+      8, 8,
+      &min, &max);
+  /* A straight line crossing the domain yields a single open polyline */
+  assert(lines->numLines == 7);
+  assert(polylines->numPolylines == 1);
+  assert(polylines->numVertices == lines->numLines + 1);
+  assert(polylines->numPolylineIndices == polylines->numVertices);
+  mcContourBuilder_destroy(&cb);
+
+  return EXIT_SUCCESS;
+}
+
+int halfPlaneColor(float x, float y, float z, const void *args) {
+  return x < 0.1f ? 0 : 1;
+}
+
+int test_mcContour_coloredIgnoresPolylines() {
+  mcContourBuilder cb;
+  mcVec2 min = { .x = -1.0f, .y = -1.0f }, max = { .x = 1.0f, .y = 1.0f };
+  mcContourBuilder_init(&cb);
+  /* Colored contours cannot be chained, so they are built as lines even when
+   * polylines were requested */
+  mcContourBuilder_setFormat(&cb, MC_CONTOUR_POLYLINES);
+  const mcContour *contour = mcContourBuilder_contourFromColoredFieldWithArgs(
+      &cb,
+      halfPlaneColor, NULL,
+      MC_COLORED_MARCHING_SQUARES,
+      8, 8,
+      &min, &max);
+  assert(contour->format == MC_CONTOUR_LINES);
+  assert(contour->numLines > 0);
+  assert(contour->numPolylines == 0);
+  mcContourBuilder_destroy(&cb);
+
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+#define TEST(routine) \
+  do { \
+    int result; \
+    if (result = test_ ## routine()) \
+      return result; \
+  } while (0)
+
+  TEST(mcContour_polylineLoop);
+  TEST(mcContour_polylineOpen);
+  TEST(mcContour_coloredIgnoresPolylines);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mc/fieldExpression.h>
+#include <mc/isosurfaceBuilder.h>
+
+/* A CSG scene of smooth unions, rotated tori, a difference, noise and a
+ * scale, which also shares nodes and has constant arithmetic to fold */
+int scene(mcFieldExpression *e) {
+  const mcVec3 origin = { 0.0f, 0.0f, 0.0f };
+  const mcVec3 xAxis = { 1.0f, 0.0f, 0.0f }, yAxis = { 0.0f, 1.0f, 0.0f };
+  mcVec3 center = { 0.1f, -0.05f, 0.0f };
+  int body = mcFieldExpression_sphere(e, &center, 0.45f);
+  mcVec3 halfExtents = { 0.2f, 0.6f, 0.2f };
+  int box = mcFieldExpression_box(e, &origin, &halfExtents);
+  int carved = mcFieldExpression_difference(e, body, box);
+  /* The same torus in two different frames */
+  int torus = mcFieldExpression_torus(e, &origin, 0.55f, 0.08f);
+  int ring0 = mcFieldExpression_rotate(e, torus, &xAxis, 0.6f);
+  int ring1 = mcFieldExpression_rotate(e, torus, &yAxis, -0.9f);
+  int rings = mcFieldExpression_smoothUnion(e, ring0, ring1, 0.05f);
+  /* Folds into a single constant */
+  int radius = mcFieldExpression_add(e,
+      mcFieldExpression_constant(e, 0.05f),
+      mcFieldExpression_constant(e, 0.05f));
+  int blend = mcFieldExpression_smoothUnion(e, carved, rings, 0.1f);
+  int bumpy = mcFieldExpression_add(e, blend,
+      mcFieldExpression_noise(e, 6.0f, 0.02f, 3));
+  mcVec3 offset = { 0.0f, 0.0f, 0.65f };
+  int sphere = mcFieldExpression_sphere(e, &offset, 0.0f);
+  int bead = mcFieldExpression_subtract(e, sphere, radius);
+  int scene = mcFieldExpression_smoothUnion(e, bumpy, bead, 0.05f);
+  return mcFieldExpression_scale(e, scene, 1.2f);
+}
+
+int test_mcFieldProgram_evaluateRow() {
+  mcFieldExpression expression;
+  mcFieldExpression_init(&expression);
+  int root = scene(&expression);
+  mcFieldProgram program;
+  mcFieldProgram_init(&program, &expression, root);
+  /* A node shared within the same frame is evaluated once, and constant
+   * arithmetic is folded into a single constant */
+  mcFieldProgram other;
+  mcFieldProgram_init(&other, &expression,
+      mcFieldExpression_add(&expression, root, root));
+  assert(other.numInstructions == program.numInstructions + 1);
+  mcFieldProgram_destroy(&other);
+  mcFieldProgram_init(&other, &expression,
+      mcFieldExpression_add(&expression, root,
+        mcFieldExpression_multiply(&expression,
+          mcFieldExpression_constant(&expression, 2.0f),
+          mcFieldExpression_constant(&expression, 0.5f))));
+  assert(other.numInstructions == program.numInstructions + 2);
+  mcFieldProgram_destroy(&other);
+  /* Rows that do not fill a whole batch, and rows that span several */
+  const unsigned int counts[] = { 1, 7, 64, 65, 200 };
+  float values[200];
+  for (int i = 0; i < (int)(sizeof(counts) / sizeof(counts[0])); ++i) {
+    const float x0 = -1.0f, dx = 2.0f / (float)counts[i];
+    for (int row = 0; row < 16; ++row) {
+      float y = -1.0f + 0.125f * (float)row;
+      float z = 0.3f - 0.05f * (float)row;
+      mcFieldProgram_evaluateRow(&program, x0, dx, y, z, counts[i], values);
+      for (unsigned int x = 0; x < counts[i]; ++x) {
+        float expected = mcFieldProgram_scalarField(
+            x0 + (float)x * dx, y, z, &program);
+        assert(values[x] == expected);
+      }
+    }
+  }
+  mcFieldProgram_destroy(&program);
+  mcFieldExpression_destroy(&expression);
+
+  return EXIT_SUCCESS;
+}
+
+/* The program passed as arguments, counting how often it is evaluated */
+int numCalls = 0;
+float countedProgram(float x, float y, float z, const void *args) {
+  ++numCalls;
+  return mcFieldProgram_scalarField(x, y, z, args);
+}
+
+/* The lattice sampler of the program, counting the samples it evaluates.
+ * Samples that it skips keep their sign but not their value. */
+mcLatticeSampler programSampler;
+int numSampled = 0;
+void countedSampler(const void *args,
+    const mcVec3 *min, const mcVec3 *delta,
+    const unsigned int *start, const unsigned int *res,
+    void **scratch, float *samples)
+{
+  programSampler(args, min, delta, start, res, scratch, samples);
+  for (unsigned int k = 0; k < res[2]; ++k) {
+    for (unsigned int j = 0; j < res[1]; ++j) {
+      for (unsigned int i = 0; i < res[0]; ++i) {
+        float expected = mcFieldProgram_scalarField(
+            min->x + (float)(start[0] + i) * delta->x,
+            min->y + (float)(start[1] + j) * delta->y,
+            min->z + (float)(start[2] + k) * delta->z,
+            args);
+        float actual = samples[i + (j + k * res[1]) * res[0]];
+        assert((actual < 0.0f) == (expected < 0.0f));
+        if (actual == expected)
+          ++numSampled;
+      }
+    }
+  }
+}
+
+int meshesEqual(const mcMesh *a, const mcMesh *b) {
+  if (a->numVertices != b->numVertices || a->numFaces != b->numFaces)
+    return 0;
+  if (memcmp(a->vertices, b->vertices, sizeof(mcVertex) * a->numVertices))
+    return 0;
+  for (unsigned int i = 0; i < a->numFaces; ++i) {
+    if (a->faces[i].numIndices != b->faces[i].numIndices)
+      return 0;
+    if (memcmp(a->faces[i].indices, b->faces[i].indices,
+          sizeof(unsigned int) * a->faces[i].numIndices))
+      return 0;
+  }
+  return 1;
+}
+
+int test_mcFieldProgram_evaluateLattice() {
+  mcFieldExpression expression;
+  mcFieldExpression_init(&expression);
+  mcFieldProgram program;
+  mcFieldProgram_init(&program, &expression, scene(&expression));
+  const unsigned int res = 97;
+  const mcVec3 min = { -1.5f, -1.5f, -1.5f }, max = { 1.5f, 1.5f, 1.5f };
+  mcScalarFieldDescriptor descriptor;
+  mcFieldProgram_descriptor(&program, &descriptor);
+  programSampler = descriptor.sampleLattice;
+  descriptor.sf = countedProgram;
+  descriptor.sampleLattice = countedSampler;
+  /* Most of the lattice is far from the surface, and is not evaluated */
+  const mcVec3 delta = {
+    (max.x - min.x) / (float)(res - 1),
+    (max.y - min.y) / (float)(res - 1),
+    (max.z - min.z) / (float)(res - 1) };
+  const unsigned int start[3] = { 0, 0, 0 }, lattice[3] = { res, res, res };
+  float *samples = (float*)malloc(sizeof(float) * res * res * res);
+  numSampled = 0;
+  mcScalarFieldDescriptor_sampleLattice(&descriptor, &min, &delta,
+      start, lattice, NULL, samples);
+  assert(numSampled < (int)(res * res * res / 4));
+  free(samples);
+  /* Extracting through the descriptor gives exactly the same meshes as
+   * evaluating the program at every sample */
+  const mcAlgorithmFlag algorithms[] = {
+    MC_SIMPLE_MARCHING_CUBES, MC_NIELSON_DUAL, MC_DUAL_MARCHING_CUBES };
+  for (int i = 0; i < 3; ++i) {
+    mcIsosurfaceBuilder ib;
+    mcIsosurfaceBuilder_init(&ib);
+    numCalls = 0;
+    const mcMesh *plain = mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
+        &ib, countedProgram, &program, algorithms[i],
+        res, res, res, &min, &max);
+    int numPlainCalls = numCalls;
+    numCalls = 0;
+    numSampled = 0;
+    const mcMesh *fast = mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
+        &ib, mcScalarFieldDescriptor_scalarField, &descriptor, algorithms[i],
+        res, res, res, &min, &max);
+    assert(plain->numFaces > 0);
+    assert(meshesEqual(plain, fast));
+    /* Without the descriptor, every sample is evaluated one at a time. Slices
+     * are culled in thinner blocks than the whole lattice. */
+    assert(numPlainCalls >= (int)(res * res * res));
+    assert(numCalls + numSampled < numPlainCalls / 3);
+    mcIsosurfaceBuilder_destroy(&ib);
+  }
+  mcFieldProgram_destroy(&program);
+  mcFieldExpression_destroy(&expression);
+
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+#define TEST(routine) \
+  do { \
+    int result; \
+    if (result = test_ ## routine()) \
+      return result; \
+  } while (0)
+
+  TEST(mcFieldProgram_evaluateRow);
+  TEST(mcFieldProgram_evaluateLattice);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mc/isosurfaceBuilder.h>
+#include <mc/lipschitzField.h>
+#include <mc/policy.h>
+
+/* The signed distance to a union of three spheres */
+float spheres(float x, float y, float z) {
+  const float centers[3][3] = {
+    { -0.4f, 0.0f, 0.1f }, { 0.35f, 0.2f, -0.1f }, { 0.0f, -0.45f, 0.3f } };
+  const float radii[3] = { 0.4f, 0.3f, 0.25f };
+  float distance = INFINITY;
+  for (int i = 0; i < 3; ++i) {
+    float dx = x - centers[i][0], dy = y - centers[i][1],
+          dz = z - centers[i][2];
+    distance = fminf(distance, sqrtf(dx * dx + dy * dy + dz * dz) - radii[i]);
+  }
+  return distance;
+}
+
+/* The spheres, counting how often they are evaluated */
+int numCalls = 0;
+float countedSpheres(float x, float y, float z, const void *args) {
+  (void)args;
+  ++numCalls;
+  return spheres(x, y, z);
+}
+
+int meshesEqual(const mcMesh *a, const mcMesh *b) {
+  if (a->numVertices != b->numVertices || a->numFaces != b->numFaces)
+    return 0;
+  if (memcmp(a->vertices, b->vertices, sizeof(mcVertex) * a->numVertices))
+    return 0;
+  for (unsigned int i = 0; i < a->numFaces; ++i) {
+    if (a->faces[i].numIndices != b->faces[i].numIndices)
+      return 0;
+    if (memcmp(a->faces[i].indices, b->faces[i].indices,
+          sizeof(unsigned int) * a->faces[i].numIndices))
+      return 0;
+  }
+  return 1;
+}
+
+int test_mcLipschitzField_evaluateLattice() {
+  mcLipschitzField field;
+  mcLipschitzField_init(&field, countedSpheres, NULL, 1.0f);
+  const unsigned int res = 61;
+  const mcVec3 min = { -1.5f, -1.5f, -1.5f };
+  const mcVec3 delta = { 3.0f / (res - 1), 3.0f / (res - 1), 3.0f / (res - 1) };
+  float *samples = (float*)malloc(sizeof(float) * res * res * res);
+  numCalls = 0;
+  mcLipschitzField_evaluateLattice(&field, &min, &delta, res, res, res,
+      samples);
+  /* Most of the lattice is far from the spheres, and is not evaluated */
+  assert(numCalls < (int)(res * res * res / 4));
+  for (unsigned int z = 0; z < res; ++z) {
+    for (unsigned int y = 0; y < res; ++y) {
+      for (unsigned int x = 0; x < res; ++x) {
+        float expected = spheres(
+            min.x + (float)x * delta.x,
+            min.y + (float)y * delta.y,
+            min.z + (float)z * delta.z);
+        float actual = samples[(z * res + y) * res + x];
+        /* Samples of the cubes around the surface are exact, and the rest
+         * keep their sign */
+        assert((actual < 0.0f) == (expected < 0.0f));
+        if (fabsf(expected) < 2.0f * delta.x)
+          assert(actual == expected);
+      }
+    }
+  }
+  free(samples);
+
+  return EXIT_SUCCESS;
+}
+
+int test_mcLipschitzField_meshes() {
+  mcLipschitzField field;
+  mcLipschitzField_init(&field, countedSpheres, NULL, 1.0f);
+  mcScalarFieldDescriptor descriptor;
+  mcLipschitzField_descriptor(&field, &descriptor);
+  const unsigned int res = 97;
+  const mcVec3 min = { -1.5f, -1.5f, -1.5f }, max = { 1.5f, 1.5f, 1.5f };
+  /* Extracting through the descriptor gives exactly the same meshes as
+   * sampling the field everywhere, with far fewer evaluations */
+  const mcAlgorithmFlag algorithms[] = {
+    MC_SIMPLE_MARCHING_CUBES, MC_MARCHING_CUBES_33, MC_SNAP_MARCHING_CUBES };
+  for (int i = 0; i < 3; ++i) {
+    mcIsosurfaceBuilder ib;
+    mcIsosurfaceBuilder_init(&ib);
+    numCalls = 0;
+    const mcMesh *plain = mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
+        &ib, countedSpheres, NULL, algorithms[i],
+        res, res, res, &min, &max);
+    int numPlainCalls = numCalls;
+    numCalls = 0;
+    const mcMesh *culled = mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
+        &ib, mcScalarFieldDescriptor_scalarField, &descriptor, algorithms[i],
+        res, res, res, &min, &max);
+    assert(plain->numFaces > 0);
+    assert(meshesEqual(plain, culled));
+    assert(numPlainCalls >= (int)(res * res * res));
+    assert(numCalls < numPlainCalls / 3);
+    mcIsosurfaceBuilder_destroy(&ib);
+  }
+  /* Blocks extracted by a policy are culled within the whole lattice */
+  mcPolicy policy = { MC_SIMPLE_MARCHING_CUBES, 1, 16 };
+  mcMesh plain, culled;
+  mcMesh_init(&plain);
+  mcMesh_init(&culled);
+  numCalls = 0;
+  mcPolicy_isosurfaceFromField(&policy, countedSpheres, NULL,
+      res, res, res, &min, &max, &plain);
+  int numPlainCalls = numCalls;
+  numCalls = 0;
+  mcPolicy_isosurfaceFromField(&policy,
+      mcScalarFieldDescriptor_scalarField, &descriptor,
+      res, res, res, &min, &max, &culled);
+  assert(plain.numFaces > 0);
+  assert(meshesEqual(&plain, &culled));
+  assert(numCalls < numPlainCalls / 3);
+  mcMesh_destroy(&plain);
+  mcMesh_destroy(&culled);
+
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+#define TEST(routine) \
+  do { \
+    int result; \
+    if (result = test_ ## routine()) \
+      return result; \
+  } while (0)
+
+  TEST(mcLipschitzField_evaluateLattice);
+  TEST(mcLipschitzField_meshes);
+
+  return EXIT_SUCCESS;
+}
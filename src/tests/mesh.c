@@ -0,0 +1,629 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mc/algorithms/snapmc.h>
+#include <mc/decimation.h>
+#include <mc/isosurfaceBuilder.h>
+#include <mc/policy.h>
+#include <mc/vertexCache.h>
+#include <mc/welder.h>
+
+/* The radius is chosen so that no sample of the lattices used in these tests
+ * lies exactly on the surface */
+float sphere(float x, float y, float z) {
+  return x * x + y * y + z * z - 0.55f;
+}
+
+/* A lattice of uniform noise, sampled at integer coordinates */
+typedef struct NoiseLattice {
+  float *samples;
+  int res;
+} NoiseLattice;
+
+float noise(float x, float y, float z, const NoiseLattice *lattice) {
+  int i = (int)lroundf(x), j = (int)lroundf(y), k = (int)lroundf(z);
+  return lattice->samples[i + (j + k * lattice->res) * lattice->res];
+}
+
+/* A small xorshift generator, so that the test is repeatable */
+uint32_t nextRandom(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return (uint32_t)(*state >> 32);
+}
+
+/* The mesh whose vertex positions are being sorted by compareVertices() */
+const mcMesh *sortedMesh;
+
+int comparePositions(const mcVec3 *u, const mcVec3 *v) {
+  if (u->x != v->x)
+    return u->x < v->x ? -1 : 1;
+  if (u->y != v->y)
+    return u->y < v->y ? -1 : 1;
+  if (u->z != v->z)
+    return u->z < v->z ? -1 : 1;
+  return 0;
+}
+
+int compareVertices(const void *a, const void *b) {
+  return comparePositions(
+      &sortedMesh->vertices[*(const unsigned int *)a].pos,
+      &sortedMesh->vertices[*(const unsigned int *)b].pos);
+}
+
+typedef struct Edge {
+  unsigned int a, b;
+  int forward;
+} Edge;
+
+int compareEdges(const void *a, const void *b) {
+  const Edge *e = (const Edge *)a, *f = (const Edge *)b;
+  if (e->a != f->a)
+    return e->a < f->a ? -1 : 1;
+  if (e->b != f->b)
+    return e->b < f->b ? -1 : 1;
+  return 0;
+}
+
+/* Counts the edges of the given mesh that are shared by more than two faces,
+ * and the edges shared by two faces that traverse it in the same direction.
+ * Vertices with identical positions are treated as the same vertex, and edges
+ * that collapse to a point are ignored. The number of edges on the open
+ * boundary of the mesh is returned in numBoundaryEdges. */
+unsigned int countNonManifoldEdges(const mcMesh *mesh,
+    unsigned int *numBoundaryEdges)
+{
+  unsigned int *order, *canonical, numEdges, result;
+  Edge *edges;
+  /* Map each vertex to the first vertex with the same position */
+  order = (unsigned int *)malloc(sizeof(unsigned int) * mesh->numVertices);
+  canonical = (unsigned int *)malloc(sizeof(unsigned int) * mesh->numVertices);
+  for (unsigned int i = 0; i < mesh->numVertices; ++i)
+    order[i] = i;
+  sortedMesh = mesh;
+  qsort(order, mesh->numVertices, sizeof(unsigned int), compareVertices);
+  for (unsigned int i = 0; i < mesh->numVertices; ++i) {
+    if (i > 0 && compareVertices(&order[i - 1], &order[i]) == 0)
+      canonical[order[i]] = canonical[order[i - 1]];
+    else
+      canonical[order[i]] = order[i];
+  }
+  /* Gather the edges of every face */
+  edges = (Edge *)malloc(sizeof(Edge) * mesh->numIndices);
+  numEdges = 0;
+  for (unsigned int i = 0; i < mesh->numFaces; ++i) {
+    const mcFace *face = &mesh->faces[i];
+    for (unsigned int j = 0; j < face->numIndices; ++j) {
+      unsigned int a = canonical[face->indices[j]];
+      unsigned int b = canonical[face->indices[(j + 1) % face->numIndices]];
+      if (a == b)
+        continue;
+      edges[numEdges].a = a < b ? a : b;
+      edges[numEdges].b = a < b ? b : a;
+      edges[numEdges].forward = a < b;
+      ++numEdges;
+    }
+  }
+  qsort(edges, numEdges, sizeof(Edge), compareEdges);
+  result = 0;
+  *numBoundaryEdges = 0;
+  for (unsigned int i = 0; i < numEdges; ) {
+    unsigned int j = i + 1;
+    while (j < numEdges && compareEdges(&edges[i], &edges[j]) == 0)
+      ++j;
+    if (j - i == 1)
+      *numBoundaryEdges += 1;
+    else if (j - i > 2 || edges[i].forward == edges[i + 1].forward)
+      result += 1;
+    i = j;
+  }
+  free(edges);
+  free(canonical);
+  free(order);
+  return result;
+}
+
+/* Computes the (unnormalized) normal of the given triangle */
+mcVec3 triangleNormal(const mcMesh *mesh, const mcFace *face) {
+  mcVec3 u, v, normal;
+  mcVec3_subtract(&mesh->vertices[face->indices[1]].pos,
+      &mesh->vertices[face->indices[0]].pos, &u);
+  mcVec3_subtract(&mesh->vertices[face->indices[2]].pos,
+      &mesh->vertices[face->indices[0]].pos, &v);
+  mcVec3_cross(&u, &v, &normal);
+  return normal;
+}
+
+/* Returns 1 if the given triangle faces away from the given center, and -1 if
+ * it faces towards the center */
+int triangleOrientation(const mcMesh *mesh, const mcFace *face,
+    const mcVec3 *center)
+{
+  mcVec3 normal, centroid, outward;
+  normal = triangleNormal(mesh, face);
+  centroid.x = centroid.y = centroid.z = 0.0f;
+  for (int i = 0; i < 3; ++i)
+    mcVec3_add(&centroid, &mesh->vertices[face->indices[i]].pos, &centroid);
+  mcVec3_scalarProduct(1.0f / 3.0f, &centroid, &centroid);
+  mcVec3_subtract(&centroid, center, &outward);
+  return mcVec3_dot(&normal, &outward) > 0.0f ? 1 : -1;
+}
+
+/* A triangle given by its three vertex indices, rotated so that the smallest
+ * index comes first without changing the winding */
+typedef struct IndexTriangle {
+  unsigned int indices[3];
+} IndexTriangle;
+
+int compareIndexTriangles(const void *a, const void *b) {
+  return memcmp(a, b, sizeof(IndexTriangle));
+}
+
+/* Returns the sorted list of the given triangles */
+IndexTriangle *sortedIndexTriangles(const unsigned int *indices,
+    unsigned int numTriangles)
+{
+  IndexTriangle *triangles =
+    (IndexTriangle *)malloc(sizeof(IndexTriangle) * numTriangles);
+  for (unsigned int i = 0; i < numTriangles; ++i) {
+    const unsigned int *t = &indices[i * 3];
+    int first = 0;
+    if (t[1] < t[first])
+      first = 1;
+    if (t[2] < t[first])
+      first = 2;
+    for (int j = 0; j < 3; ++j)
+      triangles[i].indices[j] = t[(first + j) % 3];
+  }
+  qsort(triangles, numTriangles, sizeof(IndexTriangle),
+      compareIndexTriangles);
+  return triangles;
+}
+
+/* A triangle given by its three vertex positions, rotated so that the
+ * smallest position comes first without changing the winding */
+typedef struct PositionTriangle {
+  mcVec3 pos[3];
+} PositionTriangle;
+
+int comparePositionTriangles(const void *a, const void *b) {
+  const PositionTriangle *s = (const PositionTriangle *)a;
+  const PositionTriangle *t = (const PositionTriangle *)b;
+  for (int i = 0; i < 3; ++i) {
+    int result = comparePositions(&s->pos[i], &t->pos[i]);
+    if (result != 0)
+      return result;
+  }
+  return 0;
+}
+
+/* Returns the sorted list of the triangles of the given mesh */
+PositionTriangle *sortedPositionTriangles(const mcMesh *mesh) {
+  PositionTriangle *triangles =
+    (PositionTriangle *)malloc(sizeof(PositionTriangle) * mesh->numFaces);
+  for (unsigned int i = 0; i < mesh->numFaces; ++i) {
+    const unsigned int *t = mesh->faces[i].indices;
+    int first = 0;
+    assert(mesh->faces[i].numIndices == 3);
+    for (int j = 1; j < 3; ++j) {
+      if (comparePositions(&mesh->vertices[t[j]].pos,
+            &mesh->vertices[t[first]].pos) < 0)
+        first = j;
+    }
+    for (int j = 0; j < 3; ++j)
+      triangles[i].pos[j] = mesh->vertices[t[(first + j) % 3]].pos;
+  }
+  qsort(triangles, mesh->numFaces, sizeof(PositionTriangle),
+      comparePositionTriangles);
+  return triangles;
+}
+
+int test_mcDecimation_decimateMesh() {
+  mcIsosurfaceBuilder ib;
+  mcVec3 min = { .x = -1.0f, .y = -1.0f, .z = -1.0f },
+         max = { .x = 1.0f, .y = 1.0f, .z = 1.0f };
+  mcIsosurfaceBuilder_init(&ib);
+  const mcMesh *mesh = mcIsosurfaceBuilder_isosurfaceFromField(
+      &ib,
+      sphere,
+      MC_SIMPLE_MARCHING_CUBES,
+      24, 24, 24,
+      &min, &max);
+  unsigned int numBoundaryEdges;
+  assert(countNonManifoldEdges(mesh, &numBoundaryEdges) == 0);
+  assert(numBoundaryEdges == 0);
+  /* The sphere is centered on the centroid of its vertices */
+  mcVec3 center;
+  center.x = center.y = center.z = 0.0f;
+  for (unsigned int i = 0; i < mesh->numVertices; ++i)
+    mcVec3_add(&center, &mesh->vertices[i].pos, &center);
+  mcVec3_scalarProduct(1.0f / (float)mesh->numVertices, &center, &center);
+  /* All triangles of the sphere face the same way */
+  int orientation = triangleOrientation(mesh, &mesh->faces[0], &center);
+  for (unsigned int i = 0; i < mesh->numFaces; ++i)
+    assert(triangleOrientation(mesh, &mesh->faces[i], &center)
+        == orientation);
+  /* Decimate the sphere down to a quarter of its triangles */
+  mcDecimationParams params;
+  mcDecimationParams_default(&params);
+  params.targetNumFaces = mesh->numFaces / 4;
+  params.maxError = 1.0f;
+  const mcMesh *decimated = mcIsosurfaceBuilder_decimateMesh(
+      &ib, mesh, &params);
+  assert(decimated->numFaces <= params.targetNumFaces);
+  assert(decimated->numFaces >= params.targetNumFaces - 2);
+  /* The decimated sphere is still closed and manifold, and none of its
+   * triangles have flipped */
+  assert(countNonManifoldEdges(decimated, &numBoundaryEdges) == 0);
+  assert(numBoundaryEdges == 0);
+  for (unsigned int i = 0; i < decimated->numFaces; ++i) {
+    assert(decimated->faces[i].numIndices == 3);
+    assert(triangleOrientation(decimated, &decimated->faces[i], &center)
+        == orientation);
+  }
+  mcIsosurfaceBuilder_destroy(&ib);
+
+  return EXIT_SUCCESS;
+}
+
+int test_mcVertexCache_optimizeTriangles() {
+  mcIsosurfaceBuilder ib;
+  mcVec3 min = { .x = -1.0f, .y = -1.0f, .z = -1.0f },
+         max = { .x = 1.0f, .y = 1.0f, .z = 1.0f };
+  mcIsosurfaceBuilder_init(&ib);
+  const mcMesh *mesh = mcIsosurfaceBuilder_isosurfaceFromField(
+      &ib,
+      sphere,
+      MC_SIMPLE_MARCHING_CUBES,
+      24, 24, 24,
+      &min, &max);
+  unsigned int numTriangles = mesh->numFaces;
+  unsigned int *indices =
+    (unsigned int *)malloc(sizeof(unsigned int) * numTriangles * 3);
+  for (unsigned int i = 0; i < numTriangles; ++i) {
+    assert(mesh->faces[i].numIndices == 3);
+    for (int j = 0; j < 3; ++j)
+      indices[i * 3 + j] = mesh->faces[i].indices[j];
+  }
+  IndexTriangle *original = sortedIndexTriangles(indices, numTriangles);
+  float originalRatio = mcVertexCache_averageCacheMissRatio(
+      indices, numTriangles, MC_VERTEX_CACHE_DEFAULT_SIZE);
+  /* Reordering the triangles keeps every triangle and its winding, and does
+   * not make the cache miss more often */
+  mcVertexCache_optimizeTriangles(indices, numTriangles, mesh->numVertices,
+      MC_VERTEX_CACHE_DEFAULT_SIZE);
+  IndexTriangle *reordered = sortedIndexTriangles(indices, numTriangles);
+  assert(memcmp(original, reordered, sizeof(IndexTriangle) * numTriangles)
+      == 0);
+  float reorderedRatio = mcVertexCache_averageCacheMissRatio(
+      indices, numTriangles, MC_VERTEX_CACHE_DEFAULT_SIZE);
+  assert(reorderedRatio <= originalRatio);
+  /* Renumbering the vertices maps each triangle onto its renumbered vertices
+   * and leaves the cache behavior untouched */
+  unsigned int *before =
+    (unsigned int *)malloc(sizeof(unsigned int) * numTriangles * 3);
+  memcpy(before, indices, sizeof(unsigned int) * numTriangles * 3);
+  unsigned int *remap =
+    (unsigned int *)malloc(sizeof(unsigned int) * mesh->numVertices);
+  unsigned int numVertices = mcVertexCache_optimizeVertexFetch(
+      indices, numTriangles * 3, mesh->numVertices, remap);
+  assert(numVertices <= mesh->numVertices);
+  unsigned int nextVertex = 0;
+  for (unsigned int i = 0; i < numTriangles * 3; ++i) {
+    assert(indices[i] == remap[before[i]]);
+    /* Vertices are numbered in the order of their first use */
+    assert(indices[i] <= nextVertex);
+    if (indices[i] == nextVertex)
+      ++nextVertex;
+  }
+  assert(nextVertex == numVertices);
+  assert(mcVertexCache_averageCacheMissRatio(
+        indices, numTriangles, MC_VERTEX_CACHE_DEFAULT_SIZE)
+      == reorderedRatio);
+  free(remap);
+  free(before);
+  free(reordered);
+  free(original);
+  free(indices);
+  mcIsosurfaceBuilder_destroy(&ib);
+
+  return EXIT_SUCCESS;
+}
+
+int test_mcVertexCache_optimizeMesh() {
+  mcIsosurfaceBuilder ib;
+  mcVec3 min = { .x = -1.0f, .y = -1.0f, .z = -1.0f },
+         max = { .x = 1.0f, .y = 1.0f, .z = 1.0f };
+  mcIsosurfaceBuilder_init(&ib);
+  const mcMesh *mesh = mcIsosurfaceBuilder_isosurfaceFromField(
+      &ib,
+      sphere,
+      MC_SIMPLE_MARCHING_CUBES,
+      24, 24, 24,
+      &min, &max);
+  mcMesh optimized;
+  mcMesh_copy(&optimized, mesh);
+  mcVertexCache_optimizeMesh(&optimized, MC_VERTEX_CACHE_DEFAULT_SIZE);
+  /* The optimized mesh has the same triangles at the same positions */
+  assert(optimized.numFaces == mesh->numFaces);
+  PositionTriangle *original = sortedPositionTriangles(mesh);
+  PositionTriangle *reordered = sortedPositionTriangles(&optimized);
+  for (unsigned int i = 0; i < mesh->numFaces; ++i)
+    assert(comparePositionTriangles(&original[i], &reordered[i]) == 0);
+  assert(mcVertexCache_meshAverageCacheMissRatio(
+        &optimized, MC_VERTEX_CACHE_DEFAULT_SIZE)
+      <= mcVertexCache_meshAverageCacheMissRatio(
+        mesh, MC_VERTEX_CACHE_DEFAULT_SIZE));
+  free(reordered);
+  free(original);
+  mcMesh_destroy(&optimized);
+  mcIsosurfaceBuilder_destroy(&ib);
+
+  return EXIT_SUCCESS;
+}
+
+int test_mcWelder_weldMeshes() {
+  mcIsosurfaceBuilder ib;
+  mcVec3 min = { .x = -1.0f, .y = -1.0f, .z = -1.0f },
+         mid = { .x = 0.0f, .y = -1.0f, .z = -1.0f },
+         max = { .x = 1.0f, .y = 1.0f, .z = 1.0f },
+         midMax = { .x = 0.0f, .y = 1.0f, .z = 1.0f };
+  mcIsosurfaceBuilder_init(&ib);
+  /* Build the sphere in one piece, and again as two chunks that share the
+   * lattice plane at x = 0 */
+  const mcMesh *whole = mcIsosurfaceBuilder_isosurfaceFromField(
+      &ib,
+      sphere,
+      MC_SIMPLE_MARCHING_CUBES,
+      25, 25, 25,
+      &min, &max);
+  const mcMesh *chunks[2];
+  chunks[0] = mcIsosurfaceBuilder_isosurfaceFromField(
+      &ib,
+      sphere,
+      MC_SIMPLE_MARCHING_CUBES,
+      13, 25, 25,
+      &min, &midMax);
+  chunks[1] = mcIsosurfaceBuilder_isosurfaceFromField(
+      &ib,
+      sphere,
+      MC_SIMPLE_MARCHING_CUBES,
+      13, 25, 25,
+      &mid, &max);
+  unsigned int numBoundaryEdges;
+  assert(countNonManifoldEdges(chunks[0], &numBoundaryEdges) == 0);
+  assert(numBoundaryEdges > 0);
+  /* Weld the two chunks together */
+  mcVec3 offsets[2] = {
+    { .x = 0.0f, .y = 0.0f, .z = 0.0f },
+    { .x = 1.0f, .y = 0.0f, .z = 0.0f },
+  };
+  mcVec3 delta = { .x = 1.0f / 12.0f, .y = 1.0f / 12.0f, .z = 1.0f / 12.0f };
+  mcMesh welded;
+  mcMesh_init(&welded);
+  mcWelder_weldMeshes(chunks, offsets, 2, &delta, &welded);
+  /* The boundary vertices of the chunks are merged, so the welded sphere is
+   * closed and has as many vertices as the sphere built in one piece */
+  assert(welded.numFaces == chunks[0]->numFaces + chunks[1]->numFaces);
+  assert(welded.numFaces == whole->numFaces);
+  assert(welded.numVertices < chunks[0]->numVertices + chunks[1]->numVertices);
+  assert(welded.numVertices == whole->numVertices);
+  assert(countNonManifoldEdges(&welded, &numBoundaryEdges) == 0);
+  assert(numBoundaryEdges == 0);
+  mcMesh_destroy(&welded);
+  mcIsosurfaceBuilder_destroy(&ib);
+
+  return EXIT_SUCCESS;
+}
+
+int test_mcSnapMC_manifold() {
+  mcIsosurfaceBuilder ib;
+  mcIsosurfaceBuilder_init(&ib);
+  /* Uniform noise is the worst case for snapping, since nearly every lattice
+   * point has an edge intersection close to it */
+  NoiseLattice lattice;
+  lattice.res = 32;
+  lattice.samples = (float *)malloc(
+      sizeof(float) * lattice.res * lattice.res * lattice.res);
+  uint64_t state = 0x2545f4914f6cdd1dull;
+  for (int i = 0; i < lattice.res * lattice.res * lattice.res; ++i)
+    lattice.samples[i] = (float)nextRandom(&state) / 4294967296.0f - 0.5f;
+  mcVec3 min = { .x = 0.0f, .y = 0.0f, .z = 0.0f },
+         max = { .x = lattice.res - 1, .y = lattice.res - 1,
+                 .z = lattice.res - 1 };
+  const mcMesh *mc = mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
+      &ib,
+      (mcScalarFieldWithArgs)noise, &lattice,
+      MC_SIMPLE_MARCHING_CUBES,
+      lattice.res, lattice.res, lattice.res,
+      &min, &max);
+  const mcMesh *snapped = mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
+      &ib,
+      (mcScalarFieldWithArgs)noise, &lattice,
+      MC_SNAP_MARCHING_CUBES,
+      lattice.res, lattice.res, lattice.res,
+      &min, &max);
+  /* Snapping removes vertices, but every edge is still shared by at most two
+   * consistently wound triangles */
+  unsigned int numBoundaryEdges, numSnappedBoundaryEdges;
+  assert(countNonManifoldEdges(mc, &numBoundaryEdges) == 0);
+  assert(snapped->numVertices < mc->numVertices);
+  assert(countNonManifoldEdges(snapped, &numSnappedBoundaryEdges) == 0);
+  /* Snapping never opens up new holes */
+  assert(numSnappedBoundaryEdges <= numBoundaryEdges);
+  /* Noise whose sign alternates between neighboring lattice points crosses
+   * all twelve edges of every cube */
+  for (int k = 0; k < lattice.res; ++k) {
+    for (int j = 0; j < lattice.res; ++j) {
+      for (int i = 0; i < lattice.res; ++i) {
+        float magnitude = (float)nextRandom(&state) / 4294967296.0f + 0.01f;
+        lattice.samples[i + (j + k * lattice.res) * lattice.res] =
+          (i + j + k) % 2 ? magnitude : -magnitude;
+      }
+    }
+  }
+  mc = mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
+      &ib,
+      (mcScalarFieldWithArgs)noise, &lattice,
+      MC_SIMPLE_MARCHING_CUBES,
+      lattice.res, lattice.res, lattice.res,
+      &min, &max);
+  snapped = mcIsosurfaceBuilder_isosurfaceFromFieldWithArgs(
+      &ib,
+      (mcScalarFieldWithArgs)noise, &lattice,
+      MC_SNAP_MARCHING_CUBES,
+      lattice.res, lattice.res, lattice.res,
+      &min, &max);
+  assert(countNonManifoldEdges(mc, &numBoundaryEdges) == 0);
+  assert(countNonManifoldEdges(snapped, &numSnappedBoundaryEdges) == 0);
+  assert(numSnappedBoundaryEdges <= numBoundaryEdges);
+  /* A closed surface stays closed */
+  mcVec3 sphereMin = { .x = -1.0f, .y = -1.0f, .z = -1.0f },
+         sphereMax = { .x = 1.0f, .y = 1.0f, .z = 1.0f };
+  const mcMesh *sphereMesh = mcIsosurfaceBuilder_isosurfaceFromField(
+      &ib,
+      sphere,
+      MC_SNAP_MARCHING_CUBES,
+      24, 24, 24,
+      &sphereMin, &sphereMax);
+  assert(countNonManifoldEdges(sphereMesh, &numBoundaryEdges) == 0);
+  assert(numBoundaryEdges == 0);
+  free(lattice.samples);
+  mcIsosurfaceBuilder_destroy(&ib);
+
+  return EXIT_SUCCESS;
+}
+
+/* A plane cutting off the corner of the unit cube at the origin */
+float cornerPlane(float x, float y, float z) {
+  return x + y + z - 0.1f;
+}
+
+/* A plane perpendicular to the x-axis */
+float xPlane(float x, float y, float z) {
+  return x - 0.3f;
+}
+
+int test_mcAdaptiveDualContouring_keepsSurface() {
+  mcIsosurfaceBuilder ib;
+  mcIsosurfaceBuilder_init(&ib);
+  /* The whole corner patch fits in a single octree node, which must not be
+   * collapsed into a leaf that has no faces left */
+  mcVec3 min = { .x = 0.0f, .y = 0.0f, .z = 0.0f },
+         max = { .x = 1.0f, .y = 1.0f, .z = 1.0f };
+  const mcMesh *corner = mcIsosurfaceBuilder_isosurfaceFromField(
+      &ib,
+      cornerPlane,
+      MC_ADAPTIVE_DUAL_CONTOURING,
+      33, 33, 33,
+      &min, &max);
+  assert(corner->numFaces > 0);
+  /* A plane across the whole lattice collapses into a handful of large
+   * cells, but not into the root alone */
+  mcVec3 planeMin = { .x = -1.0f, .y = -1.0f, .z = -1.0f };
+  const mcMesh *plane = mcIsosurfaceBuilder_isosurfaceFromField(
+      &ib,
+      xPlane,
+      MC_ADAPTIVE_DUAL_CONTOURING,
+      129, 129, 129,
+      &planeMin, &max);
+  assert(plane->numFaces > 0);
+  assert(plane->numFaces < 100);
+  unsigned int numBoundaryEdges;
+  assert(countNonManifoldEdges(plane, &numBoundaryEdges) == 0);
+  mcIsosurfaceBuilder_destroy(&ib);
+
+  return EXIT_SUCCESS;
+}
+
+int test_mcDualMarchingCubes_closed() {
+  mcIsosurfaceBuilder ib;
+  mcIsosurfaceBuilder_init(&ib);
+  /* The dual of a closed marching cubes surface is itself closed, with each
+   * dual face wound consistently with its neighbors */
+  mcVec3 min = { .x = -1.0f, .y = -1.0f, .z = -1.0f },
+         max = { .x = 1.0f, .y = 1.0f, .z = 1.0f };
+  const mcMesh *mc = mcIsosurfaceBuilder_isosurfaceFromField(
+      &ib,
+      sphere,
+      MC_SIMPLE_MARCHING_CUBES,
+      24, 24, 24,
+      &min, &max);
+  const mcMesh *dual = mcIsosurfaceBuilder_isosurfaceFromField(
+      &ib,
+      sphere,
+      MC_DUAL_MARCHING_CUBES,
+      24, 24, 24,
+      &min, &max);
+  unsigned int numBoundaryEdges;
+  assert(dual->numFaces > 0);
+  assert(countNonManifoldEdges(dual, &numBoundaryEdges) == 0);
+  assert(numBoundaryEdges == 0);
+  /* Each dual vertex stands for a patch of at least one marching cubes
+   * triangle */
+  assert(dual->numVertices <= mc->numFaces);
+  mcIsosurfaceBuilder_destroy(&ib);
+
+  return EXIT_SUCCESS;
+}
+
+int test_mcPolicy_defaultSingleThreaded() {
+  /* Only the explicit CPU policies may call the scalar field from several
+   * threads, even for lattices large enough to split into many blocks */
+  mcPolicy policy;
+  mcPolicy_select(MC_DEFAULT_ALGORITHM, 513, 513, 513, &policy);
+  assert(policy.numThreads == 1);
+  assert(policy.blockSize == 0);
+  mcPolicy_select(MC_LOW_MEMORY_ALGORITHM, 513, 513, 513, &policy);
+  assert(policy.numThreads == 1);
+  assert(policy.blockSize == 0);
+
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+#define TEST(routine) \
+  do { \
+    int result; \
+    if (result = test_ ## routine()) \
+      return result; \
+  } while (0)
+
+  TEST(mcDecimation_decimateMesh);
+  TEST(mcVertexCache_optimizeTriangles);
+  TEST(mcVertexCache_optimizeMesh);
+  TEST(mcWelder_weldMeshes);
+  TEST(mcSnapMC_manifold);
+  TEST(mcAdaptiveDualContouring_keepsSurface);
+  TEST(mcDualMarchingCubes_closed);
+  TEST(mcPolicy_defaultSingleThreaded);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <mc/common/morton.h>
+#include <mc/common/octNode.h>
+#include <mc/common/quadNode.h>
+
+/* Interleaves the bits of the given coordinates one at a time */
+uint64_t naiveMortonCode(const uint32_t *coord, int dimension, int bits) {
+  uint64_t code = 0;
+  for (int bit = 0; bit < bits; ++bit) {
+    for (int i = 0; i < dimension; ++i) {
+      code |= (uint64_t)((coord[i] >> bit) & 1) << (bit * dimension + i);
+    }
+  }
+  return code;
+}
+
+/* A small xorshift generator, so that the test is repeatable */
+uint32_t nextRandom(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return (uint32_t)(*state >> 32);
+}
+
+int test_mcMorton_encode2() {
+  uint64_t state = 0x2545f4914f6cdd1dull;
+  for (int n = 0; n < 10000; ++n) {
+    uint32_t coord[2] = { nextRandom(&state), nextRandom(&state) };
+    uint64_t code = mcMorton_encode2(coord[0], coord[1]);
+    assert(code == naiveMortonCode(coord, 2, 32));
+    uint32_t x, y;
+    mcMorton_decode2(code, &x, &y);
+    assert(x == coord[0] && y == coord[1]);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int test_mcMorton_encode3() {
+  uint64_t state = 0x2545f4914f6cdd1dull;
+  for (int n = 0; n < 10000; ++n) {
+    uint32_t coord[3] = {
+      nextRandom(&state) & 0x1fffff,
+      nextRandom(&state) & 0x1fffff,
+      nextRandom(&state) & 0x1fffff,
+    };
+    uint64_t code = mcMorton_encode3(coord[0], coord[1], coord[2]);
+    assert(code == naiveMortonCode(coord, 3, 21));
+    uint32_t x, y, z;
+    mcMorton_decode3(code, &x, &y, &z);
+    assert(x == coord[0] && y == coord[1] && z == coord[2]);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int test_mcOctNode_latticeIterator() {
+  mcOctNode node;
+  mcOctNode_init(&node);
+  node.level = 3;
+  node.pos.coord[0] = 8;
+  node.pos.coord[1] = -16;
+  node.pos.coord[2] = 24;
+  int count = 0;
+  for (mcOctLatticeIterator i = mcOctNode_beginLattice(&node);
+      !mcOctLatticeIterator_equals(&i, mcOctNode_endLattice(&node));
+      mcOctLatticeIterator_next(&i))
+  {
+    /* Positions must be visited in Z-order, and each one exactly once */
+    uint32_t offset[3];
+    for (int j = 0; j < 3; ++j) {
+      offset[j] = (uint32_t)(i.pos.coord[j] - node.pos.coord[j]);
+      assert(offset[j] < 8);
+    }
+    assert(naiveMortonCode(offset, 3, 3) == (uint64_t)count);
+    ++count;
+  }
+  assert(count == 8 * 8 * 8);
+
+  return EXIT_SUCCESS;
+}
+
+int test_mcQuadTree_encode() {
+  mcQuadTree tree;
+  mcQuadTree_init(&tree, 12);
+  uint64_t state = 0x2545f4914f6cdd1dull;
+  for (int n = 0; n < 10000; ++n) {
+    int level = nextRandom(&state) % 13;
+    mcQuadNodeCoordinates pos, decoded;
+    for (int i = 0; i < 2; ++i)
+      pos.coord[i] = (nextRandom(&state) % (1 << 12)) >> level << level;
+    int decodedLevel;
+    mcQuadTree_decode(&tree, mcQuadTree_encode(&tree, &pos, level),
+        &decoded, &decodedLevel);
+    assert(decodedLevel == level);
+    assert(decoded.coord[0] == pos.coord[0]);
+    assert(decoded.coord[1] == pos.coord[1]);
+  }
+  mcQuadTree_destroy(&tree);
+
+  return EXIT_SUCCESS;
+}
+
+int test_mcOctTree_getNeighbor() {
+  mcOctTree tree;
+  mcOctTree_init(&tree, 4);
+  mcOctNodeCoordinates pos = { { 4, 4, 4 } }, other = { { 8, 4, 4 } };
+  mcOctTreeNode *node = mcOctTree_getNode(&tree, &pos, 2);
+  /* Only the parent of the node on the other side exists so far */
+  mcOctTree_getNode(&tree, &other, 3);
+  mcOctTreeNode *neighbor = mcOctTree_getNeighbor(&tree, node, 0, 1);
+  assert(neighbor->level == 3);
+  assert(neighbor == mcOctTree_getNodeContainingPos(&tree, &other));
+  node = mcOctTree_getNode(&tree, &pos, 2);
+  assert(mcOctTree_getNeighbor(&tree, node, 0, -1)->level == 3);
+  /* Nothing lies beyond the edges of the tree */
+  mcOctNodeCoordinates corner = { { 0, 0, 0 } };
+  node = mcOctTree_getNode(&tree, &corner, 0);
+  assert(mcOctTree_getNeighbor(&tree, node, 2, -1) == NULL);
+  mcOctTree_destroy(&tree);
+
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+#define TEST(routine) \
+  do { \
+    int result; \
+    if (result = test_ ## routine()) \
+      return result; \
+  } while (0)
+
+  TEST(mcMorton_encode2);
+  TEST(mcMorton_encode3);
+  TEST(mcOctNode_latticeIterator);
+  TEST(mcQuadTree_encode);
+  TEST(mcOctTree_getNeighbor);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <mc/algorithms/common/qef.h>
+
+/* A small xorshift generator, so that the test is repeatable */
+uint32_t nextRandom(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return (uint32_t)(*state >> 32);
+}
+
+int test_mcQef_planar() {
+  /* Tangent planes of a single plane, far from the origin as in the lattice
+   * coordinates of a large lattice, summed up cell by cell as when collapsing
+   * an octree */
+  mcVec3 normal = { .x = 1.0f, .y = 2.0f, .z = 3.0f };
+  mcVec3_normalize(&normal, &normal);
+  const float distance = 150.0f;
+  uint64_t state = 0x2545f4914f6cdd1dull;
+  mcQef total;
+  mcQef_init(&total);
+  for (int cell = 0; cell < 4096; ++cell) {
+    mcQef qef;
+    mcQef_init(&qef);
+    for (int i = 0; i < 4; ++i) {
+      /* Pick a point on the plane within a 128 wide lattice */
+      float y = (float)nextRandom(&state) / 4294967296.0f * 128.0f;
+      float z = (float)nextRandom(&state) / 4294967296.0f * 128.0f;
+      mcVec3 point = {
+        .x = (distance - normal.y * y - normal.z * z) / normal.x,
+        .y = y, .z = z };
+      mcQef_addPlane(&qef, &point, &normal);
+    }
+    mcQef_add(&total, &qef);
+  }
+  assert(total.numPoints == 4096 * 4);
+  /* Every point on the plane has next to no error, far below the tolerances
+   * used for collapsing cells */
+  mcVec3 massPoint, minimizer;
+  mcQef_massPoint(&total, &massPoint);
+  assert(fabsf(mcVec3_dot(&normal, &massPoint) - distance) < 1.0e-3f);
+  assert(mcQef_error(&total, &massPoint) < 1.0e-3f);
+  float error = mcQef_solve(&total, &minimizer);
+  assert(error < 1.0e-3f);
+  assert(fabsf(mcVec3_dot(&normal, &minimizer) - distance) < 1.0e-3f);
+  /* Moving off of the plane adds the squared distance for every plane */
+  mcVec3 offset;
+  mcVec3_scalarProduct(0.1f, &normal, &offset);
+  mcVec3_add(&massPoint, &offset, &offset);
+  float expected = 0.01f * total.numPoints;
+  assert(fabsf(mcQef_error(&total, &offset) - expected) < 1.0e-2f * expected);
+
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+#define TEST(routine) \
+  do { \
+    int result; \
+    if (result = test_ ## routine()) \
+      return result; \
+  } while (0)
+
+  TEST(mcQef_planar);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2016 Jonathan Glines
+ * Jonathan Glines <jonathan@glines.net>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mc/algorithms/simple.h>
+#include <mc/heightField.h>
+#include <mc/sampleGrid.h>
+
+/* A wavy ellipsoid, whose features are all larger than a coarse cell of the
+ * lattices used in these tests */
+float ellipsoid(float x, float y, float z, const void *args) {
+  return x * x / 0.5f + y * y / 0.4f + z * z / 0.6f - 1.0f
+    + 0.05f * sinf(3.0f * x) * sinf(2.0f * y);
+}
+
+/* Returns true if the isosurface passes through the cube of the lattice with
+ * the given minimum corner */
+int containsSurface(const mcSampleGrid *grid,
+    unsigned int x, unsigned int y, unsigned int z)
+{
+  int numBelow = 0;
+  for (int i = 0; i < 8; ++i) {
+    if (mcSampleGrid_sample(grid, x + (i & 1), y + ((i >> 1) & 1),
+          z + ((i >> 2) & 1)) < 0.0f)
+      ++numBelow;
+  }
+  return numBelow > 0 && numBelow < 8;
+}
+
+void compareCoarseToFine(unsigned int x_res, unsigned int y_res,
+    unsigned int z_res)
+{
+  const mcVec3 min = { -1.2f, -1.2f, -1.2f }, max = { 1.2f, 1.2f, 1.2f };
+  mcSampleGrid reference, grid;
+  mcSampleGrid_init(&reference, ellipsoid, NULL,
+      x_res, y_res, z_res, &min, &max);
+  mcSampleGrid_initCoarseToFine(&grid, ellipsoid, NULL,
+      x_res, y_res, z_res, &min, &max, 4, 1);
+  int numSurfaceCubes = 0, numInterpolated = 0;
+  for (unsigned int z = 0; z < z_res; ++z) {
+    for (unsigned int y = 0; y < y_res; ++y) {
+      for (unsigned int x = 0; x < x_res; ++x) {
+        /* Interpolated samples keep their sign */
+        float expected = mcSampleGrid_sample(&reference, x, y, z);
+        float actual = mcSampleGrid_sample(&grid, x, y, z);
+        assert((expected < 0.0f) == (actual < 0.0f));
+        if (actual != expected)
+          ++numInterpolated;
+        if (x + 1 == x_res || y + 1 == y_res || z + 1 == z_res
+            || !containsSurface(&reference, x, y, z))
+          continue;
+        ++numSurfaceCubes;
+        /* Cubes containing the surface and the samples around them that
+         * normals are estimated from are sampled exactly */
+        for (unsigned int k = z > 0 ? z - 1 : z;
+            k <= z + 2 && k < z_res; ++k)
+        {
+          for (unsigned int j = y > 0 ? y - 1 : y;
+              j <= y + 2 && j < y_res; ++j)
+          {
+            for (unsigned int i = x > 0 ? x - 1 : x;
+                i <= x + 2 && i < x_res; ++i)
+            {
+              assert(mcSampleGrid_sample(&grid, i, j, k)
+                  == mcSampleGrid_sample(&reference, i, j, k));
+            }
+          }
+        }
+      }
+    }
+  }
+  assert(numSurfaceCubes > 0);
+  /* Cells far from the surface were not sampled */
+  assert(numInterpolated > 0);
+
+  /* Both grids build exactly the same mesh */
+  mcMesh expected, actual;
+  mcMesh_init(&expected);
+  mcMesh_init(&actual);
+  mcSimple_isosurfaceFromField(mcSampleGrid_scalarField, &reference,
+      x_res, y_res, z_res, &min, &max, &expected);
+  mcSimple_isosurfaceFromField(mcSampleGrid_scalarField, &grid,
+      x_res, y_res, z_res, &min, &max, &actual);
+  assert(expected.numVertices > 0);
+  assert(actual.numVertices == expected.numVertices);
+  assert(actual.numFaces == expected.numFaces);
+  assert(memcmp(actual.vertices, expected.vertices,
+        sizeof(mcVertex) * expected.numVertices) == 0);
+  for (unsigned int i = 0; i < expected.numFaces; ++i) {
+    assert(actual.faces[i].numIndices == expected.faces[i].numIndices);
+    assert(memcmp(actual.faces[i].indices, expected.faces[i].indices,
+          sizeof(unsigned int) * expected.faces[i].numIndices) == 0);
+  }
+  mcMesh_destroy(&actual);
+  mcMesh_destroy(&expected);
+  mcSampleGrid_destroy(&grid);
+  mcSampleGrid_destroy(&reference);
+}
+
+int test_mcSampleGrid_initCoarseToFine() {
+  /* The coarse cells fit the lattice exactly */
+  compareCoarseToFine(33, 33, 33);
+  /* The last coarse cell along each axis is cut short */
+  compareCoarseToFine(31, 35, 26);
+
+  return EXIT_SUCCESS;
+}
+
+/* Rolling hills between -0.5 and 0.5, which count how often they are
+ * evaluated */
+int numHeightCalls = 0;
+float hills(float u, float v, const void *args) {
+  ++numHeightCalls;
+  return 0.3f * sinf(2.0f * u) * cosf(3.0f * v) + 0.1f * u;
+}
+
+void compareHeightField(int axis,
+    const mcVec3 *min, const mcVec3 *max, const unsigned int *res,
+    int isCulled)
+{
+  mcHeightField field;
+  mcHeightField_init(&field, hills, NULL, axis, -0.5f, 0.5f);
+  mcScalarFieldDescriptor descriptor;
+  mcHeightField_descriptor(&field, &descriptor);
+  mcSampleGrid grid;
+  numHeightCalls = 0;
+  mcSampleGrid_init(&grid, mcScalarFieldDescriptor_scalarField, &descriptor,
+      res[0], res[1], res[2], min, max);
+  /* The height is evaluated once per column, or not at all if the lattice
+   * lies entirely above or below the hills */
+  unsigned int numColumns = res[0] * res[1] * res[2] / res[axis];
+  assert(numHeightCalls == (isCulled ? 0 : (int)numColumns));
+  for (unsigned int z = 0; z < res[2]; ++z) {
+    for (unsigned int y = 0; y < res[1]; ++y) {
+      for (unsigned int x = 0; x < res[0]; ++x) {
+        float expected = mcHeightField_scalarField(
+            min->x + (float)x * grid.delta.x,
+            min->y + (float)y * grid.delta.y,
+            min->z + (float)z * grid.delta.z,
+            &field);
+        float actual = mcSampleGrid_sample(&grid, x, y, z);
+        /* Culled samples only keep their sign */
+        if (isCulled)
+          assert((expected < 0.0f) == (actual < 0.0f));
+        else
+          assert(actual == expected);
+      }
+    }
+  }
+  mcSampleGrid_destroy(&grid);
+}
+
+int test_mcSampleGrid_heightField() {
+  const unsigned int res[3] = { 21, 17, 19 };
+  for (int axis = 0; axis < 3; ++axis) {
+    /* A lattice through the hills */
+    mcVec3 min = { -1.0f, -1.0f, -1.0f }, max = { 1.0f, 1.0f, 1.0f };
+    compareHeightField(axis, &min, &max, res, 0);
+    /* Lattices entirely above and below the hills */
+    (&min.x)[axis] = 1.0f;
+    (&max.x)[axis] = 2.0f;
+    compareHeightField(axis, &min, &max, res, 1);
+    (&min.x)[axis] = -2.0f;
+    (&max.x)[axis] = -1.0f;
+    compareHeightField(axis, &min, &max, res, 1);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+#define TEST(routine) \
+  do { \
+    int result; \
+    if (result = test_ ## routine()) \
+      return result; \
+  } while (0)
+
+  TEST(mcSampleGrid_initCoarseToFine);
+  TEST(mcSampleGrid_heightField);
+
+  return EXIT_SUCCESS;
+}